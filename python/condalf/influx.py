@@ -1,24 +1,24 @@
-import datetime
+import time
 from influxdb import InfluxDBClient
+from condalf.senml_parser import split_name
 
 def write(user, password, dbname, host, port, body):
     client = InfluxDBClient(host,port,user,password,dbname)
-    client.write_points(body)
+    # Times are int ns since the epoch
+    client.write_points(body, time_precision="n")
 
 def get_body(record):
     #very basic for now
     tag = None
 
     # Set Tag if available
-    record_info = record["n"].split(":")
-    if len(record_info) >= 2:
-        tag = record_info[len(record_info) - 2]
-        record["n"] = record_info[len(record_info) - 1]
+    db, tag, measurement = split_name(record["n"])
+    if tag is not None:
+        record["n"] = measurement
     
     # Check Time and set it to now if not given
-    # TODO: maybe not pass this at all?
     if "t" not in record:
-        record["t"] = datetime.datetime.utcnow().strftime("%Y-%m-%dT%H:%M:%SZ")
+        record["t"] = time.time_ns()
     
     # Check value and set to 0 if not given
     if "v" not in record:
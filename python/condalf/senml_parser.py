@@ -1,27 +1,50 @@
 import cbor2
-import datetime
+import functools
+import time
+
+@functools.lru_cache(maxsize=65536)
+def split_name(name):
+    # Names are [db:]sensor:measurement, split every name only once -> (db, sensor, measurement)
+    record_info = name.split(":")
+    db = record_info[len(record_info) - 3] if len(record_info) >= 3 else "main"
+    tag = record_info[len(record_info) - 2] if len(record_info) >= 2 else None
+    return (db, tag, record_info[len(record_info) - 1])
 
 def get_db_name(record):
-    record_info = record["n"].split(":")
-    if len(record_info) >= 3:
-        return record_info[len(record_info) - 3]
-    return "main"
+    return split_name(record["n"])[0]
+
 
+# SenML times below 2**28 are relative to now (RFC 8428 section 4.5.3)
+RELATIVE_TIME = 2**28
 
-def parse_cbor(data, callback):
+def to_ns(t, now):
+    # Seconds and fraction separately, a float can not hold ns since 1970 exactly
+    if abs(t) < RELATIVE_TIME:
+        return now + round(t * 1e9)
+    seconds = int(t)
+    return seconds * 1000000000 + round((t - seconds) * 1e9)
+
+# Records get "t" as int ns since the epoch. now is the receive time in ns, the time of the call without it.
+def parse_cbor(data, callback, now=None):
+    if now is None:
+        now = time.time_ns()
     basename = ""
+    basetime = 0
     records = cbor2.loads(data)
     key_mapping = { -6: "bs", -5:"bv", -4:"bu", -3:"bt", -2:"bn", -1:"bver", 0:"n", 1:"u", 2:"v", 3:"vs", 4:"vb", 5:"s", 6:"t", 7:"ut", 8:"vd" }
 
     for record in records:
         translated = dict((key_mapping[key],val) for key,val in record.items())
-        if "t" in translated:
-            translated["t"] = datetime.datetime.utcfromtimestamp(translated["t"]).strftime("%Y-%m-%dT%H:%M:%SZ")
 
-        # Set Basename if given
+        # Set Basename and Basetime if given
         if "bn" in translated:
             basename = translated["bn"]
             del translated["bn"]
+        if "bt" in translated:
+            basetime = translated["bt"]
+            del translated["bt"]
+
+        translated["t"] = to_ns(basetime + translated.get("t", 0), now)
         
         # TODO: other bases...
 
@@ -21,3 +21,33 @@ def process_data(data):
     senml_parser.parse_cbor(data, parser_callback)
     influx.write("USERNAME", "PASSWORD", db, "IP_ADDRESS", "PORT", body)
     return
+
+
+# Called instead of process_data when defined. The backend decodes the SenML pack
+# natively and passes the resolved records as (name, unit, value, time, sum) tuples.
+# The time is in ns since the epoch, relative times are already resolved against the receive time.
+def process_records(records):
+    global db
+    db = ""
+    global body
+    body.clear()
+
+    for name, unit, value, time, _ in records:
+        parser_callback({ "n": name, "v": value, "t": time })
+    influx.write("USERNAME", "PASSWORD", db, "IP_ADDRESS", "PORT", body)
+    return
+
+# Called instead of process_records and process_data when defined. Every entry of batch is
+# the record list of one payload (or the raw payload without process_records).
+# The records of a batch can belong to different databases, they are written once per database.
+def process_batch(batch):
+    bodies = {}
+    for records in batch:
+        for name, unit, value, time, _ in records:
+            record = { "n": name, "v": value, "t": time }
+            db_name = senml_parser.get_db_name(record)
+            bodies.setdefault(db_name, []).append(influx.get_body(record))
+
+    for db_name, db_body in bodies.items():
+        influx.write("USERNAME", "PASSWORD", db_name, "IP_ADDRESS", "PORT", db_body)
+    return
\ No newline at end of file
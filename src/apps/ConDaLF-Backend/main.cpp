@@ -1,7 +1,9 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -12,6 +14,7 @@
 
 #include <service/server/server.hpp>
 #include <service/relay/relay.hpp>
+#include <python/python_pool.hpp>
 
 bool python_enabled = false;
 bool python_initialized = false;
@@ -46,6 +49,29 @@ void close_handler(sig_t s)
     exit(1);
 }
 
+/**
+ * @brief Reads the pre-shared key from a file, so that it does not show up in the process list
+ * 
+ * @param path Path of the key file
+ * @param key The key, the first line of the file
+ * @return true On success
+ * @return false If the file can not be read or holds no key
+ */
+bool read_psk_file(const std::string& path, std::string& key)
+{
+    std::ifstream file(path);
+    if (!file.is_open() || !std::getline(file, key) || key.empty())
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not read pre-shared key from " + path + ".");
+        return false;
+    }
+
+    struct stat status;
+    if (stat(path.c_str(), &status) == 0 && (status.st_mode & (S_IRWXG | S_IRWXO)) != 0)
+        common::logging::log_warning(std::cout, LINE_INFORMATION, "Pre-shared key file " + path + " is accessible by other users.");
+    return true;
+}
+
 void argument_usage()
 {
     std::cout << "###########################################" << std::endl;
@@ -74,6 +100,45 @@ void argument_usage()
     std::cout << "#        Will run process_data            #" << std::endl;
     std::cout << "#            -s user_script               #" << std::endl;
     std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'c': Server configuration             #" << std::endl;
+    std::cout << "#        key=value options, e.g. the      #" << std::endl;
+    std::cout << "#        InfluxDB sink (influx.host=...). #" << std::endl;
+    std::cout << "#            -c server_conf               #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'S': Sink plugin                      #" << std::endl;
+    std::cout << "#        Native sink (shared object) that #" << std::endl;
+    std::cout << "#        receives payloads and records.   #" << std::endl;
+    std::cout << "#            -S ./example_sink.so         #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'D': DTLS Port                        #" << std::endl;
+    std::cout << "#        Port of the DTLS endpoint. Only  #" << std::endl;
+    std::cout << "#        used with credentials below.     #" << std::endl;
+    std::cout << "#            -D 5684                      #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'P': DTLS Pre-shared key file         #" << std::endl;
+    std::cout << "#        Enables DTLS in PSK mode. The    #" << std::endl;
+    std::cout << "#        key is the first line.           #" << std::endl;
+    std::cout << "#            -P server.psk                #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'I': DTLS PSK identity hint           #" << std::endl;
+    std::cout << "#            -I condalf                   #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'C': DTLS Certificate                 #" << std::endl;
+    std::cout << "#        Enables DTLS with a certificate. #" << std::endl;
+    std::cout << "#            -C server.crt                #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'K': DTLS Private key                 #" << std::endl;
+    std::cout << "#            -K server.key                #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'A': DTLS CA certificate              #" << std::endl;
+    std::cout << "#        Clients have to present a        #" << std::endl;
+    std::cout << "#        certificate signed by this CA.   #" << std::endl;
+    std::cout << "#            -A ca.crt                    #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
+    std::cout << "#   'W': Internal                         #" << std::endl;
+    std::cout << "#        Starts a Python worker process.  #" << std::endl;
+    std::cout << "#        Only used by the worker pool.    #" << std::endl;
+    std::cout << "#                                         #" << std::endl;
     std::cout << "###########################################" << std::endl;
 }
 
@@ -89,11 +154,16 @@ int main(int argc, char* argv[])
     bool python_enabled = false;
     std::string relay_config = "";
     std::string python_script = "";
+    std::string secure_port = "5684";
+    std::string server_config = "";
+    std::string sink_plugin = "";
+    common::CoAP::security_config security;
 
     // Check all arguments
-    // condalf_backend [-h Host] [-p Port] [-r Relay config] [-s Python module]
+    // condalf_backend [-h Host] [-p Port] [-r Relay config] [-s Python module] [-c Server config] [-S Sink plugin]
+    //                 [-D DTLS Port] [-P PSK file] [-I PSK identity] [-C Certificate] [-K Private key] [-A CA]
     int opt = 0;
-    while ((opt = getopt(argc, argv, "h:p:r:s:")) != -1)
+    while ((opt = getopt(argc, argv, "h:p:r:s:c:S:D:P:I:C:K:A:W:")) != -1)
     {
         switch (opt)
         {
@@ -111,12 +181,48 @@ int main(int argc, char* argv[])
                 python_enabled = true;
                 python_script = std::string(optarg);
                 break;
+            case 'W': // Python worker process, only started by the pool itself
+                if (getenv(CONDALF_PYTHON_POOL_WORKER_ENV) == nullptr)
+                {
+                    argument_usage();
+                    return EXIT_FAILURE;
+                }
+                return condalf::run_python_pool_worker(std::string(optarg));
+            case 'c': // Server Configuration Option
+                server_config = std::string(optarg);
+                break;
+            case 'S': // Sink Plugin Option
+                sink_plugin = std::string(optarg);
+                break;
+            case 'D': // DTLS Port Option
+                secure_port = std::string(optarg);
+                break;
+            case 'P': // DTLS PSK Option
+                if (!read_psk_file(std::string(optarg), security.psk_key))
+                    return EXIT_FAILURE;
+                break;
+            case 'I': // DTLS PSK Identity Option
+                security.psk_identity = std::string(optarg);
+                break;
+            case 'C': // DTLS Certificate Option
+                security.cert_file = std::string(optarg);
+                break;
+            case 'K': // DTLS Private Key Option
+                security.key_file = std::string(optarg);
+                break;
+            case 'A': // DTLS CA Option
+                security.ca_file = std::string(optarg);
+                break;
             default: // Invalid argument
                 argument_usage();
                 return EXIT_FAILURE;
         }
     }
 
+    // DTLS is enabled when credentials are given
+    bool dtls_enabled = !security.psk_key.empty() || !security.cert_file.empty();
+    const common::CoAP::security_config* server_security = dtls_enabled ? &security : nullptr;
+
     // Print options
     std::stringstream options;
     options << "Host: " << host << std::endl
@@ -129,7 +235,16 @@ int main(int argc, char* argv[])
     if (python_enabled)
     {
         options << "Python script is enabled." << std::endl
-                << "Python script module: " << python_script << std::endl;
+                << "Python script module: " << python_script << std::endl << std::endl;
+    }
+    if (!server_config.empty())
+        options << "Server Configuration file: " << server_config << std::endl << std::endl;
+    if (!sink_plugin.empty())
+        options << "Sink plugin: " << sink_plugin << std::endl << std::endl;
+    if (dtls_enabled)
+    {
+        options << "DTLS is enabled (" << (security.psk_key.empty() ? "certificate" : "PSK") << " mode)." << std::endl
+                << "DTLS Port: " << secure_port << std::endl;
     }
 
     common::logging::log_information(std::cout, "Startup options:\n", options.str());
@@ -151,7 +266,7 @@ int main(int argc, char* argv[])
 
     // Start Server
     coap_server = &condalf::service::Server::getInstance();
-    if (!coap_server->Start(host, port, msg_queue, python_enabled, python_script))
+    if (!coap_server->Start(host, port, msg_queue, python_enabled, python_script, secure_port, server_security, server_config, sink_plugin))
     {
         common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not start CoAP Server Service.");
         return EXIT_FAILURE;
@@ -171,13 +286,26 @@ int main(int argc, char* argv[])
                                             + (coap_server->IsActive() ? "" : "not ") 
                                             + "running");
         }
+        else if (line.compare("stats") == 0)
+        {
+            if (relay != nullptr)
+                common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Relay sessions:\n") + relay->GetStatistics());
+            std::string sink_stats = coap_server->GetStatistics();
+            if (!sink_stats.empty())
+                common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Sinks:\n") + sink_stats);
+        }
+        else if (line.compare("devices") == 0)
+        {
+            std::string devices = coap_server->GetDevices();
+            common::logging::log_information(std::cout, LINE_INFORMATION, devices.empty() ? std::string("No devices tracked.") : std::string("Devices:\n") + devices);
+        }
         else if (line.compare("start") == 0)
         {
             if (relay != nullptr)
                 if (!relay->Start(relay_config))
                     common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not start Relay Service.");
 
-            if (!coap_server->Start(host, port, msg_queue, python_enabled, python_script))
+            if (!coap_server->Start(host, port, msg_queue, python_enabled, python_script, secure_port, server_security, server_config, sink_plugin))
                 common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not start CoAP Server Service.");
         }
         else if (line.compare("stop") == 0)
@@ -197,7 +325,7 @@ int main(int argc, char* argv[])
         else
         {
             // TODO: Make this pretty
-            std::cout << "Unknown command \"" << line << "\" try status, start, stop or reload." << std::endl;
+            std::cout << "Unknown command \"" << line << "\" try status, stats, devices, start, stop or reload." << std::endl;
         }
     }
 
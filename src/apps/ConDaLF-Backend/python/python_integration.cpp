@@ -11,11 +11,125 @@
 
 #include "python_integration.hpp"
 
+#define PY_SSIZE_T_CLEAN // Lengths of '#' formats are Py_ssize_t
 #include <Python.h>
+#include <limits>
+#include <memory>
 #include <stdlib.h>
+#include <string_view>
+#include <unordered_map>
 #include <common/logging/logging.h>
+#include <sink/series.hpp>
 
-PyObject *pName, *pModule, *pDict, *pFunc, *pValue, *presult;
+PyObject *pName, *pModule, *pDict, *pFunc;
+PyObject *pRecordsFunc = nullptr;
+PyObject *pBatchFunc = nullptr;
+PyObject *pPayloadType = nullptr;
+PyThreadState *pMainThreadState = nullptr;
+thread_local PyGILState_STATE gGILState;
+
+/**
+ * @brief Exports a payload or an array of the server to Python through the buffer protocol.
+ * owner keeps the memory alive as long as Python holds buffers of it.
+ */
+struct payload_object
+{
+    PyObject_HEAD
+    const void *data;
+    Py_ssize_t count;       // Items
+    Py_ssize_t itemsize;
+    const char *format;     // struct format of an item
+    std::shared_ptr<const void> *owner;
+};
+
+static int payload_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    auto *payload = reinterpret_cast<payload_object*>(self);
+    // Fails for writable requests, keeps a reference to the payload object in view->obj
+    if (PyBuffer_FillInfo(view, self, const_cast<void*>(payload->data), payload->count * payload->itemsize, 1, flags) != 0)
+        return -1;
+
+    // Consumers that do not ask for the format see unsigned bytes
+    if ((flags & PyBUF_FORMAT) == PyBUF_FORMAT)
+    {
+        view->format = const_cast<char*>(payload->format);
+        view->itemsize = payload->itemsize;     // strides points to itemsize
+        if ((flags & PyBUF_ND) == PyBUF_ND)
+            view->shape = &payload->count;
+    }
+    return 0;
+}
+
+static void payload_dealloc(PyObject *self)
+{
+    auto *payload = reinterpret_cast<payload_object*>(self);
+    PyTypeObject *type = Py_TYPE(self);
+    delete payload->owner;
+    PyObject_Free(self);
+    Py_DECREF(type);
+}
+
+static PyType_Slot payload_slots[] = {
+    { Py_tp_dealloc, reinterpret_cast<void*>(payload_dealloc) },
+    { Py_bf_getbuffer, reinterpret_cast<void*>(payload_getbuffer) },
+    { 0, nullptr }
+};
+
+static PyType_Spec payload_spec = { "condalf.Payload", sizeof(payload_object), 0, Py_TPFLAGS_DEFAULT, payload_slots };
+
+static PyStructSequence_Field columns_fields[] = {
+    { "names", "list of record names, equal names are the same interned str" },
+    { "values", "float64 values, 0/1 for booleans, NaN for strings and data" },
+    { "times", "int64 times in ns since the epoch, resolved against the receive time" },
+    { "sums", "float64 sums, NaN if the record has none" },
+    { "units", "int32 index into unit_names, -1 if the unit table is full" },
+    { "types", "uint8 value types: 1 number, 2 string, 3 boolean, 4 data" },
+    { "strings", "dict of record index to str (string values) or bytes (data values)" },
+    { "unit_names", "list of units by id, the same list for all packs" },
+    { "series", "int32 series ids, index into series_names, -1 if the series dictionary is full" },
+    { "series_names", "list of (db, sensor, measurement) by series id, the same list for all packs" },
+    { nullptr, nullptr }
+};
+
+static PyStructSequence_Desc columns_desc = { "condalf.Columns", "A decoded SenML pack as columns", columns_fields, 10 };
+
+PyTypeObject *pColumnsType = nullptr;
+PyObject *pColumnsFunc = nullptr;
+PyObject *pUnitNames = nullptr;
+PyObject *pSeriesNames = nullptr;
+
+/**
+ * @brief Interned record names by their UTF-8 representation (owned by the str)
+ */
+std::unordered_map<std::string_view, PyObject*> gNames;
+
+/**
+ * @brief Unit ids by their UTF-8 representation (owned by the str in pUnitNames)
+ */
+std::unordered_map<std::string_view, int32_t> gUnits;
+
+/**
+ * @brief Arrays of a pack in columns. The exported views own it.
+ */
+struct column_storage
+{
+    std::vector<double> values;
+    std::vector<int64_t> times;
+    std::vector<double> sums;
+    std::vector<int32_t> units;
+    std::vector<uint8_t> types;
+    std::vector<int32_t> series;
+};
+
+/**
+ * @brief Drops the interned names
+ */
+static void clear_names()
+{
+    for (auto &name : gNames)
+        Py_DECREF(name.second);
+    gNames.clear();
+}
 
 // TODO: Don't crash when importing module and we don't have proper env
 
@@ -24,6 +138,26 @@ bool condalf::initialize_python(std::string file)
     setenv("PYTHONPATH","./python",1);
     Py_Initialize();
 
+    // Exports payloads to the script without copying them
+    pPayloadType = PyType_FromSpec(&payload_spec);
+    if (pPayloadType == NULL)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create the payload type. Python Error below:");
+        PyErr_Print();
+        return false;
+    }
+
+    // Packs in columns share the unit and series tables
+    pColumnsType = PyStructSequence_NewType(&columns_desc);
+    pUnitNames = PyList_New(0);
+    pSeriesNames = PyList_New(0);
+    if (pColumnsType == NULL || pUnitNames == NULL || pSeriesNames == NULL)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create the columns type. Python Error below:");
+        PyErr_Print();
+        return false;
+    }
+
     // Import module
     pName = PyUnicode_FromString(file.c_str());
     pModule = PyImport_Import(pName);
@@ -49,6 +183,15 @@ bool condalf::initialize_python(std::string file)
         return false;
     }
 
+    // Get the records function (optional)
+    pRecordsFunc = PyDict_GetItemString(pDict, (char*)"process_records");
+
+    // Get the batch function (optional)
+    pBatchFunc = PyDict_GetItemString(pDict, (char*)"process_batch");
+
+    // Get the columns function (optional)
+    pColumnsFunc = PyDict_GetItemString(pDict, (char*)"process_columns");
+
     // Get main function
     pFunc = PyDict_GetItemString(pDict, (char*)"process_data");
 
@@ -63,47 +206,499 @@ bool condalf::initialize_python(std::string file)
     return true;
 }
 
-void condalf::python_process_data(const std::vector<uint8_t> &data)
+/**
+ * @brief Calls a function of the module with a single argument and reports errors.
+ * 
+ * @param pFunction The function
+ * @param pArgument The argument, the reference is consumed
+ */
+static void call_with(PyObject *pFunction, PyObject *pArgument)
+{
+    PyObject *pArgs = PyTuple_Pack(1, pArgument);
+    Py_DECREF(pArgument);
+    PyObject *pResult = pArgs != NULL ? PyObject_CallObject(pFunction, pArgs) : NULL;
+
+    // Check for error
+    if (PyErr_Occurred() != NULL)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Error when running python method. See Python Error below:");
+        PyErr_Print();
+    }
+
+    Py_XDECREF(pResult);
+    Py_XDECREF(pArgs);
+}
+
+/**
+ * @brief Creates a read-only memoryview over memory of the server without copying it.
+ * 
+ * @param data First item
+ * @param count Number of items
+ * @param itemsize Size of an item
+ * @param format struct format of an item
+ * @param owner Keeps the memory alive, may be empty if the memory stays mapped
+ * @return PyObject* New reference or NULL on error
+ */
+static PyObject* export_array(const void *data, std::size_t count, std::size_t itemsize, const char *format, const std::shared_ptr<const void> &owner)
 {
-    if (PyCallable_Check(pFunc))
+    static uint64_t empty = 0;
+    payload_object *payload = PyObject_New(payload_object, reinterpret_cast<PyTypeObject*>(pPayloadType));
+    if (payload == NULL)
+        return NULL;
+    payload->data = count != 0 ? data : &empty;
+    payload->count = count;
+    payload->itemsize = itemsize;
+    payload->format = format;
+    payload->owner = owner ? new std::shared_ptr<const void>(owner) : nullptr;
+
+    PyObject *pView = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(payload));
+    Py_DECREF(payload);
+    return pView;
+}
+
+/**
+ * @brief Creates a read-only memoryview over a payload without copying it.
+ * The view has to be released with release_payload_view once the call returned.
+ * 
+ * @param data The payload
+ * @param size Length of the payload
+ * @param owner Keeps the payload alive, may be empty if the memory stays mapped
+ * @return PyObject* New reference or NULL on error
+ */
+static PyObject* payload_view(const uint8_t *data, std::size_t size, const std::shared_ptr<const void> &owner)
+{
+    return export_array(data, size, 1, "B", owner);
+}
+
+/**
+ * @brief Releases a payload view so that the script can not access the payload through it after the call.
+ * 
+ * @param pView The view, the reference is consumed
+ */
+static void release_payload_view(PyObject *pView)
+{
+    PyObject *pPayload = PyMemoryView_GET_BUFFER(pView)->obj;
+    Py_INCREF(pPayload);
+
+    PyObject *pResult = PyObject_CallMethod(pView, "release", NULL);
+    if (pResult == NULL)
+        PyErr_Clear(); // The script still exports the view, checked below
+    Py_XDECREF(pResult);
+    Py_DECREF(pView);
+
+    // Buffers the script kept hold a reference to the payload
+    if (Py_REFCNT(pPayload) > 1 && reinterpret_cast<payload_object*>(pPayload)->owner == nullptr)
+        common::logging::log_warning(std::cout, LINE_INFORMATION, "Python script kept a buffer of a payload in shared memory, it is overwritten by later payloads. Use bytes(data) to keep it.");
+    Py_DECREF(pPayload);
+}
+
+void condalf::python_process_data(const uint8_t *data, std::size_t size, const std::shared_ptr<const void> &owner)
+{
+    if (!PyCallable_Check(pFunc))
     {
-        pValue = Py_BuildValue("(y#)",&data[0], data.size());
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Function is not callable.");
+        PyErr_Print();
+        return;
+    }
+
+    PyObject *pView = payload_view(data, size, owner);
+    if (pView == NULL)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not build data value for Python.");
+        PyErr_Print();
+        return;
+    }
+
+    Py_INCREF(pView);
+    call_with(pFunc, pView);
+    release_payload_view(pView);
+}
+
+bool condalf::python_wants_records()
+{
+    return (pRecordsFunc != nullptr && PyCallable_Check(pRecordsFunc)) || (pColumnsFunc != nullptr && PyCallable_Check(pColumnsFunc));
+}
+
+/**
+ * @brief Converts the value of a record into a Python object.
+ * 
+ * @param record The record
+ * @return PyObject* New reference
+ */
+PyObject* record_value(const common::senml::Record &record)
+{
+    switch (record.type)
+    {
+    case common::senml::ValueType::NUMBER:
+        return PyFloat_FromDouble(record.value);
+    case common::senml::ValueType::STRING:
+        return PyUnicode_FromStringAndSize(record.text.data(), record.text.size());
+    case common::senml::ValueType::BOOLEAN:
+        return PyBool_FromLong(record.boolean);
+    case common::senml::ValueType::DATA:
+        return PyBytes_FromStringAndSize(record.text.data(), record.text.size());
+    default:
+        Py_RETURN_NONE;
+    }
+}
 
-        // Check for error
-        if (PyErr_Occurred() != NULL)
+/**
+ * @brief Builds the list of (name, unit, value, time, sum) tuples of a pack. The time is in ns since the epoch.
+ * 
+ * @param pack The decoded SenML records
+ * @return PyObject* New reference or NULL on error
+ */
+static PyObject* build_records(const common::senml::Pack &pack)
+{
+    const auto &records = pack.records;
+    PyObject *pRecords = PyList_New(records.size());
+    if (pRecords == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const auto &record = records[i];
+        PyObject *pSum = record.has_sum ? PyFloat_FromDouble(record.sum) : (Py_INCREF(Py_None), Py_None);
+        PyObject *pRecord = Py_BuildValue("(s#s#NLN)",
+                                          record.name.data(), (Py_ssize_t)record.name.size(),
+                                          record.unit.data(), (Py_ssize_t)record.unit.size(),
+                                          record_value(record),
+                                          (long long)record.timestamp,
+                                          pSum);
+        if (pRecord == NULL)
         {
-            common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not build data value for Python.");
-            PyErr_Print();
-            return;
+            Py_DECREF(pRecords);
+            return NULL;
         }
-        
-        presult = PyObject_CallObject(pFunc,pValue);
+        PyList_SET_ITEM(pRecords, i, pRecord); // Steals the reference
+    }
+    return pRecords;
+}
+
+/**
+ * @brief Returns the interned str of a record name. Names are cached between calls.
+ * 
+ * @param name The name
+ * @return PyObject* New reference or NULL on error
+ */
+static PyObject* intern_name(std::string_view name)
+{
+    auto it = gNames.find(name);
+    if (it != gNames.end())
+    {
+        Py_INCREF(it->second);
+        return it->second;
+    }
+
+    PyObject *pString = PyUnicode_FromStringAndSize(name.data(), name.size());
+    if (pString == NULL)
+        return NULL;
+    PyUnicode_InternInPlace(&pString);
+
+    Py_ssize_t length = 0;
+    const char *utf8 = PyUnicode_AsUTF8AndSize(pString, &length);
+    if (utf8 == NULL)
+    {
+        Py_DECREF(pString);
+        return NULL;
+    }
 
-        // Check for error
-        if (PyErr_Occurred() != NULL)
+    // Names are client controlled, start over instead of growing without bound
+    if (gNames.size() >= CONDALF_PYTHON_NAME_CACHE)
+        clear_names();
+    Py_INCREF(pString);
+    gNames.emplace(std::string_view(utf8, length), pString);
+    return pString;
+}
+
+/**
+ * @brief Returns the id of a unit in pUnitNames and adds new units
+ * 
+ * @param unit The unit
+ * @return int32_t The id or -1 if the table is full
+ */
+static int32_t unit_id(std::string_view unit)
+{
+    auto it = gUnits.find(unit);
+    if (it != gUnits.end())
+        return it->second;
+    if (gUnits.size() >= CONDALF_PYTHON_UNIT_LIMIT)
+        return -1;
+
+    PyObject *pUnit = PyUnicode_FromStringAndSize(unit.data(), unit.size());
+    Py_ssize_t length = 0;
+    const char *utf8 = pUnit != NULL ? PyUnicode_AsUTF8AndSize(pUnit, &length) : NULL;
+    int32_t id = PyList_GET_SIZE(pUnitNames);
+    if (utf8 == NULL || PyList_Append(pUnitNames, pUnit) != 0)
+    {
+        PyErr_Clear();
+        Py_XDECREF(pUnit);
+        return -1;
+    }
+    Py_DECREF(pUnit); // The list keeps it
+    gUnits.emplace(std::string_view(utf8, length), id);
+    return id;
+}
+
+/**
+ * @brief Returns the series id of a record. pSeriesNames is extended up to the id.
+ * 
+ * @param record The record
+ * @return int32_t The id or -1 if the series dictionary is full
+ */
+static int32_t series_id(const common::senml::Record &record)
+{
+    auto &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    uint32_t id = dictionary.Of(record);
+    if (id == CONDALF_SERIES_INVALID)
+        return -1;
+
+    // Ids are handed out in order, the list catches up with the dictionary
+    while (PyList_GET_SIZE(pSeriesNames) <= static_cast<Py_ssize_t>(id))
+    {
+        const auto &parts = dictionary.Get(PyList_GET_SIZE(pSeriesNames)).parts;
+        PyObject *pParts = Py_BuildValue("(s#s#s#)", parts.db.data(), static_cast<Py_ssize_t>(parts.db.size()),
+                                         parts.sensor.data(), static_cast<Py_ssize_t>(parts.sensor.size()),
+                                         parts.measurement.data(), static_cast<Py_ssize_t>(parts.measurement.size()));
+        if (pParts == NULL)
         {
-            common::logging::log_error(std::cerr, LINE_INFORMATION, "Error when running python method. See Python Error below:");
-            PyErr_Print();
-            if (pValue != NULL)
-                Py_DECREF(pValue);
+            // Names that are no valid UTF-8 keep their place as None
+            PyErr_Clear();
+            Py_INCREF(Py_None);
+            pParts = Py_None;
+        }
+        int appended = PyList_Append(pSeriesNames, pParts);
+        Py_DECREF(pParts); // The list keeps it
+        if (appended != 0)
+        {
+            PyErr_Clear();
+            return -1;
+        }
+    }
+    return static_cast<int32_t>(id);
+}
+
+/**
+ * @brief Builds a condalf.Columns of a pack. Only the names and non numeric values are Python objects,
+ * the numeric columns are exported as memoryviews.
+ * 
+ * @param pack The decoded SenML records
+ * @return PyObject* New reference or NULL on error
+ */
+static PyObject* build_columns(const common::senml::Pack &pack)
+{
+    const auto &records = pack.records;
+    PyObject *pColumns = PyStructSequence_New(pColumnsType);
+    if (pColumns == NULL)
+        return NULL;
+
+    auto storage = std::make_shared<column_storage>();
+    storage->values.resize(records.size());
+    storage->times.resize(records.size());
+    storage->sums.resize(records.size());
+    storage->units.resize(records.size());
+    storage->types.resize(records.size());
+    storage->series.resize(records.size());
+
+    // Unset fields are NULL, the struct sequence releases the ones that are set
+    PyObject *pNames = PyList_New(records.size());
+    PyStructSequence_SET_ITEM(pColumns, 0, pNames);
+    PyObject *pStrings = PyDict_New();
+    PyStructSequence_SET_ITEM(pColumns, 6, pStrings);
+    if (pNames == NULL || pStrings == NULL)
+    {
+        Py_DECREF(pColumns);
+        return NULL;
+    }
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const auto &record = records[i];
+        PyObject *pName = intern_name(record.name);
+        if (pName == NULL)
+        {
+            Py_DECREF(pColumns);
+            return NULL;
         }
+        PyList_SET_ITEM(pNames, i, pName); // Steals the reference
+
+        storage->values[i] = record.type == common::senml::ValueType::NUMBER ? record.value
+                           : record.type == common::senml::ValueType::BOOLEAN ? (record.boolean ? 1 : 0)
+                           : nan;
+        storage->sums[i] = record.has_sum ? record.sum : nan;
+        storage->units[i] = unit_id(record.unit);
+        storage->types[i] = static_cast<uint8_t>(record.type);
+        storage->series[i] = series_id(record);
 
-        if (pValue != NULL)
+        storage->times[i] = record.timestamp;
+
+        if (record.type == common::senml::ValueType::STRING || record.type == common::senml::ValueType::DATA)
+        {
+            PyObject *pIndex = PyLong_FromSize_t(i);
+            PyObject *pValue = record_value(record);
+            if (pIndex == NULL || pValue == NULL || PyDict_SetItem(pStrings, pIndex, pValue) != 0)
+            {
+                Py_XDECREF(pIndex);
+                Py_XDECREF(pValue);
+                Py_DECREF(pColumns);
+                return NULL;
+            }
+            Py_DECREF(pIndex);
             Py_DECREF(pValue);
+        }
     }
-    else 
+
+    const column_storage &columns = *storage;
+    PyObject *pFields[] = {
+        export_array(columns.values.data(), records.size(), sizeof(double), "d", storage),
+        export_array(columns.times.data(), records.size(), sizeof(int64_t), "q", storage),
+        export_array(columns.sums.data(), records.size(), sizeof(double), "d", storage),
+        export_array(columns.units.data(), records.size(), sizeof(int32_t), "i", storage),
+        export_array(columns.types.data(), records.size(), sizeof(uint8_t), "B", storage)
+    };
+    bool valid = true;
+    for (size_t i = 0; i < 5; i++)
     {
-        common::logging::log_error(std::cerr, LINE_INFORMATION, "Function is not callable.");
+        valid &= pFields[i] != NULL;
+        PyStructSequence_SET_ITEM(pColumns, i + 1, pFields[i]);
+    }
+    Py_INCREF(pUnitNames);
+    PyStructSequence_SET_ITEM(pColumns, 7, pUnitNames);
+    PyObject *pSeries = export_array(columns.series.data(), records.size(), sizeof(int32_t), "i", storage);
+    valid &= pSeries != NULL;
+    PyStructSequence_SET_ITEM(pColumns, 8, pSeries);
+    Py_INCREF(pSeriesNames);
+    PyStructSequence_SET_ITEM(pColumns, 9, pSeriesNames);
+
+    if (!valid)
+    {
+        Py_DECREF(pColumns);
+        return NULL;
+    }
+    return pColumns;
+}
+
+/**
+ * @brief Builds what the script gets for a decoded pack: columns if it defines process_columns, record tuples otherwise
+ * 
+ * @param pack The decoded SenML records
+ * @return PyObject* New reference or NULL on error
+ */
+static PyObject* build_pack(const common::senml::Pack &pack)
+{
+    if (pColumnsFunc != nullptr && PyCallable_Check(pColumnsFunc))
+        return build_columns(pack);
+    return build_records(pack);
+}
+
+void condalf::python_process_records(const common::senml::Pack &pack)
+{
+    if (!python_wants_records())
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Neither process_columns nor process_records is callable.");
+        return;
+    }
+
+    // Build the columns or the list of record tuples
+    PyObject *pRecords = build_pack(pack);
+    if (pRecords == NULL)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not build records for Python.");
         PyErr_Print();
+        return;
     }
+    call_with(pColumnsFunc != nullptr && PyCallable_Check(pColumnsFunc) ? pColumnsFunc : pRecordsFunc, pRecords);
+}
+
+bool condalf::python_wants_batch()
+{
+    return pBatchFunc != nullptr && PyCallable_Check(pBatchFunc);
+}
+
+void condalf::python_process_batch(const std::vector<batch_entry> &batch)
+{
+    if (!python_wants_batch())
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "process_batch is not callable.");
+        return;
+    }
+
+    // One entry per payload: the record list if it was decoded, the raw bytes otherwise
+    PyObject *pBatch = PyList_New(batch.size());
+    if (pBatch == NULL)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not build batch for Python.");
+        PyErr_Print();
+        return;
+    }
+
+    std::vector<PyObject*> views;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        const batch_entry &entry = batch[i];
+        PyObject *pEntry = entry.pack != nullptr ? build_pack(*entry.pack) : payload_view(entry.data, entry.size, entry.owner);
+        if (pEntry == NULL)
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not build batch entry for Python.");
+            PyErr_Print();
+            Py_DECREF(pBatch);
+            for (PyObject *pView : views)
+                release_payload_view(pView);
+            return;
+        }
+        if (entry.pack == nullptr)
+        {
+            Py_INCREF(pEntry);
+            views.push_back(pEntry);
+        }
+        PyList_SET_ITEM(pBatch, i, pEntry); // Steals the reference
+    }
+    call_with(pBatchFunc, pBatch);
+
+    // The payloads are only valid during the call
+    for (PyObject *pView : views)
+        release_payload_view(pView);
 }
 
 void condalf::uninitialize_python()
 {
     // Clean up 
+    pRecordsFunc = nullptr;
+    pBatchFunc = nullptr;
+    pColumnsFunc = nullptr;
+    clear_names();
+    gUnits.clear();
+    Py_CLEAR(pUnitNames);
+    Py_CLEAR(pSeriesNames);
+    Py_CLEAR(pColumnsType);
+    Py_CLEAR(pPayloadType);
     Py_DECREF(pModule);
     Py_DECREF(pName);
 
     // Finish the Python Interpreter
     Py_Finalize();
+}
+
+void condalf::python_release_main_thread()
+{
+    if (pMainThreadState == nullptr)
+        pMainThreadState = PyEval_SaveThread();
+}
+
+void condalf::python_restore_main_thread()
+{
+    if (pMainThreadState != nullptr)
+        PyEval_RestoreThread(pMainThreadState);
+    pMainThreadState = nullptr;
+}
+
+void condalf::python_lock()
+{
+    gGILState = PyGILState_Ensure();
+}
+
+void condalf::python_unlock()
+{
+    PyGILState_Release(gGILState);
 }
\ No newline at end of file
@@ -11,14 +11,84 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
+#include <common/senml/senml.hpp>
+
+#define CONDALF_PYTHON_NAME_CACHE 65536  // Interned record names kept between calls
+#define CONDALF_PYTHON_UNIT_LIMIT 65536  // Distinct units that get an id in unit_names
 
 // TODO: Make this clean
 
 namespace condalf
 {
     bool initialize_python(std::string file);
-    void python_process_data(const std::vector<uint8_t> &data);
+
+    /**
+     * @brief Calls process_data with a read-only memoryview of the payload. The payload is not copied,
+     * the view is released when the call returns.
+     * 
+     * @param data The payload
+     * @param size Length of the payload
+     * @param owner Keeps the payload alive while the script holds buffers of it (none for mapped memory)
+     */
+    void python_process_data(const uint8_t *data, std::size_t size, const std::shared_ptr<const void> &owner = nullptr);
+
+    /**
+     * @brief Checks if the module defines process_records or process_columns and wants natively decoded records.
+     */
+    bool python_wants_records();
+
+    /**
+     * @brief Calls process_columns with a condalf.Columns of the pack if the module defines it,
+     * otherwise process_records with a list of (name, unit, value, time, sum) tuples.
+     * 
+     * @param pack The decoded SenML records
+     */
+    void python_process_records(const common::senml::Pack &pack);
+
+    /**
+     * @brief A payload of a batch
+     */
+    struct batch_entry
+    {
+        const uint8_t *data = nullptr;                  // Raw payload, passed as memoryview if pack is not set
+        std::size_t size = 0;
+        std::shared_ptr<const void> owner;              // Keeps data alive, see python_process_data
+        const common::senml::Pack *pack = nullptr;      // Decoded payload, passed like to python_process_records
+    };
+
+    /**
+     * @brief Checks if the module defines process_batch and wants several payloads per call.
+     */
+    bool python_wants_batch();
+
+    /**
+     * @brief Calls process_batch with a list that has one entry per payload.
+     * 
+     * @param batch The payloads
+     */
+    void python_process_batch(const std::vector<batch_entry> &batch);
     void uninitialize_python();
+
+    /**
+     * @brief Releases the GIL on the thread that called initialize_python so that other threads can run Python.
+     */
+    void python_release_main_thread();
+
+    /**
+     * @brief Takes the GIL back on the thread that called initialize_python. Has to be called before uninitialize_python.
+     */
+    void python_restore_main_thread();
+
+    /**
+     * @brief Acquires the GIL on the calling thread.
+     */
+    void python_lock();
+
+    /**
+     * @brief Releases the GIL acquired with python_lock.
+     */
+    void python_unlock();
 }
\ No newline at end of file
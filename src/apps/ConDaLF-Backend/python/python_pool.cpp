@@ -0,0 +1,463 @@
+/**
+ * @file python_pool.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include "python_pool.hpp"
+#include "python_integration.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <csignal>
+#include <deque>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <common/logging/logging.h>
+#include <sink/series.hpp>
+
+using namespace condalf;
+
+#define RING_WRAP UINT32_MAX // Length of the marker that continues the ring at offset 0
+#define RING_FLAG_JSON 1
+
+/**
+ * @brief Start of the shared memory. The frames follow directly.
+ * head is only written by the worker, tail only by the server.
+ */
+struct condalf::python_ring_header
+{
+    alignas(64) std::atomic_uint64_t head;      // Position of the next frame to read
+    alignas(64) std::atomic_uint64_t tail;      // Position of the next frame to write
+    alignas(64) std::atomic_uint64_t processed; // Written by the worker
+    std::atomic_uint64_t calls;                 // Calls into the script, written by the worker
+    std::atomic_uint64_t call_time;             // us spent in the script, written by the worker
+    uint64_t size;                              // Bytes of frames
+};
+
+/**
+ * @brief Header of every frame. The payload follows, the frame is padded to 8 bytes.
+ */
+struct frame_header
+{
+    uint32_t length;
+    uint16_t flags;
+    uint16_t reserved;
+    int64_t received;   // Receive time of the payload in ns since the epoch
+};
+
+/**
+ * @brief Size of a frame including header and padding
+ *
+ * @param length Length of the payload
+ * @return uint64_t Frame size
+ */
+static uint64_t frame_size(uint64_t length)
+{
+    return (sizeof(frame_header) + length + 7) & ~(uint64_t)7;
+}
+
+PythonPool::PythonPool()
+{
+    dropped.store(0);
+    rejected.store(0);
+}
+
+PythonPool::~PythonPool()
+{
+    Stop();
+}
+
+bool PythonPool::spawn(worker& w, const std::string& executable)
+{
+    w.memfd = memfd_create("condalf-python", MFD_CLOEXEC);
+    w.mapping_size = sizeof(python_ring_header) + config.ring_size;
+    if (w.memfd < 0 || ftruncate(w.memfd, w.mapping_size) != 0)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not create shared memory: ") + strerror(errno));
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, w.mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, w.memfd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not map shared memory: ") + strerror(errno));
+        return false;
+    }
+    w.ring = new (mapping) python_ring_header();
+    w.ring->head.store(0);
+    w.ring->tail.store(0);
+    w.ring->processed.store(0);
+    w.ring->calls.store(0);
+    w.ring->call_time.store(0);
+    w.ring->size = config.ring_size;
+    w.data = static_cast<uint8_t*>(mapping) + sizeof(python_ring_header);
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not create doorbell: ") + strerror(errno));
+        return false;
+    }
+
+    // Everything is prepared before the fork, the child only execs
+    std::string arguments = std::to_string(w.memfd) + "," + std::to_string(sockets[1]) + ","
+                          + std::to_string(config.batch_size) + "," + std::to_string(config.linger) + "," + script;
+    std::vector<char*> argv = { const_cast<char*>(executable.c_str()), const_cast<char*>("-W"), const_cast<char*>(arguments.c_str()), nullptr };
+    std::string worker_env = std::string(CONDALF_PYTHON_POOL_WORKER_ENV) + "=1";
+    std::vector<char*> envp;
+    for (char** variable = environ; *variable != nullptr; variable++)
+        envp.push_back(*variable);
+    envp.push_back(const_cast<char*>(worker_env.c_str()));
+    envp.push_back(nullptr);
+
+    w.pid = fork();
+    if (w.pid == 0)
+    {
+        // Only these two descriptors are inherited
+        fcntl(w.memfd, F_SETFD, 0);
+        fcntl(sockets[1], F_SETFD, 0);
+        execve(argv[0], argv.data(), envp.data());
+        _exit(127);
+    }
+
+    close(sockets[1]);
+    w.doorbell = sockets[0];
+    if (w.pid < 0)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not start Python worker: ") + strerror(errno));
+        return false;
+    }
+    w.alive = true;
+    return true;
+}
+
+void PythonPool::terminate(worker& w)
+{
+    // Closing the doorbell makes the worker process what is left and exit
+    if (w.doorbell >= 0)
+        close(w.doorbell);
+    if (w.pid > 0 && w.alive)
+        waitpid(w.pid, nullptr, 0);
+    if (w.ring != nullptr)
+        munmap(w.ring, w.mapping_size);
+    if (w.memfd >= 0)
+        close(w.memfd);
+    w = worker();
+}
+
+bool PythonPool::check_alive(worker& w)
+{
+    if (w.alive && waitpid(w.pid, nullptr, WNOHANG) == w.pid)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Python worker ") + std::to_string(w.pid) + " exited.");
+        w.alive = false;
+    }
+    return w.alive;
+}
+
+bool PythonPool::push(worker& w, const PythonWorker::Job& job)
+{
+    const std::vector<uint8_t>& payload = *job.payload;
+    uint64_t size = w.ring->size;
+    uint64_t frame = frame_size(payload.size());
+    uint64_t tail = w.ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = w.ring->head.load(std::memory_order_acquire);
+
+    // Frames are contiguous -> skip the end of the ring if the frame does not fit there
+    uint64_t offset = tail % size;
+    uint64_t skip = offset + frame > size ? size - offset : 0;
+    if (tail + skip + frame - head > size)
+        return false;
+
+    if (skip != 0)
+    {
+        frame_header wrap = { RING_WRAP, 0, 0, 0 };
+        std::memcpy(w.data + offset, &wrap, sizeof(wrap));
+        tail += skip;
+        offset = 0;
+    }
+
+    frame_header header = { (uint32_t)payload.size(), (uint16_t)(job.json ? RING_FLAG_JSON : 0), 0, job.received };
+    std::memcpy(w.data + offset, &header, sizeof(header));
+    std::memcpy(w.data + offset + sizeof(header), payload.data(), payload.size());
+    w.ring->tail.store(tail + frame, std::memory_order_release);
+
+    // Wake the worker up. If the socket is full the worker has pending wake ups anyway.
+    char bell = 0;
+    if (send(w.doorbell, &bell, 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        check_alive(w);
+    return true;
+}
+
+bool PythonPool::Start(const std::string& _script, const PythonWorker::options& _config)
+{
+    if (IsActive())
+        return false;
+
+    script = _script;
+    config = _config;
+    config.ring_size = std::max((std::size_t)CONDALF_PYTHON_POOL_MIN_RING, (config.ring_size + 7) & ~(std::size_t)7);
+
+    char executable[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length <= 0)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not find the backend executable.");
+        return false;
+    }
+    executable[length] = '\0';
+
+    workers.resize(std::max(config.workers, 1u));
+    for (worker& w : workers)
+    {
+        if (!spawn(w, executable))
+        {
+            Stop();
+            return false;
+        }
+    }
+    common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Started ") + std::to_string(workers.size()) + " Python workers.");
+    return true;
+}
+
+void PythonPool::Stop()
+{
+    for (worker& w : workers)
+        terminate(w);
+    workers.clear();
+}
+
+bool PythonPool::Submit(PythonWorker::Job&& job)
+{
+    // Sticky per database so that the order within a series holds
+    std::string_view db = CONDALF_DEFAULT_DB;
+    if (!job.pack.records.empty())
+    {
+        auto &dictionary = condalf::sink::SeriesDictionary::getInstance();
+        uint32_t id = dictionary.Of(job.pack.records.front());
+        db = id != CONDALF_SERIES_INVALID ? dictionary.Get(id).parts.db : condalf::sink::split_series_name(job.pack.records.front().name).db;
+    }
+    worker& w = workers[std::hash<std::string_view>()(db) % workers.size()];
+
+    if (!w.alive || frame_size(job.payload->size()) > w.ring->size / 2)
+    {
+        dropped++;
+        return true;
+    }
+
+    while (!push(w, job))
+    {
+        switch (config.overflow)
+        {
+            case PythonWorker::Overflow::DROP:
+                dropped++;
+                return true;
+            case PythonWorker::Overflow::REJECT:
+                rejected++;
+                return false;
+            case PythonWorker::Overflow::BLOCK:
+                // Backpressure: the IO thread waits until the worker caught up
+                if (!check_alive(w))
+                {
+                    dropped++;
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(CONDALF_PYTHON_POOL_BLOCK_WAIT));
+                break;
+        }
+    }
+    return true;
+}
+
+std::string PythonPool::GetStatistics()
+{
+    std::stringstream stats;
+    stats << "dropped=" << dropped.load() << " rejected=" << rejected.load();
+    for (std::size_t i = 0; i < workers.size(); i++)
+    {
+        const worker& w = workers[i];
+        uint64_t processed = w.ring->processed.load();
+        uint64_t calls = w.ring->calls.load();
+        uint64_t queued = w.ring->tail.load() - w.ring->head.load();
+        stats << std::endl << "  worker " << i << " pid=" << w.pid << (w.alive ? "" : " (exited)")
+              << " queued=" << queued << "/" << w.ring->size << "B"
+              << " processed=" << processed
+              << " calls=" << calls
+              << " call_avg=" << (calls != 0 ? w.ring->call_time.load() / calls : 0) << "us";
+    }
+    return stats.str();
+}
+
+int condalf::run_python_pool_worker(const std::string& arguments)
+{
+    // The server decides when we stop (by closing the doorbell)
+    signal(SIGINT, SIG_IGN);
+
+    // memfd,doorbell,batch_size,linger,module
+    std::vector<std::string> fields;
+    std::size_t position = 0;
+    for (int i = 0; i < 4 && position != std::string::npos; i++)
+    {
+        std::size_t comma = arguments.find(',', position);
+        fields.push_back(arguments.substr(position, comma == std::string::npos ? comma : comma - position));
+        position = comma == std::string::npos ? comma : comma + 1;
+    }
+    if (position == std::string::npos)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Invalid Python worker arguments.");
+        return EXIT_FAILURE;
+    }
+    int memfd = std::atoi(fields[0].c_str());
+    int doorbell = std::atoi(fields[1].c_str());
+    std::size_t batch_size = std::max(1L, std::atol(fields[2].c_str()));
+    std::chrono::milliseconds linger(std::atol(fields[3].c_str()));
+    std::string module = arguments.substr(position);
+
+    struct stat info;
+    void *mapping = fstat(memfd, &info) == 0 ? mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0) : MAP_FAILED;
+    if (mapping == MAP_FAILED)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Python worker could not map shared memory.");
+        return EXIT_FAILURE;
+    }
+    auto *ring = static_cast<python_ring_header*>(mapping);
+    const uint8_t *data = static_cast<const uint8_t*>(mapping) + sizeof(python_ring_header);
+
+    if (!initialize_python(module))
+        return EXIT_FAILURE;
+    bool records = python_wants_records();
+    bool batching = python_wants_batch();
+    if (!batching)
+        batch_size = 1;
+
+    // Frames of the current batch stay in the ring until it was processed, head only moves on flush
+    uint64_t read = ring->head.load(std::memory_order_relaxed);
+    std::vector<batch_entry> batch;
+    std::deque<common::senml::Pack> packs;  // Stable addresses for the entries
+    std::chrono::steady_clock::time_point batch_start;
+
+    auto flush = [&]() {
+        if (!batch.empty())
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (batching)
+                python_process_batch(batch);
+            else if (batch.front().pack != nullptr)
+                python_process_records(*batch.front().pack);
+            else
+                python_process_data(batch.front().data, batch.front().size);
+            auto end = std::chrono::steady_clock::now();
+
+            ring->call_time += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            ring->calls++;
+            ring->processed += batch.size();
+            batch.clear();
+            packs.clear();
+        }
+        ring->head.store(read, std::memory_order_release);
+    };
+
+    auto drain = [&]() {
+        while (read != ring->tail.load(std::memory_order_acquire))
+        {
+            uint64_t offset = read % ring->size;
+            frame_header header;
+            std::memcpy(&header, data + offset, sizeof(header));
+            if (header.length == RING_WRAP)
+            {
+                read += ring->size - offset;
+                continue;
+            }
+            read += frame_size(header.length);
+
+            batch_entry entry;
+            entry.data = data + offset + sizeof(header);
+            entry.size = header.length;
+            bool json = header.flags & RING_FLAG_JSON;
+            if (records)
+            {
+                packs.emplace_back();
+                bool valid = json ? common::senml::decode_json(entry.data, entry.size, packs.back())
+                                  : common::senml::decode_cbor(entry.data, entry.size, packs.back());
+                if (!valid || !common::senml::normalize_times(packs.back(), header.received))
+                {
+                    common::logging::log_warning(std::cout, LINE_INFORMATION, "Python worker received a malformed SenML pack.");
+                    packs.pop_back();
+                    continue;
+                }
+                entry.pack = &packs.back();
+            }
+            else if (json)
+            {
+                common::logging::log_warning(std::cout, LINE_INFORMATION, "SenML JSON can only be processed by scripts that define process_records or process_columns.");
+                continue;
+            }
+
+            if (batch.empty())
+                batch_start = std::chrono::steady_clock::now();
+            batch.push_back(entry);
+            if (batch.size() >= batch_size)
+                flush();
+        }
+
+        // Hand skipped frames back to the server
+        if (batch.empty())
+            ring->head.store(read, std::memory_order_release);
+    };
+
+    while (true)
+    {
+        drain();
+
+        // A partial batch waits until its linger time for more frames
+        int timeout = -1;
+        if (!batch.empty())
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(batch_start + linger - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+            {
+                flush();
+                continue;
+            }
+            timeout = static_cast<int>(left.count());
+        }
+
+        pollfd bell = { doorbell, POLLIN, 0 };
+        int ready = poll(&bell, 1, timeout);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready == 0)
+            continue;
+
+        char bells[256];
+        ssize_t res = ::read(doorbell, bells, sizeof(bells));
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            break;
+    }
+
+    // The server closed the doorbell -> finish what it wrote before
+    drain();
+    flush();
+    uninitialize_python();
+    munmap(mapping, info.st_size);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,179 @@
+/**
+ * @file python_pool.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Runs the Python script in several worker processes
+ * @version 0.1
+ * @date 2021-07-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "python_worker.hpp"
+
+#define CONDALF_PYTHON_POOL_MIN_RING (64 * 1024)
+#define CONDALF_PYTHON_POOL_BLOCK_WAIT 1 // ms between checks for space in block mode
+#define CONDALF_PYTHON_POOL_WORKER_ENV "CONDALF_PYTHON_POOL_WORKER" // Set for the worker processes, -W is refused without it
+
+namespace condalf
+{
+    /**
+     * @brief Shared memory of a worker process (see python_pool.cpp)
+     */
+    struct python_ring_header;
+
+    /**
+     * @brief Runs the Python script in worker processes so that scripts scale past the GIL.
+     * Every worker is the backend binary started in worker mode (-W). It imports the module itself
+     * and reads payloads from a shared memory ring that only the server writes to. Frames in the ring
+     * are length-prefixed. A socket wakes the worker up and tells it to exit when it is closed.
+     * Payloads are dispatched by the database of their first record, so all payloads of a
+     * database are processed by the same worker in order.
+     */
+    class PythonPool
+    {
+        private:
+            /**
+             * @brief A worker process
+             */
+            struct worker
+            {
+                pid_t pid = -1;
+                int memfd = -1;
+                int doorbell = -1;          // Our end of the socket pair
+                python_ring_header *ring = nullptr;
+                uint8_t *data = nullptr;    // Frames, ring->size bytes
+                std::size_t mapping_size = 0;
+                bool alive = false;
+            };
+
+            /**
+             * @brief Name of the Python module
+             */
+            std::string script;
+
+            /**
+             * @brief Options of the pool
+             */
+            PythonWorker::options config;
+
+            /**
+             * @brief The worker processes
+             */
+            std::vector<worker> workers;
+
+            std::atomic_uint64_t dropped;
+            std::atomic_uint64_t rejected;
+
+            /**
+             * @brief Creates the ring and starts a worker process
+             *
+             * @param w The worker
+             * @param executable Path of the backend binary
+             * @return true On success
+             * @return false On failure
+             */
+            bool spawn(worker& w, const std::string& executable);
+
+            /**
+             * @brief Lets the worker finish its ring and waits for it to exit
+             *
+             * @param w The worker
+             */
+            void terminate(worker& w);
+
+            /**
+             * @brief Checks if the worker process still runs
+             *
+             * @param w The worker
+             * @return true Running
+             * @return false Exited
+             */
+            bool check_alive(worker& w);
+
+            /**
+             * @brief Writes a frame into the ring of a worker
+             *
+             * @param w The worker
+             * @param job The job
+             * @return true On success
+             * @return false If the ring is full
+             */
+            bool push(worker& w, const PythonWorker::Job& job);
+
+        public:
+            /**
+             * @brief Construct a new PythonPool object
+             */
+            PythonPool();
+
+            /**
+             * @brief Destroy the PythonPool object
+             */
+            ~PythonPool();
+
+            /**
+             * @brief Deleted copy constructor
+             */
+            PythonPool(const PythonPool&) = delete;
+
+            /**
+             * @brief Deleted copy operator
+             */
+            PythonPool& operator=(const PythonPool&) = delete;
+
+            /**
+             * @brief Starts the worker processes
+             *
+             * @param _script Name of the Python module
+             * @param _config Options of the pool (workers, ring_size, overflow, batch_size, linger)
+             * @return true On success
+             * @return false On failure
+             */
+            bool Start(const std::string& _script, const PythonWorker::options& _config);
+
+            /**
+             * @brief Stops the worker processes after they processed their rings
+             */
+            void Stop();
+
+            /**
+             * @brief Checks if the pool is running
+             *
+             * @return true Running
+             * @return false Stopped
+             */
+            bool IsActive() const { return !workers.empty(); }
+
+            /**
+             * @brief Hands a job to the worker of its database. The job has to be decoded.
+             * Only one thread may submit.
+             *
+             * @param job The job
+             * @return true If the request can be acknowledged (the job might have been dropped)
+             * @return false If the ring is full and the request should be rejected
+             */
+            bool Submit(PythonWorker::Job&& job);
+
+            /**
+             * @brief Get the statistics of the workers
+             *
+             * @return std::string One line per worker
+             */
+            std::string GetStatistics();
+    };
+
+    /**
+     * @brief Main function of a worker process. The pool starts the workers with -W and CONDALF_PYTHON_POOL_WORKER_ENV set.
+     *
+     * @param arguments "memfd,doorbell,batch_size,linger,module" as passed with -W
+     * @return int Exit code
+     */
+    int run_python_pool_worker(const std::string& arguments);
+}
\ No newline at end of file
@@ -0,0 +1,236 @@
+/**
+ * @file python_worker.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-09
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "python_worker.hpp"
+#include "python_integration.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <common/logging/logging.h>
+
+using namespace condalf;
+
+/**
+ * @brief Microseconds between two points in time
+ * 
+ * @param from Start
+ * @param to End
+ * @return uint64_t Microseconds
+ */
+static uint64_t elapsed_us(PythonWorker::clock::time_point from, PythonWorker::clock::time_point to)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+bool PythonWorker::enable_python()
+{
+    if (!initialize_python(script))
+        return false;
+    wants_records = python_wants_records();
+    wants_batch = python_wants_batch();
+
+    // The interpreter thread takes the GIL from here on
+    python_release_main_thread();
+    return true;
+}
+
+bool PythonWorker::disable_python()
+{
+    // The interpreter thread is stopped -> finish the queue here
+    std::deque<Job> left;
+    {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        left.swap(jobs);
+    }
+    space_notifier.notify_all();
+
+    python_restore_main_thread();
+    process_all(left);
+
+    wants_records = false;
+    wants_batch = false;
+    uninitialize_python();
+    return true;
+}
+
+void PythonWorker::record_call(clock::time_point start, clock::time_point end)
+{
+    uint64_t call = elapsed_us(start, end);
+    call_time += call;
+    calls++;
+    uint64_t max = max_call_time.load();
+    while (call > max && !max_call_time.compare_exchange_weak(max, call));
+}
+
+void PythonWorker::process(const Job& job)
+{
+    clock::time_point start = clock::now();
+    if (job.decoded)
+        python_process_records(job.pack);
+    else
+        python_process_data(job.payload->data(), job.payload->size(), job.payload);
+    record_call(start, clock::now());
+
+    wait_time += elapsed_us(job.enqueued, start);
+    processed++;
+}
+
+void PythonWorker::process_batch(std::deque<Job>::const_iterator first, std::deque<Job>::const_iterator last)
+{
+    std::vector<batch_entry> batch;
+    batch.reserve(std::distance(first, last));
+    for (auto it = first; it != last; it++)
+    {
+        batch_entry entry;
+        entry.data = it->payload->data();
+        entry.size = it->payload->size();
+        entry.owner = it->payload;
+        entry.pack = it->decoded ? &it->pack : nullptr;
+        batch.push_back(entry);
+    }
+
+    clock::time_point start = clock::now();
+    python_process_batch(batch);
+    record_call(start, clock::now());
+
+    for (auto it = first; it != last; it++)
+        wait_time += elapsed_us(it->enqueued, start);
+    processed += batch.size();
+}
+
+void PythonWorker::process_all(const std::deque<Job>& pending)
+{
+    if (!wants_batch)
+    {
+        for (const Job& job : pending)
+            process(job);
+        return;
+    }
+
+    for (auto first = pending.begin(); first != pending.end();)
+    {
+        auto last = first + std::min<std::size_t>(config.batch_size, pending.end() - first);
+        process_batch(first, last);
+        first = last;
+    }
+}
+
+void PythonWorker::run()
+{
+    std::deque<Job> pending;
+    {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        job_notifier.wait_for(lock, std::chrono::milliseconds(CONDALF_PYTHON_WAIT_TIMEOUT), [this] { return !jobs.empty(); });
+
+        // Give a partial batch until the linger time of its oldest payload to fill up
+        if (wants_batch && !jobs.empty() && jobs.size() < config.batch_size)
+        {
+            clock::time_point deadline = jobs.front().enqueued + std::chrono::milliseconds(config.linger);
+            job_notifier.wait_until(lock, deadline, [this] { return jobs.size() >= config.batch_size; });
+        }
+        pending.swap(jobs);
+    }
+    if (pending.empty())
+        return;
+    space_notifier.notify_all();
+
+    // One GIL acquisition for everything that queued up
+    python_lock();
+    process_all(pending);
+    python_unlock();
+}
+
+PythonWorker::PythonWorker() : Service(), wants_records(false), wants_batch(false)
+{
+    this->service_name = "ConDaLF-Backend-Python";
+    processed.store(0);
+    dropped.store(0);
+    rejected.store(0);
+    calls.store(0);
+    call_time.store(0);
+    max_call_time.store(0);
+    wait_time.store(0);
+
+    add_hook(
+        std::bind(&PythonWorker::enable_python, this),
+        std::bind(&PythonWorker::disable_python, this)
+    );
+}
+
+PythonWorker::~PythonWorker()
+{
+    Stop();
+}
+
+bool PythonWorker::Start(const std::string& _script, const options& _config)
+{
+    if (IsActive())
+        return false;
+
+    script = _script;
+    config = _config;
+    if (config.queue_size == 0)
+        config.queue_size = 1;
+    if (config.batch_size == 0)
+        config.batch_size = 1;
+    return common::Service::Start();
+}
+
+bool PythonWorker::Submit(Job&& job)
+{
+    std::unique_lock<std::mutex> lock(job_mutex);
+    if (jobs.size() >= config.queue_size)
+    {
+        switch (config.overflow)
+        {
+            case Overflow::DROP:
+                dropped++;
+                return true;
+            case Overflow::REJECT:
+                rejected++;
+                return false;
+            case Overflow::BLOCK:
+                // Backpressure: the IO thread waits until the script caught up
+                while (jobs.size() >= config.queue_size && IsActive())
+                    space_notifier.wait_for(lock, std::chrono::milliseconds(CONDALF_PYTHON_WAIT_TIMEOUT));
+                break;
+        }
+    }
+
+    job.enqueued = clock::now();
+    jobs.push_back(std::move(job));
+    lock.unlock();
+    job_notifier.notify_one();
+    return true;
+}
+
+std::string PythonWorker::GetStatistics()
+{
+    std::size_t depth = 0;
+    {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        depth = jobs.size();
+    }
+
+    uint64_t count = processed.load();
+    uint64_t call_count = calls.load();
+    std::stringstream stats;
+    stats << "queue=" << depth << "/" << config.queue_size
+          << " processed=" << count
+          << " dropped=" << dropped.load()
+          << " rejected=" << rejected.load()
+          << " calls=" << call_count
+          << " call_avg=" << (call_count != 0 ? call_time.load() / call_count : 0) << "us"
+          << " call_max=" << max_call_time.load() << "us"
+          << " wait_avg=" << (count != 0 ? wait_time.load() / count : 0) << "us";
+    return stats.str();
+}
\ No newline at end of file
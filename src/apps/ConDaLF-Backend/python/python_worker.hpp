@@ -0,0 +1,231 @@
+/**
+ * @file python_worker.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Runs the Python script on its own thread
+ * @version 0.1
+ * @date 2021-07-09
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <common/service/service.hpp>
+#include <common/senml/senml.hpp>
+
+#define CONDALF_PYTHON_QUEUE_SIZE 1024      // Payloads waiting for the script
+#define CONDALF_PYTHON_WAIT_TIMEOUT 100     // ms the worker waits for work before checking if it should stop
+#define CONDALF_PYTHON_RETRY_AFTER 5        // Max-Age in seconds of a rejected request
+#define CONDALF_PYTHON_WORKERS 1            // Interpreters, more than one runs worker processes
+#define CONDALF_PYTHON_RING_SIZE (4 * 1024 * 1024) // Bytes of the shared memory ring of each worker process
+#define CONDALF_PYTHON_BATCH_SIZE 64        // Payloads per process_batch call
+#define CONDALF_PYTHON_LINGER 10            // ms a partial batch waits for more payloads
+
+namespace condalf
+{
+    /**
+     * @brief Hands payloads to the Python script on a dedicated interpreter thread.
+     * The CoAP IO thread only queues the payload and answers right away. The queue is bounded,
+     * what happens when it is full is decided by the overflow option.
+     */
+    class PythonWorker : private common::Service
+    {
+        public:
+            using common::Service::IsActive;
+            using common::Service::Stop;
+
+            using clock = std::chrono::steady_clock;
+
+            /**
+             * @brief What to do with a payload when the queue is full
+             */
+            enum class Overflow
+            {
+                DROP,       // Accept the request but drop the payload
+                REJECT,     // Answer 5.03 with Max-Age so that the client retries later
+                BLOCK       // Wait for space, this holds up the CoAP IO thread
+            };
+
+            /**
+             * @brief Options of the worker
+             */
+            struct options
+            {
+                std::size_t queue_size = CONDALF_PYTHON_QUEUE_SIZE;
+                Overflow overflow = Overflow::DROP;
+                unsigned int workers = CONDALF_PYTHON_WORKERS;
+                std::size_t ring_size = CONDALF_PYTHON_RING_SIZE;
+                std::size_t batch_size = CONDALF_PYTHON_BATCH_SIZE;
+                unsigned int linger = CONDALF_PYTHON_LINGER;  // ms
+            };
+
+            /**
+             * @brief A payload for the script
+             */
+            struct Job
+            {
+                std::shared_ptr<const std::vector<uint8_t>> payload;
+                bool json = false;          // SenML JSON instead of SenML CBOR
+                common::senml::Pack pack;   // Decoded payload if decoded is set, points into payload
+                bool decoded = false;
+                int64_t received = 0;       // Receive time in ns since the epoch, for packs decoded by a pool worker
+                clock::time_point enqueued;
+            };
+
+        private:
+            /**
+             * @brief Name of the Python module
+             */
+            std::string script;
+
+            /**
+             * @brief Options of the worker
+             */
+            options config;
+
+            /**
+             * @brief True if the module defines process_records
+             */
+            bool wants_records;
+
+            /**
+             * @brief True if the module defines process_batch
+             */
+            bool wants_batch;
+
+            /**
+             * @brief Protects jobs
+             */
+            std::mutex job_mutex;
+
+            /**
+             * @brief Signals new jobs to the worker
+             */
+            std::condition_variable job_notifier;
+
+            /**
+             * @brief Signals free space to blocked producers
+             */
+            std::condition_variable space_notifier;
+
+            /**
+             * @brief Queued jobs, oldest first
+             */
+            std::deque<Job> jobs;
+
+            std::atomic_uint64_t processed;
+            std::atomic_uint64_t dropped;
+            std::atomic_uint64_t rejected;
+            std::atomic_uint64_t calls;         // Calls into the script, less than processed when batching
+            std::atomic_uint64_t call_time;     // Sum of the time spent in the script in us
+            std::atomic_uint64_t max_call_time; // us
+            std::atomic_uint64_t wait_time;     // Sum of the time jobs spent in the queue in us
+
+            /**
+             * @brief Loads the module and releases the GIL for the worker thread
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool enable_python();
+
+            /**
+             * @brief Processes the jobs that are left and unloads the module
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool disable_python();
+
+            /**
+             * @brief Calls the script for a job. The GIL has to be held.
+             * 
+             * @param job The job
+             */
+            void process(const Job& job);
+
+            /**
+             * @brief Calls process_batch for a range of jobs. The GIL has to be held.
+             * 
+             * @param first First job
+             * @param last Past the last job
+             */
+            void process_batch(std::deque<Job>::const_iterator first, std::deque<Job>::const_iterator last);
+
+            /**
+             * @brief Calls the script for all jobs, in batches if the module defines process_batch.
+             * The GIL has to be held.
+             * 
+             * @param pending The jobs
+             */
+            void process_all(const std::deque<Job>& pending);
+
+            /**
+             * @brief Updates the statistics after a call into the script
+             * 
+             * @param start When the call started
+             * @param end When the call returned
+             */
+            void record_call(clock::time_point start, clock::time_point end);
+
+        protected:
+            /**
+             * @brief Run function of the interpreter thread
+             */
+            void run();
+
+        public:
+            /**
+             * @brief Construct a new PythonWorker object
+             */
+            PythonWorker();
+
+            /**
+             * @brief Destroy the PythonWorker object
+             */
+            ~PythonWorker();
+
+            /**
+             * @brief Loads the module and starts the interpreter thread
+             * 
+             * @param _script Name of the Python module
+             * @param _config Options of the worker
+             * @return true On success
+             * @return false On failure
+             */
+            bool Start(const std::string& _script, const options& _config);
+
+            /**
+             * @brief Checks if the module defines process_records. Jobs should be decoded then.
+             * 
+             * @return true Records are wanted
+             * @return false Raw payloads are wanted
+             */
+            bool WantsRecords() const { return wants_records; }
+
+            /**
+             * @brief Queues a job for the script
+             * 
+             * @param job The job
+             * @return true If the request can be acknowledged (the job might have been dropped)
+             * @return false If the queue is full and the request should be rejected
+             */
+            bool Submit(Job&& job);
+
+            /**
+             * @brief Get the statistics of the worker
+             * 
+             * @return std::string Queue depth, processed and dropped jobs and call latencies
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
@@ -8,7 +8,6 @@ MessageQueue::~MessageQueue()
     while (!IsEmpty())
     {
         auto msg = Extract();
-        delete[] msg->data;
         delete msg;
     }
 }
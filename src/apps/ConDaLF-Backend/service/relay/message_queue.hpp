@@ -12,6 +12,7 @@
 #pragma once
 
 #include <common/coap/coap.hpp>
+#include <memory>
 #include <queue>
 
 namespace condalf::service
@@ -28,8 +29,8 @@ namespace condalf::service
             coap_pdu_type_t type;
             coap_pdu_code_t code;
             std::string uri;
-            uint8_t* data;
-            size_t data_size;
+            uint16_t content_format;
+            std::shared_ptr<const std::vector<uint8_t>> data; // Shared by every session that relays this message
         };
 
         private:
@@ -1,4 +1,6 @@
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <common/logging/logging.h>
@@ -10,14 +12,102 @@
 
 using namespace condalf::service;
 
-void Relay::configuration_line_handler(const std::string& line)
+/**
+ * @brief Converts a block size in bytes into the block size exponent (SZX).
+ * 
+ * @param block_size Block size in bytes (power of two between 16 and 1024)
+ * @param szx The resulting exponent
+ * @return true On success
+ * @return false If the size is not a valid block size
+ */
+bool block_size_to_szx(unsigned long block_size, unsigned int& szx)
 {
+    for (unsigned int i = 0; i <= COAP_MAX_BLOCK_SZX; i++)
+    {
+        if ((1ul << (i + 4)) == block_size)
+        {
+            szx = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Relay::configuration_line_handler(const std::string& configuration_line)
+{
+    if (configuration_line.size() == 0)
+        return;
+
+    // Line format: [scheme://]host[:port] [option=value ...]
+    std::stringstream ss_line(configuration_line);
+    std::string line, option;
+    ss_line >> line;
     if (line.size() == 0)
         return;
+
+    unsigned int block_szx = CONDALF_SESSION_DEFAULT_BLOCK_SZX;
+    common::CoAP::security_config security;
+    while (ss_line >> option)
+    {
+        std::size_t separator = option.find('=');
+        std::string key = option.substr(0, separator);
+        std::string value = separator != std::string::npos ? option.substr(separator + 1) : "";
+
+        if (key.compare("block") == 0)
+        {
+            char* end = nullptr;
+            unsigned long block_size = std::strtoul(value.c_str(), &end, 10);
+            if (end == value.c_str() || *end != '\0' || !block_size_to_szx(block_size, block_szx))
+            {
+                common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("Invalid block size \"") + value + "\" for " + line + ". Using the default block size.");
+                block_szx = CONDALF_SESSION_DEFAULT_BLOCK_SZX;
+            }
+        }
+        else if (key.compare("psk-id") == 0)
+            security.psk_identity = value;
+        else if (key.compare("psk") == 0)
+            security.psk_key = value;
+        else if (key.compare("ca") == 0)
+            security.ca_file = value;
+        else if (key.compare("cert") == 0)
+            security.cert_file = value;
+        else if (key.compare("key") == 0)
+            security.key_file = value;
+        else
+            common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("Unknown relay option \"") + option + "\" for " + line + ".");
+    }
     
     std::string host, port;
     port = "5683";
 
+    // Check for the scheme -> plain coap over UDP if none is given
+    coap_proto_t proto = COAP_PROTO_UDP;
+    std::string scheme = "coap";
+    std::size_t scheme_end = line.find("://");
+    if (scheme_end != std::string::npos)
+    {
+        scheme = line.substr(0, scheme_end);
+        line = line.substr(scheme_end + 3);
+
+        if (scheme.compare("coaps") == 0)
+        {
+            proto = COAP_PROTO_DTLS;
+            port = "5684";
+        }
+        else if (scheme.compare("coap+tcp") == 0)
+            proto = COAP_PROTO_TCP;
+        else if (scheme.compare("coaps+tcp") == 0)
+        {
+            proto = COAP_PROTO_TLS;
+            port = "5684";
+        }
+        else if (scheme.compare("coap") != 0)
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Unsupported scheme \"") + scheme + "\" in relay configuration.");
+            return;
+        }
+    }
+
     // Check if port is given else we assume standard port
     std::size_t pos = line.find_first_of(':', 0);
     if (pos != std::string::npos)
@@ -29,14 +119,17 @@ void Relay::configuration_line_handler(const std::string& line)
         host = line;
     
     // Skip if we already have read this before
-    if (configuration_data.find(host + ":" + port) != configuration_data.end())
+    std::string upstream = scheme + "://" + host + ":" + port;
+    if (configuration_data.find(upstream) != configuration_data.end())
         return;
+    configuration_data.insert(upstream);
 
     // Create session and check for failure
-    Session* session = new Session();
-    if (!session->Connect(coap_context, host, port))
+    Session* session = new Session(&run_queue);
+    session->SetBlockSize(block_szx);
+    if (!session->Connect(coap_context, host, port, proto, security))
     {
-        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not create relay session to ") + host + ":" + port);
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not create relay session to ") + upstream);
         delete session;
         return;
     }
@@ -104,50 +197,78 @@ bool Relay::enable_relay()
 
     // Clear configuration data used as a cache
     configuration_data.clear();
+    publish_statistics();
     return true;
 }
 
 bool Relay::disable_relay()
 {
-    // Get CoAP Instance
-    auto coap = &common::CoAP::getInstance();
-
     // Remove all the relayed sessions
+    run_queue.Clear();
     for (auto session : sessions)
         delete session;
     sessions.clear();
+    publish_statistics();
     return true;
 }
 
+void Relay::publish_statistics()
+{
+    std::stringstream stats;
+    for (auto session : sessions)
+    {
+        stats << session->GetAddress()
+              << (session->IsConnected() ? "" : " (disconnected)")
+              << " block=" << session->GetBlockSize()
+              << " transmit=" << session->GetTransmitQueueCount()
+              << " retransmit=" << session->GetRetransmitQueueCount() << std::endl;
+    }
+
+    std::lock_guard guard(statistics_mutex);
+    statistics = stats.str();
+}
+
 void Relay::run()
 {
-    // Get CoAP and SessionManager Instance
+    // Get CoAP Instance
     auto coap = &common::CoAP::getInstance();
-    auto session_manager = &SessionManager::getInstance();
 
-    // Enqueue every message into all sessions
+    // Enqueue every message into all sessions (marks them as ready)
     while (!msg_queue->IsEmpty())
     {
         // Get the message and enqueue it
         MessageQueue::Message* msg = msg_queue->Extract();
         for (auto session : sessions)
-        {
             session->EnqueueMessage(*msg);
-            delete[] msg->data;
-            delete msg;
-        }
+        delete msg;
     }
 
-    // Transmit messages
-    for (auto session : sessions)
+    // Transmit messages of the ready sessions only. Sessions that become ready
+    // while doing so are handled on the next run.
+    auto now = RunQueue::clock::now();
+    run_queue.ExpireTimers(now);
+    for (unsigned int ready = run_queue.ReadyCount(); ready > 0; ready--)
     {
-        if (!session->IsConnected())
-            session->Reconnect();
+        Session* session = run_queue.Extract();
+        if (!session->IsConnected() && !session->TryReconnect(now))
+            continue;
         session->Transmit(); // we are doing nothing with the rvalue yet
     }
+
+    // The sessions are only touched by this thread, the main thread reads a snapshot
+    if (now >= next_statistics)
+    {
+        publish_statistics();
+        next_statistics = now + std::chrono::milliseconds(CONDALF_RELAY_STATISTICS_INTERVAL);
+    }
     
-    // Do IO with timeout of 500ms
-    coap->IO(coap_context, 100);
+    // Do IO until the next timer expires (at most CONDALF_RELAY_IO_TIMEOUT)
+    std::chrono::milliseconds timeout(CONDALF_RELAY_IO_TIMEOUT);
+    if (run_queue.ReadyCount() != 0)
+        timeout = std::chrono::milliseconds(1); // 0 would block until there is IO
+    else
+        timeout = run_queue.TimeUntilNextTimer(now, timeout);
+    coap->IO(coap_context, std::max(timeout.count(), (std::chrono::milliseconds::rep)1));
 }
 
 Relay::Relay(MessageQueue* _msg_queue) : Service()
@@ -171,6 +292,12 @@ bool Relay::Start(const std::string& _configuration_file)
     return common::Service::Start();
 }
 
+std::string Relay::GetStatistics()
+{
+    std::lock_guard guard(statistics_mutex);
+    return statistics;
+}
+
 bool Relay::Reload(const std::string& _configuration_file)
 {
     this->configuration_file = _configuration_file;
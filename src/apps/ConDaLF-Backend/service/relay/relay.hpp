@@ -11,15 +11,19 @@
 
 #pragma once
 
+#include <mutex>
 #include <queue>
 #include <unordered_set>
 #include <unordered_map>
 #include <common/coap/coap.hpp>
 #include <common/service/service.hpp>
 
+#include "run_queue.hpp"
 #include "session.hpp"
 
 #define CONDALF_RELAY_KEEP_ALIVE_TIMEOUT 10 // seconds
+#define CONDALF_RELAY_IO_TIMEOUT 100 // milliseconds
+#define CONDALF_RELAY_STATISTICS_INTERVAL 1000 // milliseconds between snapshots of the session statistics
 
 namespace condalf::service
 {
@@ -56,12 +60,38 @@ namespace condalf::service
              */
             std::vector<Session*> sessions;
 
+            /**
+             * @brief Sessions that have work to do. Only these are touched in run().
+             */
+            RunQueue run_queue;
+
+            /**
+             * @brief Snapshot of the session statistics. The sessions belong to the relay thread,
+             * so it writes the snapshot and GetStatistics only reads it.
+             */
+            std::string statistics;
+
+            /**
+             * @brief Protects statistics
+             */
+            std::mutex statistics_mutex;
+
+            /**
+             * @brief Time of the next statistics snapshot
+             */
+            RunQueue::clock::time_point next_statistics;
+
+            /**
+             * @brief Writes the statistics of all sessions into the snapshot
+             */
+            void publish_statistics();
+
             /**
              * @brief Handles a read line from the configuration.
              * 
-             * @param line Line that got read
+             * @param configuration_line Line that got read
              */
-            void configuration_line_handler(const std::string& line);
+            void configuration_line_handler(const std::string& configuration_line);
 
             /**
              * @brief Inits CoAP for the Server
@@ -135,5 +165,13 @@ namespace condalf::service
              * @return false On failure
              */
             bool Reload(const std::string& _configuration_file);
+
+            /**
+             * @brief Get the statistics of all relay sessions (one line per session).
+             * They are at most CONDALF_RELAY_STATISTICS_INTERVAL old.
+             * 
+             * @return std::string Human readable statistics
+             */
+            std::string GetStatistics();
     };
 }
\ No newline at end of file
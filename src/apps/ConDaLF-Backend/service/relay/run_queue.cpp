@@ -0,0 +1,75 @@
+#include "run_queue.hpp"
+
+#include <algorithm>
+
+using namespace condalf::service;
+
+void RunQueue::MarkReady(Session* session)
+{
+    if (!ready_set.insert(session).second)
+        return;
+    ready.push_back(session);
+}
+
+void RunQueue::ScheduleTimer(Session* session, clock::time_point due)
+{
+    // A timer that fires earlier already makes the session ready in time
+    auto it = armed.find(session);
+    if (it != armed.end() && it->second <= due)
+        return;
+
+    armed[session] = due;
+    timers.push(timer { .due = due, .session = session });
+}
+
+void RunQueue::ExpireTimers(clock::time_point now)
+{
+    while (!timers.empty() && timers.top().due <= now)
+    {
+        // Timers that were replaced by an earlier one are skipped
+        timer expired = timers.top();
+        timers.pop();
+        auto it = armed.find(expired.session);
+        if (it == armed.end() || it->second != expired.due)
+            continue;
+
+        armed.erase(it);
+        MarkReady(expired.session);
+    }
+}
+
+Session* RunQueue::Extract()
+{
+    if (ready.empty())
+        return nullptr;
+
+    Session* session = ready.front();
+    ready.pop_front();
+    ready_set.erase(session);
+    return session;
+}
+
+unsigned int RunQueue::ReadyCount()
+{
+    return ready.size();
+}
+
+std::chrono::milliseconds RunQueue::TimeUntilNextTimer(clock::time_point now, std::chrono::milliseconds max)
+{
+    // Replaced timers still wake the relay once, which only costs one empty run
+    if (timers.empty())
+        return max;
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(timers.top().due - now);
+    if (remaining.count() < 0)
+        return std::chrono::milliseconds(0);
+    return std::min(remaining, max);
+}
+
+void RunQueue::Clear()
+{
+    ready.clear();
+    ready_set.clear();
+    timers = decltype(timers)();
+    armed.clear();
+}
@@ -0,0 +1,131 @@
+/**
+ * @file run_queue.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Run queue of relay sessions that have work to do
+ * @version 0.1
+ * @date 2021-07-02
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace condalf::service
+{
+    class Session;
+
+    /**
+     * @brief Sessions put themselves into this queue when an event gives them work (enqueued message,
+     * ACK, NACK, ...). The relay only touches the sessions in here instead of every configured session.
+     * Not thread-safe. It is only used by the relay thread.
+     */
+    class RunQueue
+    {
+        public:
+            using clock = std::chrono::steady_clock;
+
+        private:
+            /**
+             * @brief Timer that makes a session ready when it expires
+             */
+            struct timer
+            {
+                clock::time_point due;
+                Session* session;
+
+                bool operator>(const timer& other) const { return due > other.due; }
+            };
+
+            /**
+             * @brief Sessions that are ready in the order they became ready.
+             */
+            std::deque<Session*> ready;
+
+            /**
+             * @brief Set of ready sessions to avoid duplicates in the queue.
+             */
+            std::unordered_set<Session*> ready_set;
+
+            /**
+             * @brief Pending timers. The earliest timer is on top.
+             */
+            std::priority_queue<timer, std::vector<timer>, std::greater<timer>> timers;
+
+            /**
+             * @brief Due time of the armed timer of every session. A session has one armed timer at most,
+             * entries in timers with a different due time were replaced and are skipped.
+             */
+            std::unordered_map<Session*, clock::time_point> armed;
+
+        public:
+            /**
+             * @brief Default constructor
+             */
+            RunQueue() = default;
+
+            /**
+             * @brief Deleted copy constructor
+             */
+            RunQueue(const RunQueue&) = delete;
+
+            /**
+             * @brief Marks a session as ready. Does nothing if it is already ready.
+             * 
+             * @param session The session
+             */
+            void MarkReady(Session* session);
+
+            /**
+             * @brief Marks the session as ready once the time is reached. Does nothing if the session
+             * already has a timer that expires at that time or earlier.
+             * 
+             * @param session The session
+             * @param due When the session should become ready
+             */
+            void ScheduleTimer(Session* session, clock::time_point due);
+
+            /**
+             * @brief Moves the sessions of all expired timers into the ready queue.
+             * 
+             * @param now The current time
+             */
+            void ExpireTimers(clock::time_point now);
+
+            /**
+             * @brief Extract the next ready session.
+             * 
+             * @return Session* The session or nullptr if no session is ready
+             */
+            Session* Extract();
+
+            /**
+             * @brief Get the amount of ready sessions
+             * 
+             * @return unsigned int Ready sessions
+             */
+            unsigned int ReadyCount();
+
+            /**
+             * @brief Get the time until the next timer expires
+             * 
+             * @param now The current time
+             * @param max Upper bound that is returned when there is no earlier timer
+             * @return std::chrono::milliseconds Time until the next timer
+             */
+            std::chrono::milliseconds TimeUntilNextTimer(clock::time_point now, std::chrono::milliseconds max);
+
+            /**
+             * @brief Removes all sessions and timers.
+             */
+            void Clear();
+    };
+}
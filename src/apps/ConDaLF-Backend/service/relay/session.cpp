@@ -3,6 +3,7 @@
 #include <cstring>
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 
 #include "session.hpp"
 
@@ -13,16 +14,29 @@ TODO:
 Missed messages zwischenspeichern?
 */
 
-Session::Session()
+Session::Session(RunQueue* _run_queue)
 {
+    run_queue = _run_queue;
+    reconnect_time = RunQueue::clock::time_point::min();
+    reconnect_backoff = std::chrono::milliseconds(CONDALF_SESSION_MIN_RECONNECT_BACKOFF);
     host = "";
     port = "";
+    proto = COAP_PROTO_UDP;
     disconnected = false;
+    block_szx.store(CONDALF_SESSION_DEFAULT_BLOCK_SZX);
+    max_block_szx = CONDALF_SESSION_DEFAULT_BLOCK_SZX;
+    success_streak = 0;
     session = COAP_INVALID_RVALUE;
     context = -1;
     transmit_queue = new MessageQueue();
     retransmit_queue = new MessageQueue();
     pending_message = nullptr;
+
+    // Encode the Block1 option once for every block size
+    for (unsigned int szx = 0; szx <= COAP_MAX_BLOCK_SZX; szx++)
+        block1_option_lengths[szx] = coap_encode_var_safe(block1_options[szx],
+                                                          sizeof(block1_options[szx]),
+                                                          ((0 << 4) | (0 << 3) | szx)); // block.num = 0, block.m = (set by coap)
 }
 
 Session::~Session()
@@ -32,24 +46,27 @@ Session::~Session()
     delete retransmit_queue;
 
     if (pending_message != nullptr)
-    {
-        delete[] pending_message->data;
         delete pending_message;
-    }
 }
 
-bool Session::Connect(common::CoAP::context_descriptor _context, const std::string& _host, const std::string& _port)
+bool Session::Connect(common::CoAP::context_descriptor _context,
+                      const std::string& _host,
+                      const std::string& _port,
+                      coap_proto_t _proto,
+                      const common::CoAP::security_config& _security)
 {
-    // Save values
+    // Save values (the coap session keeps using host and security)
     host = _host;
     port = _port;
+    proto = _proto;
+    security = _security;
     context = _context;
 
     // Get the CoAP instance
     auto coap = &common::CoAP::getInstance();
 
     // Create a session
-    session = coap->CreateSession(_context, _host, _port);
+    session = coap->CreateSession(context, host, port, proto, &security);
 
     if (session == COAP_INVALID_RVALUE)
     {
@@ -60,10 +77,37 @@ bool Session::Connect(common::CoAP::context_descriptor _context, const std::stri
     return true;
 }
 
+bool Session::IsReliable()
+{
+    return proto == COAP_PROTO_TCP || proto == COAP_PROTO_TLS;
+}
+
 bool Session::Reconnect()
 {
     Disconnect();
-    return Connect(context, host, port);
+    return Connect(context, host, port, proto, security);
+}
+
+bool Session::TryReconnect(RunQueue::clock::time_point now)
+{
+    // Wait until the backoff time has passed
+    if (now < reconnect_time)
+    {
+        if (run_queue != nullptr)
+            run_queue->ScheduleTimer(this, reconnect_time);
+        return false;
+    }
+
+    // The next attempt has to wait longer unless a message gets through in between
+    reconnect_time = now + reconnect_backoff;
+    reconnect_backoff = std::min(reconnect_backoff * 2, std::chrono::milliseconds(CONDALF_SESSION_MAX_RECONNECT_BACKOFF));
+    if (!Reconnect())
+    {
+        if (run_queue != nullptr)
+            run_queue->ScheduleTimer(this, reconnect_time);
+        return false;
+    }
+    return true;
 }
 
 void Session::Disconnect()
@@ -74,11 +118,16 @@ void Session::Disconnect()
     disconnected = true;
 }
 
+void Session::notify_ready()
+{
+    if (run_queue != nullptr)
+        run_queue->MarkReady(this);
+}
+
 void Session::delete_pending_message()
 {
     if (pending_message != nullptr)
     {
-        delete[] pending_message->data;
         delete pending_message;
         pending_message = nullptr;
     }
@@ -89,48 +138,78 @@ const char* Session::session_str()
     return coap_session_str(session);
 }
 
-bool Session::send_message(const MessageQueue::Message& msg)
+const Session::pdu_template& Session::get_pdu_template(const std::string& uri)
+{
+    auto it = pdu_templates.find(uri);
+    if (it != pdu_templates.end())
+        return it->second;
+
+    // Split the path only once per URI
+    pdu_template entry;
+    std::stringstream ss_path(uri.c_str());
+    std::string uri_segment;
+    while(std::getline(ss_path, uri_segment, '/'))
+        entry.uri_path.push_back(uri_segment);
+    return pdu_templates.emplace(uri, std::move(entry)).first->second;
+}
+
+coap_pdu_t* Session::BuildPDU(const MessageQueue::Message& msg)
 {
     // Create PDU
     auto pdu = coap_new_pdu(msg.type, msg.code, session);
     if (pdu == COAP_INVALID_RVALUE)
     {
         common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create pdu.");
-        return false;
+        return nullptr;
     }
 
     // Add Path
-    std::stringstream ss_path(msg.uri.c_str());
-    std::string uri_segment;
-    while(std::getline(ss_path, uri_segment, '/'))
+    const pdu_template& uri_template = get_pdu_template(msg.uri);
+    for (const auto& uri_segment : uri_template.uri_path)
         coap_add_option(pdu,
                         COAP_OPTION_URI_PATH,
                         uri_segment.length(),
                         reinterpret_cast<const uint8_t *>(uri_segment.c_str()));
 
-    // Add Data to PDU
-    if (msg.data_size != 0)
+    // Options of the payload
+    if (msg.data != nullptr && msg.data->size() != 0)
     {
+        // Tell the upstream how to decode the payload
+        unsigned char content_format[2] = {};
+        coap_add_option(pdu,
+                        COAP_OPTION_CONTENT_FORMAT,
+                        coap_encode_var_safe(content_format, sizeof(content_format), msg.content_format),
+                        content_format);
+
         // We prefer to always use block-wise transfer. This way our response handler will get called.
-        unsigned char buf[4] = {};
+        unsigned int szx = block_szx.load();
         coap_add_option(pdu,
                         COAP_OPTION_BLOCK1,
-                        coap_encode_var_safe(buf,
-                                            sizeof(buf),
-                                            ((0 << 4) | (0 << 3) | COAP_MAX_BLOCK_SZX)), // block.num = 0, block.m = (set by coap), block.size = max because reliable transmission
-                        buf);
+                        block1_option_lengths[szx],
+                        block1_options[szx]);
+    }
+    return pdu;
+}
 
-        // Copy data for block-wise transfer
-        uint8_t* data_copy = new uint8_t[msg.data_size];
-        std::memcpy(data_copy, msg.data, msg.data_size);
+bool Session::send_message(const MessageQueue::Message& msg)
+{
+    coap_pdu_t* pdu = BuildPDU(msg);
+    if (pdu == nullptr)
+        return false;
+
+    // Add Data to PDU
+    if (msg.data != nullptr && msg.data->size() != 0)
+    {
+        // Hold a reference to the payload until libcoap is done with the block-wise transfer
+        auto payload_reference = new std::shared_ptr<const std::vector<uint8_t>>(msg.data);
 
         // Add large data to PDU
         if (!coap_add_data_large_request(session, 
                                         pdu,
-                                        msg.data_size, 
-                                        data_copy, 
-                                        [](coap_session_t* session, void* data) { delete[] (uint8_t*)data; },
-                                        data_copy))
+                                        msg.data->size(), 
+                                        msg.data->data(), 
+                                        [](coap_session_t* session, void* data) { delete (std::shared_ptr<const std::vector<uint8_t>>*)data; },
+                                        payload_reference))
         {
             coap_delete_pdu(pdu);
             common::logging::log_error(std::cerr, LINE_INFORMATION, "Relay could not add data to PDU.");
@@ -147,16 +226,12 @@ bool Session::send_message(const MessageQueue::Message& msg)
 
 void Session::EnqueueMessage(const MessageQueue::Message& msg)
 {
-    // Copy msg
-    MessageQueue::Message* msg_copy = new MessageQueue::Message();
-    *msg_copy = msg;
-
-    // Copy data
-    msg_copy->data = new u_int8_t[msg.data_size];
-    std::memcpy(msg_copy->data, msg.data, msg.data_size);
+    // Copy msg (the payload itself is shared)
+    MessageQueue::Message* msg_copy = new MessageQueue::Message(msg);
 
     // Insert into transmit queue
     transmit_queue->Insert(msg_copy);
+    notify_ready();
 }
 
 bool Session::IsConnected()
@@ -164,6 +239,11 @@ bool Session::IsConnected()
     return !disconnected && session != COAP_INVALID_RVALUE;
 }
 
+std::string Session::GetAddress()
+{
+    return host + ":" + port;
+}
+
 common::CoAP::session_ptr Session::GetRawSessionPtr()
 {
     return session;
@@ -176,8 +256,20 @@ void Session::NotifySuccess()
         return;
     common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Server received the message successfully on ") + session_str());
 
-    // Delete pending message
+    // Delete pending message and send the next one
     delete_pending_message();
+    reconnect_backoff = std::chrono::milliseconds(CONDALF_SESSION_MIN_RECONNECT_BACKOFF);
+    notify_ready();
+
+    // Grow the block size again after enough transfers went through without loss
+    if (++success_streak < CONDALF_SESSION_BLOCK_GROW_THRESHOLD)
+        return;
+    success_streak = 0;
+    if (block_szx.load() < max_block_szx)
+    {
+        block_szx.store(block_szx.load() + 1);
+        common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Increased block size to ") + std::to_string(GetBlockSize()) + " on " + session_str());
+    }
 }
 
 void Session::NotifyFailure()
@@ -190,6 +282,70 @@ void Session::NotifyFailure()
     // Put the message in the retransmit queue
     retransmit_queue->Insert(pending_message);
     pending_message = nullptr;
+    notify_ready();
+}
+
+void Session::NotifyLoss()
+{
+    // Every loss restarts the growth phase
+    success_streak = 0;
+
+    // TCP retransmits lost segments itself, smaller blocks would only add round trips
+    if (IsReliable() || block_szx.load() <= CONDALF_SESSION_MIN_BLOCK_SZX)
+        return;
+
+    // Smaller blocks are less likely to be fragmented or dropped
+    block_szx.store(block_szx.load() - 1);
+    common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Decreased block size to ") + std::to_string(GetBlockSize()) + " on " + session_str());
+}
+
+void Session::NotifyBlockSizeHint(unsigned int szx)
+{
+    success_streak = 0;
+
+    // The server told us its limit -> never grow past it
+    unsigned int used_szx = block_szx.load();
+    if (szx < max_block_szx)
+        max_block_szx = std::max(szx, (unsigned int)CONDALF_SESSION_MIN_BLOCK_SZX);
+    if (block_szx.load() > max_block_szx)
+        block_szx.store(max_block_szx);
+
+    // Sending the same blocks again would only get the same answer
+    if (block_szx.load() >= used_szx)
+    {
+        NotifyRejected();
+        return;
+    }
+
+    // Retransmit with the new block size
+    common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("Server requested smaller blocks. Using block size ") + std::to_string(GetBlockSize()) + " on " + session_str());
+    NotifyFailure();
+}
+
+void Session::NotifyRejected()
+{
+    // Check for valid pending message
+    if (pending_message == nullptr)
+        return;
+    common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Server rejected a message to ") + pending_message->uri + " on " + session_str() + ". Dropping message.");
+
+    // Drop the message and send the next one
+    delete_pending_message();
+    notify_ready();
+}
+
+void Session::SetBlockSize(unsigned int szx)
+{
+    if (szx > COAP_MAX_BLOCK_SZX)
+        szx = COAP_MAX_BLOCK_SZX;
+    max_block_szx = szx;
+    block_szx.store(szx);
+    success_streak = 0;
+}
+
+unsigned int Session::GetBlockSize()
+{
+    return 1u << (block_szx.load() + 4);
 }
 
 bool Session::Transmit()
@@ -214,6 +370,10 @@ bool Session::Transmit()
         // We could not send the message
         common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not send message when trying to transmit.");
         delete_pending_message();
+
+        // Try the next message on the next run
+        if (!retransmit_queue->IsEmpty() || !transmit_queue->IsEmpty())
+            notify_ready();
         return false;
     }
     return true;
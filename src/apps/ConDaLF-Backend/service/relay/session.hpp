@@ -11,9 +11,20 @@
 
 #pragma once
 
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <common/coap/coap.hpp>
 
 #include "message_queue.hpp"
+#include "run_queue.hpp"
+
+#define CONDALF_SESSION_MIN_BLOCK_SZX 0             // 16 bytes
+#define CONDALF_SESSION_DEFAULT_BLOCK_SZX COAP_MAX_BLOCK_SZX
+#define CONDALF_SESSION_BLOCK_GROW_THRESHOLD 8      // Successful transfers before the block size is increased
+#define CONDALF_SESSION_MIN_RECONNECT_BACKOFF 500   // milliseconds
+#define CONDALF_SESSION_MAX_RECONNECT_BACKOFF 60000 // milliseconds
 
 /**
  * TODO: What about a maximum queue size?
@@ -25,6 +36,29 @@ namespace condalf::service
     class Session
     {
         private:
+            /**
+             * @brief Prebuilt options for a destination URI. Built once and reused for every message.
+             */
+            struct pdu_template
+            {
+                std::vector<std::string> uri_path; // Already split Uri-Path option values
+            };
+
+            /**
+             * @brief PDU templates by destination URI.
+             */
+            std::unordered_map<std::string, pdu_template> pdu_templates;
+
+            /**
+             * @brief Encoded Block1 option (block.num = 0) for every block size exponent.
+             */
+            uint8_t block1_options[COAP_MAX_BLOCK_SZX + 1][4];
+
+            /**
+             * @brief Lengths of the encoded Block1 options.
+             */
+            size_t block1_option_lengths[COAP_MAX_BLOCK_SZX + 1];
+
             /**
              * @brief The raw session pointer.
              */
@@ -60,11 +94,57 @@ namespace condalf::service
              */
             std::string port;
 
+            /**
+             * @brief Transport used for this session
+             */
+            coap_proto_t proto;
+
+            /**
+             * @brief Credentials for secured transports
+             */
+            common::CoAP::security_config security;
+
             /**
              * @brief Flag set when the session is disconnected
              */
             bool disconnected;
 
+            /**
+             * @brief Block1 size exponent (SZX) currently used for transfers on this session.
+             */
+            std::atomic_uint block_szx;
+
+            /**
+             * @brief Upper bound for the block size exponent. Starts at the configured value
+             * and is lowered when the server tells us about a smaller limit.
+             */
+            unsigned int max_block_szx;
+
+            /**
+             * @brief Successful transfers since the block size was last changed.
+             */
+            unsigned int success_streak;
+
+            /**
+             * @brief Run queue that gets notified when this session has work to do.
+             */
+            RunQueue* run_queue;
+
+            /**
+             * @brief Earliest time for the next reconnect attempt.
+             */
+            RunQueue::clock::time_point reconnect_time;
+
+            /**
+             * @brief Time to wait before the next reconnect attempt. Doubles on every attempt.
+             */
+            std::chrono::milliseconds reconnect_backoff;
+
+            /**
+             * @brief Puts this session into the run queue.
+             */
+            void notify_ready();
+
             /**
              * @brief Deletes the pending message and sets it to nullptr.
              * 
@@ -78,6 +158,14 @@ namespace condalf::service
              */
             const char* session_str();
 
+            /**
+             * @brief Get the PDU template for the URI. Creates it on first use.
+             * 
+             * @param uri Destination URI
+             * @return const pdu_template& The template
+             */
+            const pdu_template& get_pdu_template(const std::string& uri);
+
             /**
              * @brief Send the message over the session.
              * 
@@ -90,8 +178,10 @@ namespace condalf::service
         public:
             /**
              * @brief Construct a new Session object.
+             * 
+             * @param _run_queue Run queue that gets notified about events of this session (may be nullptr)
              */ 
-            Session();
+            Session(RunQueue* _run_queue = nullptr);
 
             /**
              * @brief Deleted copy constructor.
@@ -109,10 +199,33 @@ namespace condalf::service
              * @param _context Context the session will be used in.
              * @param _host Host address
              * @param _port Port to connect to
+             * @param _proto Transport to use (UDP, TCP or TLS)
+             * @param _security Credentials for secured transports
              * @return true Could resolve address and create a session.
              * @return false Could not resolve address or create a session.
              */
-            bool Connect(common::CoAP::context_descriptor _context, const std::string& _host, const std::string& _port);
+            bool Connect(common::CoAP::context_descriptor _context,
+                         const std::string& _host,
+                         const std::string& _port,
+                         coap_proto_t _proto = COAP_PROTO_UDP,
+                         const common::CoAP::security_config& _security = {});
+
+            /**
+             * @brief Creates the PDU of a message with its Uri-Path, Content-Format and Block1 options
+             * from the template of its URI. The payload is not added.
+             * 
+             * @param msg The message
+             * @return coap_pdu_t* The PDU, nullptr on failure
+             */
+            coap_pdu_t* BuildPDU(const MessageQueue::Message& msg);
+
+            /**
+             * @brief Checks if the session uses a reliable transport (TCP or TLS).
+             * 
+             * @return true Reliable transport
+             * @return false Datagram transport
+             */
+            bool IsReliable();
 
             /**
              * @brief Reconnects to the once given host and port.
@@ -122,6 +235,16 @@ namespace condalf::service
              */
             bool Reconnect();
 
+            /**
+             * @brief Reconnects if the backoff time has passed. Otherwise a timer is set in the
+             * run queue so that the session gets ready again when it may reconnect.
+             * 
+             * @param now The current time
+             * @return true The session got reconnected
+             * @return false The session has to wait or the reconnect failed
+             */
+            bool TryReconnect(RunQueue::clock::time_point now);
+
             /**
              * @brief Disconnect the session.
              */
@@ -142,6 +265,13 @@ namespace condalf::service
              */
             bool IsConnected();
 
+            /**
+             * @brief Get the configured address of this session.
+             * 
+             * @return std::string host:port
+             */
+            std::string GetAddress();
+
             /**
              * @brief Get the Raw Session Pointer.
              * 
@@ -162,6 +292,42 @@ namespace condalf::service
              */
             void NotifyFailure();
 
+            /**
+             * @brief Notify to the session that a block got lost on the way (too many retries).
+             * The block size will be decreased for the following transfers unless the transport is reliable.
+             */
+            void NotifyLoss();
+
+            /**
+             * @brief Notify to the session that the server answered with 4.13 (Request Entity Too Large).
+             * The block size is limited to the hinted size and the message will be retransmitted if the
+             * blocks got smaller. Otherwise the message itself is too large and gets dropped.
+             * 
+             * @param szx Block size exponent from the Block1 option of the response
+             */
+            void NotifyBlockSizeHint(unsigned int szx);
+
+            /**
+             * @brief Notify to the session that the server will never accept the last sent message.
+             * The message is dropped and the session will try to transmit the next message.
+             */
+            void NotifyRejected();
+
+            /**
+             * @brief Set the block size that the session should start with. This is also the
+             * largest block size the session will grow to.
+             * 
+             * @param szx Block size exponent (0 -> 16 bytes, 6 -> 1024 bytes)
+             */
+            void SetBlockSize(unsigned int szx);
+
+            /**
+             * @brief Get the currently used block size
+             * 
+             * @return unsigned int Block size in bytes
+             */
+            unsigned int GetBlockSize();
+
             /**
              * @brief Transmit the next message if possible. (Will first try to retransmit)
              * 
@@ -19,9 +19,25 @@ COAP_RESPONSE_HANDLER(response_handler)
         return COAP_RESPONSE_FAIL;
     }
 
-    // Notify the session
+    // Find the session
     auto session_manager = &SessionManager::getInstance();
     Session* s = session_manager->FindSession(session);
+    if (s == nullptr)
+        return COAP_RESPONSE_OK;
+
+    // Server cannot handle our block size -> it tells us the size it can handle (RFC 7959 2.9.3)
+    coap_block_t hint;
+    if (coap_pdu_get_code(received) == COAP_RESPONSE_CODE_REQUEST_TOO_LARGE)
+    {
+        // Without a hint the size of the whole payload is too large
+        if (coap_get_block(received, COAP_OPTION_BLOCK1, &hint))
+            s->NotifyBlockSizeHint(hint.szx);
+        else
+            s->NotifyRejected();
+        return COAP_RESPONSE_OK;
+    }
+
+    // Notify the session
     s->NotifySuccess();
     return COAP_RESPONSE_OK;
 }
@@ -67,7 +83,12 @@ COAP_NACK_HANDLER(nack_handler)
                                      LINE_INFORMATION, 
                                      std::string("Too many retries for PDU on ") + session_str);
         if (relay_session != nullptr)
+        {
+            // Blocks got lost -> use smaller ones for the next attempt
+            if (data_transmit)
+                relay_session->NotifyLoss();
             relay_session->Disconnect();
+        }
         break;
     case COAP_NACK_NOT_DELIVERABLE: // Happens when we lose connection
         common::logging::log_warning(std::cout, 
@@ -100,7 +121,7 @@ COAP_NACK_HANDLER(nack_handler)
     }
 
     // Notify session when it was a data transmit
-    if (data_transmit)
+    if (data_transmit && relay_session != nullptr)
         relay_session->NotifyFailure();
 
     return;
@@ -0,0 +1,102 @@
+/**
+ * @file pdu_benchmark.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Time to build a relay PDU from the URI template compared to parsing the URI per message
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/relay/session.hpp>
+
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#define PDU_BENCHMARK_ROUNDS 100000
+
+using namespace condalf::service;
+using bench_clock = std::chrono::steady_clock;
+
+/**
+ * @brief Builds a PDU the way the relay did before the templates: the URI is split for every message
+ * and the Block1 option is encoded again
+ * 
+ * @param session The CoAP session
+ * @param msg The message
+ * @param szx Block size exponent
+ * @return coap_pdu_t* The PDU
+ */
+static coap_pdu_t* build_parsed(coap_session_t* session, const MessageQueue::Message& msg, unsigned int szx)
+{
+    auto pdu = coap_new_pdu(msg.type, msg.code, session);
+    if (pdu == nullptr)
+        return nullptr;
+
+    std::stringstream ss_path(msg.uri.c_str());
+    std::string uri_segment;
+    while(std::getline(ss_path, uri_segment, '/'))
+        coap_add_option(pdu, COAP_OPTION_URI_PATH, uri_segment.length(), reinterpret_cast<const uint8_t *>(uri_segment.c_str()));
+
+    unsigned char content_format[2] = {};
+    coap_add_option(pdu, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(content_format, sizeof(content_format), msg.content_format), content_format);
+
+    unsigned char buf[4] = {};
+    coap_add_option(pdu, COAP_OPTION_BLOCK1, coap_encode_var_safe(buf, sizeof(buf), ((0 << 4) | (0 << 3) | szx)), buf);
+    return pdu;
+}
+
+/**
+ * @brief Get the nanoseconds per PDU of a builder
+ * 
+ * @param build Builds one PDU
+ * @return double Nanoseconds per PDU
+ */
+template <typename Builder>
+static double time_builder(Builder build)
+{
+    auto begin = bench_clock::now();
+    for (unsigned int i = 0; i < PDU_BENCHMARK_ROUNDS; i++)
+    {
+        coap_pdu_t* pdu = build();
+        if (pdu == nullptr)
+            throw std::runtime_error(LINE_INFORMATION + std::string("\tCould not build PDU"));
+        coap_delete_pdu(pdu);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - begin);
+    return static_cast<double>(elapsed.count()) / PDU_BENCHMARK_ROUNDS;
+}
+
+TEST_CASE(pdu_build_time)
+{
+    common::CoAP *coap = &common::CoAP::getInstance();
+    common::CoAP::context_descriptor context = coap->CreateContext(true);
+    ASSERT_TRUE(context >= 0);
+    {
+        // No peer is needed, the PDUs are never sent
+        Session session(nullptr);
+        ASSERT_TRUE(session.Connect(context, "127.0.0.1", "5683"));
+
+        MessageQueue::Message msg;
+        msg.type = COAP_MESSAGE_CON;
+        msg.code = COAP_REQUEST_CODE_PUT;
+        msg.uri = "tenants/lab/condalf/data";
+        msg.content_format = COAP_MEDIATYPE_APPLICATION_SENML_CBOR;
+        msg.data = std::make_shared<const std::vector<uint8_t>>(512, 0xa5);
+
+        unsigned int szx = COAP_MAX_BLOCK_SZX;
+        double parsed = time_builder([&] { return build_parsed(session.GetRawSessionPtr(), msg, szx); });
+        double templated = time_builder([&] { return session.BuildPDU(msg); });
+
+        std::cout << "PDU build time: parsed per message " << parsed << " ns, from template " << templated << " ns" << std::endl;
+        session.Disconnect();
+    }
+    coap->ReleaseContext(context);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(pdu_build_time);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,80 @@
+/**
+ * @file run_queue_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the relay run queue
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/relay/run_queue.hpp>
+
+using namespace condalf::service;
+
+// The run queue never dereferences its sessions
+static Session* const session_a = reinterpret_cast<Session*>(0x10);
+static Session* const session_b = reinterpret_cast<Session*>(0x20);
+
+TEST_CASE(ready_sessions_are_unique)
+{
+    RunQueue queue;
+    queue.MarkReady(session_a);
+    queue.MarkReady(session_a);
+    queue.MarkReady(session_b);
+    ASSERT_EQUAL(queue.ReadyCount(), 2u);
+    ASSERT_TRUE(queue.Extract() == session_a);
+    ASSERT_TRUE(queue.Extract() == session_b);
+    ASSERT_TRUE(queue.Extract() == nullptr);
+}
+
+TEST_CASE(timers_make_sessions_ready)
+{
+    RunQueue queue;
+    auto now = RunQueue::clock::now();
+    queue.ScheduleTimer(session_a, now + std::chrono::milliseconds(50));
+    ASSERT_EQUAL(queue.TimeUntilNextTimer(now, std::chrono::milliseconds(100)).count(), 50);
+
+    queue.ExpireTimers(now);
+    ASSERT_EQUAL(queue.ReadyCount(), 0u);
+    queue.ExpireTimers(now + std::chrono::milliseconds(60));
+    ASSERT_EQUAL(queue.ReadyCount(), 1u);
+    ASSERT_EQUAL(queue.TimeUntilNextTimer(now, std::chrono::milliseconds(100)).count(), 100);
+}
+
+TEST_CASE(one_timer_per_session)
+{
+    RunQueue queue;
+    auto now = RunQueue::clock::now();
+    auto due = now + std::chrono::milliseconds(50);
+
+    // A session that waits for its backoff schedules the same timer on every pass
+    for (int i = 0; i < 1000; i++)
+        queue.ScheduleTimer(session_a, due);
+    queue.ScheduleTimer(session_a, due + std::chrono::milliseconds(10));
+    queue.ExpireTimers(due + std::chrono::milliseconds(20));
+    ASSERT_EQUAL(queue.ReadyCount(), 1u);
+    ASSERT_EQUAL(queue.TimeUntilNextTimer(now, std::chrono::milliseconds(100)).count(), 100);
+    queue.Extract();
+
+    // An earlier timer replaces a later one, the later one does not fire anymore
+    queue.ScheduleTimer(session_b, now + std::chrono::milliseconds(80));
+    queue.ScheduleTimer(session_b, now + std::chrono::milliseconds(30));
+    queue.ExpireTimers(now + std::chrono::milliseconds(40));
+    ASSERT_TRUE(queue.Extract() == session_b);
+    queue.ExpireTimers(now + std::chrono::milliseconds(90));
+    ASSERT_EQUAL(queue.ReadyCount(), 0u);
+
+    // The session can be armed again once its timer fired
+    queue.ScheduleTimer(session_b, now + std::chrono::milliseconds(100));
+    queue.ExpireTimers(now + std::chrono::milliseconds(100));
+    ASSERT_EQUAL(queue.ReadyCount(), 1u);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(ready_sessions_are_unique);
+    TEST_CASE_RUN(timers_make_sessions_ready);
+    TEST_CASE_RUN(one_timer_per_session);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,122 @@
+/**
+ * @file transport_benchmark.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Relay throughput over UDP and over TCP to a local peer
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/relay/relay.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define TRANSPORT_BENCHMARK_PAYLOADS 200
+#define TRANSPORT_BENCHMARK_PAYLOAD_SIZE 4096
+#define TRANSPORT_BENCHMARK_TIMEOUT 60      // Seconds until the benchmark gives up
+#define TRANSPORT_BENCHMARK_UDP_PORT "15783"
+#define TRANSPORT_BENCHMARK_TCP_PORT "15784"
+
+using namespace condalf::service;
+using bench_clock = std::chrono::steady_clock;
+
+std::atomic_uint64_t g_received;    // Complete payloads the peer received
+
+/**
+ * @brief Counts the complete payloads. The peer lets libcoap reassemble the blocks, which works over TCP as well.
+ */
+COAP_RESOURCE_HANDLER(handle_bench)
+{
+    size_t length = 0, offset = 0, total = 0;
+    const uint8_t *data = nullptr;
+    if (coap_get_data_large(request, &length, &data, &offset, &total) && offset + length == total && total == TRANSPORT_BENCHMARK_PAYLOAD_SIZE)
+        g_received++;
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CHANGED);
+}
+
+/**
+ * @brief Relays the payloads to the peer through one upstream
+ * 
+ * @param upstream The relay configuration line
+ * @return double Payloads per second
+ */
+static double relay_payloads(const std::string& upstream)
+{
+    std::string config_file = std::string("relay_benchmark_") + std::to_string(std::hash<std::string>()(upstream)) + ".conf";
+    {
+        std::ofstream config(config_file);
+        config << upstream << std::endl;
+    }
+
+    MessageQueue queue;
+    Relay relay(&queue);
+    if (!relay.Start(config_file))
+        throw std::runtime_error(LINE_INFORMATION + std::string("\tCould not start relay for ") + upstream);
+
+    g_received.store(0);
+    auto payload = std::make_shared<const std::vector<uint8_t>>(TRANSPORT_BENCHMARK_PAYLOAD_SIZE, 0x5a);
+    auto begin = bench_clock::now();
+    for (unsigned int i = 0; i < TRANSPORT_BENCHMARK_PAYLOADS; i++)
+        queue.Insert(new MessageQueue::Message{ COAP_MESSAGE_CON, COAP_REQUEST_CODE_PUT, "bench", COAP_MEDIATYPE_APPLICATION_CBOR, payload });
+
+    auto deadline = begin + std::chrono::seconds(TRANSPORT_BENCHMARK_TIMEOUT);
+    while (g_received.load() < TRANSPORT_BENCHMARK_PAYLOADS && bench_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double seconds = std::chrono::duration<double>(bench_clock::now() - begin).count();
+    uint64_t received = g_received.load();
+
+    relay.Stop();
+    std::remove(config_file.c_str());
+    ASSERT_EQUAL(received, TRANSPORT_BENCHMARK_PAYLOADS);
+    return TRANSPORT_BENCHMARK_PAYLOADS / seconds;
+}
+
+TEST_CASE(udp_and_tcp_throughput)
+{
+    common::CoAP *coap = &common::CoAP::getInstance();
+    common::CoAP::context_descriptor peer = coap->CreateContext(true);
+    ASSERT_TRUE(peer >= 0);
+    ASSERT_TRUE(coap->CreateEndpoint(peer, "127.0.0.1", TRANSPORT_BENCHMARK_UDP_PORT));
+    ASSERT_TRUE(coap->CreateEndpoint(peer, "127.0.0.1", TRANSPORT_BENCHMARK_TCP_PORT, nullptr, COAP_PROTO_TCP));
+
+    common::CoAP::resource_ptr resource = coap->CreateResource("bench");
+    ASSERT_TRUE(coap->RegisterResourceHandler(resource, COAP_REQUEST_PUT, handle_bench));
+    ASSERT_TRUE(coap->AddResource(peer, resource));
+
+    std::atomic_bool stop(false);
+    std::thread io([&] {
+        while (!stop.load())
+            coap->IO(peer, 100);
+    });
+
+    double udp = 0, tcp = 0;
+    try
+    {
+        udp = relay_payloads(std::string("coap://127.0.0.1:") + TRANSPORT_BENCHMARK_UDP_PORT);
+        tcp = relay_payloads(std::string("coap+tcp://127.0.0.1:") + TRANSPORT_BENCHMARK_TCP_PORT);
+    }
+    catch (...)
+    {
+        stop.store(true);
+        io.join();
+        coap->ReleaseContext(peer);
+        throw;
+    }
+
+    stop.store(true);
+    io.join();
+    coap->ReleaseContext(peer);
+    std::cout << "Relay throughput with " << TRANSPORT_BENCHMARK_PAYLOAD_SIZE << " byte payloads: UDP " << udp << " payloads/s, TCP " << tcp << " payloads/s" << std::endl;
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(udp_and_tcp_throughput);
+TEST_MODULE_END
\ No newline at end of file
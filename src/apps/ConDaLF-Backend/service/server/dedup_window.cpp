@@ -0,0 +1,215 @@
+/**
+ * @file dedup_window.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-20
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "dedup_window.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <sstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+using namespace condalf::service;
+
+/**
+ * @brief CRC32C with a table, one byte at a time
+ * 
+ * @param data The buffer
+ * @param size Size of the buffer
+ * @param crc Inverted CRC of the data before
+ * @return uint32_t Inverted CRC
+ */
+static uint32_t crc32c_table(const uint8_t* data, std::size_t size, uint32_t crc)
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> generated = {};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++)
+                value = (value >> 1) ^ (0x82f63b78u & (0u - (value & 1)));
+            generated[i] = value;
+        }
+        return generated;
+    }();
+
+    for (std::size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief CRC32C with the SSE4.2 crc32 instruction. Only called if the CPU supports it.
+ * 
+ * @param data The buffer
+ * @param size Size of the buffer
+ * @param crc Inverted CRC of the data before
+ * @return uint32_t Inverted CRC
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hardware(const uint8_t* data, std::size_t size, uint32_t crc)
+{
+#if defined(__x86_64__)
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+    }
+#endif
+    for (; size >= 4; data += 4, size -= 4)
+    {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; size > 0; data++, size--)
+        crc = _mm_crc32_u8(crc, *data);
+    return crc;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+/**
+ * @brief CRC32C with the ARMv8 crc32c instructions
+ * 
+ * @param data The buffer
+ * @param size Size of the buffer
+ * @param crc Inverted CRC of the data before
+ * @return uint32_t Inverted CRC
+ */
+static uint32_t crc32c_hardware(const uint8_t* data, std::size_t size, uint32_t crc)
+{
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; size > 0; data++, size--)
+        crc = __crc32cb(crc, *data);
+    return crc;
+}
+#endif
+
+uint32_t condalf::service::crc32c(const uint8_t* data, std::size_t size, uint32_t crc)
+{
+    crc = ~crc;
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    crc = hardware ? crc32c_hardware(data, size, crc) : crc32c_table(data, size, crc);
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    crc = crc32c_hardware(data, size, crc);
+#else
+    crc = crc32c_table(data, size, crc);
+#endif
+    return ~crc;
+}
+
+DedupWindow::DedupWindow() : start(clock::now())
+{
+    checked.store(0);
+    duplicates.store(0);
+    replaced.store(0);
+}
+
+void DedupWindow::Configure(unsigned int _window, std::size_t entries)
+{
+    std::lock_guard guard(dedup_mutex);
+    window = static_cast<int64_t>(_window) * 1000;
+
+    std::size_t sets = 1;
+    while (sets * CONDALF_DEDUP_WAYS < entries)
+        sets <<= 1;
+    slots.assign(sets * CONDALF_DEDUP_WAYS, entry());
+}
+
+uint64_t DedupWindow::Key(std::string_view client, std::string_view path, const std::vector<uint8_t>& payload)
+{
+    // The payload CRC in the upper half, client, path and size in the lower half
+    uint32_t origin = crc32c(reinterpret_cast<const uint8_t*>(client.data()), client.size());
+    origin = crc32c(reinterpret_cast<const uint8_t*>("/"), 1, origin);
+    origin = crc32c(reinterpret_cast<const uint8_t*>(path.data()), path.size(), origin);
+    uint64_t key = (static_cast<uint64_t>(crc32c(payload.data(), payload.size())) << 32) |
+                   (origin ^ static_cast<uint32_t>(payload.size() * 0x9e3779b1u));
+    return key != 0 ? key : 1;
+}
+
+DedupWindow::entry* DedupWindow::set_of(uint64_t key)
+{
+    uint64_t mixed = key;
+    mixed ^= mixed >> 33;
+    mixed *= 0xff51afd7ed558ccdull;
+    mixed ^= mixed >> 33;
+
+    std::size_t sets = slots.size() / CONDALF_DEDUP_WAYS;
+    return &slots[(mixed & (sets - 1)) * CONDALF_DEDUP_WAYS];
+}
+
+bool DedupWindow::Seen(uint64_t key)
+{
+    std::lock_guard guard(dedup_mutex);
+    if (slots.empty())
+        return false;
+    checked++;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    entry* set = set_of(key);
+    for (std::size_t i = 0; i < CONDALF_DEDUP_WAYS; i++)
+    {
+        if (set[i].key == key && set[i].expires > now)
+        {
+            duplicates++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DedupWindow::Remember(uint64_t key)
+{
+    std::lock_guard guard(dedup_mutex);
+    if (slots.empty())
+        return;
+
+    // The entry of the key is renewed, otherwise the slot that expires first is taken
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    entry* set = set_of(key);
+    entry* victim = set;
+    for (std::size_t i = 0; i < CONDALF_DEDUP_WAYS; i++)
+    {
+        if (set[i].key == key)
+        {
+            victim = &set[i];
+            break;
+        }
+        if (set[i].expires < victim->expires)
+            victim = &set[i];
+    }
+
+    if (victim->key != 0 && victim->key != key && victim->expires > now)
+        replaced++;
+    victim->key = key;
+    victim->expires = now + window;
+}
+
+std::string DedupWindow::GetStatistics()
+{
+    std::stringstream stats;
+    stats << "checked=" << checked.load()
+          << " duplicates=" << duplicates.load()
+          << " replaced=" << replaced.load();
+    return stats.str();
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+/**
+ * @file dedup_window.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Suppresses payloads that a client uploads again
+ * @version 0.1
+ * @date 2021-07-20
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define CONDALF_DEDUP_ENTRIES 16384     // Payloads remembered at most
+#define CONDALF_DEDUP_WAYS 4            // Slots per set of the table
+
+namespace condalf::service
+{
+    /**
+     * @brief Computes the CRC32C (Castagnoli) of a buffer. The SSE4.2 or ARMv8 CRC instructions are used when
+     * the CPU has them, a table otherwise.
+     * 
+     * @param data The buffer
+     * @param size Size of the buffer
+     * @param crc CRC of the data before, 0 to start
+     * @return uint32_t The CRC
+     */
+    uint32_t crc32c(const uint8_t* data, std::size_t size, uint32_t crc = 0);
+
+    /**
+     * @brief Remembers the payloads of the last window seconds by client, path and CRC32C of the payload.
+     * A client that restarts an upload because the ACK of the last block went missing sends the same payload
+     * with a new message id. The payload is then acknowledged without being processed again.
+     * Checking and remembering are separate, a payload is only remembered once it was accepted.
+     * The table is set associative with a fixed size. Entries expire after the window, a full set replaces the
+     * entry that expires first.
+     */
+    class DedupWindow
+    {
+        public:
+            using clock = std::chrono::steady_clock;
+
+        private:
+            /**
+             * @brief A remembered payload
+             */
+            struct entry
+            {
+                uint64_t key = 0;           // 0 if the slot is free
+                int64_t expires = 0;        // Milliseconds since start
+            };
+
+            /**
+             * @brief Protects slots
+             */
+            std::mutex dedup_mutex;
+
+            /**
+             * @brief Sets of CONDALF_DEDUP_WAYS slots, the number of sets is a power of two
+             */
+            std::vector<entry> slots;
+
+            /**
+             * @brief Milliseconds an entry is kept
+             */
+            int64_t window = 0;
+
+            /**
+             * @brief Time the milliseconds are counted from
+             */
+            clock::time_point start;
+
+            std::atomic_uint64_t checked;       // Payloads that were checked
+            std::atomic_uint64_t duplicates;    // Payloads that were seen before
+            std::atomic_uint64_t replaced;      // Entries that were replaced before they expired
+
+            /**
+             * @brief Get the set of a key
+             * 
+             * @param key Key of a payload
+             * @return entry* First slot of the set, the table must not be empty
+             */
+            entry* set_of(uint64_t key);
+
+        public:
+            /**
+             * @brief Construct a new DedupWindow object
+             */
+            DedupWindow();
+
+            /**
+             * @brief Drops all entries and sets the size of the table
+             * 
+             * @param _window Seconds a payload is remembered
+             * @param entries Payloads remembered at most
+             */
+            void Configure(unsigned int _window, std::size_t entries);
+
+            /**
+             * @brief Get the key of a payload by client, path and CRC32C of the payload
+             * 
+             * @param client Identifies the client
+             * @param path Path of the request
+             * @param payload The payload
+             * @return uint64_t The key, never 0
+             */
+            static uint64_t Key(std::string_view client, std::string_view path, const std::vector<uint8_t>& payload);
+
+            /**
+             * @brief Checks if a payload was remembered within the window
+             * 
+             * @param key Key of the payload
+             * @return true If the payload is a duplicate
+             * @return false If it is new
+             */
+            bool Seen(uint64_t key);
+
+            /**
+             * @brief Remembers a payload for the window. Only payloads that were accepted should be remembered,
+             * so that a client that retries after an error is not answered as if its payload was processed.
+             * 
+             * @param key Key of the payload
+             */
+            void Remember(uint64_t key);
+
+            /**
+             * @brief Get the statistics of the window
+             * 
+             * @return std::string Checked payloads, duplicates and replaced entries
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+/**
+ * @file device_table.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "device_table.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+using namespace condalf::service;
+
+void DeviceTable::evict(int64_t now, std::size_t count)
+{
+    auto is_stale = [this, now](const device& entry) { return entry.last_seen + stale <= now; };
+    evicted += count != 0 ? devices.Sweep(count, is_stale) : devices.EraseIf(is_stale);
+}
+
+double DeviceTable::rate_at(const device& entry, int64_t now)
+{
+    return entry.rate * std::exp(-(now - entry.last_seen) / (CONDALF_DEVICE_RATE_WINDOW * 1000.0));
+}
+
+std::string DeviceTable::address_of(const device& entry)
+{
+    char text[INET6_ADDRSTRLEN] = {};
+    if (entry.length == 4 && inet_ntop(AF_INET, entry.address, text, sizeof(text)) != nullptr)
+        return text;
+    if (entry.length == 16 && inet_ntop(AF_INET6, entry.address, text, sizeof(text)) != nullptr)
+        return text;
+    return std::string((const char *)entry.address, entry.length);
+}
+
+DeviceTable::DeviceTable() : start(clock::now())
+{
+    recorded.store(0);
+    untracked.store(0);
+    evicted.store(0);
+}
+
+void DeviceTable::Configure(std::size_t _max_devices, unsigned int _stale)
+{
+    std::lock_guard guard(table_mutex);
+    stale = static_cast<int64_t>(std::max(_stale, 1u)) * 1000;
+    devices.Configure(_max_devices);
+}
+
+void DeviceTable::Record(std::string_view client, std::size_t bytes, bool complete, bool error)
+{
+    std::lock_guard guard(table_mutex);
+    if (devices.Slots() == 0)
+        return;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+    uint64_t key = OpenTable<device>::Key(client);
+    device* found = devices.Find(key);
+    if (found == nullptr)
+    {
+        if (devices.Full())
+            evict(now, CONDALF_OPEN_TABLE_SWEEP);
+        found = devices.Insert(key);
+        if (found == nullptr)
+        {
+            untracked++;
+            return;
+        }
+
+        found->first_seen = now;
+        found->last_seen = now;
+        found->length = static_cast<uint8_t>(std::min(client.size(), sizeof(found->address)));
+        std::memcpy(found->address, client.data(), found->length);
+    }
+
+    device& entry = *found;
+    entry.bytes += bytes;
+    if (complete)
+    {
+        // Every request adds 1/window and the sum decays with the window as time constant,
+        // which follows the request rate without keeping the times of past requests
+        entry.rate = static_cast<float>(rate_at(entry, now) + 1.0 / CONDALF_DEVICE_RATE_WINDOW);
+        entry.requests++;
+        if (error)
+            entry.errors++;
+    }
+    entry.last_seen = now;
+    recorded++;
+
+    // Check one slot per request, stale devices go away without a pass over the whole table.
+    // The device was just seen, so it is not dropped itself.
+    evict(now, 1);
+}
+
+std::string DeviceTable::Dump()
+{
+    std::vector<device> seen;
+    int64_t now = 0;
+    {
+        std::lock_guard guard(table_mutex);
+        now = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+        evict(now, 0);
+        seen.reserve(devices.Size());
+        for (std::size_t i = 0; i < devices.Slots(); i++)
+        {
+            if (devices.Slot(i).key != 0)
+                seen.push_back(devices.Slot(i));
+        }
+    }
+
+    std::sort(seen.begin(), seen.end(), [](const device& a, const device& b) { return a.last_seen > b.last_seen; });
+
+    std::stringstream dump;
+    dump << std::fixed;
+    for (const auto& entry : seen)
+    {
+        dump << address_of(entry)
+             << " seen=" << std::setprecision(1) << (now - entry.last_seen) / 1000.0 << "s"
+             << " since=" << (now - entry.first_seen) / 1000 << "s"
+             << " rate=" << std::setprecision(3) << rate_at(entry, now) << "/s"
+             << " requests=" << entry.requests
+             << " bytes=" << entry.bytes
+             << " avg=" << (entry.requests != 0 ? entry.bytes / entry.requests : entry.bytes)
+             << " errors=" << entry.errors << "\n";
+    }
+    return dump.str();
+}
+
+std::string DeviceTable::GetStatistics()
+{
+    std::size_t count = 0, max_devices = 0;
+    {
+        std::lock_guard guard(table_mutex);
+        count = devices.Size();
+        max_devices = devices.Capacity();
+    }
+
+    std::stringstream stats;
+    stats << "devices=" << count << "/" << max_devices
+          << " recorded=" << recorded.load()
+          << " untracked=" << untracked.load()
+          << " evicted=" << evicted.load();
+    return stats.str();
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * @file device_table.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Activity of every device that sends to the ingest resources
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "open_table.hpp"
+
+#define CONDALF_DEVICE_STALE 3600       // Seconds without requests after which a device is evicted
+#define CONDALF_DEVICE_RATE_WINDOW 60   // Time constant of the request rate in seconds
+
+namespace condalf::service
+{
+    /**
+     * @brief Keeps when every device (remote IP address) was last seen, its request rate and its bytes and errors.
+     * The entries have a fixed size and live in an open addressing table keyed by a hash of the device,
+     * so recording a request costs a lookup and a few additions. Every record also checks one slot for a stale
+     * entry, the table runs full only when all devices are active. A new device on a full table checks a few more
+     * slots, devices that still do not fit are counted only.
+     */
+    class DeviceTable
+    {
+        public:
+            using clock = std::chrono::steady_clock;
+
+        private:
+            /**
+             * @brief A device, 64 bytes
+             */
+            struct device
+            {
+                uint64_t key = 0;           // 0 if the slot is free
+                int64_t first_seen = 0;     // Milliseconds since start
+                int64_t last_seen = 0;      // Milliseconds since start
+                uint64_t bytes = 0;         // Payload bytes of all blocks
+                uint32_t requests = 0;      // Complete transfers
+                uint32_t errors = 0;        // Transfers answered with 4.xx or 5.xx
+                float rate = 0;             // Requests per second at last_seen
+                uint8_t length = 0;         // Bytes of address in use
+                uint8_t address[16] = {};   // The client identity, cut off after 16 bytes
+            };
+
+            /**
+             * @brief Protects devices
+             */
+            std::mutex table_mutex;
+
+            /**
+             * @brief The devices that fit
+             */
+            OpenTable<device> devices;
+
+            /**
+             * @brief Milliseconds without requests after which a device is evicted
+             */
+            int64_t stale = static_cast<int64_t>(CONDALF_DEVICE_STALE) * 1000;
+
+            /**
+             * @brief Time the milliseconds are counted from
+             */
+            clock::time_point start;
+
+            std::atomic_uint64_t recorded;      // Requests that were recorded
+            std::atomic_uint64_t untracked;     // Requests of devices that did not fit
+            std::atomic_uint64_t evicted;       // Stale devices that were dropped
+
+            /**
+             * @brief Drops stale devices
+             * 
+             * @param now Milliseconds since start
+             * @param count Slots to check, they continue where the last call stopped. 0 checks all slots.
+             */
+            void evict(int64_t now, std::size_t count);
+
+            /**
+             * @brief Get the rate of a device at a time
+             * 
+             * @param entry The device
+             * @param now Milliseconds since start, not before last_seen
+             * @return double Requests per second
+             */
+            static double rate_at(const device& entry, int64_t now);
+
+            /**
+             * @brief Formats the address of a device
+             * 
+             * @param entry The device
+             * @return std::string IPv4 or IPv6 address, the identity as is otherwise
+             */
+            static std::string address_of(const device& entry);
+
+        public:
+            /**
+             * @brief Construct a new DeviceTable object
+             */
+            DeviceTable();
+
+            /**
+             * @brief Drops all devices and sets the size of the table
+             * 
+             * @param _max_devices Devices kept at most
+             * @param _stale Seconds without requests after which a device is evicted
+             */
+            void Configure(std::size_t _max_devices, unsigned int _stale);
+
+            /**
+             * @brief Records a request of a device
+             * 
+             * @param client Identifies the device
+             * @param bytes Payload bytes of the request
+             * @param complete True if the transfer is complete, false for the blocks before the last one
+             * @param error True if the request was answered with an error
+             */
+            void Record(std::string_view client, std::size_t bytes, bool complete, bool error);
+
+            /**
+             * @brief Lists the devices, the most recently seen first. Stale devices are evicted before.
+             * 
+             * @return std::string One line per device with address, last seen, rate, requests, bytes and errors
+             */
+            std::string Dump();
+
+            /**
+             * @brief Get the statistics of the table
+             * 
+             * @return std::string Devices, recorded and untracked requests and evicted devices
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * @file fair_scheduler.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-19
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "fair_scheduler.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace condalf::service;
+
+bool FairScheduler::next(Job& job)
+{
+    while (!active.empty())
+    {
+        queue& current = *active.front();
+        if (!current.credited)
+        {
+            current.deficit += config.quantum * current.weight;
+            current.credited = true;
+            rounds++;
+        }
+
+        // Send while the head fits into the deficit
+        if (!current.jobs.empty() && cost(current.jobs.front()) <= current.deficit)
+        {
+            job = std::move(current.jobs.front());
+            current.jobs.pop_front();
+            current.deficit -= cost(job);
+            waiting--;
+            return true;
+        }
+
+        // The round of this queue is over. Empty queues lose their deficit and are dropped.
+        active.pop_front();
+        current.credited = false;
+        if (current.jobs.empty())
+        {
+            std::string key = current.key;
+            queues.erase(key);
+        }
+        else
+            active.push_back(&current);
+    }
+    return false;
+}
+
+bool FairScheduler::drain()
+{
+    Job job;
+    std::unique_lock<std::mutex> lock(schedule_mutex);
+    while (next(job))
+    {
+        lock.unlock();
+        processor(job);
+        processed++;
+        lock.lock();
+    }
+    return true;
+}
+
+void FairScheduler::run()
+{
+    std::unique_lock<std::mutex> lock(schedule_mutex);
+    schedule_notifier.wait_for(lock, std::chrono::milliseconds(CONDALF_SCHEDULE_WAIT_TIMEOUT), [this] { return !active.empty(); });
+
+    // The pipeline runs without holding the queues so that the IO thread can keep queueing
+    Job job;
+    for (unsigned int i = 0; i < CONDALF_SCHEDULE_BURST && next(job); i++)
+    {
+        lock.unlock();
+        processor(job);
+        processed++;
+        lock.lock();
+    }
+}
+
+FairScheduler::FairScheduler() : Service()
+{
+    this->service_name = "ConDaLF-Backend-FairScheduler";
+    waiting.store(0);
+    processed.store(0);
+    rejected.store(0);
+    rounds.store(0);
+
+    add_hook(
+        [] { return true; },
+        std::bind(&FairScheduler::drain, this)
+    );
+}
+
+FairScheduler::~FairScheduler()
+{
+    Stop();
+}
+
+bool FairScheduler::Start(const options& _config, std::function<void(Job&)> _processor)
+{
+    if (IsActive())
+        return false;
+
+    config = _config;
+    if (config.queue_size == 0)
+        config.queue_size = 1;
+    if (config.quantum == 0)
+        config.quantum = 1;
+    processor = std::move(_processor);
+    return common::Service::Start();
+}
+
+bool FairScheduler::Submit(const std::string& class_name, std::string_view client, Job&& job)
+{
+    std::string key = class_name;
+    key += '\0';
+    key.append(client);
+
+    std::unique_lock<std::mutex> lock(schedule_mutex);
+    auto it = queues.find(key);
+    if (it == queues.end())
+    {
+        if (queues.size() >= config.max_queues)
+        {
+            rejected++;
+            return false;
+        }
+
+        auto weight = config.weights.find(class_name);
+        it = queues.emplace(key, queue()).first;
+        it->second.key = key;
+        it->second.weight = weight != config.weights.end() ? std::max(weight->second, 1u) : 1;
+        active.push_back(&it->second);
+    }
+    else if (it->second.jobs.size() >= config.queue_size)
+    {
+        rejected++;
+        return false;
+    }
+
+    it->second.jobs.push_back(std::move(job));
+    waiting++;
+    lock.unlock();
+    schedule_notifier.notify_one();
+    return true;
+}
+
+std::string FairScheduler::GetStatistics()
+{
+    std::size_t clients = 0;
+    {
+        std::unique_lock<std::mutex> lock(schedule_mutex);
+        clients = queues.size();
+    }
+
+    std::stringstream stats;
+    stats << "queues=" << clients << "/" << config.max_queues
+          << " waiting=" << waiting.load()
+          << " processed=" << processed.load()
+          << " rejected=" << rejected.load()
+          << " rounds=" << rounds.load();
+    return stats.str();
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+/**
+ * @file fair_scheduler.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Weighted fair processing of payloads across clients
+ * @version 0.1
+ * @date 2021-07-19
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <common/senml/senml.hpp>
+#include <common/service/service.hpp>
+
+#define CONDALF_SCHEDULE_QUEUE_SIZE 64          // Payloads a client may have waiting
+#define CONDALF_SCHEDULE_MAX_QUEUES 4096        // Clients with waiting payloads at most
+#define CONDALF_SCHEDULE_QUANTUM 1024           // Bytes a queue of weight 1 may send per round
+#define CONDALF_SCHEDULE_JOB_OVERHEAD 64        // Bytes added to the cost of every payload so that small ones are not free
+#define CONDALF_SCHEDULE_RETRY_AFTER 2          // Max-Age in seconds of the 5.03 sent when a queue is full
+#define CONDALF_SCHEDULE_WAIT_TIMEOUT 100       // ms the scheduler thread waits for work before checking if it should stop
+#define CONDALF_SCHEDULE_BURST 64               // Payloads processed before checking if the thread should stop
+
+namespace condalf::service
+{
+    /**
+     * @brief Processes complete payloads on its own thread instead of the CoAP IO thread.
+     * The server decodes payloads before it queues them, so that malformed packs are still answered with 4.00.
+     * Every client of a class (see the class option of the resources) has its own queue. The queues are
+     * served by deficit round robin: a queue gains quantum * weight bytes per round and sends payloads while their
+     * cost (size + overhead) fits into what it gained. Heavy reporters therefore only get their share
+     * and clients with few small payloads are served within one round.
+     */
+    class FairScheduler : private common::Service
+    {
+        public:
+            using common::Service::IsActive;
+            using common::Service::Stop;
+
+            /**
+             * @brief Options of the scheduler
+             */
+            struct options
+            {
+                std::size_t queue_size = CONDALF_SCHEDULE_QUEUE_SIZE;
+                std::size_t max_queues = CONDALF_SCHEDULE_MAX_QUEUES;
+                std::size_t quantum = CONDALF_SCHEDULE_QUANTUM;
+                std::unordered_map<std::string, unsigned int> weights;     // Weight by class, 1 for classes without
+            };
+
+            /**
+             * @brief A payload of an ingest resource
+             */
+            struct Job
+            {
+                std::string path;           // Path of the request
+                uint8_t code = 0;           // Request code
+                unsigned int sinks = 0;     // Sink bits of the resource
+                uint16_t content_format = 0;
+                int64_t received = 0;       // Receive time in ns since the epoch, SenML times are relative to it
+                std::shared_ptr<const std::vector<uint8_t>> payload;
+                common::senml::Pack pack;   // Decoded payload if decoded is set, points into payload
+                bool decoded = false;
+            };
+
+        private:
+            /**
+             * @brief The queue of a client
+             */
+            struct queue
+            {
+                std::string key;            // Class and client
+                std::deque<Job> jobs;
+                std::size_t deficit = 0;    // Bytes the queue may still send in this round
+                std::size_t weight = 1;
+                bool credited = false;      // The quantum of the current round was added
+            };
+
+            /**
+             * @brief Options of the scheduler
+             */
+            options config;
+
+            /**
+             * @brief Runs the pipeline for a job
+             */
+            std::function<void(Job&)> processor;
+
+            /**
+             * @brief Protects queues and active
+             */
+            std::mutex schedule_mutex;
+
+            /**
+             * @brief Signals new jobs to the scheduler thread
+             */
+            std::condition_variable schedule_notifier;
+
+            /**
+             * @brief Queues by class and client. Only queues with jobs exist.
+             */
+            std::unordered_map<std::string, queue> queues;
+
+            /**
+             * @brief Queues with jobs in round robin order
+             */
+            std::deque<queue*> active;
+
+            std::atomic_uint64_t waiting;       // Jobs in the queues
+            std::atomic_uint64_t processed;
+            std::atomic_uint64_t rejected;      // Jobs that did not fit into their queue
+            std::atomic_uint64_t rounds;        // Visits of a queue
+
+            /**
+             * @brief Get the cost of a job
+             * 
+             * @param job The job
+             * @return std::size_t Payload size plus overhead
+             */
+            static std::size_t cost(const Job& job)
+            {
+                return (job.payload != nullptr ? job.payload->size() : 0) + CONDALF_SCHEDULE_JOB_OVERHEAD;
+            }
+
+            /**
+             * @brief Takes the next job in deficit round robin order
+             * 
+             * @param job The job
+             * @return true If there was a job
+             * @return false If all queues are empty
+             */
+            bool next(Job& job);
+
+            /**
+             * @brief Processes the jobs that are left
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool drain();
+
+        protected:
+            /**
+             * @brief Run function of the scheduler thread
+             */
+            void run();
+
+        public:
+            /**
+             * @brief Construct a new FairScheduler object
+             */
+            FairScheduler();
+
+            /**
+             * @brief Destroy the FairScheduler object. Jobs that are left are processed.
+             */
+            ~FairScheduler();
+
+            /**
+             * @brief Starts the scheduler thread
+             * 
+             * @param _config Options of the scheduler
+             * @param _processor Runs the pipeline for a job on the scheduler thread
+             * @return true On success
+             * @return false On failure
+             */
+            bool Start(const options& _config, std::function<void(Job&)> _processor);
+
+            /**
+             * @brief Queues a job
+             * 
+             * @param class_name Class of the resource
+             * @param client Identifies the client
+             * @param job The job
+             * @return true If it was queued
+             * @return false If the queue of the client is full or there are too many clients
+             */
+            bool Submit(const std::string& class_name, std::string_view client, Job&& job);
+
+            /**
+             * @brief Get the statistics of the scheduler
+             * 
+             * @return std::string Queues, waiting, processed and rejected jobs and rounds
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,249 @@
+/**
+ * @file open_table.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Fixed-size open addressing table for the per-client state of the server
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#define CONDALF_OPEN_TABLE_SWEEP 16     // Slots checked for an entry to drop when a full table misses, at most half are in use
+
+namespace condalf::service
+{
+    /**
+     * @brief Entries keyed by a 64-bit hash in a table of a fixed size, used by the rate limiter and the device table.
+     * The size is a power of two and at most half of the slots are used so that probe sequences stay short.
+     * An entry is removed by moving the following ones of its probe sequence back, so there are no tombstones.
+     * Sweep checks a few slots per call and continues where the last call stopped, so that a full table
+     * makes room without a pass over all slots.
+     * Not thread safe, the owner locks.
+     * 
+     * @tparam T Entry with a member uint64_t key that is 0 in a default constructed (free) entry
+     */
+    template <typename T>
+    class OpenTable
+    {
+        private:
+            /**
+             * @brief Entries, the size is a power of two
+             */
+            std::vector<T> slots;
+
+            /**
+             * @brief Entries in slots
+             */
+            std::size_t used = 0;
+
+            /**
+             * @brief Entries kept at most
+             */
+            std::size_t capacity = 0;
+
+            /**
+             * @brief Next slot Sweep checks
+             */
+            std::size_t cursor = 0;
+
+            /**
+             * @brief Get the slot of a key or the free slot that ends its probe sequence
+             * 
+             * @param key The key
+             * @return std::size_t The slot
+             */
+            std::size_t probe(uint64_t key) const
+            {
+                std::size_t mask = slots.size() - 1;
+                std::size_t index = key & mask;
+                while (slots[index].key != 0 && slots[index].key != key)
+                    index = (index + 1) & mask;
+                return index;
+            }
+
+        public:
+            /**
+             * @brief Hashes an identity into a key
+             * 
+             * @param data Identifies the entry, e.g. the client
+             * @param salt Mixed in after the data, e.g. resource + 1, 0 for none
+             * @return uint64_t The key, never 0
+             */
+            static uint64_t Key(std::string_view data, uint64_t salt = 0)
+            {
+                // FNV-1a over the data, the salt is mixed in by the finalizer
+                uint64_t hash = 14695981039346656037ull;
+                for (char c : data)
+                {
+                    hash ^= static_cast<uint8_t>(c);
+                    hash *= 1099511628211ull;
+                }
+                hash ^= salt * 0x9e3779b97f4a7c15ull;
+                hash ^= hash >> 33;
+                hash *= 0xff51afd7ed558ccdull;
+                hash ^= hash >> 33;
+                return hash != 0 ? hash : 1;
+            }
+
+            /**
+             * @brief Drops all entries and sets the size of the table
+             * 
+             * @param _capacity Entries kept at most, at least 1
+             */
+            void Configure(std::size_t _capacity)
+            {
+                capacity = std::max<std::size_t>(_capacity, 1);
+                std::size_t size = 1;
+                while (size < 2 * capacity)
+                    size <<= 1;
+                slots.assign(size, T());
+                used = 0;
+                cursor = 0;
+            }
+
+            /**
+             * @brief Get the entry of a key
+             * 
+             * @param key The key
+             * @return T* The entry, nullptr if there is none
+             */
+            T* Find(uint64_t key)
+            {
+                if (slots.empty())
+                    return nullptr;
+                T& entry = slots[probe(key)];
+                return entry.key != 0 ? &entry : nullptr;
+            }
+
+            /**
+             * @brief Adds a default entry for a key that is not in the table
+             * 
+             * @param key The key
+             * @return T* The new entry, nullptr if the table is full
+             */
+            T* Insert(uint64_t key)
+            {
+                if (used >= capacity)
+                    return nullptr;
+                T& entry = slots[probe(key)];
+                entry.key = key;
+                used++;
+                return &entry;
+            }
+
+            /**
+             * @brief Removes an entry and moves the following ones of its probe sequence back
+             * 
+             * @param index Slot of the entry
+             */
+            void Erase(std::size_t index)
+            {
+                std::size_t mask = slots.size() - 1;
+                slots[index] = T();
+                used--;
+
+                // Move the following entries back unless that would put them before their home slot
+                std::size_t hole = index;
+                for (std::size_t next = (index + 1) & mask; slots[next].key != 0; next = (next + 1) & mask)
+                {
+                    std::size_t home = slots[next].key & mask;
+                    bool stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+                    if (stays)
+                        continue;
+
+                    slots[hole] = slots[next];
+                    slots[next] = T();
+                    hole = next;
+                }
+            }
+
+            /**
+             * @brief Removes every entry a predicate selects
+             * 
+             * @tparam F bool(const T& entry)
+             * @param selected True for the entries to remove
+             * @return std::size_t Entries that were removed
+             */
+            template <typename F>
+            std::size_t EraseIf(F selected)
+            {
+                std::size_t erased = 0;
+                for (std::size_t i = 0; i < slots.size(); i++)
+                {
+                    // Erase moves the next entry into this slot
+                    while (slots[i].key != 0 && selected(slots[i]))
+                    {
+                        Erase(i);
+                        erased++;
+                    }
+                }
+                return erased;
+            }
+
+            /**
+             * @brief Removes the entries a predicate selects among the next count slots
+             * 
+             * @tparam F bool(const T& entry)
+             * @param count Slots to check
+             * @param selected True for the entries to remove
+             * @return std::size_t Entries that were removed
+             */
+            template <typename F>
+            std::size_t Sweep(std::size_t count, F selected)
+            {
+                if (slots.empty())
+                    return 0;
+
+                std::size_t mask = slots.size() - 1;
+                std::size_t erased = 0;
+                for (std::size_t checked = 0; checked < count; checked++)
+                {
+                    // Erase moves the next entry into this slot, it is checked next
+                    if (slots[cursor].key != 0 && selected(slots[cursor]))
+                    {
+                        Erase(cursor);
+                        erased++;
+                    }
+                    else
+                        cursor = (cursor + 1) & mask;
+                }
+                return erased;
+            }
+
+            /**
+             * @brief Get a slot, free slots have key 0
+             * 
+             * @param index Slot index below Slots()
+             * @return T& The slot
+             */
+            T& Slot(std::size_t index) { return slots[index]; }
+
+            /**
+             * @brief Get the number of slots, a power of two or 0 before Configure
+             */
+            std::size_t Slots() const { return slots.size(); }
+
+            /**
+             * @brief Get the number of entries
+             */
+            std::size_t Size() const { return used; }
+
+            /**
+             * @brief Get the number of entries kept at most
+             */
+            std::size_t Capacity() const { return capacity; }
+
+            /**
+             * @brief Checks if no further entry can be added
+             */
+            bool Full() const { return used >= capacity; }
+    };
+}
\ No newline at end of file
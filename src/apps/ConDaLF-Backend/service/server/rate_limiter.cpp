@@ -0,0 +1,115 @@
+/**
+ * @file rate_limiter.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-18
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace condalf::service;
+
+bool RateLimiter::take(bucket& entry, int64_t now, uint32_t& retry_after)
+{
+    if (now > entry.updated)
+    {
+        entry.tokens = std::min(entry.burst, entry.tokens + static_cast<float>((now - entry.updated) * (entry.rate / 1000.0)));
+        entry.updated = now;
+    }
+
+    if (entry.tokens >= 1)
+    {
+        entry.tokens -= 1;
+        return true;
+    }
+
+    retry_after = static_cast<uint32_t>(std::max(1.0, std::ceil((1.0 - entry.tokens) / entry.rate)));
+    return false;
+}
+
+RateLimiter::RateLimiter() : start(clock::now())
+{
+    allowed.store(0);
+    limited.store(0);
+    evicted.store(0);
+    overflowed.store(0);
+}
+
+void RateLimiter::Configure(std::size_t _max_clients, std::size_t resources)
+{
+    std::lock_guard guard(limiter_mutex);
+    buckets.Configure(_max_clients);
+    shared.assign(resources, bucket());
+}
+
+bool RateLimiter::Allow(std::string_view client, uint32_t resource, double rate, double burst, uint32_t& retry_after)
+{
+    std::lock_guard guard(limiter_mutex);
+    if (buckets.Slots() == 0 || resource >= shared.size())
+        return true;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    uint64_t key = OpenTable<bucket>::Key(client, static_cast<uint64_t>(resource) + 1);
+    bucket* entry = buckets.Find(key);
+    if (entry == nullptr)
+    {
+        // Buckets that would be full again are the same as no bucket. Only a few slots are checked
+        // so that a full table of active clients does not cost a pass over all buckets per request.
+        if (buckets.Full())
+        {
+            evicted += buckets.Sweep(CONDALF_OPEN_TABLE_SWEEP, [now](const bucket& idle) {
+                return idle.tokens + (now - idle.updated) * (idle.rate / 1000.0) >= idle.burst;
+            });
+        }
+
+        // A new bucket starts full. Clients that do not fit share a bucket.
+        entry = buckets.Insert(key);
+        if (entry == nullptr)
+        {
+            entry = &shared[resource];
+            overflowed++;
+        }
+
+        if (entry->rate == 0)
+        {
+            entry->updated = now;
+            entry->tokens = static_cast<float>(burst);
+        }
+        entry->burst = static_cast<float>(burst);
+        entry->rate = static_cast<float>(rate);
+    }
+
+    if (take(*entry, now, retry_after))
+    {
+        allowed++;
+        return true;
+    }
+    limited++;
+    return false;
+}
+
+std::string RateLimiter::GetStatistics()
+{
+    std::size_t clients = 0, max_clients = 0;
+    {
+        std::lock_guard guard(limiter_mutex);
+        clients = buckets.Size();
+        max_clients = buckets.Capacity();
+    }
+
+    std::stringstream stats;
+    stats << "clients=" << clients << "/" << max_clients
+          << " allowed=" << allowed.load()
+          << " limited=" << limited.load()
+          << " evicted=" << evicted.load()
+          << " shared=" << overflowed.load();
+    return stats.str();
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+/**
+ * @file rate_limiter.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Token buckets per client and resource
+ * @version 0.1
+ * @date 2021-07-18
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "open_table.hpp"
+
+#define CONDALF_RATE_LIMIT_CLIENTS 4096     // Buckets kept at most, clients beyond share one bucket per resource
+
+namespace condalf::service
+{
+    /**
+     * @brief Limits the requests of every client on a resource with a token bucket.
+     * A bucket holds up to burst tokens and gains rate tokens per second, every request takes one.
+     * The buckets are kept in an open addressing table keyed by a hash of client and resource. A bucket that
+     * would be full again is the same as no bucket, so a new client on a full table checks the next few slots
+     * for idle buckets and evicts them. Clients that still do not fit share one bucket per resource.
+     */
+    class RateLimiter
+    {
+        public:
+            using clock = std::chrono::steady_clock;
+
+        private:
+            /**
+             * @brief A token bucket
+             */
+            struct bucket
+            {
+                uint64_t key = 0;       // 0 if the slot is free
+                int64_t updated = 0;    // Milliseconds since start when tokens was computed
+                float tokens = 0;
+                float burst = 0;        // Capacity the bucket was created with
+                float rate = 0;         // Tokens per second the bucket was created with
+            };
+
+            /**
+             * @brief Protects buckets and shared
+             */
+            std::mutex limiter_mutex;
+
+            /**
+             * @brief Buckets of the clients that fit
+             */
+            OpenTable<bucket> buckets;
+
+            /**
+             * @brief Buckets for the clients that do not fit, by resource
+             */
+            std::vector<bucket> shared;
+
+            /**
+             * @brief Time the milliseconds are counted from
+             */
+            clock::time_point start;
+
+            std::atomic_uint64_t allowed;       // Requests that got a token
+            std::atomic_uint64_t limited;       // Requests that were answered with 4.29
+            std::atomic_uint64_t evicted;       // Idle buckets that were dropped
+            std::atomic_uint64_t overflowed;    // Requests of clients that did not fit and used a shared bucket
+
+            /**
+             * @brief Refills a bucket and takes a token
+             * 
+             * @param entry The bucket
+             * @param now Milliseconds since start
+             * @param retry_after Seconds until the next token if there is none
+             * @return true If a token was taken
+             * @return false If the bucket is empty
+             */
+            static bool take(bucket& entry, int64_t now, uint32_t& retry_after);
+
+        public:
+            /**
+             * @brief Construct a new RateLimiter object
+             */
+            RateLimiter();
+
+            /**
+             * @brief Drops all buckets and sets the size of the table
+             * 
+             * @param _max_clients Buckets kept at most
+             * @param resources Number of resources, for the shared buckets
+             */
+            void Configure(std::size_t _max_clients, std::size_t resources);
+
+            /**
+             * @brief Takes a token from the bucket of a client on a resource
+             * 
+             * @param client Identifies the client
+             * @param resource Index of the resource
+             * @param rate Tokens per second
+             * @param burst Tokens a bucket holds at most
+             * @param retry_after Seconds until the client may retry if it is limited
+             * @return true If the request may be processed
+             * @return false If the client exceeded its rate
+             */
+            bool Allow(std::string_view client, uint32_t resource, double rate, double burst, uint32_t& retry_after);
+
+            /**
+             * @brief Get the statistics of the rate limiter
+             * 
+             * @return std::string Buckets, allowed, limited and evicted, requests on shared buckets
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
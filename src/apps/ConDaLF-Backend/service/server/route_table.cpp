@@ -0,0 +1,393 @@
+/**
+ * @file route_table.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-17
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "route_table.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <coap3/coap.h>
+#include <common/logging/logging.h>
+
+using namespace condalf::service;
+
+/**
+ * @brief Splits a path into its segments. Empty segments are skipped.
+ * 
+ * @tparam T std::string or std::string_view
+ * @param path The path
+ * @param segments The segments
+ */
+template <typename T>
+static void split_path(std::string_view path, std::vector<T>& segments)
+{
+    std::size_t position = 0;
+    while (position <= path.size())
+    {
+        std::size_t next = std::min(path.find('/', position), path.size());
+        if (next > position)
+            segments.emplace_back(path.substr(position, next - position));
+        position = next + 1;
+    }
+}
+
+/**
+ * @brief Calls handler for every element of a comma separated list
+ * 
+ * @param value The list
+ * @param handler Returns false for an invalid element
+ * @return true If all elements are valid
+ * @return false If one is not
+ */
+template <typename F>
+static bool for_each_element(const std::string& value, F handler)
+{
+    std::size_t position = 0;
+    while (position <= value.size())
+    {
+        std::size_t next = std::min(value.find(',', position), value.size());
+        if (next > position && !handler(value.substr(position, next - position)))
+            return false;
+        position = next + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a request method
+ * 
+ * @param name Method name in lower case
+ * @param bit The bit of the method
+ * @return true On success
+ * @return false Unknown method
+ */
+static bool parse_method(const std::string& name, unsigned int& bit)
+{
+    static const std::pair<const char*, coap_request_t> methods[] = {
+        { "get", COAP_REQUEST_GET }, { "post", COAP_REQUEST_POST }, { "put", COAP_REQUEST_PUT },
+        { "delete", COAP_REQUEST_DELETE }, { "fetch", COAP_REQUEST_FETCH }, { "patch", COAP_REQUEST_PATCH },
+        { "ipatch", COAP_REQUEST_IPATCH }
+    };
+    for (const auto& method : methods)
+    {
+        if (name == method.first)
+        {
+            bit = RouteTable::MethodBit(method.second);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parses a Content-Format given by name or number
+ * 
+ * @param name senml+cbor, senml+json, cbor, json or the number
+ * @param format The Content-Format
+ * @return true On success
+ * @return false On failure
+ */
+static bool parse_format(const std::string& name, uint16_t& format)
+{
+    static const std::pair<const char*, uint16_t> formats[] = {
+        { "senml+cbor", COAP_MEDIATYPE_APPLICATION_SENML_CBOR }, { "senml+json", COAP_MEDIATYPE_APPLICATION_SENML_JSON },
+        { "cbor", COAP_MEDIATYPE_APPLICATION_CBOR }, { "json", COAP_MEDIATYPE_APPLICATION_JSON }
+    };
+    for (const auto& known : formats)
+    {
+        if (name == known.first)
+        {
+            format = known.second;
+            return true;
+        }
+    }
+
+    char* end = nullptr;
+    unsigned long number = std::strtoul(name.c_str(), &end, 10);
+    if (name.empty() || *end != '\0' || number > UINT16_MAX)
+        return false;
+    format = static_cast<uint16_t>(number);
+    return true;
+}
+
+/**
+ * @brief Parses a sink name
+ * 
+ * @param name python, influx, plugin, store, relay, all or none
+ * @param sinks The sink bits
+ * @return true On success
+ * @return false Unknown sink
+ */
+static bool parse_sink(const std::string& name, unsigned int& sinks)
+{
+    static const std::pair<const char*, unsigned int> names[] = {
+        { "python", RouteTable::SINK_PYTHON }, { "influx", RouteTable::SINK_INFLUX }, { "plugin", RouteTable::SINK_PLUGIN },
+        { "store", RouteTable::SINK_STORE }, { "relay", RouteTable::SINK_RELAY }, { "latest", RouteTable::SINK_LATEST },
+        { "all", RouteTable::SINK_ALL }, { "none", 0 }
+    };
+    for (const auto& sink : names)
+    {
+        if (name == sink.first)
+        {
+            sinks |= sink.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RouteTable::Parse(const std::string& declaration, route& parsed)
+{
+    std::stringstream ss_declaration(declaration);
+    std::string path, option;
+    ss_declaration >> path;
+    while (!path.empty() && path.front() == '/')
+        path.erase(0, 1);
+    if (path.empty())
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Missing path in resource \"") + declaration + "\".");
+        return false;
+    }
+
+    parsed = route();
+    parsed.path = path;
+    bool has_methods = false;
+    bool has_formats = false;
+    while (ss_declaration >> option)
+    {
+        std::size_t separator = option.find('=');
+        std::string key = option.substr(0, separator);
+        std::string value = separator != std::string::npos ? option.substr(separator + 1) : "";
+
+        bool valid = true;
+        if (key == "methods")
+        {
+            has_methods = true;
+            valid = for_each_element(value, [&parsed](const std::string& name) {
+                unsigned int bit = 0;
+                if (!parse_method(name, bit))
+                    return false;
+                parsed.methods |= bit;
+                return true;
+            });
+        }
+        else if (key == "formats")
+        {
+            has_formats = true;
+            valid = for_each_element(value, [&parsed](const std::string& name) {
+                uint16_t format = 0;
+                if (!parse_format(name, format))
+                    return false;
+                parsed.formats.push_back(format);
+                return true;
+            });
+        }
+        else if (key == "pipeline")
+        {
+            if (value == "ingest")
+                parsed.pipeline = Pipeline::INGEST;
+            else if (value == "query")
+                parsed.pipeline = Pipeline::QUERY;
+            else if (value == "latest")
+                parsed.pipeline = Pipeline::LATEST;
+            else if (value == "test")
+                parsed.pipeline = Pipeline::TEST;
+            else
+                valid = false;
+        }
+        else if (key == "sinks")
+        {
+            valid = ParseSinks(value, parsed.sinks);
+        }
+        else if (key == "class")
+        {
+            parsed.class_name = value;
+            valid = !value.empty();
+        }
+        else if (key == "rate" || key == "burst")
+        {
+            char* end = nullptr;
+            double number = std::strtod(value.c_str(), &end);
+            valid = !value.empty() && *end == '\0' && std::isfinite(number) && number >= 0;
+            (key == "rate" ? parsed.rate : parsed.burst) = number;
+        }
+        else
+            common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("Unknown resource option \"") + option + "\" for " + path + ".");
+
+        if (!valid)
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Invalid resource option \"") + option + "\" for " + path + ".");
+            return false;
+        }
+    }
+
+    // A bucket holds at least one request, by default one second worth of requests
+    if (parsed.rate > 0 && parsed.burst < 1)
+        parsed.burst = std::max(1.0, std::ceil(parsed.rate));
+
+    // Defaults of the pipeline
+    if (!has_methods)
+        parsed.methods = parsed.pipeline == Pipeline::INGEST ? MethodBit(COAP_REQUEST_PUT) : MethodBit(COAP_REQUEST_GET);
+    if (!has_formats && parsed.pipeline == Pipeline::INGEST)
+    {
+        parsed.formats = { COAP_MEDIATYPE_APPLICATION_SENML_CBOR, COAP_MEDIATYPE_APPLICATION_SENML_JSON,
+                           COAP_MEDIATYPE_APPLICATION_CBOR, COAP_MEDIATYPE_APPLICATION_JSON };
+    }
+    return true;
+}
+
+std::vector<RouteTable::route> RouteTable::Defaults(bool query, bool latest)
+{
+    std::vector<route> routes(2);
+    Parse("condalf/data pipeline=ingest", routes[0]);
+    Parse("condalf/test pipeline=test", routes[1]);
+    if (query)
+    {
+        routes.emplace_back();
+        Parse("condalf/query pipeline=query", routes.back());
+    }
+    if (latest)
+    {
+        routes.emplace_back();
+        Parse("condalf/latest pipeline=latest", routes.back());
+    }
+    return routes;
+}
+
+bool RouteTable::ParseSinks(const std::string& value, unsigned int& sinks)
+{
+    sinks = 0;
+    return for_each_element(value, [&sinks](const std::string& name) { return parse_sink(name, sinks); });
+}
+
+bool RouteTable::Compile(const std::vector<route>& routes)
+{
+    nodes.clear();
+    entries.clear();
+    nodes.emplace_back();
+
+    for (const auto& declared : routes)
+    {
+        Entry& entry = entries.emplace_back();
+        entry.config = declared;
+        entry.index = static_cast<uint32_t>(entries.size() - 1);
+        split_path(declared.path, entry.segments);
+
+        // Walk down the trie and add the missing nodes
+        uint32_t current = 0;
+        for (std::size_t i = 0; i < entry.segments.size(); i++)
+        {
+            const std::string& segment = entry.segments[i];
+            if (segment == CONDALF_ROUTE_ANY_SUFFIX)
+            {
+                if (i + 1 != entry.segments.size())
+                {
+                    common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("\"**\" has to be the last segment of resource ") + declared.path + ".");
+                    return false;
+                }
+                entry.wildcard = true;
+                break;
+            }
+
+            int32_t next = -1;
+            if (segment == CONDALF_ROUTE_ANY_SEGMENT)
+            {
+                entry.wildcard = true;
+                next = nodes[current].any;
+            }
+            else
+            {
+                auto& children = nodes[current].children;
+                auto it = std::lower_bound(children.begin(), children.end(), segment,
+                                           [](const auto& child, const std::string& name) { return child.first < name; });
+                if (it != children.end() && it->first == segment)
+                    next = it->second;
+            }
+
+            if (next < 0)
+            {
+                next = static_cast<int32_t>(nodes.size());
+                nodes.emplace_back();
+                if (segment == CONDALF_ROUTE_ANY_SEGMENT)
+                    nodes[current].any = next;
+                else
+                {
+                    auto& children = nodes[current].children;
+                    auto it = std::lower_bound(children.begin(), children.end(), segment,
+                                               [](const auto& child, const std::string& name) { return child.first < name; });
+                    children.emplace(it, segment, next);
+                }
+            }
+            current = next;
+        }
+
+        int32_t& slot = !entry.segments.empty() && entry.segments.back() == CONDALF_ROUTE_ANY_SUFFIX ? nodes[current].rest : nodes[current].entry;
+        if (slot >= 0)
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Resource ") + declared.path + " is declared twice.");
+            return false;
+        }
+        slot = static_cast<int32_t>(entries.size() - 1);
+    }
+    return true;
+}
+
+int32_t RouteTable::match(uint32_t current, const std::vector<std::string_view>& segments, std::size_t index) const
+{
+    const node& position = nodes[current];
+    if (index == segments.size())
+        return position.entry;
+
+    // Literal segments first, then "*" and "**"
+    auto it = std::lower_bound(position.children.begin(), position.children.end(), segments[index],
+                               [](const auto& child, std::string_view name) { return std::string_view(child.first) < name; });
+    if (it != position.children.end() && it->first == segments[index])
+    {
+        int32_t found = match(it->second, segments, index + 1);
+        if (found >= 0)
+            return found;
+    }
+
+    if (position.any >= 0)
+    {
+        int32_t found = match(position.any, segments, index + 1);
+        if (found >= 0)
+            return found;
+    }
+    return position.rest;
+}
+
+RouteTable::Entry* RouteTable::Find(std::string_view path)
+{
+    if (nodes.empty())
+        return nullptr;
+
+    std::vector<std::string_view> segments;
+    split_path(path, segments);
+    int32_t found = match(0, segments, 0);
+    return found >= 0 ? &entries[found] : nullptr;
+}
+
+std::string RouteTable::GetStatistics() const
+{
+    std::stringstream stats;
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        if (i != 0)
+            stats << ", ";
+        stats << entries[i].config.path
+              << " requests=" << entries[i].requests.load()
+              << " rejected=" << entries[i].rejected.load()
+              << " limited=" << entries[i].limited.load();
+    }
+    return stats.str();
+}
\ No newline at end of file
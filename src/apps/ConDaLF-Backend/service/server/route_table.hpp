@@ -0,0 +1,196 @@
+/**
+ * @file route_table.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Resources of the server and the trie that routes requests to them
+ * @version 0.1
+ * @date 2021-07-17
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define CONDALF_ROUTE_ANY_SEGMENT "*"     // Path segment that matches any single segment
+#define CONDALF_ROUTE_ANY_SUFFIX "**"     // Last path segment that matches the rest of the path (at least one segment)
+#define CONDALF_ROUTE_DEFAULT_CLASS "default"   // Scheduling class of resources without class option
+
+namespace condalf::service
+{
+    /**
+     * @brief The resources of the server. Every resource has a path, the methods and content formats it accepts,
+     * the pipeline that handles its requests and the sinks this pipeline feeds.
+     * The paths are compiled into a trie of path segments. A segment "*" matches any single segment and a last
+     * segment "**" the rest of the path. Literal segments take precedence over "*", which takes precedence over "**".
+     */
+    class RouteTable
+    {
+        public:
+            /**
+             * @brief What handles the requests of a resource
+             */
+            enum class Pipeline
+            {
+                INGEST,     // Decodes SenML and feeds the sinks
+                QUERY,      // Queries the time series store
+                LATEST,     // Latest values of the series, observable
+                TEST        // Answers "valid"
+            };
+
+            /**
+             * @brief Sinks an ingest pipeline can feed
+             */
+            enum Sink : unsigned int
+            {
+                SINK_PYTHON = 1 << 0,
+                SINK_INFLUX = 1 << 1,
+                SINK_PLUGIN = 1 << 2,
+                SINK_STORE = 1 << 3,
+                SINK_RELAY = 1 << 4,
+                SINK_LATEST = 1 << 5,
+                SINK_ALL = SINK_PYTHON | SINK_INFLUX | SINK_PLUGIN | SINK_STORE | SINK_RELAY | SINK_LATEST
+            };
+
+            /**
+             * @brief Declaration of a resource
+             */
+            struct route
+            {
+                std::string path;                   // Without leading slash
+                unsigned int methods = 0;           // Bit (1 << coap_request_t) per accepted method
+                std::vector<uint16_t> formats;      // Accepted Content-Formats, the first one is assumed without Content-Format
+                Pipeline pipeline = Pipeline::INGEST;
+                unsigned int sinks = SINK_ALL;      // Sink bits fed by an ingest pipeline
+                double rate = 0;                    // Requests per second and client, 0 for no limit
+                double burst = 0;                   // Requests a client may send at once (at least 1)
+                std::string class_name = CONDALF_ROUTE_DEFAULT_CLASS;     // Scheduling class of an ingest pipeline
+            };
+
+            /**
+             * @brief A compiled resource
+             */
+            struct Entry
+            {
+                route config;
+                uint32_t index = 0;                 // Position in declaration order
+                std::vector<std::string> segments;
+                bool wildcard = false;              // Has a "*" or "**" segment
+                std::atomic_uint64_t requests{0};   // Requests that were routed here
+                std::atomic_uint64_t rejected{0};   // Requests with a method or Content-Format that is not accepted
+                std::atomic_uint64_t limited{0};    // Requests that were answered with 4.29
+            };
+
+        private:
+            /**
+             * @brief A node of the trie
+             */
+            struct node
+            {
+                std::vector<std::pair<std::string, uint32_t>> children;    // Literal segments, sorted
+                int32_t any = -1;       // Child for "*"
+                int32_t rest = -1;      // Entry for "**"
+                int32_t entry = -1;     // Entry of the path ending here
+            };
+
+            /**
+             * @brief Nodes of the trie, the first one is the root
+             */
+            std::vector<node> nodes;
+
+            /**
+             * @brief The compiled resources. A deque so that entries keep their address.
+             */
+            std::deque<Entry> entries;
+
+            /**
+             * @brief Matches the segments from index on below a node
+             * 
+             * @param current Node index
+             * @param segments The path segments
+             * @param index First segment to match
+             * @return int32_t Entry index, -1 if nothing matches
+             */
+            int32_t match(uint32_t current, const std::vector<std::string_view>& segments, std::size_t index) const;
+
+        public:
+            /**
+             * @brief Parses a resource declaration "<path> [option=value ...]" with the options
+             * methods, formats, pipeline, sinks, rate, burst and class
+             * 
+             * @param declaration The declaration
+             * @param parsed The resource
+             * @return true On success
+             * @return false On failure
+             */
+            static bool Parse(const std::string& declaration, route& parsed);
+
+            /**
+             * @brief Get the resources of a server without resource declarations
+             * 
+             * @param query True if condalf/query should be served
+             * @param latest True if condalf/latest should be served
+             * @return std::vector<route> condalf/data, condalf/test, condalf/query and condalf/latest
+             */
+            static std::vector<route> Defaults(bool query, bool latest);
+
+            /**
+             * @brief Parses a comma separated list of sinks
+             * 
+             * @param value python, influx, plugin, store, relay, latest, all or none
+             * @param sinks The sink bits
+             * @return true On success
+             * @return false Unknown sink
+             */
+            static bool ParseSinks(const std::string& value, unsigned int& sinks);
+
+            /**
+             * @brief Get the bit of a request method
+             * 
+             * @param method Request code
+             * @return unsigned int The bit, 0 if it is not a request method
+             */
+            static unsigned int MethodBit(unsigned int method)
+            {
+                return method >= 1 && method < 32 ? 1u << method : 0;
+            }
+
+            /**
+             * @brief Replaces the resources and builds the trie
+             * 
+             * @param routes The resources
+             * @return true On success
+             * @return false A path was declared twice or has a "**" before its last segment
+             */
+            bool Compile(const std::vector<route>& routes);
+
+            /**
+             * @brief Finds the resource of a request path
+             * 
+             * @param path Path without leading slash
+             * @return Entry* The resource, nullptr if there is none
+             */
+            Entry* Find(std::string_view path);
+
+            /**
+             * @brief Get the compiled resources
+             * 
+             * @return const std::deque<Entry>& The resources in declaration order
+             */
+            const std::deque<Entry>& Entries() const { return entries; }
+
+            /**
+             * @brief Get the statistics of the resources
+             * 
+             * @return std::string One "<path> requests=N rejected=N limited=N" per resource, separated by ", "
+             */
+            std::string GetStatistics() const;
+    };
+}
\ No newline at end of file
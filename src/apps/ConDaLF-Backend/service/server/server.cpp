@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <functional>
-#include <python/python_integration.hpp>
+#include <memory>
+#include <python/python_worker.hpp>
+#include <python/python_pool.hpp>
 #include <common/logging/logging.h>
+#include <common/senml/senml.hpp>
 #include <apps/ConDaLF-Backend/service/relay/relay.hpp>
+#include <sys/socket.h>
 #include <sys/types.h>
 
 #include "server.hpp"
@@ -10,45 +16,710 @@
 
 using namespace condalf::service;
 
-bool g_python_enabled = false;          // Python Processing enabled?
+condalf::PythonWorker* g_python_worker = nullptr;   // Python Processing if enabled
+condalf::PythonPool* g_python_pool = nullptr;       // Python Processing in worker processes if enabled
 MessageQueue* g_msg_queue = nullptr;       // The Relay service itself
+condalf::sink::InfluxSink* g_influx_sink = nullptr;    // InfluxDB sink if configured
+condalf::sink::PluginSink* g_plugin_sink = nullptr;    // Native sink plugin if loaded
+condalf::sink::Rollup* g_rollup = nullptr;            // Rollup before the sinks if configured
+condalf::sink::ReorderBuffer* g_reorder = nullptr;    // Puts points in time order before the store, the rollup and the sinks if configured
+unsigned int g_reorder_late = 0;                      // Sinks of the points that are too late for the reorder buffer
+condalf::store::TimeSeriesStore* g_store = nullptr;    // Time series store if configured
+condalf::store::StoreQuery* g_store_query = nullptr;    // Queries on the time series store
+condalf::store::LastValueCache* g_latest = nullptr;     // Latest value of every series if configured
+condalf::service::RouteTable* g_routes = nullptr;       // Routes requests to the pipelines of the resources
+condalf::service::RateLimiter* g_rate_limiter = nullptr;  // Token buckets of the resources with a rate
+condalf::service::FairScheduler* g_scheduler = nullptr;   // Processes payloads fairly across clients if configured
+condalf::service::DedupWindow* g_dedup = nullptr;         // Suppresses payloads that are uploaded again if configured
+condalf::service::DeviceTable* g_devices = nullptr;       // Activity of the devices if configured
 
-COAP_RESOURCE_HANDLER(handle_condalf_test_get)
+/**
+ * @brief Answers "valid" (test pipeline)
+ * 
+ * @param path Path of the request
+ * @param response CoAP response
+ */
+static void handle_test(const std::string &path, coap_pdu_t *response)
 {
-    common::logging::log_information(std::cout, LINE_INFORMATION, "Received GET on /condalf/test");
+    common::logging::log_information(std::cout, LINE_INFORMATION, "Received request on /" + path);
     coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
     coap_add_data(response, 5, (const uint8_t *)"valid");
 }
 
-COAP_RESOURCE_HANDLER(handle_condalf_data_put)
+/**
+ * @brief Answers a query on the time series store (query pipeline)
+ * 
+ * @param session The CoAP session, identifies the client
+ * @param request The CoAP request
+ * @param query Uri-Query of the request
+ * @param response CoAP response
+ */
+static void handle_query(coap_session_t *session, const coap_pdu_t *request, const coap_string_t *query, coap_pdu_t *response)
+{
+    if (g_store_query == nullptr)
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        return;
+    }
+
+    // Blocks after the first one are served from the result of the first one
+    coap_block_t block2 = {};
+    bool fresh = !coap_get_block(request, COAP_OPTION_BLOCK2, &block2) || block2.num == 0;
+    std::string query_string = query != nullptr ? std::string((const char *)query->s, query->length) : "";
+
+    condalf::store::StoreQuery::Result result;
+    switch (g_store_query->Execute(coap_session_str(session), query_string, fresh, result))
+    {
+        case condalf::store::StoreQuery::Status::BAD_REQUEST:
+            coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+            return;
+        case condalf::store::StoreQuery::Status::NOT_FOUND:
+            coap_pdu_set_code(response, COAP_RESPONSE_CODE_NOT_FOUND);
+            return;
+        default:
+            break;
+    }
+
+    common::CoAP::getInstance().AddBlockedResponse(request, response,
+                                                   result.senml ? COAP_MEDIATYPE_APPLICATION_SENML_JSON : COAP_MEDIATYPE_APPLICATION_JSON,
+                                                   (const uint8_t *)result.body->data(), result.body->size());
+}
+
+/**
+ * @brief Answers with the latest values of the series (latest pipeline). Observers run through here for every notification.
+ * 
+ * @param request The CoAP request
+ * @param query Uri-Query of the request
+ * @param response CoAP response
+ */
+static void handle_latest(const coap_pdu_t *request, const coap_string_t *query, coap_pdu_t *response)
+{
+    if (g_latest == nullptr)
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        return;
+    }
+
+    // The generation is the ETag, so a client notices when the values changed between the blocks of a transfer
+    uint64_t generation = g_latest->Generation();
+    std::string query_string = query != nullptr ? std::string((const char *)query->s, query->length) : "";
+    std::string body;
+    if (!g_latest->Render(query_string, body))
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return;
+    }
+
+    uint8_t etag[8];
+    for (int i = 0; i < 8; i++)
+        etag[i] = static_cast<uint8_t>(generation >> (56 - 8 * i));
+    coap_add_option(response, COAP_OPTION_ETAG, sizeof(etag), etag);
+    common::CoAP::getInstance().AddBlockedResponse(request, response, COAP_MEDIATYPE_APPLICATION_SENML_JSON,
+                                                   (const uint8_t *)body.data(), body.size());
+}
+
+/**
+ * @brief Decodes the payload according to its content format.
+ * 
+ * @param content_format Content-Format of the request
+ * @param payload The payload
+ * @param pack The decoded records
+ * @return true On success
+ * @return false Malformed payload
+ */
+bool decode_payload(uint16_t content_format, const std::vector<uint8_t> &payload, common::senml::Pack &pack)
+{
+    if (content_format == COAP_MEDIATYPE_APPLICATION_SENML_JSON || content_format == COAP_MEDIATYPE_APPLICATION_JSON)
+        return common::senml::decode_json(payload.data(), payload.size(), pack);
+    return common::senml::decode_cbor(payload.data(), payload.size(), pack);
+}
+
+/**
+ * @brief Get the current time
+ * 
+ * @return double Seconds since the epoch
+ */
+double now_seconds()
+{
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Get the current time
+ * 
+ * @return int64_t ns since the epoch
+ */
+int64_t now_nanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Hands records without a payload (closed rollup windows) to the sinks that fed their series
+ * 
+ * @param closed The records by their sinks
+ */
+void submit_rollups(std::vector<condalf::sink::sink_batch> &&closed)
+{
+    using condalf::service::RouteTable;
+
+    for (auto &batch : closed)
+    {
+        if (batch.pack.records.empty())
+            continue;
+
+        if (g_influx_sink != nullptr && (batch.sinks & RouteTable::SINK_INFLUX))
+            g_influx_sink->Process(batch.pack);
+
+        // There is no payload for windows that were closed by the timer
+        if (g_plugin_sink != nullptr && (batch.sinks & RouteTable::SINK_PLUGIN))
+        {
+            condalf::sink::PluginSink::Job job;
+            job.payload = std::make_shared<const std::vector<uint8_t>>();
+            job.json = true;
+            job.pack = std::move(batch.pack);
+            g_plugin_sink->Submit(std::move(job));
+        }
+    }
+}
+
+/**
+ * @brief Hands the points that the reorder buffer released on its timer to the store, the rollup and the sinks
+ * that fed their series
+ * 
+ * @param released The records by their sinks
+ */
+void submit_released(std::vector<condalf::sink::sink_batch> &&released)
+{
+    using condalf::service::RouteTable;
+
+    for (auto &batch : released)
+    {
+        if (g_store != nullptr && (batch.sinks & RouteTable::SINK_STORE))
+            g_store->Insert(batch.pack);
+
+        // Only InfluxDB and the plugin get windows
+        if (g_rollup != nullptr && (batch.sinks & (RouteTable::SINK_INFLUX | RouteTable::SINK_PLUGIN)))
+        {
+            common::senml::Pack rolled;
+            g_rollup->Process(batch.pack, batch.sinks, rolled);
+            batch.pack = std::move(rolled);
+        }
+    }
+    submit_rollups(std::move(released));
+}
+
+/**
+ * @brief What the ingest pipeline asks to answer
+ */
+enum class IngestResult
+{
+    OK,
+    BAD_REQUEST,    // Malformed pack
+    RETRY           // Python did not accept the payload
+};
+
+/**
+ * @brief Checks if a native stage (InfluxDB, the sink plugin, the store or the last value cache) reads the records
+ * 
+ * @param sinks Sink bits of the resource
+ * @return true If one of them is bound and enabled
+ */
+static bool feeds_records(unsigned int sinks)
+{
+    using condalf::service::RouteTable;
+    return ((sinks & RouteTable::SINK_INFLUX) && g_influx_sink != nullptr) || ((sinks & RouteTable::SINK_PLUGIN) && g_plugin_sink != nullptr)
+        || ((sinks & RouteTable::SINK_STORE) && g_store != nullptr) || ((sinks & RouteTable::SINK_LATEST) && g_latest != nullptr);
+}
+
+/**
+ * @brief Checks if Python gets the decoded pack
+ * 
+ * @param sinks Sink bits of the resource
+ * @return true If Python is bound and its script takes records or runs in a pool
+ */
+static bool python_records(unsigned int sinks)
+{
+    using condalf::service::RouteTable;
+    return (sinks & RouteTable::SINK_PYTHON) && ((g_python_worker != nullptr && g_python_worker->WantsRecords()) || g_python_pool != nullptr);
+}
+
+/**
+ * @brief Relays and decodes a payload (first stage of the ingest pipeline). It runs on the IO thread,
+ * also with the fair scheduler, so that a malformed pack is answered with 4.00.
+ * 
+ * @param ingest The payload, its pack gets the records if anyone needs them
+ * @return IngestResult BAD_REQUEST for a malformed pack
+ */
+static IngestResult decode_ingest(condalf::service::FairScheduler::Job &ingest)
+{
+    using condalf::service::RouteTable;
+
+    // Only the sinks bound to the resource are fed
+    unsigned int sinks = ingest.sinks;
+    MessageQueue *msg_queue = (sinks & RouteTable::SINK_RELAY) ? g_msg_queue : nullptr;
+
+    // Relay if enabled, the payload is shared with the relay sessions instead of being copied
+    if (msg_queue != nullptr)
+    {
+        msg_queue->Insert(new MessageQueue::Message {
+            .type = COAP_MESSAGE_CON,
+            .code = static_cast<coap_pdu_code_t>(ingest.code),
+            .uri = ingest.path,
+            .content_format = ingest.content_format,
+            .data = ingest.payload
+        });
+    }
+
+    // Decode natively if anyone needs the records
+    if (!feeds_records(sinks) && !python_records(sinks))
+        return IngestResult::OK;
+
+    if (!decode_payload(ingest.content_format, *ingest.payload, ingest.pack))
+    {
+        common::logging::log_warning(std::cout, LINE_INFORMATION, "Received malformed SenML pack on /" + ingest.path + ".");
+        return IngestResult::BAD_REQUEST;
+    }
+
+    // Times are resolved against the receive time once, the stages after the decoder get absolute ns
+    if (!common::senml::normalize_times(ingest.pack, ingest.received))
+    {
+        common::logging::log_warning(std::cout, LINE_INFORMATION, "Received SenML pack with invalid time on /" + ingest.path + ".");
+        return IngestResult::BAD_REQUEST;
+    }
+
+    // The stages after the decoder work on series ids
+    condalf::sink::SeriesDictionary::getInstance().Assign(ingest.pack);
+    ingest.decoded = true;
+    return IngestResult::OK;
+}
+
+/**
+ * @brief Hands a payload to Python
+ * 
+ * @param ingest The decoded payload
+ * @param copy Copy the pack because later stages still read it, otherwise Python takes it
+ * @return IngestResult RETRY if Python did not accept the payload
+ */
+static IngestResult submit_python(condalf::service::FairScheduler::Job &ingest, bool copy)
+{
+    using condalf::service::RouteTable;
+
+    unsigned int sinks = ingest.sinks;
+    bool json = ingest.content_format == COAP_MEDIATYPE_APPLICATION_SENML_JSON || ingest.content_format == COAP_MEDIATYPE_APPLICATION_JSON;
+    condalf::PythonWorker *python_worker = (sinks & RouteTable::SINK_PYTHON) ? g_python_worker : nullptr;
+    condalf::PythonPool *python_pool = (sinks & RouteTable::SINK_PYTHON) ? g_python_pool : nullptr;
+
+    // JSON for scripts without process_records or process_columns was already answered with 4.15 (see handle_ingest).
+    if ((python_worker == nullptr || (!python_worker->WantsRecords() && json)) && python_pool == nullptr)
+        return IngestResult::OK;
+
+    condalf::PythonWorker::Job job;
+    job.payload = ingest.payload;
+    job.json = json;
+    job.decoded = python_records(sinks);
+    job.received = ingest.received;
+    if (job.decoded && copy)
+    {
+        // Python frees its pack while the later stages might still read it, so the copy gets its own strings
+        job.pack.records.reserve(ingest.pack.records.size());
+        for (const auto& record : ingest.pack.records)
+            common::senml::append_record(record, job.pack);
+    }
+    else if (job.decoded)
+        job.pack = std::move(ingest.pack);
+
+    bool accepted = python_pool != nullptr ? python_pool->Submit(std::move(job)) : python_worker->Submit(std::move(job));
+    return accepted ? IngestResult::OK : IngestResult::RETRY;
+}
+
+/**
+ * @brief Feeds the sinks of its resource with a decoded payload (rest of the ingest pipeline).
+ * Runs on the scheduler thread if there is one.
+ * 
+ * @param ingest The payload that decode_ingest decoded
+ * @param python Hand the payload to Python at the end, false if it already got it
+ * @return IngestResult What to answer if the response is still open
+ */
+static IngestResult process_ingest(condalf::service::FairScheduler::Job &ingest, bool python)
+{
+    using condalf::service::RouteTable;
+
+    // Only the sinks bound to the resource are fed
+    unsigned int sinks = ingest.sinks;
+    bool json = ingest.content_format == COAP_MEDIATYPE_APPLICATION_SENML_JSON || ingest.content_format == COAP_MEDIATYPE_APPLICATION_JSON;
+    condalf::sink::InfluxSink *influx_sink = (sinks & RouteTable::SINK_INFLUX) ? g_influx_sink : nullptr;
+    condalf::sink::PluginSink *plugin_sink = (sinks & RouteTable::SINK_PLUGIN) ? g_plugin_sink : nullptr;
+    condalf::store::TimeSeriesStore *store = (sinks & RouteTable::SINK_STORE) ? g_store : nullptr;
+    condalf::store::LastValueCache *latest = (sinks & RouteTable::SINK_LATEST) ? g_latest : nullptr;
+    condalf::sink::Rollup *rollup = influx_sink != nullptr || plugin_sink != nullptr ? g_rollup : nullptr;
+    common::senml::Pack &pack = ingest.pack;
+    bool python_pack = python && python_records(sinks);
+
+    // Observers of condalf/latest are notified by the IO thread
+    if (latest != nullptr)
+        latest->Update(pack);
+
+    // Numeric points are put back into time order before the store, the rollup and the sinks.
+    // Python and the last value cache get them as they came.
+    common::senml::Pack ordered;
+    bool reorder = g_reorder != nullptr && (store != nullptr || rollup != nullptr || influx_sink != nullptr || plugin_sink != nullptr);
+    if (reorder)
+    {
+        common::senml::Pack late;
+        g_reorder->Process(pack, ingest.received, sinks, ordered, late);
+
+        // Points that are too late go to the side channel, InfluxDB takes them out of order
+        if (!late.records.empty() && influx_sink != nullptr && (g_reorder_late & RouteTable::SINK_INFLUX))
+            influx_sink->Process(late);
+        if (!late.records.empty() && plugin_sink != nullptr && (g_reorder_late & RouteTable::SINK_PLUGIN))
+        {
+            // The late records still point into the payload
+            condalf::sink::PluginSink::Job job;
+            job.payload = ingest.payload;
+            job.json = json;
+            job.pack = std::move(late);
+            plugin_sink->Submit(std::move(job));
+        }
+    }
+    common::senml::Pack &timed = reorder ? ordered : pack;
+
+    // Keep the numeric records for condalf/query
+    if (store != nullptr)
+        store->Insert(timed);
+
+    // Numeric series are rolled up before the sinks, Python and the store still get every point
+    common::senml::Pack rolled;
+    if (rollup != nullptr)
+        rollup->Process(timed, sinks, rolled);
+    common::senml::Pack &sink_pack = rollup != nullptr ? rolled : timed;
+
+    // Buffer for InfluxDB, the sink writes on its own thread
+    if (influx_sink != nullptr)
+        influx_sink->Process(sink_pack);
+
+    // Queue for the sink plugin, it runs on its own thread. The pack is only copied if Python needs it too,
+    // the copy gets its own strings because Python frees the pack while the plugin might still read it.
+    if (plugin_sink != nullptr)
+    {
+        condalf::sink::PluginSink::Job job;
+        job.payload = ingest.payload;
+        job.json = json;
+        if (python_pack && &sink_pack == &pack)
+        {
+            job.pack.records.reserve(pack.records.size());
+            for (const auto& record : pack.records)
+                common::senml::append_record(record, job.pack);
+        }
+        else
+            job.pack = std::move(sink_pack);
+        plugin_sink->Submit(std::move(job));
+    }
+
+    // Python Processing if available. The script runs on its own thread, the response goes out right away.
+    if (python)
+        return submit_python(ingest, false);
+    return IngestResult::OK;
+}
+
+/**
+ * @brief Get what identifies a client for rate limiting, duplicate suppression, fair scheduling and the device table
+ * 
+ * @param session The CoAP session
+ * @return std::string_view The remote IP address (without port), the session if it has none
+ */
+static std::string_view client_identity(coap_session_t *session)
+{
+    const coap_address_t *remote = coap_session_get_addr_remote(session);
+    if (remote != nullptr && remote->addr.sa.sa_family == AF_INET)
+        return std::string_view((const char *)&remote->addr.sin.sin_addr, sizeof(remote->addr.sin.sin_addr));
+    if (remote != nullptr && remote->addr.sa.sa_family == AF_INET6)
+        return std::string_view((const char *)&remote->addr.sin6.sin6_addr, sizeof(remote->addr.sin6.sin6_addr));
+    return coap_session_str(session);
+}
+
+/**
+ * @brief Reassembles the payload of an ingest resource and hands it to the fair scheduler,
+ * or processes it right away without one
+ * 
+ * @param route The resource
+ * @param path Path of the request
+ * @param resource The CoAP resource
+ * @param session The CoAP session
+ * @param request The CoAP request
+ * @param response CoAP response
+ */
+static void handle_ingest(condalf::service::RouteTable::Entry &route, const std::string &path, coap_resource_t *resource, coap_session_t *session, const coap_pdu_t *request, coap_pdu_t *response)
 {
     std::vector<uint8_t> data = common::CoAP::getInstance().ResourceBlockHandler(resource, session, request, response);
-    std::string str(data.begin(), data.end());
     
     // We have a complete message
-    if (data.size() != 0)
+    if (data.size() == 0)
+        return;
+
+    common::logging::log_information(std::cout, LINE_INFORMATION, "Received request on /" + path + " with size " + std::to_string(data.size()));
+
+    // The first format of the resource is assumed when there is no Content-Format
+    const std::vector<uint16_t> &formats = route.config.formats;
+    uint16_t content_format = formats.empty() ? COAP_MEDIATYPE_APPLICATION_SENML_CBOR : formats.front();
+    common::CoAP::getInstance().GetContentFormat(request, content_format);
+    if (std::find(formats.begin(), formats.end(), content_format) == formats.end())
+    {
+        common::logging::log_warning(std::cout, LINE_INFORMATION, "Unsupported Content-Format " + std::to_string(content_format) + " on /" + path + ".");
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_UNSUPPORTED_CONTENT_FORMAT);
+        route.rejected++;
+        return;
+    }
+
+    // A script with only process_data gets the raw payload, which it expects as SenML CBOR
+    bool json = content_format == COAP_MEDIATYPE_APPLICATION_SENML_JSON || content_format == COAP_MEDIATYPE_APPLICATION_JSON;
+    if (json && (route.config.sinks & condalf::service::RouteTable::SINK_PYTHON) && g_python_worker != nullptr && !g_python_worker->WantsRecords())
     {
-        common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Received PUT on /condalf/data with size ") + std::to_string(data.size()));
-        // Relay if enabled
-        if (g_msg_queue != nullptr)
+        common::logging::log_warning(std::cout, LINE_INFORMATION, "SenML JSON on /" + path + " can only be processed by scripts that define process_records or process_columns.");
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_UNSUPPORTED_CONTENT_FORMAT);
+        route.rejected++;
+        return;
+    }
+
+    // A client that restarts an upload because the last ACK went missing is acknowledged without processing it again
+    uint64_t dedup_key = g_dedup != nullptr ? condalf::service::DedupWindow::Key(client_identity(session), path, data) : 0;
+    if (g_dedup != nullptr && g_dedup->Seen(dedup_key))
+    {
+        common::logging::log_information(std::cout, LINE_INFORMATION, "Received duplicate payload on /" + path + ". Ignoring payload.");
+        return;
+    }
+
+    condalf::service::FairScheduler::Job ingest;
+    ingest.path = path;
+    ingest.code = static_cast<uint8_t>(coap_pdu_get_code(request));
+    ingest.sinks = route.config.sinks;
+    ingest.content_format = content_format;
+    ingest.received = now_nanoseconds();
+    ingest.payload = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+
+    // With the fair scheduler the rest of the pipeline runs on its thread and the response goes out right away.
+    // The pack is decoded and Python gets it before that, so that 4.00 and 5.03 still reach the client.
+    IngestResult result = decode_ingest(ingest);
+    if (result == IngestResult::OK && g_scheduler != nullptr)
+    {
+        // Payloads that only Python or the relay get are not queued
+        bool later = feeds_records(ingest.sinks);
+        result = submit_python(ingest, later);
+        if (result == IngestResult::OK && later && !g_scheduler->Submit(route.config.class_name, client_identity(session), std::move(ingest)))
+            common::CoAP::getInstance().SetRetryResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE, CONDALF_SCHEDULE_RETRY_AFTER);
+    }
+    else if (result == IngestResult::OK)
+        result = process_ingest(ingest, true);
+
+    switch (result)
+    {
+        case IngestResult::BAD_REQUEST:
+            coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+            break;
+        case IngestResult::RETRY:
+            common::CoAP::getInstance().SetRetryResponse(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE, CONDALF_PYTHON_RETRY_AFTER);
+            break;
+        default:
+            break;
+    }
+
+    // Only accepted payloads are remembered, a retry after 4.00 or 5.03 has to be processed
+    if (g_dedup != nullptr && (coap_pdu_get_code(response) >> 5) == 2)
+        g_dedup->Remember(dedup_key);
+}
+
+/**
+ * @brief Records an ingest request in the device table. Every block counts its bytes,
+ * the transfer is counted once it is answered with anything but 2.31 Continue.
+ * 
+ * @param session The CoAP session
+ * @param request The CoAP request
+ * @param response CoAP response
+ */
+static void record_device(coap_session_t *session, const coap_pdu_t *request, const coap_pdu_t *response)
+{
+    if (g_devices == nullptr)
+        return;
+
+    size_t length = 0;
+    const uint8_t *data = nullptr;
+    if (!coap_get_data(request, &length, &data))
+        length = 0;
+
+    coap_pdu_code_t code = coap_pdu_get_code(response);
+    g_devices->Record(client_identity(session), length, code != COAP_RESPONSE_CODE_CONTINUE, (code >> 5) >= 4);
+}
+
+COAP_RESOURCE_HANDLER(handle_route)
+{
+    using condalf::service::RouteTable;
+
+    // Libcoap only finds the resource, the trie decides which pipeline handles the request
+    std::string path;
+    coap_string_t *uri_path = coap_get_uri_path(request);
+    if (uri_path != nullptr)
+    {
+        path.assign((const char *)uri_path->s, uri_path->length);
+        coap_delete_string(uri_path);
+    }
+
+    RouteTable::Entry *route = g_routes != nullptr ? g_routes->Find(path) : nullptr;
+    if (route == nullptr)
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_NOT_FOUND);
+        return;
+    }
+
+    route->requests++;
+    if ((route->config.methods & RouteTable::MethodBit(coap_pdu_get_code(request))) == 0)
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_NOT_ALLOWED);
+        route->rejected++;
+        return;
+    }
+
+    // The rate applies to whole transfers, following blocks of a transfer are not limited
+    coap_block_t block1 = {};
+    bool first_block = !coap_get_block(request, COAP_OPTION_BLOCK1, &block1) || block1.num == 0;
+    uint32_t retry_after = 1;
+    if (route->config.rate > 0 && g_rate_limiter != nullptr && first_block &&
+        !g_rate_limiter->Allow(client_identity(session), route->index, route->config.rate, route->config.burst, retry_after))
+    {
+        common::CoAP::getInstance().SetRetryResponse(response, COAP_RESPONSE_CODE_TOO_MANY_REQUESTS, retry_after);
+        route->limited++;
+        if (route->config.pipeline == RouteTable::Pipeline::INGEST)
+            record_device(session, request, response);
+        return;
+    }
+
+    switch (route->config.pipeline)
+    {
+        case RouteTable::Pipeline::INGEST:
+            handle_ingest(*route, path, resource, session, request, response);
+            record_device(session, request, response);
+            break;
+        case RouteTable::Pipeline::QUERY:
+            handle_query(session, request, query, response);
+            break;
+        case RouteTable::Pipeline::LATEST:
+            handle_latest(request, query, response);
+            break;
+        case RouteTable::Pipeline::TEST:
+            handle_test(path, response);
+            break;
+    }
+}
+
+bool Server::load_config()
+{
+    config = ServerConfig();
+    if (config_file.empty())
+        return true;
+    return config.Load(config_file);
+}
+
+bool Server::enable_sinks()
+{
+    g_influx_sink = nullptr;
+    g_plugin_sink = nullptr;
+    g_store = nullptr;
+    g_store_query = nullptr;
+    g_latest = nullptr;
+    g_rollup = nullptr;
+    g_reorder = nullptr;
+
+    // Series ids are handed out from 0 again, so that series that are gone free their ids. The reorder buffer and
+    // the rollup were flushed when the sinks were disabled, the store and the latest values move to the new ids.
+    std::vector<std::string> names = condalf::sink::SeriesDictionary::getInstance().Reset();
+    condalf::sink::SeriesDictionary::getInstance().SetLimit(config.series_limit);
+    store.Rekey(names);
+    latest.Rekey(names);
+
+    if (config.reorder_enabled)
+    {
+        reorder.Configure(config.reorder);
+        next_reorder_flush = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        g_reorder_late = config.reorder_late_sinks;
+        g_reorder = &reorder;
+    }
+
+    if (config.rollup_enabled)
+    {
+        rollup.Configure(config.rollup);
+        next_rollup_flush = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        g_rollup = &rollup;
+    }
+
+    if (config.store_enabled)
+    {
+        // Points are kept over reloads unless the options changed
+        store.Configure(config.store);
+        g_store = &store;
+        g_store_query = &store_query;
+    }
+    else
+        store.Clear();
+
+    if (config.latest_enabled)
+    {
+        // Values are kept over reloads unless the number of series changed
+        latest.Configure(config.latest);
+        g_latest = &latest;
+    }
+    else
+        latest.Clear();
+
+    if (config.influx_enabled)
+    {
+        if (!influx_sink.Start(config.influx))
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not start InfluxDB sink.");
+            return false;
+        }
+        g_influx_sink = &influx_sink;
+    }
+
+    if (!plugin_file.empty())
+    {
+        config.plugin.path = plugin_file;
+        if (!plugin_sink.Start(config.plugin))
         {
-            // Copy data
-            uint8_t* data_copy = new u_int8_t[data.size()];
-            std::memcpy(data_copy, &data[0], data.size());
-
-            g_msg_queue->Insert(new MessageQueue::Message {
-                .type = COAP_MESSAGE_CON,
-                .code = COAP_REQUEST_CODE_PUT,
-                .uri = "condalf/data",
-                .data = data_copy,
-                .data_size = data.size()
-            });
+            common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not start sink plugin.");
+            disable_sinks(); // Not called by the service for a failing hook
+            return false;
         }
+        g_plugin_sink = &plugin_sink;
+    }
+    return true;
+}
 
-        // Python Processing if available
-        if (g_python_enabled)
-            condalf::python_process_data(data);
+bool Server::disable_sinks()
+{
+    // Buffered points and open windows are written before the sinks stop
+    if (g_reorder != nullptr)
+    {
+        std::vector<condalf::sink::sink_batch> released;
+        g_reorder->FlushAll(released);
+        submit_released(std::move(released));
+    }
+    if (g_rollup != nullptr)
+    {
+        std::vector<condalf::sink::sink_batch> closed;
+        g_rollup->FlushAll(closed);
+        submit_rollups(std::move(closed));
     }
+
+    g_reorder = nullptr;
+    g_rollup = nullptr;
+    g_influx_sink = nullptr;
+    g_plugin_sink = nullptr;
+    g_store = nullptr;
+    g_store_query = nullptr;
+    g_latest = nullptr;
+    store_query.Clear();
+    influx_sink.Stop();
+    plugin_sink.Stop();
+    return true;
 }
 
 bool Server::enable_coap()
@@ -71,33 +742,115 @@ bool Server::enable_coap()
         return false;
     }
 
-    // Create resource /condalf/data - failure -> return
-    coap_condalf_data_res = coap->CreateResource("condalf/data");
-    if (coap_condalf_data_res == COAP_INVALID_RVALUE)
+    // Create DTLS Endpoint if credentials were given
+    if (dtls_enabled && !coap->CreateEndpoint(coap_context, host, secure_port, &security))
     {
-        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create resource. Exiting.");
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create DTLS endpoint. Exiting.");
         return false;
     }
 
-    // Create resource /condalf/data - failure -> return
-    coap_condalf_test_res = coap->CreateResource("condalf/test");
-    if (coap_condalf_test_res == COAP_INVALID_RVALUE)
+    // Compile the declared resources, the defaults serve condalf/data, condalf/test, condalf/query and condalf/latest
+    if (!routes.Compile(config.routes.empty() ? RouteTable::Defaults(config.store_enabled, config.latest_enabled) : config.routes))
     {
-        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create resource. Exiting.");
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not compile resources. Exiting.");
         return false;
     }
 
-    // Register and assign resource to context
-    coap->RegisterResourceHandler(coap_condalf_test_res, 
-                                  COAP_REQUEST_GET, 
-                                  handle_condalf_test_get);
+    // Every literal path gets a resource of its own (listed in .well-known/core), paths with wildcards are caught
+    // by the resource for unknown paths. All requests are dispatched by handle_route.
+    static const coap_request_t methods[] = { COAP_REQUEST_GET, COAP_REQUEST_POST, COAP_REQUEST_PUT, COAP_REQUEST_DELETE,
+                                              COAP_REQUEST_FETCH, COAP_REQUEST_PATCH, COAP_REQUEST_IPATCH };
+    unsigned int wildcard_methods = 0;
+    latest_resources.clear();
+    for (const auto& route : routes.Entries())
+    {
+        if (route.wildcard)
+        {
+            wildcard_methods |= route.config.methods;
+            continue;
+        }
 
-    coap->RegisterResourceHandler(coap_condalf_data_res, 
-                                  COAP_REQUEST_PUT, 
-                                  handle_condalf_data_put);
+        common::CoAP::resource_ptr resource = coap->CreateResource(route.config.path);
+        if (resource == COAP_INVALID_RVALUE)
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create resource. Exiting.");
+            return false;
+        }
+        for (coap_request_t method : methods)
+        {
+            if (route.config.methods & RouteTable::MethodBit(method))
+                coap->RegisterResourceHandler(resource, method, handle_route);
+        }
+
+        // Only resources of their own can be observed, not the resource for unknown paths
+        if (route.config.pipeline == RouteTable::Pipeline::LATEST)
+        {
+            coap->SetObservable(resource);
+            latest_resources.push_back(resource);
+        }
+        coap->AddResource(coap_context, resource);
+    }
+    next_latest_notify = std::chrono::steady_clock::now();
+
+    if (wildcard_methods != 0)
+    {
+        common::CoAP::resource_ptr resource = coap->CreateUnknownResource(handle_route);
+        if (resource == COAP_INVALID_RVALUE)
+        {
+            common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not create resource. Exiting.");
+            return false;
+        }
+        for (coap_request_t method : methods)
+        {
+            if (wildcard_methods & RouteTable::MethodBit(method))
+                coap->RegisterResourceHandler(resource, method, handle_route);
+        }
+        coap->AddResource(coap_context, resource);
+    }
+
+    // Buckets are dropped on reload since the rates may have changed
+    rate_limiter.Configure(config.rate_limit_clients, routes.Entries().size());
+    g_rate_limiter = &rate_limiter;
+
+    // Remembered payloads are dropped on reload as well
+    g_dedup = nullptr;
+    if (config.dedup_window > 0)
+    {
+        dedup.Configure(config.dedup_window, config.dedup_entries);
+        g_dedup = &dedup;
+    }
+
+    // The devices are tracked again from scratch as well
+    g_devices = nullptr;
+    if (config.device_max > 0)
+    {
+        devices.Configure(config.device_max, config.device_stale);
+        g_devices = &devices;
+    }
+    g_routes = &routes;
+    return true;
+}
+
+bool Server::enable_scheduler()
+{
+    g_scheduler = nullptr;
+    if (!config.schedule_enabled)
+        return true;
 
-    coap->AddResource(coap_context, coap_condalf_data_res);
-    coap->AddResource(coap_context, coap_condalf_test_res);
+    if (!scheduler.Start(config.schedule, [](condalf::service::FairScheduler::Job &job) { process_ingest(job, false); }))
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "Could not start fair scheduler.");
+        return false;
+    }
+    g_scheduler = &scheduler;
+    return true;
+}
+
+bool Server::disable_scheduler()
+{
+    // Waiting payloads are processed while Python and the sinks still run
+    g_scheduler = nullptr;
+    scheduler.Stop();
     return true;
 }
 
@@ -105,6 +858,11 @@ bool Server::disable_coap()
 {
     // Get CoAP Instance
     common::CoAP *coap = &common::CoAP::getInstance();
+    g_routes = nullptr;
+    g_rate_limiter = nullptr;
+    g_dedup = nullptr;
+    g_devices = nullptr;
+    latest_resources.clear();
 
     // Release our context -> will free everything associated with it
     coap->ReleaseContext(coap_context);
@@ -113,26 +871,33 @@ bool Server::disable_coap()
 
 bool Server::enable_python()
 {
-    g_python_enabled = false;
-    // Initialize Python if it is enabled
-    if (python_enabled)
+    g_python_worker = nullptr;
+    g_python_pool = nullptr;
+    if (!python_enabled)
+        return true;
+
+    // Several workers run in their own processes, a single one runs on a thread
+    if (config.python.workers > 1)
     {
-        if (condalf::initialize_python(python_script))
-        {
-            g_python_enabled = true;
-            return true;
-        }
-        return false;
+        if (!python_pool.Start(python_script, config.python))
+            return false;
+        g_python_pool = &python_pool;
+        return true;
     }
+
+    if (!python_worker.Start(python_script, config.python))
+        return false;
+    g_python_worker = &python_worker;
     return true;
 }
 
 bool Server::disable_python()
 {
-    g_python_enabled = false;
-    // Uninit Python when required
-    if (python_enabled)
-        condalf::uninitialize_python();
+    g_python_worker = nullptr;
+    g_python_pool = nullptr;
+    // Stop the Python thread or processes, queued payloads are still processed
+    python_worker.Stop();
+    python_pool.Stop();
     return true;
 }
 
@@ -141,16 +906,53 @@ void Server::run()
     // Get CoAP Instance
     common::CoAP *coap = &common::CoAP::getInstance();
 
-    // Run IO with timeout of 1 second
-    coap->IO(coap_context, 1000);
+    // Run IO with timeout of 1 second, observers of condalf/latest may need to be notified earlier
+    bool observed = g_latest != nullptr && !latest_resources.empty();
+    coap->IO(coap_context, observed ? std::min<size_t>(1000, g_latest->GetOptions().coalesce) : 1000);
+
+    // Changes are coalesced, observers get at most one notification per interval
+    if (observed && std::chrono::steady_clock::now() >= next_latest_notify && g_latest->TakeChanges())
+    {
+        for (common::CoAP::resource_ptr resource : latest_resources)
+            coap->NotifyObservers(resource);
+        next_latest_notify = std::chrono::steady_clock::now() + std::chrono::milliseconds(g_latest->GetOptions().coalesce);
+    }
+
+    // Release the points of series that went quiet, at most once per second
+    if (g_reorder != nullptr && std::chrono::steady_clock::now() >= next_reorder_flush)
+    {
+        std::vector<condalf::sink::sink_batch> released;
+        g_reorder->Flush(now_nanoseconds(), released);
+        submit_released(std::move(released));
+        next_reorder_flush = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    }
+
+    // Close the windows of series that went quiet, at most once per second
+    if (g_rollup != nullptr && std::chrono::steady_clock::now() >= next_rollup_flush)
+    {
+        std::vector<condalf::sink::sink_batch> closed;
+        g_rollup->Flush(now_seconds(), closed);
+        submit_rollups(std::move(closed));
+        next_rollup_flush = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    }
 }
 
-Server::Server() : Service()
+Server::Server() : Service(), store_query(store)
 {
     // Initialize all values
     this->service_name = "ConDaLF-Backend-Server";
 
     // Bind hooks for the service
+    add_hook(
+        std::bind(&Server::load_config, this),
+        [] { return true; }
+    );
+
+    add_hook(
+        std::bind(&Server::enable_sinks, this),
+        std::bind(&Server::disable_sinks, this)
+    );
+
     add_hook(
         std::bind(&Server::enable_coap, this),
         std::bind(&Server::disable_coap, this)
@@ -160,18 +962,32 @@ Server::Server() : Service()
         std::bind(&Server::enable_python, this),
         std::bind(&Server::disable_python, this)
     );
+
+    add_hook(
+        std::bind(&Server::enable_scheduler, this),
+        std::bind(&Server::disable_scheduler, this)
+    );
 }
 
 bool Server::Start(const std::string& _host,
                    const std::string& _port,
                    MessageQueue* _msg_queue,
                    bool enable_python_script, 
-                   const std::string& _script_file)
+                   const std::string& _script_file,
+                   const std::string& _secure_port,
+                   const common::CoAP::security_config* _security,
+                   const std::string& _config_file,
+                   const std::string& _plugin_file)
 {
     this->host = _host;
     this->port = _port;
     this->python_enabled = enable_python_script;
     this->python_script = _script_file;
+    this->dtls_enabled = _security != nullptr;
+    this->secure_port = _secure_port;
+    this->security = _security != nullptr ? *_security : common::CoAP::security_config();
+    this->config_file = _config_file;
+    this->plugin_file = _plugin_file;
     g_msg_queue = _msg_queue;
     return common::Service::Start();
 }
@@ -181,12 +997,62 @@ bool Server::Reload(const std::string& _host,
                     const std::string& _port,
                     MessageQueue* _msg_queue,
                     bool enable_python_script, 
-                    const std::string& _script_file)
+                    const std::string& _script_file,
+                    const std::string& _secure_port,
+                    const common::CoAP::security_config* _security,
+                    const std::string& _config_file,
+                   const std::string& _plugin_file)
 {
     this->host = _host;
     this->port = _port;
     this->python_enabled = enable_python_script;
     this->python_script = _script_file;
+    this->dtls_enabled = _security != nullptr;
+    this->secure_port = _secure_port;
+    this->security = _security != nullptr ? *_security : common::CoAP::security_config();
+    this->config_file = _config_file;
+    this->plugin_file = _plugin_file;
     g_msg_queue = _msg_queue;
     return common::Service::Reload();
+}
+
+std::string Server::GetStatistics()
+{
+    std::string stats;
+    if (g_routes != nullptr)
+        stats += "resources: " + routes.GetStatistics() + "\n";
+    if (g_rate_limiter != nullptr)
+        stats += "ratelimit: " + rate_limiter.GetStatistics() + "\n";
+    if (g_dedup != nullptr)
+        stats += "dedup: " + dedup.GetStatistics() + "\n";
+    if (g_devices != nullptr)
+        stats += "devices: " + devices.GetStatistics() + "\n";
+    if (scheduler.IsActive())
+        stats += "scheduler: " + scheduler.GetStatistics() + "\n";
+    if (python_worker.IsActive())
+        stats += "python: " + python_worker.GetStatistics() + "\n";
+    if (python_pool.IsActive())
+        stats += "python: " + python_pool.GetStatistics() + "\n";
+    if (influx_sink.IsActive())
+        stats += "influx: " + influx_sink.GetStatistics() + "\n";
+    if (plugin_sink.IsActive())
+        stats += "plugin: " + plugin_sink.GetStatistics() + "\n";
+    if (condalf::sink::SeriesDictionary::getInstance().Size() != 0)
+        stats += "dictionary: " + condalf::sink::SeriesDictionary::getInstance().GetStatistics() + "\n";
+    if (g_reorder != nullptr)
+        stats += "reorder: " + reorder.GetStatistics() + "\n";
+    if (g_rollup != nullptr)
+        stats += "rollup: " + rollup.GetStatistics() + "\n";
+    if (g_store != nullptr)
+        stats += "store: " + store.GetStatistics() + "\n";
+    if (g_latest != nullptr)
+        stats += "latest: " + latest.GetStatistics() + "\n";
+    return stats;
+}
+
+std::string Server::GetDevices()
+{
+    if (g_devices == nullptr)
+        return "";
+    return devices.Dump();
 }
\ No newline at end of file
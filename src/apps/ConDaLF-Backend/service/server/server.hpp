@@ -11,9 +11,19 @@
 
 #pragma once
 
+#include <chrono>
 #include <common/service/service.hpp>
 #include <common/coap/coap.hpp>
 #include <apps/ConDaLF-Backend/service/relay/message_queue.hpp>
+#include <sink/influx_sink.hpp>
+#include <sink/rollup.hpp>
+#include <sink/reorder_buffer.hpp>
+#include <python/python_worker.hpp>
+#include <python/python_pool.hpp>
+#include <store/time_series_store.hpp>
+#include <store/store_query.hpp>
+#include <store/last_value_cache.hpp>
+#include "server_config.hpp"
 
 // TODO: Write Documentation
 
@@ -58,21 +68,155 @@ namespace condalf::service
              */
             std::string port;
             
+            /**
+             * @brief True if a DTLS endpoint should be created
+             */
+            bool dtls_enabled;
+
+            /**
+             * @brief Port of the DTLS endpoint
+             */
+            std::string secure_port;
+
+            /**
+             * @brief Credentials for the DTLS endpoint
+             */
+            common::CoAP::security_config security;
+
+            /**
+             * @brief Path of the server configuration file. Empty if there is none.
+             */
+            std::string config_file;
+
+            /**
+             * @brief Path of the sink plugin. Empty if there is none.
+             */
+            std::string plugin_file;
+
+            /**
+             * @brief Options read from the server configuration file
+             */
+            ServerConfig config;
+
+            /**
+             * @brief Runs the Python script on its own thread
+             */
+            condalf::PythonWorker python_worker;
+
+            /**
+             * @brief Runs the Python script in worker processes (python.workers > 1)
+             */
+            condalf::PythonPool python_pool;
+
+            /**
+             * @brief Writes decoded records to InfluxDB if configured
+             */
+            condalf::sink::InfluxSink influx_sink;
+
+            /**
+             * @brief Hands payloads to the native sink plugin if one was given
+             */
+            condalf::sink::PluginSink plugin_sink;
+
+            /**
+             * @brief Puts numeric points in time order before the store, the rollup and the sinks if configured
+             */
+            condalf::sink::ReorderBuffer reorder;
+
+            /**
+             * @brief When the points of quiet series are released next
+             */
+            std::chrono::steady_clock::time_point next_reorder_flush;
+
+            /**
+             * @brief Rolls numeric series up before the sinks if configured
+             */
+            condalf::sink::Rollup rollup;
+
+            /**
+             * @brief When windows of quiet series are closed next
+             */
+            std::chrono::steady_clock::time_point next_rollup_flush;
+
+            /**
+             * @brief Keeps recent records in memory if configured
+             */
+            condalf::store::TimeSeriesStore store;
+
+            /**
+             * @brief Answers queries on the /condalf/query resource
+             */
+            condalf::store::StoreQuery store_query;
+
+            /**
+             * @brief Latest value of every series for the latest resources if configured
+             */
+            condalf::store::LastValueCache latest;
+
+            /**
+             * @brief Literal resources of the latest pipeline, their observers are notified when values changed
+             */
+            std::vector<common::CoAP::resource_ptr> latest_resources;
+
+            /**
+             * @brief When the observers of the latest resources may be notified next
+             */
+            std::chrono::steady_clock::time_point next_latest_notify;
+
             /**
              * @brief The coap context being used for the coap server
              */
             common::CoAP::context_descriptor coap_context;
             
             /**
-             * @brief The /condalf/data resource
+             * @brief The resources of the server and the trie that routes requests to them
+             */
+            RouteTable routes;
+
+            /**
+             * @brief Token buckets of the resources with a rate
+             */
+            RateLimiter rate_limiter;
+
+            /**
+             * @brief Processes the payloads of ingest resources fairly across clients if configured
+             */
+            FairScheduler scheduler;
+
+            /**
+             * @brief Remembers recent payloads per client if configured
              */
-            common::CoAP::resource_ptr coap_condalf_data_res;
+            DedupWindow dedup;
 
             /**
-             * @brief The /condalf/test resource
+             * @brief Activity of the devices that send to the ingest resources if configured
              */
-            common::CoAP::resource_ptr coap_condalf_test_res;
+            DeviceTable devices;
             
+            /**
+             * @brief Reads the server configuration file
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool load_config();
+
+            /**
+             * @brief Starts the configured sinks
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool enable_sinks();
+
+            /**
+             * @brief Stops the sinks and writes what they still buffer
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool disable_sinks();
+
             /**
              * @brief Inits CoAP for the Server
              * 
@@ -90,7 +234,7 @@ namespace condalf::service
             bool disable_coap();
 
             /**
-             * @brief Inits Python Processing for the Server
+             * @brief Starts the Python thread or worker processes for the Server
              * 
              * @return true On success
              * @return false On failure
@@ -98,13 +242,29 @@ namespace condalf::service
             bool enable_python();
 
             /**
-             * @brief Destroys Python Processing for the Server
+             * @brief Stops the Python thread or worker processes for the Server
              * 
              * @return true On success
              * @return false On failure
              */
             bool disable_python();
 
+            /**
+             * @brief Starts the fair scheduler if configured
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool enable_scheduler();
+
+            /**
+             * @brief Stops the fair scheduler after processing the payloads that are left
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool disable_scheduler();
+
             /**
              * @brief Construct a new Server object
              * 
@@ -114,7 +274,7 @@ namespace condalf::service
             /**
              * @brief Destroy the Server object
              */
-            ~Server() {}
+            ~Server() { Stop(); }
         
         protected:
             /**
@@ -142,6 +302,10 @@ namespace condalf::service
              * @param _msg_queue nullptr if we do not relay messages
              * @param enable_python_script True of python processing should be used
              * @param _script_file Script file for python processing
+             * @param _secure_port Port of the DTLS endpoint
+             * @param _security Credentials for DTLS. No DTLS endpoint is created when nullptr.
+             * @param _config_file Server configuration file. Defaults are used when empty.
+             * @param _plugin_file Sink plugin to load. No plugin is loaded when empty.
              * 
              * @return true On Success
              * @return false On failure
@@ -150,7 +314,11 @@ namespace condalf::service
                        const std::string& _port = "5683",
                        MessageQueue* _msg_queue = nullptr,
                        bool enable_python_script = false, 
-                       const std::string& _script_file = "");
+                       const std::string& _script_file = "",
+                       const std::string& _secure_port = "5684",
+                       const common::CoAP::security_config* _security = nullptr,
+                       const std::string& _config_file = "",
+                       const std::string& _plugin_file = "");
 
             /**
              * @brief Reloads the Server
@@ -160,6 +328,10 @@ namespace condalf::service
              * @param _msg_queue nullptr if we do not relay messages
              * @param enable_python_script True of python processing should be used
              * @param _script_file Script file for python processing
+             * @param _secure_port Port of the DTLS endpoint
+             * @param _security Credentials for DTLS. No DTLS endpoint is created when nullptr.
+             * @param _config_file Server configuration file. Defaults are used when empty.
+             * @param _plugin_file Sink plugin to load. No plugin is loaded when empty.
              * 
              * @return true On success
              * @return false On failure
@@ -168,6 +340,25 @@ namespace condalf::service
                         const std::string& _port = "5683",
                         MessageQueue* _msg_queue = nullptr,
                         bool enable_python_script = false, 
-                        const std::string& _script_file = "");
+                        const std::string& _script_file = "",
+                        const std::string& _secure_port = "5684",
+                        const common::CoAP::security_config* _security = nullptr,
+                        const std::string& _config_file = "",
+                       const std::string& _plugin_file = "");
+
+            /**
+             * @brief Get the statistics of the resources, the dedup window, the device table, the scheduler, the Python thread,
+             * the sinks, the reorder buffer, the rollup, the store and the last value cache
+             * 
+             * @return std::string One line per consumer
+             */
+            std::string GetStatistics();
+
+            /**
+             * @brief Get the activity of the devices that send to the ingest resources
+             * 
+             * @return std::string One line per device, empty if the device table is not configured
+             */
+            std::string GetDevices();
     };
 }
\ No newline at end of file
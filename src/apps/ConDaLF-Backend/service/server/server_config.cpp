@@ -0,0 +1,221 @@
+/**
+ * @file server_config.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "server_config.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <common/config/parser.h>
+#include <common/logging/logging.h>
+
+using namespace condalf::service;
+
+/**
+ * @brief Parses an unsigned number option
+ * 
+ * @tparam T Type of the option
+ * @param key Key of the option
+ * @param value Value of the option
+ * @param number The parsed number
+ * @return true On success
+ * @return false On failure
+ */
+template <typename T>
+static bool parse_number(const std::string& key, const std::string& value, T& number)
+{
+    try
+    {
+        std::size_t end = 0;
+        unsigned long long parsed = std::stoull(value, &end);
+        if (end == value.size() && value[0] != '-')
+        {
+            number = static_cast<T>(parsed);
+            return true;
+        }
+    }
+    catch (const std::exception&) {}
+
+    common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Invalid number for ") + key + ": " + value);
+    return false;
+}
+
+bool ServerConfig::Load(const std::string& file)
+{
+    bool valid = true;
+    try
+    {
+        common::config::parse_options(file, [this, &valid](const std::string& key, const std::string& value) {
+            if (key == "resource")
+            {
+                RouteTable::route parsed;
+                if (RouteTable::Parse(value, parsed))
+                    routes.push_back(std::move(parsed));
+                else
+                    valid = false;
+            }
+            else if (key == "ratelimit.clients")
+                valid &= parse_number(key, value, rate_limit_clients);
+            else if (key == "dedup.window")
+                valid &= parse_number(key, value, dedup_window);
+            else if (key == "dedup.entries")
+                valid &= parse_number(key, value, dedup_entries);
+            else if (key == "devices.max")
+                valid &= parse_number(key, value, device_max);
+            else if (key == "devices.stale")
+                valid &= parse_number(key, value, device_stale);
+            else if (key == "schedule.queue")
+            {
+                valid &= parse_number(key, value, schedule.queue_size);
+                schedule_enabled = schedule.queue_size > 0;
+            }
+            else if (key == "schedule.clients")
+                valid &= parse_number(key, value, schedule.max_queues);
+            else if (key == "schedule.quantum")
+                valid &= parse_number(key, value, schedule.quantum);
+            else if (key == "schedule.weights")
+            {
+                // Comma separated class:weight
+                std::size_t position = 0;
+                while (position <= value.size())
+                {
+                    std::size_t next = std::min(value.find(',', position), value.size());
+                    std::string element = value.substr(position, next - position);
+                    std::size_t separator = element.find(':');
+                    if (separator == std::string::npos)
+                    {
+                        if (!element.empty())
+                        {
+                            common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Invalid value for schedule.weights: ") + element);
+                            valid = false;
+                        }
+                    }
+                    else
+                        valid &= parse_number(key, element.substr(separator + 1), schedule.weights[element.substr(0, separator)]);
+                    position = next + 1;
+                }
+            }
+            else if (key == "python.queue")
+                valid &= parse_number(key, value, python.queue_size);
+            else if (key == "python.workers")
+                valid &= parse_number(key, value, python.workers);
+            else if (key == "python.ring")
+                valid &= parse_number(key, value, python.ring_size);
+            else if (key == "python.batch")
+                valid &= parse_number(key, value, python.batch_size);
+            else if (key == "python.linger")
+                valid &= parse_number(key, value, python.linger);
+            else if (key == "python.overflow")
+            {
+                if (value == "drop")
+                    python.overflow = condalf::PythonWorker::Overflow::DROP;
+                else if (value == "reject")
+                    python.overflow = condalf::PythonWorker::Overflow::REJECT;
+                else if (value == "block")
+                    python.overflow = condalf::PythonWorker::Overflow::BLOCK;
+                else
+                {
+                    common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Invalid value for python.overflow: ") + value);
+                    valid = false;
+                }
+            }
+            else if (key == "influx.host")
+            {
+                influx.host = value;
+                influx_enabled = !value.empty();
+            }
+            else if (key == "influx.port")
+                influx.port = value;
+            else if (key == "influx.user")
+                influx.user = value;
+            else if (key == "influx.password")
+                influx.password = value;
+            else if (key == "influx.batch")
+                valid &= parse_number(key, value, influx.batch_points);
+            else if (key == "influx.interval")
+                valid &= parse_number(key, value, influx.flush_interval);
+            else if (key == "influx.buffer")
+                valid &= parse_number(key, value, influx.max_buffer);
+            else if (key == "plugin.argument")
+                plugin.argument = value;
+            else if (key == "plugin.queue")
+                valid &= parse_number(key, value, plugin.queue_size);
+            else if (key == "plugin.batch")
+                valid &= parse_number(key, value, plugin.batch_size);
+            else if (key == "plugin.interval")
+                valid &= parse_number(key, value, plugin.flush_interval);
+            else if (key == "series.limit")
+                valid &= parse_number(key, value, series_limit);
+            else if (key == "reorder.lateness")
+            {
+                valid &= parse_number(key, value, reorder.lateness);
+                reorder_enabled = reorder.lateness > 0;
+            }
+            else if (key == "reorder.points")
+                valid &= parse_number(key, value, reorder.max_points);
+            else if (key == "reorder.series")
+                valid &= parse_number(key, value, reorder.max_series);
+            else if (key == "reorder.late")
+            {
+                // The store and the rollup can not take late points
+                if (!RouteTable::ParseSinks(value, reorder_late_sinks) || (reorder_late_sinks & ~(RouteTable::SINK_INFLUX | RouteTable::SINK_PLUGIN)) != 0)
+                {
+                    common::logging::log_error(std::cerr, LINE_INFORMATION, "Invalid value for reorder.late: " + value);
+                    valid = false;
+                }
+            }
+            else if (key == "rollup.window")
+            {
+                valid &= parse_number(key, value, rollup.window);
+                rollup_enabled = rollup.window > 0;
+            }
+            else if (key == "rollup.grace")
+                valid &= parse_number(key, value, rollup.grace);
+            else if (key == "rollup.series")
+                valid &= parse_number(key, value, rollup.max_series);
+            else if (key == "rollup.raw")
+            {
+                // Comma separated series
+                std::size_t position = 0;
+                while (position <= value.size())
+                {
+                    std::size_t next = std::min(value.find(',', position), value.size());
+                    if (next > position)
+                        rollup.raw.push_back(value.substr(position, next - position));
+                    position = next + 1;
+                }
+            }
+            else if (key == "store.retention")
+            {
+                valid &= parse_number(key, value, store.retention);
+                store_enabled = store.retention > 0;
+            }
+            else if (key == "store.chunk")
+                valid &= parse_number(key, value, store.chunk);
+            else if (key == "store.series")
+                valid &= parse_number(key, value, store.max_series);
+            else if (key == "latest.series")
+            {
+                valid &= parse_number(key, value, latest.max_series);
+                latest_enabled = latest.max_series > 0;
+            }
+            else if (key == "latest.coalesce")
+                valid &= parse_number(key, value, latest.coalesce);
+            else
+                common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("Unknown server option: ") + key);
+        });
+    }
+    catch (const std::exception&)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not read server configuration ") + file);
+        return false;
+    }
+    return valid;
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+/**
+ * @file server_config.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Server configuration file
+ * @version 0.1
+ * @date 2021-07-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <string>
+#include <sink/influx_sink.hpp>
+#include <sink/plugin_sink.hpp>
+#include <sink/rollup.hpp>
+#include <sink/reorder_buffer.hpp>
+#include <store/time_series_store.hpp>
+#include <store/last_value_cache.hpp>
+#include <python/python_worker.hpp>
+#include "route_table.hpp"
+#include "rate_limiter.hpp"
+#include "fair_scheduler.hpp"
+#include "dedup_window.hpp"
+#include "device_table.hpp"
+
+namespace condalf::service
+{
+    /**
+     * @brief Options of the server configuration file. The file contains one "key=value" per line.
+     */
+    class ServerConfig
+    {
+        public:
+            /**
+             * @brief Resources declared with resource=<path> [option=value ...]. The defaults are used when there are none.
+             */
+            std::vector<RouteTable::route> routes;
+
+            /**
+             * @brief Clients whose rate is tracked at most (ratelimit.clients)
+             */
+            std::size_t rate_limit_clients = CONDALF_RATE_LIMIT_CLIENTS;
+
+            /**
+             * @brief Seconds a payload is remembered per client to suppress duplicates, 0 to disable (dedup.window)
+             */
+            unsigned int dedup_window = 0;
+
+            /**
+             * @brief Payloads remembered at most (dedup.entries)
+             */
+            std::size_t dedup_entries = CONDALF_DEDUP_ENTRIES;
+
+            /**
+             * @brief Devices whose activity is tracked at most, 0 to disable (devices.max)
+             */
+            std::size_t device_max = 0;
+
+            /**
+             * @brief Seconds without requests after which a device is evicted (devices.stale)
+             */
+            unsigned int device_stale = CONDALF_DEVICE_STALE;
+
+            /**
+             * @brief True if ingest payloads should be processed by the fair scheduler (schedule.queue is set)
+             */
+            bool schedule_enabled = false;
+
+            /**
+             * @brief Options of the fair scheduler (schedule.*)
+             */
+            FairScheduler::options schedule;
+
+            /**
+             * @brief Options of the Python thread (python.*)
+             */
+            condalf::PythonWorker::options python;
+
+            /**
+             * @brief True if the InfluxDB sink should be used (influx.host is set)
+             */
+            bool influx_enabled = false;
+
+            /**
+             * @brief Options of the InfluxDB sink (influx.*)
+             */
+            condalf::sink::InfluxSink::options influx;
+
+            /**
+             * @brief Options of the sink plugin (plugin.*). The path is given with -S.
+             */
+            condalf::sink::PluginSink::options plugin;
+
+            /**
+             * @brief Series ids handed out at most by the series dictionary (series.limit)
+             */
+            std::size_t series_limit = CONDALF_SERIES_LIMIT;
+
+            /**
+             * @brief True if numeric points should be put in time order before the store, the rollup and the sinks (reorder.lateness is set)
+             */
+            bool reorder_enabled = false;
+
+            /**
+             * @brief Options of the reorder buffer (reorder.*)
+             */
+            condalf::sink::ReorderBuffer::options reorder;
+
+            /**
+             * @brief Sinks that get the points that are too late for the reorder buffer, influx and plugin (reorder.late)
+             */
+            unsigned int reorder_late_sinks = RouteTable::SINK_INFLUX;
+
+            /**
+             * @brief True if numeric series should be rolled up before the sinks (rollup.window is set)
+             */
+            bool rollup_enabled = false;
+
+            /**
+             * @brief Options of the rollup (rollup.*)
+             */
+            condalf::sink::Rollup::options rollup;
+
+            /**
+             * @brief True if recent records should be kept in memory for condalf/query (store.retention is set)
+             */
+            bool store_enabled = false;
+
+            /**
+             * @brief Options of the time series store (store.*)
+             */
+            condalf::store::TimeSeriesStore::options store;
+
+            /**
+             * @brief True if the latest value of every series should be kept for condalf/latest (latest.series is set)
+             */
+            bool latest_enabled = false;
+
+            /**
+             * @brief Options of the last value cache (latest.*)
+             */
+            condalf::store::LastValueCache::options latest;
+
+            /**
+             * @brief Reads the configuration file. Options that are not in the file keep their defaults.
+             * 
+             * @param file Filepath
+             * @return true On success
+             * @return false On failure
+             */
+            bool Load(const std::string& file);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+/**
+ * @file dedup_window_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the duplicate payload window
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/server/dedup_window.hpp>
+
+#include <cstring>
+
+using namespace condalf::service;
+
+TEST_CASE(crc32c_check_value)
+{
+    // Check value of CRC-32C (RFC 3720 appendix B.4)
+    const char* digits = "123456789";
+    ASSERT_EQUAL(crc32c(reinterpret_cast<const uint8_t*>(digits), std::strlen(digits)), 0xe3069283u);
+
+    // Chunks continue the CRC
+    uint32_t crc = crc32c(reinterpret_cast<const uint8_t*>(digits), 4);
+    ASSERT_EQUAL(crc32c(reinterpret_cast<const uint8_t*>(digits) + 4, 5, crc), 0xe3069283u);
+}
+
+TEST_CASE(keys)
+{
+    std::vector<uint8_t> payload = { 1, 2, 3 };
+    std::vector<uint8_t> other = { 1, 2, 4 };
+    uint64_t key = DedupWindow::Key("client", "condalf/data", payload);
+    ASSERT_NOT_EQUAL(key, 0u);
+    ASSERT_EQUAL(key, DedupWindow::Key("client", "condalf/data", payload));
+    ASSERT_NOT_EQUAL(key, DedupWindow::Key("other", "condalf/data", payload));
+    ASSERT_NOT_EQUAL(key, DedupWindow::Key("client", "condalf/other", payload));
+    ASSERT_NOT_EQUAL(key, DedupWindow::Key("client", "condalf/data", other));
+}
+
+TEST_CASE(only_remembered_payloads_are_duplicates)
+{
+    DedupWindow dedup;
+    dedup.Configure(60, 64);
+    uint64_t key = DedupWindow::Key("client", "condalf/data", { 1, 2, 3 });
+
+    // A payload that was rejected is checked but not remembered, its retry is new again
+    ASSERT_FALSE(dedup.Seen(key));
+    ASSERT_FALSE(dedup.Seen(key));
+
+    dedup.Remember(key);
+    ASSERT_TRUE(dedup.Seen(key));
+    dedup.Remember(key);
+    ASSERT_TRUE(dedup.GetStatistics() == "checked=3 duplicates=1 replaced=0");
+}
+
+TEST_CASE(full_sets_replace_entries)
+{
+    DedupWindow dedup;
+    dedup.Configure(60, 1);
+
+    // A single set, the oldest entries make room
+    for (uint8_t i = 0; i < CONDALF_DEDUP_WAYS + 2; i++)
+        dedup.Remember(DedupWindow::Key("client", "condalf/data", { i }));
+    ASSERT_TRUE(dedup.Seen(DedupWindow::Key("client", "condalf/data", { CONDALF_DEDUP_WAYS + 1 })));
+    ASSERT_TRUE(dedup.GetStatistics().find("replaced=2") != std::string::npos);
+}
+
+TEST_CASE(entries_expire)
+{
+    DedupWindow dedup;
+    dedup.Configure(0, 64);
+    uint64_t key = DedupWindow::Key("client", "condalf/data", { 1 });
+    dedup.Remember(key);
+    ASSERT_FALSE(dedup.Seen(key));
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(crc32c_check_value);
+    TEST_CASE_RUN(keys);
+    TEST_CASE_RUN(only_remembered_payloads_are_duplicates);
+    TEST_CASE_RUN(full_sets_replace_entries);
+    TEST_CASE_RUN(entries_expire);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,83 @@
+/**
+ * @file device_table_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the device table
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/server/device_table.hpp>
+
+#include <thread>
+
+#define DEVICE_TABLE_TEST_CHURN 100000      // Requests of the churn test
+#define DEVICE_TABLE_TEST_DEVICES 1500      // Distinct devices of the churn test
+
+using namespace condalf::service;
+
+TEST_CASE(devices_are_recorded)
+{
+    DeviceTable table;
+    table.Configure(3, 1);
+    const uint8_t first[] = { 10, 0, 0, 1 }, second[] = { 10, 0, 0, 2 };
+    std::string_view a(reinterpret_cast<const char*>(first), sizeof(first));
+    std::string_view b(reinterpret_cast<const char*>(second), sizeof(second));
+
+    for (int i = 0; i < 10; i++)
+        table.Record(a, 100, true, i == 3);
+    table.Record(b, 50, false, false);
+    table.Record(b, 50, true, true);
+    table.Record("0123456789abcdef", 7, true, false);
+    table.Record("does-not-fit", 7, true, false);
+
+    std::string dump = table.Dump();
+    ASSERT_TRUE(dump.find("10.0.0.1 ") != std::string::npos);
+    ASSERT_TRUE(dump.find("requests=10 bytes=1000 avg=100 errors=1") != std::string::npos);
+    ASSERT_TRUE(dump.find("10.0.0.2 ") != std::string::npos);
+    ASSERT_TRUE(dump.find("requests=1 bytes=100 avg=100 errors=1") != std::string::npos);
+    ASSERT_TRUE(dump.find("3031:3233:3435:3637:3839:6162:6364:6566 ") != std::string::npos);
+    ASSERT_TRUE(table.GetStatistics() == "devices=3/3 recorded=13 untracked=1 evicted=0");
+
+    // Devices without requests for a second are stale
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    table.Record(b, 1, true, false);
+    dump = table.Dump();
+    ASSERT_TRUE(dump.find("10.0.0.1 ") == std::string::npos);
+    ASSERT_TRUE(dump.find("10.0.0.2 ") != std::string::npos);
+    ASSERT_TRUE(table.GetStatistics() == "devices=1/3 recorded=14 untracked=1 evicted=2");
+}
+
+TEST_CASE(more_devices_than_slots)
+{
+    DeviceTable table;
+    table.Configure(1000, 3600);
+    for (int i = 0; i < DEVICE_TABLE_TEST_CHURN; i++)
+        table.Record(std::to_string(i % DEVICE_TABLE_TEST_DEVICES), 1, true, false);
+    ASSERT_TRUE(table.GetStatistics().find("devices=1000/1000 ") == 0);
+}
+
+TEST_CASE(new_devices_check_a_few_slots)
+{
+    DeviceTable table;
+    table.Configure(256, 1);
+    for (int i = 0; i < 256; i++)
+        table.Record(std::to_string(i), 1, true, false);
+
+    // All devices are stale, a new one evicts only the ones in the slots it checks
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    table.Record("new", 1, true, false);
+    std::string stats = table.GetStatistics();
+    std::size_t evicted = std::stoul(stats.substr(stats.find("evicted=") + 8));
+    ASSERT_TRUE(evicted >= 1 && evicted <= 1 + CONDALF_OPEN_TABLE_SWEEP);
+    ASSERT_TRUE(stats.find("untracked=0 ") != std::string::npos);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(devices_are_recorded);
+    TEST_CASE_RUN(more_devices_than_slots);
+    TEST_CASE_RUN(new_devices_check_a_few_slots);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,137 @@
+/**
+ * @file fair_scheduler_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the deficit round robin scheduler
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/server/fair_scheduler.hpp>
+
+#include <future>
+
+using namespace condalf::service;
+
+/**
+ * @brief Records the order in which a scheduler processes its jobs. The job with path "gate"
+ * holds up the scheduler thread until it is opened, so that the jobs queued meanwhile are taken in DRR order.
+ */
+struct order
+{
+    std::mutex mutex;
+    std::vector<std::string> paths;
+    std::promise<void> started;
+    std::promise<void> opened;
+    std::shared_future<void> open = opened.get_future().share();
+
+    void operator()(FairScheduler::Job& job)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            paths.push_back(job.path);
+        }
+        if (job.path == "gate")
+        {
+            started.set_value();
+            open.wait();
+        }
+    }
+};
+
+/**
+ * @brief Get a job whose cost is payload size plus CONDALF_SCHEDULE_JOB_OVERHEAD
+ */
+static FairScheduler::Job job(const std::string& path, std::size_t cost)
+{
+    FairScheduler::Job job;
+    job.path = path;
+    job.payload = std::make_shared<const std::vector<uint8_t>>(cost - CONDALF_SCHEDULE_JOB_OVERHEAD);
+    return job;
+}
+
+/**
+ * @brief Starts a scheduler and blocks its thread in the gate job
+ */
+static void close_gate(FairScheduler& scheduler, const FairScheduler::options& config, order& processed)
+{
+    scheduler.Start(config, [&processed](FairScheduler::Job& job) { processed(job); });
+    scheduler.Submit("gate", "g", job("gate", 100));
+    processed.started.get_future().wait();
+}
+
+TEST_CASE(weights)
+{
+    // A queue of weight 3 sends three jobs per round where one of weight 1 sends one
+    FairScheduler scheduler;
+    FairScheduler::options config;
+    config.quantum = 100;
+    config.weights["critical"] = 3;
+    order processed;
+    close_gate(scheduler, config, processed);
+
+    for (int i = 1; i <= 4; i++)
+        ASSERT_TRUE(scheduler.Submit("bulk", "a", job("a" + std::to_string(i), 100)));
+    for (int i = 1; i <= 4; i++)
+        ASSERT_TRUE(scheduler.Submit("critical", "b", job("b" + std::to_string(i), 100)));
+    processed.opened.set_value();
+    scheduler.Stop();
+
+    std::vector<std::string> expected = { "gate", "a1", "b1", "b2", "b3", "a2", "b4", "a3", "a4" };
+    ASSERT_TRUE(processed.paths == expected);
+    ASSERT_TRUE(scheduler.GetStatistics().find(" processed=9 rejected=0 ") != std::string::npos);
+}
+
+TEST_CASE(quantum)
+{
+    // A job that costs two quanta waits for the deficit of two rounds, so both clients get the same bytes
+    FairScheduler scheduler;
+    FairScheduler::options config;
+    config.quantum = 100;
+    order processed;
+    close_gate(scheduler, config, processed);
+
+    for (int i = 1; i <= 2; i++)
+        ASSERT_TRUE(scheduler.Submit("bulk", "a", job("a" + std::to_string(i), 200)));
+    for (int i = 1; i <= 4; i++)
+        ASSERT_TRUE(scheduler.Submit("bulk", "b", job("b" + std::to_string(i), 100)));
+    processed.opened.set_value();
+    scheduler.Stop();
+
+    std::vector<std::string> expected = { "gate", "b1", "a1", "b2", "b3", "a2", "b4" };
+    ASSERT_TRUE(processed.paths == expected);
+}
+
+TEST_CASE(full_queues)
+{
+    // Submit fails when a queue or the table of queues is full, the server answers that with 5.03
+    FairScheduler scheduler;
+    FairScheduler::options config;
+    config.queue_size = 2;
+    config.max_queues = 2;
+    order processed;
+    close_gate(scheduler, config, processed);
+
+    ASSERT_TRUE(scheduler.Submit("bulk", "a", job("a1", 100)));
+    ASSERT_TRUE(scheduler.Submit("bulk", "a", job("a2", 100)));
+    ASSERT_FALSE(scheduler.Submit("bulk", "a", job("a3", 100)));
+    ASSERT_FALSE(scheduler.Submit("bulk", "b", job("b1", 100)));
+    ASSERT_TRUE(scheduler.GetStatistics() == "queues=2/2 waiting=2 processed=0 rejected=2 rounds=1");
+    processed.opened.set_value();
+    scheduler.Stop();
+
+    std::vector<std::string> expected = { "gate", "a1", "a2" };
+    ASSERT_TRUE(processed.paths == expected);
+
+    // Once the queue is empty the client may queue again
+    ASSERT_TRUE(scheduler.GetStatistics() == "queues=0/2 waiting=0 processed=3 rejected=2 rounds=2");
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(weights);
+    TEST_CASE_RUN(quantum);
+    TEST_CASE_RUN(full_queues);
+TEST_MODULE_END
\ No newline at end of file
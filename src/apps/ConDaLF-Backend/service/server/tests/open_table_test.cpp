@@ -0,0 +1,91 @@
+/**
+ * @file open_table_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the open addressing table of the rate limiter and the device table
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/server/open_table.hpp>
+
+using namespace condalf::service;
+
+/**
+ * @brief An entry of the open addressing table
+ */
+struct test_entry
+{
+    uint64_t key = 0;
+    int value = 0;
+};
+
+TEST_CASE(erase_keeps_probe_sequences)
+{
+    OpenTable<test_entry> table;
+    table.Configure(8);
+    ASSERT_EQUAL(table.Slots(), 16u);
+
+    // Keys with the same home slot form one probe sequence
+    for (uint64_t i = 1; i <= 4; i++)
+        table.Insert(i * 16 + 3)->value = static_cast<int>(i);
+    table.Erase(static_cast<std::size_t>(table.Find(2 * 16 + 3) - &table.Slot(0)));
+    ASSERT_TRUE(table.Find(2 * 16 + 3) == nullptr);
+    for (uint64_t i : { 1, 3, 4 })
+    {
+        ASSERT_TRUE(table.Find(i * 16 + 3) != nullptr);
+        ASSERT_EQUAL(table.Find(i * 16 + 3)->value, static_cast<int>(i));
+    }
+
+    ASSERT_EQUAL(table.EraseIf([](const test_entry& entry) { return entry.value != 4; }), 2u);
+    ASSERT_EQUAL(table.Size(), 1u);
+    ASSERT_TRUE(table.Find(4 * 16 + 3) != nullptr);
+}
+
+TEST_CASE(full_table_rejects_inserts)
+{
+    OpenTable<test_entry> table;
+    table.Configure(2);
+    ASSERT_TRUE(table.Insert(OpenTable<test_entry>::Key("a")) != nullptr);
+    ASSERT_TRUE(table.Insert(OpenTable<test_entry>::Key("b")) != nullptr);
+    ASSERT_TRUE(table.Full());
+    ASSERT_TRUE(table.Insert(OpenTable<test_entry>::Key("c")) == nullptr);
+    ASSERT_NOT_EQUAL(OpenTable<test_entry>::Key("a"), OpenTable<test_entry>::Key("a", 1));
+}
+
+TEST_CASE(sweeps_continue_where_they_stopped)
+{
+    OpenTable<test_entry> table;
+    table.Configure(8);
+    for (uint64_t i = 0; i < 8; i++)
+        table.Insert(i + 1)->value = static_cast<int>(i % 2);
+
+    // The keys 1 to 8 are in the slots 1 to 8, every call checks 4 slots.
+    // A slot is checked again after an erase because the next entry might have moved into it.
+    auto odd = [](const test_entry& entry) { return entry.value == 1; };
+    ASSERT_EQUAL(table.Sweep(4, odd), 1u);  // Slots 0, 1, 2, 2
+    ASSERT_EQUAL(table.Sweep(4, odd), 1u);  // Slots 3, 4, 4, 5
+    ASSERT_EQUAL(table.Sweep(4, odd), 2u);  // Slots 6, 6, 7, 8
+    ASSERT_EQUAL(table.Sweep(16, odd), 0u);
+    ASSERT_EQUAL(table.Size(), 4u);
+    for (uint64_t i = 0; i < 8; i++)
+        ASSERT_EQUAL(table.Find(i + 1) != nullptr, i % 2 == 0);
+
+    // Entries of one probe sequence move into the erased slot one after the other
+    for (uint64_t i = 1; i <= 4; i++)
+        table.Insert(i * 16 + 12)->value = 1;
+    ASSERT_EQUAL(table.Sweep(16, odd), 4u);
+    ASSERT_EQUAL(table.Size(), 4u);
+
+    OpenTable<test_entry> empty;
+    ASSERT_EQUAL(empty.Sweep(4, odd), 0u);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(erase_keeps_probe_sequences);
+    TEST_CASE_RUN(full_table_rejects_inserts);
+    TEST_CASE_RUN(sweeps_continue_where_they_stopped);
+TEST_MODULE_END
\ No newline at end of file
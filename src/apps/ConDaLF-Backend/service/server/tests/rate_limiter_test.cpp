@@ -0,0 +1,86 @@
+/**
+ * @file rate_limiter_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the token buckets per client and resource
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/server/rate_limiter.hpp>
+
+#include <thread>
+
+using namespace condalf::service;
+
+TEST_CASE(buckets_hold_burst_tokens)
+{
+    RateLimiter limiter;
+    limiter.Configure(16, 2);
+    uint32_t retry_after = 0;
+    for (int i = 0; i < 3; i++)
+        ASSERT_TRUE(limiter.Allow("client", 0, 1, 3, retry_after));
+    ASSERT_FALSE(limiter.Allow("client", 0, 1, 3, retry_after));
+    ASSERT_EQUAL(retry_after, 1u);
+
+    // Other clients and other resources have their own bucket
+    ASSERT_TRUE(limiter.Allow("other", 0, 1, 3, retry_after));
+    ASSERT_TRUE(limiter.Allow("client", 1, 1, 3, retry_after));
+    ASSERT_TRUE(limiter.GetStatistics() == "clients=3/16 allowed=5 limited=1 evicted=0 shared=0");
+}
+
+TEST_CASE(clients_that_do_not_fit_share_a_bucket)
+{
+    RateLimiter limiter;
+    limiter.Configure(2, 1);
+    uint32_t retry_after = 0;
+    ASSERT_TRUE(limiter.Allow("a", 0, 1, 2, retry_after));
+    ASSERT_TRUE(limiter.Allow("b", 0, 1, 2, retry_after));
+
+    // a and b are not idle, c and d take the two tokens of the shared bucket
+    ASSERT_TRUE(limiter.Allow("c", 0, 1, 2, retry_after));
+    ASSERT_TRUE(limiter.Allow("d", 0, 1, 2, retry_after));
+    ASSERT_FALSE(limiter.Allow("c", 0, 1, 2, retry_after));
+    ASSERT_TRUE(limiter.GetStatistics() == "clients=2/2 allowed=4 limited=1 evicted=0 shared=3");
+}
+
+TEST_CASE(idle_buckets_are_evicted)
+{
+    RateLimiter limiter;
+    limiter.Configure(2, 1);
+    uint32_t retry_after = 0;
+    ASSERT_TRUE(limiter.Allow("a", 0, 100, 1, retry_after));
+    ASSERT_TRUE(limiter.Allow("b", 0, 100, 1, retry_after));
+
+    // Both buckets are full again after 10 ms
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(limiter.Allow("c", 0, 100, 1, retry_after));
+    ASSERT_TRUE(limiter.GetStatistics() == "clients=1/2 allowed=3 limited=0 evicted=2 shared=0");
+}
+
+TEST_CASE(new_clients_check_a_few_slots)
+{
+    RateLimiter limiter;
+    limiter.Configure(256, 1);
+    uint32_t retry_after = 0;
+    for (int i = 0; i < 256; i++)
+        ASSERT_TRUE(limiter.Allow(std::to_string(i), 0, 100, 1, retry_after));
+
+    // All buckets are idle, but a new client only evicts the ones in the next few slots
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(limiter.Allow("new", 0, 100, 1, retry_after));
+    std::string stats = limiter.GetStatistics();
+    std::size_t evicted = std::stoul(stats.substr(stats.find("evicted=") + 8));
+    ASSERT_TRUE(evicted >= 1 && evicted <= CONDALF_OPEN_TABLE_SWEEP);
+    ASSERT_TRUE(stats.find("clients=" + std::to_string(256 - evicted + 1) + "/256 ") == 0);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(buckets_hold_burst_tokens);
+    TEST_CASE_RUN(clients_that_do_not_fit_share_a_bucket);
+    TEST_CASE_RUN(idle_buckets_are_evicted);
+    TEST_CASE_RUN(new_clients_check_a_few_slots);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,156 @@
+/**
+ * @file route_table_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the resource table of the server
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/service/server/route_table.hpp>
+
+#include <coap3/coap.h>
+
+using namespace condalf::service;
+
+/**
+ * @brief Compiles resources given by their paths
+ * 
+ * @param table The table
+ * @param paths The paths
+ * @return true On success
+ * @return false Compile failed
+ */
+static bool compile(RouteTable& table, std::initializer_list<const char*> paths)
+{
+    std::vector<RouteTable::route> routes;
+    for (const char* path : paths)
+    {
+        if (!RouteTable::Parse(path, routes.emplace_back()))
+            return false;
+    }
+    return table.Compile(routes);
+}
+
+/**
+ * @brief Get the declared path of the resource that serves a request path
+ * 
+ * @param table The table
+ * @param path The request path
+ * @return std::string The declared path, "4.04" if no resource serves it
+ */
+static std::string route_of(RouteTable& table, std::string_view path)
+{
+    RouteTable::Entry* entry = table.Find(path);
+    return entry != nullptr ? entry->config.path : "4.04";
+}
+
+TEST_CASE(exact_paths)
+{
+    RouteTable table;
+    ASSERT_TRUE(table.Compile(RouteTable::Defaults(true, false)));
+    ASSERT_TRUE(route_of(table, "condalf/data") == "condalf/data");
+    ASSERT_TRUE(route_of(table, "condalf/test") == "condalf/test");
+    ASSERT_TRUE(route_of(table, "condalf/query") == "condalf/query");
+
+    // Paths that are not declared, also prefixes and extensions of declared ones
+    ASSERT_TRUE(route_of(table, "condalf/latest") == "4.04");
+    ASSERT_TRUE(route_of(table, "condalf") == "4.04");
+    ASSERT_TRUE(route_of(table, "condalf/data/x") == "4.04");
+    ASSERT_TRUE(route_of(table, "Condalf/data") == "4.04");
+    ASSERT_TRUE(route_of(table, "") == "4.04");
+
+    // Before Compile nothing is found
+    RouteTable empty;
+    ASSERT_TRUE(empty.Find("condalf/data") == nullptr);
+}
+
+TEST_CASE(trailing_and_repeated_slashes)
+{
+    RouteTable table;
+    ASSERT_TRUE(compile(table, { "/sensors/temp/", "sensors//hum" }));
+    ASSERT_TRUE(table.Entries()[0].config.path == "sensors/temp/");
+    ASSERT_TRUE(route_of(table, "sensors/temp") == "sensors/temp/");
+    ASSERT_TRUE(route_of(table, "sensors/temp/") == "sensors/temp/");
+    ASSERT_TRUE(route_of(table, "/sensors//temp") == "sensors/temp/");
+    ASSERT_TRUE(route_of(table, "sensors/hum") == "sensors//hum");
+}
+
+TEST_CASE(wildcards)
+{
+    RouteTable table;
+    ASSERT_TRUE(compile(table, { "site/*/temp", "site/*/*", "site/north/temp", "site/**", "site/north/**", "logs/**" }));
+    ASSERT_TRUE(table.Entries()[0].wildcard);
+    ASSERT_FALSE(table.Entries()[2].wildcard);
+
+    // Literal segments take precedence over "*", which takes precedence over "**"
+    ASSERT_TRUE(route_of(table, "site/north/temp") == "site/north/temp");
+    ASSERT_TRUE(route_of(table, "site/south/temp") == "site/*/temp");
+    ASSERT_TRUE(route_of(table, "site/south/hum") == "site/*/*");
+    ASSERT_TRUE(route_of(table, "site/south/hum/raw") == "site/**");
+
+    // The longest literal prefix wins, even over a "*" that would match the whole path
+    ASSERT_TRUE(route_of(table, "site/north/hum") == "site/north/**");
+    ASSERT_TRUE(route_of(table, "site/north/a/b") == "site/north/**");
+
+    // "*" matches exactly one segment, "**" at least one
+    ASSERT_TRUE(route_of(table, "site/south") == "site/**");
+    ASSERT_TRUE(route_of(table, "site") == "4.04");
+    ASSERT_TRUE(route_of(table, "logs") == "4.04");
+    ASSERT_TRUE(route_of(table, "logs/a/b/c/") == "logs/**");
+    ASSERT_TRUE(route_of(table, "other/a") == "4.04");
+
+    // Placeholders like {id} are literal segments
+    RouteTable literal;
+    ASSERT_TRUE(compile(literal, { "devices/{id}" }));
+    ASSERT_TRUE(route_of(literal, "devices/{id}") == "devices/{id}");
+    ASSERT_TRUE(route_of(literal, "devices/7") == "4.04");
+}
+
+TEST_CASE(invalid_tables)
+{
+    RouteTable table;
+    ASSERT_FALSE(compile(table, { "a/b", "a/b/" }));
+    ASSERT_FALSE(compile(table, { "a/*", "a/*" }));
+    ASSERT_FALSE(compile(table, { "a/**/b" }));
+
+    RouteTable::route parsed;
+    ASSERT_FALSE(RouteTable::Parse("/", parsed));
+    ASSERT_FALSE(RouteTable::Parse("a methods=get,brew", parsed));
+    ASSERT_FALSE(RouteTable::Parse("a pipeline=other", parsed));
+    ASSERT_FALSE(RouteTable::Parse("a rate=-1", parsed));
+    ASSERT_FALSE(RouteTable::Parse("a formats=70000", parsed));
+}
+
+TEST_CASE(options)
+{
+    RouteTable::route parsed;
+    ASSERT_TRUE(RouteTable::Parse("a/b methods=put,post formats=senml+json,60 sinks=store,relay rate=2.5 class=bulk", parsed));
+    ASSERT_EQUAL(parsed.methods, RouteTable::MethodBit(COAP_REQUEST_PUT) | RouteTable::MethodBit(COAP_REQUEST_POST));
+    ASSERT_EQUAL(parsed.formats.size(), 2u);
+    ASSERT_EQUAL(parsed.formats[0], COAP_MEDIATYPE_APPLICATION_SENML_JSON);
+    ASSERT_EQUAL(parsed.formats[1], 60);
+    ASSERT_EQUAL(parsed.sinks, RouteTable::SINK_STORE | RouteTable::SINK_RELAY);
+    ASSERT_EQUAL(parsed.burst, 3.0);
+    ASSERT_TRUE(parsed.class_name == "bulk");
+
+    // Defaults of the pipelines
+    ASSERT_TRUE(RouteTable::Parse("q pipeline=query", parsed));
+    ASSERT_EQUAL(parsed.methods, RouteTable::MethodBit(COAP_REQUEST_GET));
+    ASSERT_TRUE(parsed.formats.empty());
+    ASSERT_TRUE(RouteTable::Parse("d", parsed));
+    ASSERT_EQUAL(parsed.methods, RouteTable::MethodBit(COAP_REQUEST_PUT));
+    ASSERT_EQUAL(parsed.formats.size(), 4u);
+    ASSERT_EQUAL(parsed.sinks, RouteTable::SINK_ALL);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(exact_paths);
+    TEST_CASE_RUN(trailing_and_repeated_slashes);
+    TEST_CASE_RUN(wildcards);
+    TEST_CASE_RUN(invalid_tables);
+    TEST_CASE_RUN(options);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,395 @@
+/**
+ * @file influx_sink.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "influx_sink.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <common/logging/logging.h>
+
+using namespace condalf::sink;
+
+/**
+ * @brief Appends a string and escapes the given characters with a backslash.
+ * Newlines can not be represented in line protocol and are replaced by spaces.
+ * 
+ * @param out The output
+ * @param value The string
+ * @param special Characters to escape
+ */
+static void append_escaped(std::string& out, std::string_view value, const char* special)
+{
+    for (char c : value)
+    {
+        if (c == '\n' || c == '\r')
+            c = ' ';
+        if (c == '\\' || std::strchr(special, c) != nullptr)
+            out += '\\';
+        out += c;
+    }
+}
+
+/**
+ * @brief Appends a float field value
+ * 
+ * @param out The output
+ * @param value The value
+ */
+static void append_float(std::string& out, double value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+/**
+ * @brief Checks if a record can be written
+ * 
+ * @param record The record
+ * @return true If it has a value or sum InfluxDB can store
+ * @return false Binary data, no value or non-finite numbers
+ */
+static bool is_writable(const common::senml::Record& record)
+{
+    using common::senml::ValueType;
+
+    if (record.type == ValueType::DATA || (record.type == ValueType::NONE && !record.has_sum))
+        return false;
+    return !(record.type == ValueType::NUMBER && !std::isfinite(record.value)) && !(record.has_sum && !std::isfinite(record.sum));
+}
+
+/**
+ * @brief Appends the measurement and the sensor tag of a series
+ * 
+ * @param line The output
+ * @param series The split record name
+ * @return true On success
+ * @return false If the series has no measurement or database
+ */
+static bool append_series(std::string& line, const series_name& series)
+{
+    if (series.measurement.empty() || series.db.empty())
+        return false;
+
+    append_escaped(line, series.measurement, ", ");
+    if (!series.sensor.empty())
+    {
+        line += ",sensor=";
+        append_escaped(line, series.sensor, ",= ");
+    }
+    return true;
+}
+
+/**
+ * @brief Appends the fields and the time of a record
+ * 
+ * @param line The output
+ * @param record A writable record
+ */
+static void append_fields(std::string& line, const common::senml::Record& record)
+{
+    using common::senml::ValueType;
+
+    line += ' ';
+    switch (record.type)
+    {
+        case ValueType::NUMBER:
+            line += "value=";
+            append_float(line, record.value);
+            break;
+        case ValueType::BOOLEAN:
+            line += record.boolean ? "value=true" : "value=false";
+            break;
+        case ValueType::STRING:
+            line += "value=\"";
+            append_escaped(line, record.text, "\"");
+            line += '"';
+            break;
+        default:
+            break;
+    }
+    if (record.has_sum)
+    {
+        if (record.type != ValueType::NONE)
+            line += ',';
+        line += "sum=";
+        append_float(line, record.sum);
+    }
+
+    // The time was resolved at ingress, without one InfluxDB uses the time of the write
+    if (record.timestamp != 0)
+    {
+        line += ' ';
+        line += std::to_string(record.timestamp);
+    }
+}
+
+bool condalf::sink::to_line_protocol(const common::senml::Record& record, std::string& db, std::string& line)
+{
+    // Binary data and non-finite numbers can not be written
+    if (!is_writable(record))
+        return false;
+
+    // Name is [db:]sensor:measurement
+    series_name series = split_series_name(record.name);
+    line.clear();
+    if (!append_series(line, series))
+        return false;
+    db = series.db;
+    append_fields(line, record);
+    return true;
+}
+
+bool InfluxSink::enable_connection()
+{
+    if (config.host.empty())
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, "No InfluxDB host configured.");
+        return false;
+    }
+
+    connection = std::make_unique<common::http::Connection>(config.host, config.port);
+    connection->SetBasicAuth(config.user, config.password);
+    flush_requested = false;
+    retry_backoff = CONDALF_INFLUX_MIN_RETRY_BACKOFF;
+    retry_time = clock::now();
+    return true;
+}
+
+bool InfluxSink::disable_connection()
+{
+    // The sink thread is stopped -> write what is left once
+    std::deque<batch> pending;
+    {
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        pending.swap(retries);
+        for (auto& it : batches)
+            pending.push_back(std::move(it.second));
+        batches.clear();
+    }
+    write_all(pending);
+
+    connection.reset();
+    return true;
+}
+
+bool InfluxSink::write(const batch& data, bool& retry)
+{
+    retry = false;
+    write_requests++;
+
+    int status = 0;
+    std::string response;
+    std::string target = "/write?db=" + common::http::url_encode(data.db) + "&precision=ns";
+    if (!connection->Post(target, "text/plain; charset=utf-8", data.lines, status, response))
+    {
+        failed_requests++;
+        retry = true;
+        return false;
+    }
+
+    if (status / 100 == 2)
+        return true;
+
+    // Server errors and rate limits might go away, anything else will not
+    failed_requests++;
+    retry = status / 100 == 5 || status == 429;
+    common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("InfluxDB answered ") + std::to_string(status) + " for database \"" + data.db + "\": " + response);
+    return false;
+}
+
+void InfluxSink::write_all(std::deque<batch>& pending)
+{
+    for (const batch& data : pending)
+    {
+        bool retry = false;
+        if (write(data, retry))
+            written_points += data.points;
+        else
+            dropped_points += data.points;
+
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        buffered -= data.lines.size();
+    }
+    pending.clear();
+}
+
+void InfluxSink::run()
+{
+    std::deque<batch> pending;
+    {
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        batch_notifier.wait_for(lock, std::chrono::milliseconds(config.flush_interval), [this] { return flush_requested; });
+        flush_requested = false;
+
+        // Nothing is written while waiting for a retry. Retries come first to keep the order of the points.
+        clock::time_point now = clock::now();
+        if (!retries.empty() && now < retry_time)
+            return;
+        pending.swap(retries);
+
+        auto max_age = std::chrono::milliseconds(config.flush_interval);
+        for (auto it = batches.begin(); it != batches.end();)
+        {
+            if (it->second.points >= config.batch_points || now - it->second.created >= max_age)
+            {
+                pending.push_back(std::move(it->second));
+                it = batches.erase(it);
+            }
+            else
+                it++;
+        }
+    }
+
+    while (!pending.empty())
+    {
+        bool retry = false;
+        batch& data = pending.front();
+        if (write(data, retry))
+        {
+            written_points += data.points;
+            retry_backoff = CONDALF_INFLUX_MIN_RETRY_BACKOFF;
+        }
+        else if (retry)
+        {
+            // InfluxDB is unavailable -> keep everything that is left for later
+            std::unique_lock<std::mutex> lock(batch_mutex);
+            while (!pending.empty())
+            {
+                retries.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+            retry_time = clock::now() + std::chrono::milliseconds(retry_backoff);
+            retry_backoff = std::min(retry_backoff * 2, (unsigned int)CONDALF_INFLUX_MAX_RETRY_BACKOFF);
+            return;
+        }
+        else
+            dropped_points += data.points;
+
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        buffered -= data.lines.size();
+        pending.pop_front();
+    }
+}
+
+InfluxSink::InfluxSink() : Service(), flush_requested(false), buffered(0), retry_backoff(CONDALF_INFLUX_MIN_RETRY_BACKOFF)
+{
+    this->service_name = "ConDaLF-Backend-InfluxSink";
+    written_points.store(0);
+    dropped_points.store(0);
+    write_requests.store(0);
+    failed_requests.store(0);
+
+    add_hook(
+        std::bind(&InfluxSink::enable_connection, this),
+        std::bind(&InfluxSink::disable_connection, this)
+    );
+}
+
+InfluxSink::~InfluxSink()
+{
+    Stop();
+}
+
+bool InfluxSink::Start(const options& _config)
+{
+    if (IsActive())
+        return false;
+
+    config = _config;
+    if (config.batch_points == 0)
+        config.batch_points = 1;
+    if (config.flush_interval == 0)
+        config.flush_interval = 1;
+
+    // The series ids are handed out again after a reload
+    {
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        prefixes.clear();
+    }
+    return common::Service::Start();
+}
+
+void InfluxSink::Process(const common::senml::Pack& pack)
+{
+    std::string db;
+    std::string line;
+    clock::time_point now = clock::now();
+
+    SeriesDictionary &dictionary = SeriesDictionary::getInstance();
+    std::unique_lock<std::mutex> lock(batch_mutex);
+    for (const common::senml::Record& record : pack.records)
+    {
+        // Known series reuse their escaped measurement and tags, the name is only split once
+        uint32_t id = dictionary.Of(record);
+        if (id == CONDALF_SERIES_INVALID)
+        {
+            if (!to_line_protocol(record, db, line))
+                continue;
+        }
+        else
+        {
+            if (!is_writable(record))
+                continue;
+            if (id >= prefixes.size())
+                prefixes.resize(id + 1);
+            const series_entry &series = dictionary.Get(id);
+            if (prefixes[id].empty() && !append_series(prefixes[id], series.parts))
+                continue;
+            line = prefixes[id];
+            append_fields(line, record);
+            db = series.parts.db;
+        }
+
+        // Memory is bounded -> drop points that do not fit anymore
+        if (buffered + line.size() + 1 > config.max_buffer)
+        {
+            dropped_points++;
+            continue;
+        }
+
+        batch& data = batches[db];
+        if (data.points == 0)
+        {
+            data.db = db;
+            data.created = now;
+        }
+        data.lines += line;
+        data.lines += '\n';
+        data.points++;
+        buffered += line.size() + 1;
+
+        if (data.points >= config.batch_points && !flush_requested)
+        {
+            flush_requested = true;
+            batch_notifier.notify_one();
+        }
+    }
+}
+
+std::string InfluxSink::GetStatistics()
+{
+    std::size_t bytes = 0;
+    {
+        std::unique_lock<std::mutex> lock(batch_mutex);
+        bytes = buffered;
+    }
+
+    std::stringstream stats;
+    stats << "written=" << written_points.load()
+          << " dropped=" << dropped_points.load()
+          << " requests=" << write_requests.load()
+          << " failed=" << failed_requests.load()
+          << " buffered=" << bytes << "B";
+    return stats.str();
+}
\ No newline at end of file
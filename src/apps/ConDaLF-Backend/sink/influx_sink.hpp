@@ -0,0 +1,225 @@
+/**
+ * @file influx_sink.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Writes decoded SenML records to InfluxDB
+ * @version 0.1
+ * @date 2021-07-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <common/service/service.hpp>
+#include <common/senml/senml.hpp>
+#include <common/http/http.hpp>
+#include "series.hpp"
+
+#define CONDALF_INFLUX_DEFAULT_PORT "8086"
+#define CONDALF_INFLUX_BATCH_POINTS 5000                // Points after which a database is flushed
+#define CONDALF_INFLUX_FLUSH_INTERVAL 1000              // ms after which a database is flushed
+#define CONDALF_INFLUX_MAX_BUFFER (16 * 1024 * 1024)    // Bytes of line protocol kept in memory (including retries)
+#define CONDALF_INFLUX_MIN_RETRY_BACKOFF 1000           // ms
+#define CONDALF_INFLUX_MAX_RETRY_BACKOFF 60000          // ms
+
+namespace condalf::sink
+{
+    /**
+     * @brief Converts records to InfluxDB line protocol and writes them in batches.
+     * Records are buffered per database. A database is flushed by the sink thread once it holds
+     * batch_points points or its oldest point is flush_interval old. The HTTP connection is kept alive.
+     * Failed writes are retried with backoff. All buffered data is bounded by max_buffer, points that
+     * do not fit are dropped.
+     * 
+     * The record name is split like python/condalf/influx.py does: [db:]sensor:measurement.
+     * The sensor becomes the tag "sensor", the value becomes the field "value" and the sum the field "sum".
+     */
+    class InfluxSink : private common::Service
+    {
+        public:
+            using common::Service::IsActive;
+            using common::Service::Stop;
+
+            using clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Options of the sink
+             */
+            struct options
+            {
+                std::string host;
+                std::string port = CONDALF_INFLUX_DEFAULT_PORT;
+                std::string user;
+                std::string password;
+                std::size_t batch_points = CONDALF_INFLUX_BATCH_POINTS;
+                unsigned int flush_interval = CONDALF_INFLUX_FLUSH_INTERVAL;
+                std::size_t max_buffer = CONDALF_INFLUX_MAX_BUFFER;
+            };
+
+        private:
+            /**
+             * @brief Lines of a single database
+             */
+            struct batch
+            {
+                std::string db;
+                std::string lines;
+                std::size_t points = 0;
+                clock::time_point created;
+            };
+
+            /**
+             * @brief Options of the sink
+             */
+            options config;
+
+            /**
+             * @brief Connection to InfluxDB. Only used by the sink thread.
+             */
+            std::unique_ptr<common::http::Connection> connection;
+
+            /**
+             * @brief Protects batches, retries, buffered and prefixes
+             */
+            std::mutex batch_mutex;
+
+            /**
+             * @brief Wakes the sink thread when a batch is full
+             */
+            std::condition_variable batch_notifier;
+
+            /**
+             * @brief True if a batch is full and should be written right away
+             */
+            bool flush_requested;
+
+            /**
+             * @brief Batches that are being filled, by database
+             */
+            std::unordered_map<std::string, batch> batches;
+
+            /**
+             * @brief Batches whose write failed, oldest first
+             */
+            std::deque<batch> retries;
+
+            /**
+             * @brief Escaped measurement and sensor tag by series id, empty if not built yet
+             */
+            std::vector<std::string> prefixes;
+
+            /**
+             * @brief Bytes held by batches, retries and the write in progress
+             */
+            std::size_t buffered;
+
+            /**
+             * @brief Time of the next retry
+             */
+            clock::time_point retry_time;
+
+            /**
+             * @brief Current retry backoff in ms
+             */
+            unsigned int retry_backoff;
+
+            std::atomic_uint64_t written_points;
+            std::atomic_uint64_t dropped_points;
+            std::atomic_uint64_t write_requests;
+            std::atomic_uint64_t failed_requests;
+
+            /**
+             * @brief Creates the connection
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool enable_connection();
+
+            /**
+             * @brief Writes everything that is left and closes the connection
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool disable_connection();
+
+            /**
+             * @brief Writes a batch to InfluxDB
+             * 
+             * @param data The batch
+             * @param retry Set to true if the write failed and should be retried
+             * @return true On success
+             * @return false On failure
+             */
+            bool write(const batch& data, bool& retry);
+
+            /**
+             * @brief Writes all batches and drops those that fail
+             * 
+             * @param pending The batches
+             */
+            void write_all(std::deque<batch>& pending);
+
+        protected:
+            /**
+             * @brief Run function of the sink thread. Writes due batches.
+             */
+            void run();
+
+        public:
+            /**
+             * @brief Construct a new InfluxSink object
+             */
+            InfluxSink();
+
+            /**
+             * @brief Destroy the InfluxSink object
+             */
+            ~InfluxSink();
+
+            /**
+             * @brief Starts the sink thread
+             * 
+             * @param _config Options of the sink
+             * @return true On success
+             * @return false On failure
+             */
+            bool Start(const options& _config);
+
+            /**
+             * @brief Converts the records of a pack and buffers them. Does not block on the network.
+             * 
+             * @param pack The decoded pack
+             */
+            void Process(const common::senml::Pack& pack);
+
+            /**
+             * @brief Get the statistics of the sink
+             * 
+             * @return std::string Written, dropped and buffered points
+             */
+            std::string GetStatistics();
+    };
+
+    /**
+     * @brief Converts a record to a line of InfluxDB line protocol (without newline).
+     * 
+     * @param record The record
+     * @param db The database of the record
+     * @param line The line
+     * @return true On success
+     * @return false If the record can not be represented
+     */
+    bool to_line_protocol(const common::senml::Record& record, std::string& db, std::string& line);
+}
\ No newline at end of file
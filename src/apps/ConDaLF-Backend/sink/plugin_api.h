@@ -0,0 +1,116 @@
+/**
+ * @file plugin_api.h
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief C interface of native sink plugins
+ * @version 0.1
+ * @date 2021-07-13
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * A plugin is a shared object that exports CONDALF_SINK_PLUGIN_ENTRY. The server loads it with -S,
+ * checks api_version and calls the plugin on a thread of its own:
+ * 
+ * init once, process_batch for every batch of payloads, flush periodically and before shutdown,
+ * shutdown once. All calls come from the same thread. Nothing passed to process_batch may be used
+ * after the call returned.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONDALF_SINK_API_VERSION 1
+#define CONDALF_SINK_PLUGIN_ENTRY "condalf_get_sink_plugin"
+
+/* Value types of a record, same as common::senml::ValueType */
+#define CONDALF_SINK_VALUE_NONE 0
+#define CONDALF_SINK_VALUE_NUMBER 1
+#define CONDALF_SINK_VALUE_STRING 2
+#define CONDALF_SINK_VALUE_BOOLEAN 3
+#define CONDALF_SINK_VALUE_DATA 4
+
+/* Formats of a payload */
+#define CONDALF_SINK_FORMAT_SENML_CBOR 0
+#define CONDALF_SINK_FORMAT_SENML_JSON 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A resolved SenML record. Base values are applied. Strings are not null terminated.
+ */
+typedef struct condalf_sink_record
+{
+    const char *name;
+    size_t name_length;
+    const char *unit;
+    size_t unit_length;
+    uint8_t type;           /* CONDALF_SINK_VALUE_* */
+    uint8_t boolean;        /* Boolean value */
+    uint8_t has_sum;
+    double value;           /* Numeric value */
+    const char *text;       /* String value or data value */
+    size_t text_length;
+    double sum;
+    double time;            /* Seconds since the epoch, relative times are already resolved */
+    double update_time;
+} condalf_sink_record;
+
+/**
+ * @brief A payload as received on /condalf/data and its decoded records
+ */
+typedef struct condalf_sink_payload
+{
+    const uint8_t *data;
+    size_t size;
+    int format;             /* CONDALF_SINK_FORMAT_* */
+    const condalf_sink_record *records;
+    size_t record_count;
+} condalf_sink_payload;
+
+/**
+ * @brief Entry points of a plugin
+ */
+typedef struct condalf_sink_plugin
+{
+    uint32_t api_version;   /* CONDALF_SINK_API_VERSION the plugin was built against */
+    const char *name;
+
+    /**
+     * @brief Sets the plugin up
+     * 
+     * @param argument plugin.argument of the server configuration, empty if not set
+     * @return State passed to the other calls, NULL on failure
+     */
+    void *(*init)(const char *argument);
+
+    /**
+     * @brief Processes a batch of payloads
+     * 
+     * @return 0 on success
+     */
+    int (*process_batch)(void *state, const condalf_sink_payload *payloads, size_t count);
+
+    /**
+     * @brief Writes what the plugin buffers
+     * 
+     * @return 0 on success
+     */
+    int (*flush)(void *state);
+
+    /**
+     * @brief Releases the state. The plugin is unloaded afterwards.
+     */
+    void (*shutdown)(void *state);
+} condalf_sink_plugin;
+
+/**
+ * @brief Signature of CONDALF_SINK_PLUGIN_ENTRY
+ */
+typedef const condalf_sink_plugin *(*condalf_sink_plugin_entry)(void);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
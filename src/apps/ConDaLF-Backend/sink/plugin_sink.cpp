@@ -0,0 +1,241 @@
+/**
+ * @file plugin_sink.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-13
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "plugin_sink.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <dlfcn.h>
+#include <common/logging/logging.h>
+
+using namespace condalf::sink;
+
+/**
+ * @brief Converts a record for the plugin. The record has to outlive the result.
+ * 
+ * @param record The record
+ * @return condalf_sink_record The record for the plugin
+ */
+static condalf_sink_record to_plugin_record(const common::senml::Record& record)
+{
+    condalf_sink_record result;
+    result.name = record.name.data();
+    result.name_length = record.name.size();
+    result.unit = record.unit.data();
+    result.unit_length = record.unit.size();
+    result.type = static_cast<uint8_t>(record.type);
+    result.boolean = record.boolean ? 1 : 0;
+    result.has_sum = record.has_sum ? 1 : 0;
+    result.value = record.value;
+    result.text = record.text.data();
+    result.text_length = record.text.size();
+    result.sum = record.sum;
+    result.time = record.time;
+    result.update_time = record.update_time;
+    return result;
+}
+
+bool PluginSink::load_plugin()
+{
+    library = dlopen(config.path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not load sink plugin: ") + dlerror());
+        return false;
+    }
+
+    auto entry = reinterpret_cast<condalf_sink_plugin_entry>(dlsym(library, CONDALF_SINK_PLUGIN_ENTRY));
+    plugin = entry != nullptr ? entry() : nullptr;
+    if (plugin == nullptr)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, config.path + " does not export " + CONDALF_SINK_PLUGIN_ENTRY + ".");
+        dlclose(library);
+        library = nullptr;
+        return false;
+    }
+
+    std::string invalid;
+    if (plugin->api_version != CONDALF_SINK_API_VERSION)
+        invalid = " was built for sink API version " + std::to_string(plugin->api_version) + ", expected " + std::to_string(CONDALF_SINK_API_VERSION) + ".";
+    else if (plugin->init == nullptr)
+        invalid = " does not implement init.";
+    else if (plugin->process_batch == nullptr)
+        invalid = " does not implement process_batch.";
+    if (!invalid.empty())
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, config.path + invalid);
+        plugin = nullptr;
+        dlclose(library);
+        library = nullptr;
+        return false;
+    }
+
+    state = plugin->init(config.argument.c_str());
+    if (state == nullptr)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Sink plugin ") + (plugin->name != nullptr ? plugin->name : config.path) + " failed to initialize.");
+        plugin = nullptr;
+        dlclose(library);
+        library = nullptr;
+        return false;
+    }
+
+    common::logging::log_information(std::cout, LINE_INFORMATION, std::string("Loaded sink plugin ") + (plugin->name != nullptr ? plugin->name : config.path) + ".");
+    next_flush = clock::now() + std::chrono::milliseconds(config.flush_interval);
+    return true;
+}
+
+bool PluginSink::unload_plugin()
+{
+    // The plugin thread is stopped -> hand over the queue here
+    std::deque<Job> left;
+    {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        left.swap(jobs);
+    }
+    deliver(left);
+    flush();
+
+    if (plugin->shutdown != nullptr)
+        plugin->shutdown(state);
+    state = nullptr;
+    plugin = nullptr;
+    dlclose(library);
+    library = nullptr;
+    return true;
+}
+
+void PluginSink::deliver(const std::deque<Job>& pending)
+{
+    std::vector<condalf_sink_payload> payloads;
+    std::vector<condalf_sink_record> records;
+    for (auto first = pending.begin(); first != pending.end();)
+    {
+        auto last = first + std::min<std::size_t>(config.batch_size, pending.end() - first);
+
+        // Records of all payloads in one array, the pointers are set once it does not grow anymore
+        payloads.clear();
+        records.clear();
+        for (auto it = first; it != last; it++)
+        {
+            condalf_sink_payload payload;
+            payload.data = it->payload->data();
+            payload.size = it->payload->size();
+            payload.format = it->json ? CONDALF_SINK_FORMAT_SENML_JSON : CONDALF_SINK_FORMAT_SENML_CBOR;
+            payload.records = nullptr;
+            payload.record_count = it->pack.records.size();
+            payloads.push_back(payload);
+
+            for (const auto& record : it->pack.records)
+                records.push_back(to_plugin_record(record));
+        }
+        std::size_t offset = 0;
+        for (auto& payload : payloads)
+        {
+            payload.records = records.data() + offset;
+            offset += payload.record_count;
+        }
+
+        if (plugin->process_batch(state, payloads.data(), payloads.size()) != 0)
+            failed++;
+        batches++;
+        processed += payloads.size();
+        first = last;
+    }
+}
+
+void PluginSink::flush()
+{
+    if (plugin->flush != nullptr && plugin->flush(state) != 0)
+        failed++;
+    next_flush = clock::now() + std::chrono::milliseconds(config.flush_interval);
+}
+
+void PluginSink::run()
+{
+    std::deque<Job> pending;
+    {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        clock::time_point wake = std::min(next_flush, clock::now() + std::chrono::milliseconds(CONDALF_PLUGIN_WAIT_TIMEOUT));
+        job_notifier.wait_until(lock, wake, [this] { return jobs.size() >= config.batch_size; });
+        pending.swap(jobs);
+    }
+
+    if (!pending.empty())
+        deliver(pending);
+    if (clock::now() >= next_flush)
+        flush();
+}
+
+PluginSink::PluginSink() : Service(), library(nullptr), plugin(nullptr), state(nullptr)
+{
+    this->service_name = "ConDaLF-Backend-PluginSink";
+    processed.store(0);
+    dropped.store(0);
+    batches.store(0);
+    failed.store(0);
+
+    add_hook(
+        std::bind(&PluginSink::load_plugin, this),
+        std::bind(&PluginSink::unload_plugin, this)
+    );
+}
+
+PluginSink::~PluginSink()
+{
+    Stop();
+}
+
+bool PluginSink::Start(const options& _config)
+{
+    if (IsActive())
+        return false;
+
+    config = _config;
+    if (config.queue_size == 0)
+        config.queue_size = 1;
+    if (config.batch_size == 0)
+        config.batch_size = 1;
+    return common::Service::Start();
+}
+
+void PluginSink::Submit(Job&& job)
+{
+    std::unique_lock<std::mutex> lock(job_mutex);
+    if (jobs.size() >= config.queue_size)
+    {
+        dropped++;
+        return;
+    }
+
+    jobs.push_back(std::move(job));
+    bool full = jobs.size() >= config.batch_size;
+    lock.unlock();
+    if (full)
+        job_notifier.notify_one();
+}
+
+std::string PluginSink::GetStatistics()
+{
+    std::size_t depth = 0;
+    {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        depth = jobs.size();
+    }
+
+    std::stringstream stats;
+    stats << "queue=" << depth << "/" << config.queue_size
+          << " processed=" << processed.load()
+          << " dropped=" << dropped.load()
+          << " batches=" << batches.load()
+          << " failed=" << failed.load();
+    return stats.str();
+}
\ No newline at end of file
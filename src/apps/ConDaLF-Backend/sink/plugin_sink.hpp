@@ -0,0 +1,182 @@
+/**
+ * @file plugin_sink.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Hands payloads to a native sink plugin
+ * @version 0.1
+ * @date 2021-07-13
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <common/service/service.hpp>
+#include <common/senml/senml.hpp>
+#include "plugin_api.h"
+
+#define CONDALF_PLUGIN_QUEUE_SIZE 1024      // Payloads waiting for the plugin
+#define CONDALF_PLUGIN_BATCH_SIZE 256       // Payloads per process_batch call
+#define CONDALF_PLUGIN_FLUSH_INTERVAL 1000  // ms between flush calls
+#define CONDALF_PLUGIN_WAIT_TIMEOUT 100     // ms the plugin thread waits for work before checking if it should stop
+
+namespace condalf::sink
+{
+    /**
+     * @brief Loads a sink plugin (see plugin_api.h) and calls it on its own thread.
+     * The CoAP IO thread only queues the payload with its decoded records. The queue is bounded,
+     * payloads that do not fit are dropped.
+     */
+    class PluginSink : private common::Service
+    {
+        public:
+            using common::Service::IsActive;
+            using common::Service::Stop;
+
+            using clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Options of the sink
+             */
+            struct options
+            {
+                std::string path;       // Shared object of the plugin
+                std::string argument;   // Passed to init
+                std::size_t queue_size = CONDALF_PLUGIN_QUEUE_SIZE;
+                std::size_t batch_size = CONDALF_PLUGIN_BATCH_SIZE;
+                unsigned int flush_interval = CONDALF_PLUGIN_FLUSH_INTERVAL;
+            };
+
+            /**
+             * @brief A payload for the plugin
+             */
+            struct Job
+            {
+                std::shared_ptr<const std::vector<uint8_t>> payload;
+                bool json = false;          // SenML JSON instead of SenML CBOR
+                common::senml::Pack pack;   // Decoded payload, points into payload
+            };
+
+        private:
+            /**
+             * @brief Options of the sink
+             */
+            options config;
+
+            /**
+             * @brief Handle returned by dlopen
+             */
+            void *library;
+
+            /**
+             * @brief Entry points of the plugin
+             */
+            const condalf_sink_plugin *plugin;
+
+            /**
+             * @brief State returned by init
+             */
+            void *state;
+
+            /**
+             * @brief When the plugin is flushed next
+             */
+            clock::time_point next_flush;
+
+            /**
+             * @brief Protects jobs
+             */
+            std::mutex job_mutex;
+
+            /**
+             * @brief Signals new jobs to the plugin thread
+             */
+            std::condition_variable job_notifier;
+
+            /**
+             * @brief Queued jobs, oldest first
+             */
+            std::deque<Job> jobs;
+
+            std::atomic_uint64_t processed;
+            std::atomic_uint64_t dropped;
+            std::atomic_uint64_t batches;
+            std::atomic_uint64_t failed;        // Calls that did not return 0
+
+            /**
+             * @brief Loads the plugin and calls init
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool load_plugin();
+
+            /**
+             * @brief Hands over the jobs that are left, flushes, calls shutdown and unloads the plugin
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool unload_plugin();
+
+            /**
+             * @brief Calls process_batch for the jobs in batches of batch_size
+             * 
+             * @param pending The jobs
+             */
+            void deliver(const std::deque<Job>& pending);
+
+            /**
+             * @brief Calls flush
+             */
+            void flush();
+
+        protected:
+            /**
+             * @brief Run function of the plugin thread
+             */
+            void run();
+
+        public:
+            /**
+             * @brief Construct a new PluginSink object
+             */
+            PluginSink();
+
+            /**
+             * @brief Destroy the PluginSink object
+             */
+            ~PluginSink();
+
+            /**
+             * @brief Loads the plugin and starts the plugin thread
+             * 
+             * @param _config Options of the sink
+             * @return true On success
+             * @return false On failure
+             */
+            bool Start(const options& _config);
+
+            /**
+             * @brief Queues a payload for the plugin
+             * 
+             * @param job The payload and its records
+             */
+            void Submit(Job&& job);
+
+            /**
+             * @brief Get the statistics of the sink
+             * 
+             * @return std::string Processed and dropped payloads, calls and failed calls
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
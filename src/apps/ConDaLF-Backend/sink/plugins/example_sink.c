@@ -0,0 +1,93 @@
+/**
+ * @file example_sink.c
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Example sink plugin that writes numeric records as CSV
+ * @version 0.1
+ * @date 2021-07-13
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Load it with -S and set plugin.argument to the output file (stdout if not set).
+ * Every numeric or boolean record becomes a line "name,value,time,unit".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sink/plugin_api.h>
+
+/**
+ * @brief State of the plugin
+ */
+typedef struct example_state
+{
+    FILE *file;
+    unsigned long payloads;
+    unsigned long records;
+} example_state;
+
+static void *example_init(const char *argument)
+{
+    example_state *state = calloc(1, sizeof(example_state));
+    if (state == NULL)
+        return NULL;
+
+    state->file = argument[0] != '\0' ? fopen(argument, "a") : stdout;
+    if (state->file == NULL)
+    {
+        perror("example_sink");
+        free(state);
+        return NULL;
+    }
+    return state;
+}
+
+static int example_process_batch(void *opaque, const condalf_sink_payload *payloads, size_t count)
+{
+    example_state *state = opaque;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < payloads[i].record_count; j++)
+        {
+            const condalf_sink_record *record = &payloads[i].records[j];
+            if (record->type != CONDALF_SINK_VALUE_NUMBER && record->type != CONDALF_SINK_VALUE_BOOLEAN)
+                continue;
+
+            double value = record->type == CONDALF_SINK_VALUE_NUMBER ? record->value : record->boolean;
+            if (fprintf(state->file, "%.*s,%.17g,%.9f,%.*s\n", (int)record->name_length, record->name,
+                        value, record->time, (int)record->unit_length, record->unit) < 0)
+                return -1;
+            state->records++;
+        }
+        state->payloads++;
+    }
+    return 0;
+}
+
+static int example_flush(void *opaque)
+{
+    example_state *state = opaque;
+    return fflush(state->file) == 0 ? 0 : -1;
+}
+
+static void example_shutdown(void *opaque)
+{
+    example_state *state = opaque;
+    fprintf(stderr, "example_sink: %lu payloads, %lu records\n", state->payloads, state->records);
+    if (state->file != stdout)
+        fclose(state->file);
+    free(state);
+}
+
+static const condalf_sink_plugin example_plugin = {
+    CONDALF_SINK_API_VERSION,
+    "example_sink",
+    example_init,
+    example_process_batch,
+    example_flush,
+    example_shutdown
+};
+
+const condalf_sink_plugin *condalf_get_sink_plugin(void)
+{
+    return &example_plugin;
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+/**
+ * @file reorder_buffer.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-23
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "reorder_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace condalf::sink;
+
+void ReorderBuffer::release(uint32_t id, buffer& entry, common::senml::Pack& out)
+{
+    std::pop_heap(entry.heap.begin(), entry.heap.end(), newer);
+    const point& oldest = entry.heap.back();
+
+    common::senml::Record record;
+    record.name = SeriesDictionary::getInstance().Get(id).name;
+    record.series = id;
+
+    // Points of a series are mostly released together, they share one copy of the unit
+    if (!entry.unit.empty())
+    {
+        if (out.strings.empty() || out.strings.back() != entry.unit)
+            out.strings.push_back(entry.unit);
+        record.unit = out.strings.back();
+        record.owned |= common::senml::Record::OWNS_UNIT;
+    }
+    record.type = common::senml::ValueType::NUMBER;
+    record.value = oldest.value;
+    record.has_sum = oldest.has_sum;
+    record.sum = oldest.sum;
+    record.timestamp = oldest.timestamp;
+    record.time = static_cast<double>(oldest.timestamp / 1000000000) + static_cast<double>(oldest.timestamp % 1000000000) / 1e9;
+    out.records.push_back(std::move(record));
+
+    entry.released = oldest.timestamp;
+    entry.heap.pop_back();
+    buffered--;
+    released++;
+}
+
+void ReorderBuffer::release_until(uint32_t id, buffer& entry, int64_t until, common::senml::Pack& out)
+{
+    while (!entry.heap.empty() && entry.heap.front().timestamp <= until)
+        release(id, entry, out);
+}
+
+ReorderBuffer::ReorderBuffer()
+{
+    buffered.store(0);
+    released.store(0);
+    late.store(0);
+    forced.store(0);
+    passed.store(0);
+}
+
+void ReorderBuffer::Configure(const options& _config)
+{
+    std::lock_guard guard(reorder_mutex);
+    config = _config;
+    if (config.max_points == 0)
+        config.max_points = 1;
+    series.clear();
+    buffered.store(0);
+}
+
+void ReorderBuffer::Process(const common::senml::Pack& pack, int64_t now, unsigned int sinks, common::senml::Pack& out, common::senml::Pack& late_out)
+{
+    using common::senml::ValueType;
+
+    std::lock_guard guard(reorder_mutex);
+    int64_t lateness = static_cast<int64_t>(config.lateness) * 1000000;
+    for (const auto& record : pack.records)
+    {
+        if (record.type != ValueType::NUMBER || !std::isfinite(record.value))
+        {
+            common::senml::append_record(record, out);
+            passed++;
+            continue;
+        }
+
+        // New series pass through once there is no room left
+        uint32_t id = SeriesDictionary::getInstance().Of(record);
+        auto it = series.find(id);
+        if (it == series.end())
+        {
+            if (id == CONDALF_SERIES_INVALID || series.size() >= config.max_series)
+            {
+                common::senml::append_record(record, out);
+                passed++;
+                continue;
+            }
+            it = series.emplace(id, buffer()).first;
+        }
+
+        // Points before the last released one can not be put in order anymore
+        buffer& entry = it->second;
+        if (record.timestamp < entry.released)
+        {
+            common::senml::append_record(record, late_out);
+            late++;
+            continue;
+        }
+
+        entry.heap.push_back({ record.timestamp, record.value, record.sum, record.has_sum });
+        std::push_heap(entry.heap.begin(), entry.heap.end(), newer);
+        buffered++;
+        entry.newest = std::max(entry.newest, record.timestamp);
+        entry.arrived = now;
+        entry.sinks |= sinks;
+        entry.unit = record.unit;
+
+        // A full buffer moves the watermark of its series forward
+        if (entry.heap.size() > config.max_points)
+        {
+            release(id, entry, out);
+            forced++;
+        }
+        release_until(id, entry, entry.newest - lateness, out);
+    }
+}
+
+void ReorderBuffer::Flush(int64_t now, std::vector<sink_batch>& out)
+{
+    std::lock_guard guard(reorder_mutex);
+    int64_t lateness = static_cast<int64_t>(config.lateness) * 1000000;
+    int64_t idle = static_cast<int64_t>(CONDALF_REORDER_IDLE) * 1000000000;
+    for (auto it = series.begin(); it != series.end();)
+    {
+        buffer& entry = it->second;
+        if (entry.arrived + lateness <= now && !entry.heap.empty())
+            release_until(it->first, entry, INT64_MAX, batch_for(out, entry.sinks));
+
+        // Series that stopped sending are forgotten, the time of their last released point with them
+        if (entry.heap.empty() && entry.arrived + idle <= now)
+            it = series.erase(it);
+        else
+            it++;
+    }
+}
+
+void ReorderBuffer::FlushAll(std::vector<sink_batch>& out)
+{
+    std::lock_guard guard(reorder_mutex);
+    for (auto& entry : series)
+    {
+        if (!entry.second.heap.empty())
+            release_until(entry.first, entry.second, INT64_MAX, batch_for(out, entry.second.sinks));
+    }
+    series.clear();
+}
+
+std::string ReorderBuffer::GetStatistics()
+{
+    std::size_t buffers = 0;
+    {
+        std::lock_guard guard(reorder_mutex);
+        buffers = series.size();
+    }
+
+    std::stringstream stats;
+    stats << "series=" << buffers << "/" << config.max_series
+          << " buffered=" << buffered.load()
+          << " released=" << released.load()
+          << " late=" << late.load()
+          << " forced=" << forced.load()
+          << " passed=" << passed.load();
+    return stats.str();
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+/**
+ * @file reorder_buffer.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Puts the points of numeric series back into time order before they reach the sinks
+ * @version 0.1
+ * @date 2021-07-23
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <common/senml/senml.hpp>
+#include "series.hpp"
+
+#define CONDALF_REORDER_LATENESS 5000       // ms a point may arrive after newer points of its series
+#define CONDALF_REORDER_MAX_POINTS 4096     // Points buffered per series, the oldest is released when there are more
+#define CONDALF_REORDER_MAX_SERIES 10000    // Series with a buffer at most, further series pass through
+#define CONDALF_REORDER_IDLE 600            // Seconds without points after which a series is forgotten
+
+namespace condalf::sink
+{
+    /**
+     * @brief Buffers the numeric points of every series in a min-heap and releases them in time order.
+     * The watermark of a series is the newest time seen minus the lateness. Points at or before the watermark
+     * are released, points older than the last released one are too late and go to the side channel instead.
+     * A series that receives no points for the lateness is released completely (see Flush), so quiet
+     * series do not hold their last points back. Points released by the timer go to the sinks of the resources
+     * that fed their series. String, boolean and data records pass through.
+     */
+    class ReorderBuffer
+    {
+        public:
+            /**
+             * @brief Options of the buffer
+             */
+            struct options
+            {
+                unsigned int lateness = CONDALF_REORDER_LATENESS;       // ms
+                std::size_t max_points = CONDALF_REORDER_MAX_POINTS;
+                std::size_t max_series = CONDALF_REORDER_MAX_SERIES;
+            };
+
+        private:
+            /**
+             * @brief A buffered point
+             */
+            struct point
+            {
+                int64_t timestamp;  // ns since the epoch
+                double value;
+                double sum;
+                bool has_sum;
+            };
+
+            /**
+             * @brief Buffer of a series
+             */
+            struct buffer
+            {
+                std::vector<point> heap;        // Min-heap by time
+                int64_t newest = INT64_MIN;     // Newest time seen
+                int64_t released = INT64_MIN;   // Time of the last released point
+                int64_t arrived = 0;            // Receive time of the last point in ns
+                unsigned int sinks = 0;         // Sinks of the resources that fed the series
+                std::string unit;
+            };
+
+            /**
+             * @brief Options of the buffer
+             */
+            options config;
+
+            /**
+             * @brief Protects series
+             */
+            std::mutex reorder_mutex;
+
+            /**
+             * @brief Buffers by series id
+             */
+            std::unordered_map<uint32_t, buffer> series;
+
+            std::atomic_uint64_t buffered;      // Points in the buffers
+            std::atomic_uint64_t released;      // Points that were released in order
+            std::atomic_uint64_t late;          // Points that went to the side channel
+            std::atomic_uint64_t forced;        // Points released early because their buffer was full
+            std::atomic_uint64_t passed;        // Records that passed through
+
+            /**
+             * @brief Orders the heaps so that the oldest point is at the front
+             * 
+             * @param a A point
+             * @param b Another point
+             * @return true If a is newer than b
+             */
+            static bool newer(const point& a, const point& b)
+            {
+                return a.timestamp > b.timestamp;
+            }
+
+            /**
+             * @brief Releases the oldest point of a series
+             * 
+             * @param id Series id
+             * @param entry The buffer
+             * @param out Pack to append the record to
+             */
+            void release(uint32_t id, buffer& entry, common::senml::Pack& out);
+
+            /**
+             * @brief Releases the points of a series up to a time
+             * 
+             * @param id Series id
+             * @param entry The buffer
+             * @param until Last time to release in ns
+             * @param out Pack to append the records to
+             */
+            void release_until(uint32_t id, buffer& entry, int64_t until, common::senml::Pack& out);
+
+        public:
+            /**
+             * @brief Construct a new ReorderBuffer object with the default options
+             */
+            ReorderBuffer();
+
+            /**
+             * @brief Sets the options. Buffered points are dropped.
+             * 
+             * @param _config Options of the buffer
+             */
+            void Configure(const options& _config);
+
+            /**
+             * @brief Feeds the records of a pack. Records that pass through and points that were released
+             * are appended to out, points that are too late to late.
+             * 
+             * @param pack The decoded pack with times normalized by common::senml::normalize_times
+             * @param now Receive time of the pack in ns since the epoch
+             * @param sinks Sinks of the resource that received the pack
+             * @param out Records in time order per series for the store, the rollup and the sinks
+             * @param late Points older than the last released point of their series
+             */
+            void Process(const common::senml::Pack& pack, int64_t now, unsigned int sinks, common::senml::Pack& out, common::senml::Pack& late);
+
+            /**
+             * @brief Releases the series that received no points for the lateness and forgets idle series
+             * 
+             * @param now ns since the epoch
+             * @param out The records by the sinks of their series
+             */
+            void Flush(int64_t now, std::vector<sink_batch>& out);
+
+            /**
+             * @brief Releases all points, used when the server stops
+             * 
+             * @param out The records by the sinks of their series
+             */
+            void FlushAll(std::vector<sink_batch>& out);
+
+            /**
+             * @brief Get the statistics of the buffer
+             * 
+             * @return std::string Series, buffered, released, late, forced and passed points
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
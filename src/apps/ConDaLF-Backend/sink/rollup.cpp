@@ -0,0 +1,207 @@
+/**
+ * @file rollup.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-15
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "rollup.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace condalf::sink;
+
+bool Rollup::is_raw(std::string_view name) const
+{
+    for (const auto& selected : config.raw)
+    {
+        if (!selected.empty() && selected.back() == '*')
+        {
+            if (name.compare(0, selected.size() - 1, selected, 0, selected.size() - 1) == 0)
+                return true;
+        }
+        else if (name == selected)
+            return true;
+    }
+    return false;
+}
+
+void Rollup::close(uint32_t id, accumulator& window, common::senml::Pack& out)
+{
+    static const char* suffixes[] = { "_min", "_max", "_mean", "_count" };
+    SeriesDictionary &dictionary = SeriesDictionary::getInstance();
+    const std::string &name = dictionary.Get(id).name;
+    double values[] = { window.min, window.max, window.sum / window.count, static_cast<double>(window.count) };
+    std::string_view unit;
+    if (!window.unit.empty())
+        unit = out.strings.emplace_back(window.unit);
+
+    for (int i = 0; i < 4; i++)
+    {
+        // The ids of the rollup series are looked up once per series
+        if (window.outputs[i] == CONDALF_SERIES_INVALID)
+            window.outputs[i] = dictionary.Intern(name, suffixes[i]);
+
+        // The dictionary keeps the names of the rollup series, only names that did not fit are built
+        common::senml::Record record;
+        if (window.outputs[i] != CONDALF_SERIES_INVALID)
+            record.name = dictionary.Get(window.outputs[i]).name;
+        else
+        {
+            record.name = out.strings.emplace_back(name + suffixes[i]);
+            record.owned |= common::senml::Record::OWNS_NAME;
+        }
+        record.series = window.outputs[i];
+        if (i < 3 && !unit.empty())
+        {
+            record.unit = unit;
+            record.owned |= common::senml::Record::OWNS_UNIT;
+        }
+        record.type = common::senml::ValueType::NUMBER;
+        record.value = values[i];
+        record.time = static_cast<double>(window.start);
+        record.timestamp = window.start * 1000000000;
+        out.records.push_back(std::move(record));
+    }
+
+    window.closed = window.start;
+    window.count = 0;
+    rollups++;
+}
+
+Rollup::Rollup()
+{
+    points.store(0);
+    rollups.store(0);
+    passed.store(0);
+    late.store(0);
+}
+
+void Rollup::Configure(const options& _config)
+{
+    std::lock_guard guard(rollup_mutex);
+    config = _config;
+    if (config.window == 0)
+        config.window = 1;
+    series.clear();
+    forgotten.clear();
+}
+
+void Rollup::Process(const common::senml::Pack& pack, unsigned int sinks, common::senml::Pack& out)
+{
+    using common::senml::ValueType;
+
+    std::lock_guard guard(rollup_mutex);
+    int64_t length = config.window;
+    for (const auto& record : pack.records)
+    {
+        if (record.type != ValueType::NUMBER || !std::isfinite(record.value) || is_raw(record.name))
+        {
+            common::senml::append_record(record, out);
+            passed++;
+            continue;
+        }
+
+        // New series pass through once there is no room left
+        uint32_t id = SeriesDictionary::getInstance().Of(record);
+        auto it = series.find(id);
+        if (it == series.end())
+        {
+            if (id == CONDALF_SERIES_INVALID || series.size() >= config.max_series)
+            {
+                common::senml::append_record(record, out);
+                passed++;
+                continue;
+            }
+            it = series.emplace(id, accumulator()).first;
+            if (id < forgotten.size())
+                it->second.closed = forgotten[id];
+        }
+
+        accumulator& window = it->second;
+        int64_t start = record.timestamp / 1000000000 / length * length;
+        if (start <= window.closed || (window.count > 0 && start < window.start))
+        {
+            late++;
+            continue;
+        }
+
+        // A point of a later window closes the open one
+        if (window.count > 0 && start > window.start)
+            close(it->first, window, out);
+
+        if (window.count == 0)
+        {
+            window.start = start;
+            window.min = window.max = window.sum = record.value;
+            window.sinks = sinks;
+        }
+        else
+        {
+            window.min = std::min(window.min, record.value);
+            window.max = std::max(window.max, record.value);
+            window.sum += record.value;
+            window.sinks |= sinks;
+        }
+        window.count++;
+        window.unit = record.unit;
+        points++;
+    }
+}
+
+void Rollup::Flush(double now, std::vector<sink_batch>& out)
+{
+    std::lock_guard guard(rollup_mutex);
+    int64_t length = config.window;
+    for (auto it = series.begin(); it != series.end();)
+    {
+        accumulator& window = it->second;
+        if (window.count > 0 && window.start + length + config.grace <= now)
+            close(it->first, window, batch_for(out, window.sinks));
+
+        // Series that stopped sending are forgotten after another window, only their watermark is kept
+        if (window.count == 0 && window.closed != INT64_MIN && window.closed + 2 * length + config.grace <= now)
+        {
+            if (it->first >= forgotten.size())
+                forgotten.resize(it->first + 1, INT64_MIN);
+            forgotten[it->first] = window.closed;
+            it = series.erase(it);
+        }
+        else
+            it++;
+    }
+}
+
+void Rollup::FlushAll(std::vector<sink_batch>& out)
+{
+    std::lock_guard guard(rollup_mutex);
+    for (auto& entry : series)
+    {
+        if (entry.second.count > 0)
+            close(entry.first, entry.second, batch_for(out, entry.second.sinks));
+    }
+    series.clear();
+}
+
+std::string Rollup::GetStatistics()
+{
+    std::size_t open = 0;
+    {
+        std::lock_guard guard(rollup_mutex);
+        open = series.size();
+    }
+
+    std::stringstream stats;
+    stats << "series=" << open << "/" << config.max_series
+          << " points=" << points.load()
+          << " rollups=" << rollups.load()
+          << " passed=" << passed.load()
+          << " late=" << late.load();
+    return stats.str();
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+/**
+ * @file rollup.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Downsamples numeric series before they reach the sinks
+ * @version 0.1
+ * @date 2021-07-15
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <common/senml/senml.hpp>
+#include "series.hpp"
+
+#define CONDALF_ROLLUP_WINDOW 60            // Seconds per window
+#define CONDALF_ROLLUP_GRACE 5              // Seconds a window stays open after its end for late points
+#define CONDALF_ROLLUP_MAX_SERIES 10000     // Series with an open window at most, further series pass through
+
+namespace condalf::sink
+{
+    /**
+     * @brief Replaces the numeric records of a series by min, max, mean and count per window.
+     * Every series has one open window. It is closed when a point of a later window arrives or when
+     * its end is grace seconds in the past (see Flush). A closed window becomes the records
+     * <name>_min, <name>_max, <name>_mean and <name>_count with the start of the window as time.
+     * Points of windows that were already closed are dropped, also after an idle series was forgotten. Windows closed by the timer
+     * go to the sinks of the resources that fed them. String, boolean and data records as well
+     * as the series selected for raw passthrough are not touched.
+     */
+    class Rollup
+    {
+        public:
+            /**
+             * @brief Options of the rollup
+             */
+            struct options
+            {
+                unsigned int window = CONDALF_ROLLUP_WINDOW;
+                unsigned int grace = CONDALF_ROLLUP_GRACE;
+                std::size_t max_series = CONDALF_ROLLUP_MAX_SERIES;
+                std::vector<std::string> raw;   // Series that pass through, a trailing * matches a prefix
+            };
+
+        private:
+            /**
+             * @brief Accumulator of the open window of a series
+             */
+            struct accumulator
+            {
+                int64_t start = 0;          // Start of the open window in seconds
+                int64_t closed = INT64_MIN; // Start of the last closed window
+                uint64_t count = 0;         // 0 if no window is open
+                double min = 0;
+                double max = 0;
+                double sum = 0;
+                unsigned int sinks = 0;     // Sinks of the resources that fed the open window
+                std::string unit;
+                uint32_t outputs[4] = { CONDALF_SERIES_INVALID, CONDALF_SERIES_INVALID, CONDALF_SERIES_INVALID, CONDALF_SERIES_INVALID };  // Series ids of _min, _max, _mean and _count
+            };
+
+            /**
+             * @brief Options of the rollup
+             */
+            options config;
+
+            /**
+             * @brief Protects series
+             */
+            std::mutex rollup_mutex;
+
+            /**
+             * @brief Accumulators by series id
+             */
+            std::unordered_map<uint32_t, accumulator> series;
+
+            /**
+             * @brief Start of the last closed window by series id, kept when a series is forgotten so that
+             * late points can not open a window again that was already written. Bounded by the series ids.
+             */
+            std::vector<int64_t> forgotten;
+
+            std::atomic_uint64_t points;        // Points that were rolled up
+            std::atomic_uint64_t rollups;       // Windows that were closed
+            std::atomic_uint64_t passed;        // Records that passed through
+            std::atomic_uint64_t late;          // Points of closed windows
+
+            /**
+             * @brief Checks if a series is selected for raw passthrough
+             * 
+             * @param name Record name
+             * @return true If its records pass through
+             * @return false If it is rolled up
+             */
+            bool is_raw(std::string_view name) const;
+
+            /**
+             * @brief Appends the records of a window and resets the accumulator
+             * 
+             * @param id Series id
+             * @param window The accumulator
+             * @param out Pack to append to
+             */
+            void close(uint32_t id, accumulator& window, common::senml::Pack& out);
+
+        public:
+            /**
+             * @brief Construct a new Rollup object with the default options
+             */
+            Rollup();
+
+            /**
+             * @brief Sets the options. Open windows are dropped.
+             * 
+             * @param _config Options of the rollup
+             */
+            void Configure(const options& _config);
+
+            /**
+             * @brief Feeds the records of a pack. Records that pass through and windows that were closed
+             * by this pack are appended to out.
+             * 
+             * @param pack The decoded pack with times normalized by common::senml::normalize_times
+             * @param sinks Sinks of the resource that received the pack
+             * @param out Records for the sinks
+             */
+            void Process(const common::senml::Pack& pack, unsigned int sinks, common::senml::Pack& out);
+
+            /**
+             * @brief Closes the windows whose end is more than grace seconds before now
+             * 
+             * @param now Seconds since the epoch
+             * @param out The records of the closed windows by the sinks that fed them
+             */
+            void Flush(double now, std::vector<sink_batch>& out);
+
+            /**
+             * @brief Closes all open windows and forgets the series
+             * 
+             * @param out The records of the closed windows by the sinks that fed them
+             */
+            void FlushAll(std::vector<sink_batch>& out);
+
+            /**
+             * @brief Get the statistics of the rollup
+             * 
+             * @return std::string Open windows, rolled up points, closed windows, passed and late records
+             */
+            std::string GetStatistics();
+    };
+}
\ No newline at end of file
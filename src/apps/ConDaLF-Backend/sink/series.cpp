@@ -0,0 +1,151 @@
+/**
+ * @file series.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-10
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "series.hpp"
+
+#include <mutex>
+#include <common/logging/logging.h>
+#include <sstream>
+
+using namespace condalf::sink;
+
+series_name condalf::sink::split_series_name(std::string_view name)
+{
+    std::string_view parts[3];
+    std::size_t count = 0;
+    while (count < 3)
+    {
+        std::size_t separator = name.rfind(':');
+        parts[count++] = separator == std::string_view::npos ? name : name.substr(separator + 1);
+        if (separator == std::string_view::npos)
+            break;
+        name = name.substr(0, separator);
+    }
+
+    series_name series;
+    series.measurement = parts[0];
+    if (count >= 2)
+        series.sensor = parts[1];
+    if (count >= 3)
+        series.db = parts[2];
+    return series;
+}
+
+uint32_t SeriesDictionary::Intern(std::string_view name)
+{
+    {
+        std::shared_lock lock(dictionary_mutex);
+        auto it = ids.find(name);
+        if (it != ids.end())
+            return it->second;
+    }
+
+    // Another thread might have added it in between
+    std::unique_lock lock(dictionary_mutex);
+    auto it = ids.find(name);
+    if (it != ids.end())
+        return it->second;
+    if (entries.size() >= limit)
+    {
+        // Logged once, the stages still process the records by name
+        if (!limit_logged)
+        {
+            common::logging::log_warning(std::cout, LINE_INFORMATION, "The series dictionary is full (" + std::to_string(limit) + " series), further series are processed without id.");
+            limit_logged = true;
+        }
+        refused++;
+        return CONDALF_SERIES_INVALID;
+    }
+
+    uint32_t id = static_cast<uint32_t>(entries.size());
+    series_entry& entry = entries.emplace_back();
+    entry.name = name;
+    entry.parts = split_series_name(entry.name);
+    ids.emplace(entry.name, id);
+    return id;
+}
+
+uint32_t SeriesDictionary::Intern(std::string_view base_name, std::string_view name)
+{
+    // The scratch buffer only allocates until it reached the longest name
+    thread_local std::string full;
+    full.assign(base_name);
+    full.append(name);
+    return Intern(full);
+}
+
+uint32_t SeriesDictionary::Find(std::string_view name) const
+{
+    std::shared_lock lock(dictionary_mutex);
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : CONDALF_SERIES_INVALID;
+}
+
+const series_entry& SeriesDictionary::Get(uint32_t id) const
+{
+    std::shared_lock lock(dictionary_mutex);
+    return entries[id];
+}
+
+void SeriesDictionary::Assign(common::senml::Pack& pack)
+{
+    for (auto& record : pack.records)
+    {
+        if (record.series == CONDALF_SERIES_INVALID)
+            record.series = Intern(record.name);
+    }
+}
+
+std::size_t SeriesDictionary::Size() const
+{
+    std::shared_lock lock(dictionary_mutex);
+    return entries.size();
+}
+
+void SeriesDictionary::SetLimit(std::size_t _limit)
+{
+    std::unique_lock lock(dictionary_mutex);
+    limit = _limit;
+}
+
+std::vector<std::string> SeriesDictionary::Reset()
+{
+    std::unique_lock lock(dictionary_mutex);
+    std::vector<std::string> names;
+    names.reserve(entries.size());
+    for (auto& entry : entries)
+        names.push_back(std::move(entry.name));
+    ids.clear();
+    entries.clear();
+    limit_logged = false;
+    return names;
+}
+
+std::string SeriesDictionary::GetStatistics() const
+{
+    std::shared_lock lock(dictionary_mutex);
+    std::stringstream stats;
+    stats << "series=" << entries.size() << "/" << limit
+          << " refused=" << refused.load();
+    return stats.str();
+}
+
+common::senml::Pack& condalf::sink::batch_for(std::vector<sink_batch>& batches, unsigned int sinks)
+{
+    for (auto& batch : batches)
+    {
+        if (batch.sinks == sinks)
+            return batch.pack;
+    }
+    sink_batch& batch = batches.emplace_back();
+    batch.sinks = sinks;
+    return batch.pack;
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+/**
+ * @file series.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Naming scheme of the series
+ * @version 0.1
+ * @date 2021-07-10
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <common/senml/senml.hpp>
+
+#define CONDALF_DEFAULT_DB "main"
+#define CONDALF_SERIES_LIMIT 65536              // Series ids handed out at most
+#define CONDALF_SERIES_INVALID UINT32_MAX       // Id of names that did not fit into the dictionary
+
+namespace condalf::sink
+{
+    /**
+     * @brief Parts of a record name of the form [db:]sensor:measurement.
+     * Only the last three parts are used, like python/condalf/senml_parser.py does.
+     */
+    struct series_name
+    {
+        std::string_view db = CONDALF_DEFAULT_DB;
+        std::string_view sensor;        // Empty if the name has no sensor
+        std::string_view measurement;
+    };
+
+    /**
+     * @brief Splits a record name. The parts point into name.
+     * 
+     * @param name The record name
+     * @return series_name The parts
+     */
+    series_name split_series_name(std::string_view name);
+
+    /**
+     * @brief A series of the dictionary
+     */
+    struct series_entry
+    {
+        std::string name;       // The record name
+        series_name parts;      // Split name, points into name
+    };
+
+    /**
+     * @brief Maps record names to stable 32-bit series ids, so that stages after the decoder can key their state
+     * by integer and do not have to split names again. Ids are handed out in order starting at 0 and stay valid
+     * until Reset, which the server calls on reload so that the ids of series that are gone are freed.
+     * The number of series is bounded, names that do not fit get CONDALF_SERIES_INVALID and are counted.
+     * Lookups of known names only take a shared lock.
+     */
+    class SeriesDictionary
+    {
+        private:
+            /**
+             * @brief Protects entries and ids
+             */
+            mutable std::shared_mutex dictionary_mutex;
+
+            /**
+             * @brief Series by id. A deque keeps the names in place when it grows.
+             */
+            std::deque<series_entry> entries;
+
+            /**
+             * @brief Ids by name, the keys point into entries
+             */
+            std::unordered_map<std::string_view, uint32_t> ids;
+
+            /**
+             * @brief Series ids handed out at most
+             */
+            std::size_t limit;
+
+            /**
+             * @brief True once a full dictionary was logged, reset by Reset
+             */
+            bool limit_logged = false;
+
+            /**
+             * @brief Names that did not fit
+             */
+            std::atomic_uint64_t refused;
+
+            /**
+             * @brief Construct a new SeriesDictionary object (private because it's a Singleton)
+             */
+            SeriesDictionary() : limit(CONDALF_SERIES_LIMIT) { refused.store(0); }
+
+        public:
+            /**
+             * @brief Get the Singleton Instance
+             * 
+             * @return SeriesDictionary& 
+             */
+            static SeriesDictionary &getInstance()
+            {
+                static SeriesDictionary instance;
+                return instance;
+            }
+
+            /**
+             * @brief Deleted copy constructor
+             */
+            SeriesDictionary(const SeriesDictionary&) = delete;
+
+            /**
+             * @brief Deleted assign operator
+             */
+            SeriesDictionary& operator=(const SeriesDictionary&) = delete;
+
+            /**
+             * @brief Get the id of a name and add the name if it is new
+             * 
+             * @param name The record name
+             * @return uint32_t The id or CONDALF_SERIES_INVALID if the dictionary is full
+             */
+            uint32_t Intern(std::string_view name);
+
+            /**
+             * @brief Get the id of base name + name without building the name first
+             * 
+             * @param base_name The base name
+             * @param name The name
+             * @return uint32_t The id or CONDALF_SERIES_INVALID if the dictionary is full
+             */
+            uint32_t Intern(std::string_view base_name, std::string_view name);
+
+            /**
+             * @brief Get the id of a known name
+             * 
+             * @param name The record name
+             * @return uint32_t The id or CONDALF_SERIES_INVALID if the name is unknown
+             */
+            uint32_t Find(std::string_view name) const;
+
+            /**
+             * @brief Get a series. The entry stays valid until Reset.
+             * 
+             * @param id A valid id
+             * @return const series_entry& The series
+             */
+            const series_entry& Get(uint32_t id) const;
+
+            /**
+             * @brief Sets the series id of every record of a pack that has none yet
+             * 
+             * @param pack The decoded pack
+             */
+            void Assign(common::senml::Pack& pack);
+
+            /**
+             * @brief Get the id of a record, the record name is interned if the record has none
+             * 
+             * @param record The record
+             * @return uint32_t The id or CONDALF_SERIES_INVALID if the dictionary is full
+             */
+            uint32_t Of(const common::senml::Record& record)
+            {
+                return record.series != CONDALF_SERIES_INVALID ? record.series : Intern(record.name);
+            }
+
+            /**
+             * @brief Get the number of series
+             * 
+             * @return std::size_t Series ids handed out
+             */
+            std::size_t Size() const;
+
+            /**
+             * @brief Set the number of series ids handed out at most. Ids that were handed out stay valid.
+             * 
+             * @param _limit The limit
+             */
+            void SetLimit(std::size_t _limit);
+
+            /**
+             * @brief Drops all series, ids are handed out from 0 again. Must not run while another thread uses
+             * the dictionary or ids of it, stages that keep state by id have to drop it or move it to the new ids.
+             * 
+             * @return std::vector<std::string> The names by their old id
+             */
+            std::vector<std::string> Reset();
+
+            /**
+             * @brief Get the statistics of the dictionary
+             * 
+             * @return std::string Series, limit and names that did not fit
+             */
+            std::string GetStatistics() const;
+    };
+
+    /**
+     * @brief Records that a buffer released on its timer, for the sinks of the resources that fed their series
+     */
+    struct sink_batch
+    {
+        unsigned int sinks = 0;     // Sink bits of condalf::service::RouteTable
+        common::senml::Pack pack;
+    };
+
+    /**
+     * @brief Get the pack of the batch for some sinks, it is appended if there is none yet.
+     * There are only a few distinct sink sets, so they are searched.
+     * 
+     * @param batches The batches
+     * @param sinks Sink bits
+     * @return common::senml::Pack& Pack of the batch
+     */
+    common::senml::Pack& batch_for(std::vector<sink_batch>& batches, unsigned int sinks);
+}
\ No newline at end of file
@@ -0,0 +1,324 @@
+/**
+ * @file influx_sink_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the InfluxDB sink against a local HTTP stand-in that counts points
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/sink/influx_sink.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#define INFLUX_TEST_TIMEOUT 5000    // ms to wait for the points
+
+using namespace condalf::sink;
+using test_clock = std::chrono::steady_clock;
+
+/**
+ * @brief Answers InfluxDB writes on a local port and counts the lines per database
+ */
+class InfluxStandIn
+{
+    private:
+        int listener = -1;
+        std::string port;
+        std::thread worker;
+        std::atomic_bool stop;
+
+        std::mutex stand_in_mutex;
+        std::deque<int> statuses;               // Statuses to answer before 204
+        std::map<std::string, std::size_t> points;  // Lines by target
+        std::size_t requests = 0;
+        std::string last_body;
+
+        /**
+         * @brief Reads and answers the requests of one connection until it is closed
+         * 
+         * @param fd The connection
+         */
+        void serve(int fd)
+        {
+            std::string buffer;
+            while (!stop.load())
+            {
+                std::size_t header_end = buffer.find("\r\n\r\n");
+                std::size_t length_at = buffer.find("Content-Length: ");
+                if (header_end != std::string::npos && length_at != std::string::npos && length_at < header_end)
+                {
+                    std::size_t length = std::stoul(buffer.substr(length_at + 16));
+                    if (buffer.size() >= header_end + 4 + length)
+                    {
+                        std::string target = buffer.substr(5, buffer.find(' ', 5) - 5);
+                        std::string body = buffer.substr(header_end + 4, length);
+                        buffer.erase(0, header_end + 4 + length);
+
+                        int status = 204;
+                        {
+                            std::lock_guard guard(stand_in_mutex);
+                            requests++;
+                            if (!statuses.empty())
+                            {
+                                status = statuses.front();
+                                statuses.pop_front();
+                            }
+                            if (status == 204)
+                            {
+                                points[target] += std::count(body.begin(), body.end(), '\n');
+                                last_body = body;
+                            }
+                        }
+
+                        std::string response = "HTTP/1.1 " + std::to_string(status) + (status == 204 ? " No Content" : " Service Unavailable") + "\r\nContent-Length: 0\r\n\r\n";
+                        if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) != (ssize_t)response.size())
+                            return;
+                        continue;
+                    }
+                }
+
+                pollfd wait = { fd, POLLIN, 0 };
+                if (poll(&wait, 1, 50) <= 0)
+                    continue;
+                char chunk[4096];
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0)
+                    return;
+                buffer.append(chunk, received);
+            }
+        }
+
+    public:
+        /**
+         * @brief Listens on a free local port and answers on its own thread
+         */
+        InfluxStandIn()
+        {
+            stop.store(false);
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0 ||
+                getsockname(listener, (sockaddr*)&address, &length) != 0)
+                throw std::runtime_error(LINE_INFORMATION + std::string("\tCould not listen for the stand-in"));
+            port = std::to_string(ntohs(address.sin_port));
+
+            worker = std::thread([this] {
+                while (!stop.load())
+                {
+                    pollfd wait = { listener, POLLIN, 0 };
+                    if (poll(&wait, 1, 50) <= 0)
+                        continue;
+                    int fd = accept(listener, nullptr, nullptr);
+                    if (fd < 0)
+                        continue;
+                    serve(fd);
+                    close(fd);
+                }
+            });
+        }
+
+        /**
+         * @brief Stops the stand-in
+         */
+        ~InfluxStandIn()
+        {
+            stop.store(true);
+            worker.join();
+            close(listener);
+        }
+
+        /**
+         * @brief Get the port the stand-in listens on
+         * 
+         * @return const std::string& The port
+         */
+        const std::string& Port() const { return port; }
+
+        /**
+         * @brief Answers the next write with an error, its points are not counted
+         * 
+         * @param status The HTTP status
+         */
+        void FailNext(int status)
+        {
+            std::lock_guard guard(stand_in_mutex);
+            statuses.push_back(status);
+        }
+
+        /**
+         * @brief Get the points a database received
+         * 
+         * @param db The database
+         * @return std::size_t Lines of the successful writes
+         */
+        std::size_t Points(const std::string& db)
+        {
+            std::lock_guard guard(stand_in_mutex);
+            return points["/write?db=" + db + "&precision=ns"];
+        }
+
+        /**
+         * @brief Get the number of writes, failed ones included
+         * 
+         * @return std::size_t The writes
+         */
+        std::size_t Requests()
+        {
+            std::lock_guard guard(stand_in_mutex);
+            return requests;
+        }
+
+        /**
+         * @brief Get the body of the last successful write
+         * 
+         * @return std::string The line protocol
+         */
+        std::string LastBody()
+        {
+            std::lock_guard guard(stand_in_mutex);
+            return last_body;
+        }
+
+        /**
+         * @brief Waits until the databases received the points
+         * 
+         * @param expected Points by database
+         * @return true All points arrived
+         * @return false Timeout
+         */
+        bool WaitFor(const std::map<std::string, std::size_t>& expected)
+        {
+            auto deadline = test_clock::now() + std::chrono::milliseconds(INFLUX_TEST_TIMEOUT);
+            while (test_clock::now() < deadline)
+            {
+                bool done = true;
+                for (const auto& db : expected)
+                    done = done && Points(db.first) >= db.second;
+                if (done)
+                    return true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+};
+
+/**
+ * @brief Creates a numeric record
+ * 
+ * @param name The record name
+ * @param value The value
+ * @param timestamp ns since the epoch
+ * @return common::senml::Record The record
+ */
+static common::senml::Record number(std::string_view name, double value, int64_t timestamp)
+{
+    common::senml::Record record;
+    record.name = name;
+    record.type = common::senml::ValueType::NUMBER;
+    record.value = value;
+    record.timestamp = timestamp;
+    return record;
+}
+
+TEST_CASE(line_protocol)
+{
+    std::string db, line;
+    ASSERT_TRUE(to_line_protocol(number("mydb:s 1:temp,x", 1.5, 5), db, line));
+    ASSERT_TRUE(db == "mydb");
+    ASSERT_TRUE(line == "temp\\,x,sensor=s\\ 1 value=1.5 5");
+
+    ASSERT_TRUE(to_line_protocol(number("hum", 40, 0), db, line));
+    ASSERT_TRUE(db == CONDALF_DEFAULT_DB);
+    ASSERT_TRUE(line == "hum value=40");
+
+    common::senml::Record text;
+    text.name = "a:b";
+    text.type = common::senml::ValueType::STRING;
+    text.text = "he said \"hi\"";
+    text.has_sum = true;
+    text.sum = 3;
+    ASSERT_TRUE(to_line_protocol(text, db, line));
+    ASSERT_TRUE(line == "b,sensor=a value=\"he said \\\"hi\\\"\",sum=3");
+
+    ASSERT_FALSE(to_line_protocol(number("nan", NAN, 0), db, line));
+    common::senml::Record data;
+    data.name = "blob";
+    data.type = common::senml::ValueType::DATA;
+    data.text = "AAEC";
+    ASSERT_FALSE(to_line_protocol(data, db, line));
+}
+
+TEST_CASE(batched_writes)
+{
+    InfluxStandIn stand_in;
+    InfluxSink sink;
+    InfluxSink::options config;
+    config.host = "127.0.0.1";
+    config.port = stand_in.Port();
+    config.batch_points = 3;
+    config.flush_interval = 200;
+    ASSERT_TRUE(sink.Start(config));
+
+    common::senml::Pack pack;
+    for (int i = 0; i < 7; i++)
+        pack.records.push_back(number(i < 4 ? "mydb:s1:temp" : "hum", i + 0.5, 1625000000250000000ll + i));
+    sink.Process(pack);
+
+    bool arrived = stand_in.WaitFor({ { "mydb", 4 }, { CONDALF_DEFAULT_DB, 3 } });
+    sink.Stop();
+    ASSERT_TRUE(arrived);
+    ASSERT_EQUAL(stand_in.Points("mydb"), 4u);
+    ASSERT_EQUAL(stand_in.Points(CONDALF_DEFAULT_DB), 3u);
+    ASSERT_TRUE(sink.GetStatistics().find("written=7 dropped=0") == 0);
+}
+
+TEST_CASE(retry_after_server_error)
+{
+    InfluxStandIn stand_in;
+    stand_in.FailNext(503);
+
+    InfluxSink sink;
+    InfluxSink::options config;
+    config.host = "127.0.0.1";
+    config.port = stand_in.Port();
+    config.flush_interval = 50;
+    ASSERT_TRUE(sink.Start(config));
+
+    common::senml::Pack pack;
+    pack.records.push_back(number("retry", 1, 1));
+    pack.records.push_back(number("retry", 2, 2));
+    sink.Process(pack);
+
+    // The batch is kept and written again after the backoff
+    bool arrived = stand_in.WaitFor({ { CONDALF_DEFAULT_DB, 2 } });
+    sink.Stop();
+    ASSERT_TRUE(arrived);
+    ASSERT_EQUAL(stand_in.Requests(), 2u);
+    ASSERT_TRUE(stand_in.LastBody() == "retry value=1 1\nretry value=2 2\n");
+    ASSERT_TRUE(sink.GetStatistics().find("written=2 dropped=0 requests=2 failed=1") == 0);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(line_protocol);
+    TEST_CASE_RUN(batched_writes);
+    TEST_CASE_RUN(retry_after_server_error);
+TEST_MODULE_END
\ No newline at end of file
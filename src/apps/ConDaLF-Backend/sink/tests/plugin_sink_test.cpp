@@ -0,0 +1,101 @@
+/**
+ * @file plugin_sink_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the plugin sink with the example plugin
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/sink/plugin_sink.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#ifndef EXAMPLE_SINK_PATH
+#define EXAMPLE_SINK_PATH "./example_sink.so"
+#endif
+
+#define PLUGIN_TEST_OUTPUT "plugin_sink_test.csv"
+
+using namespace condalf::sink;
+
+/**
+ * @brief Decodes a SenML JSON pack
+ * 
+ * @param payload The payload, it has to outlive the pack
+ * @return common::senml::Pack The pack
+ */
+static common::senml::Pack decode(const std::vector<uint8_t>& payload)
+{
+    common::senml::Pack pack;
+    if (!common::senml::decode_json(payload.data(), payload.size(), pack) || !common::senml::normalize_times(pack, 0))
+        throw std::runtime_error(LINE_INFORMATION + std::string("\tCould not decode the pack"));
+    return pack;
+}
+
+/**
+ * @brief Reads what the example plugin wrote
+ * 
+ * @return std::string The CSV lines
+ */
+static std::string read_output()
+{
+    std::ifstream file(PLUGIN_TEST_OUTPUT);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+TEST_CASE(example_plugin_receives_batch)
+{
+    std::remove(PLUGIN_TEST_OUTPUT);
+    const char* json = R"([{"bn":"dev:","n":"temp","u":"C\u0065l","v":21.5,"t":1},{"n":"on","vb":true,"t":2},{"n":"note","vs":"x","t":3},)"
+                       R"({"n":"temp2","u":"Cel","v":-1,"t":4}])";
+    auto payload = std::make_shared<const std::vector<uint8_t>>(json, json + std::strlen(json));
+
+    PluginSink sink;
+    PluginSink::options config;
+    config.path = EXAMPLE_SINK_PATH;
+    config.argument = PLUGIN_TEST_OUTPUT;
+    ASSERT_TRUE(sink.Start(config));
+
+    // The copy keeps its own strings, the decoded pack is gone before the plugin reads the records
+    PluginSink::Job job;
+    job.payload = payload;
+    job.json = true;
+    {
+        common::senml::Pack pack = decode(*payload);
+        for (const auto& record : pack.records)
+            common::senml::append_record(record, job.pack);
+    }
+    sink.Submit(std::move(job));
+
+    // Stopping delivers the queue and flushes the plugin
+    sink.Stop();
+    std::string output = read_output();
+    std::remove(PLUGIN_TEST_OUTPUT);
+    ASSERT_TRUE(output == "dev:temp,21.5,1.000000000,Cel\n"
+                          "dev:on,1,2.000000000,\n"
+                          "dev:temp2,-1,4.000000000,Cel\n");
+    ASSERT_TRUE(sink.GetStatistics().find("processed=1 dropped=0 batches=1 failed=0") != std::string::npos);
+}
+
+TEST_CASE(missing_plugin)
+{
+    PluginSink sink;
+    PluginSink::options config;
+    config.path = "./does_not_exist.so";
+    ASSERT_FALSE(sink.Start(config));
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(example_plugin_receives_batch);
+    TEST_CASE_RUN(missing_plugin);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,137 @@
+/**
+ * @file reorder_buffer_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the reorder buffer
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/sink/reorder_buffer.hpp>
+
+#include <initializer_list>
+#include <vector>
+
+#define REORDER_TEST_SINKS 0x2          // Sinks of the resource that fed the points
+#define REORDER_TEST_OTHER_SINKS 0x4    // Sinks of another resource
+
+using namespace condalf::sink;
+
+/**
+ * @brief Creates a pack with numeric points of one series
+ * 
+ * @param name The record name
+ * @param seconds Time in seconds since the epoch per point, also the value
+ * @return common::senml::Pack The pack
+ */
+static common::senml::Pack points(std::string_view name, std::initializer_list<int64_t> seconds)
+{
+    common::senml::Pack pack;
+    for (int64_t time : seconds)
+    {
+        common::senml::Record& record = pack.records.emplace_back();
+        record.name = name;
+        record.type = common::senml::ValueType::NUMBER;
+        record.value = static_cast<double>(time);
+        record.timestamp = time * 1000000000;
+    }
+    return pack;
+}
+
+/**
+ * @brief Get the times of the records
+ * 
+ * @param pack The pack
+ * @return std::vector<int64_t> Seconds since the epoch per record
+ */
+static std::vector<int64_t> times(const common::senml::Pack& pack)
+{
+    std::vector<int64_t> seconds;
+    for (const auto& record : pack.records)
+        seconds.push_back(record.timestamp / 1000000000);
+    return seconds;
+}
+
+TEST_CASE(points_are_released_in_order)
+{
+    ReorderBuffer buffer;
+    ReorderBuffer::options config;
+    config.lateness = 5000;
+    config.max_points = 4;
+    buffer.Configure(config);
+
+    // 20 moves the watermark to 15, 8 9 10 12 are released
+    common::senml::Pack out, late;
+    buffer.Process(points("reorder:a", { 10, 8, 12, 9, 20 }), 100, REORDER_TEST_SINKS, out, late);
+    ASSERT_TRUE(times(out) == std::vector<int64_t>({ 8, 9, 10, 12 }));
+    ASSERT_TRUE(late.records.empty());
+
+    // 11 and 3 are older than 12, the full buffer forces 14 and 20 out early
+    out = common::senml::Pack();
+    buffer.Process(points("reorder:a", { 11, 14, 3, 25, 26, 27, 28, 29 }), 200, REORDER_TEST_SINKS, out, late);
+    ASSERT_TRUE(times(out) == std::vector<int64_t>({ 14, 20, 25 }));
+    ASSERT_TRUE(times(late) == std::vector<int64_t>({ 11, 3 }));
+
+    // The rest is released once the series was quiet for the lateness
+    std::vector<sink_batch> released;
+    buffer.Flush(200 + 4999999999ll, released);
+    ASSERT_TRUE(released.empty());
+    buffer.Flush(200 + 5000000000ll, released);
+    ASSERT_EQUAL(released.size(), 1u);
+    ASSERT_EQUAL(released[0].sinks, REORDER_TEST_SINKS);
+    ASSERT_TRUE(times(released[0].pack) == std::vector<int64_t>({ 26, 27, 28, 29 }));
+    ASSERT_TRUE(buffer.GetStatistics() == "series=1/10000 buffered=0 released=11 late=2 forced=2 passed=0");
+}
+
+TEST_CASE(timer_releases_go_to_the_sinks_that_fed_them)
+{
+    ReorderBuffer buffer;
+    common::senml::Pack out, late;
+    buffer.Process(points("reorder:b", { 10 }), 100, REORDER_TEST_SINKS, out, late);
+    buffer.Process(points("reorder:c", { 10 }), 100, REORDER_TEST_OTHER_SINKS, out, late);
+    buffer.Process(points("reorder:d", { 10 }), 100, REORDER_TEST_SINKS, out, late);
+    buffer.Process(points("reorder:d", { 11 }), 100, REORDER_TEST_OTHER_SINKS, out, late);
+    ASSERT_TRUE(out.records.empty());
+
+    std::vector<sink_batch> released;
+    buffer.FlushAll(released);
+    ASSERT_EQUAL(released.size(), 3u);
+    for (const auto& batch : released)
+    {
+        std::string_view name = batch.pack.records[0].name;
+        unsigned int expected = REORDER_TEST_SINKS | REORDER_TEST_OTHER_SINKS;
+        if (name == "reorder:b")
+            expected = REORDER_TEST_SINKS;
+        else if (name == "reorder:c")
+            expected = REORDER_TEST_OTHER_SINKS;
+        ASSERT_EQUAL(batch.sinks, expected);
+    }
+}
+
+TEST_CASE(passed_records_keep_their_strings)
+{
+    ReorderBuffer buffer;
+    common::senml::Pack pack;
+    common::senml::Record& record = pack.records.emplace_back();
+    record.name = pack.strings.emplace_back("reorder:e");
+    record.owned |= common::senml::Record::OWNS_NAME;
+    record.type = common::senml::ValueType::STRING;
+    record.text = "on";
+
+    common::senml::Pack out, late;
+    buffer.Process(pack, 100, REORDER_TEST_SINKS, out, late);
+    pack = common::senml::Pack();
+    ASSERT_EQUAL(out.records.size(), 1u);
+    ASSERT_TRUE(out.records[0].name == "reorder:e");
+    ASSERT_TRUE(out.records[0].text == "on");
+    ASSERT_TRUE(buffer.GetStatistics().find("passed=1") != std::string::npos);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(points_are_released_in_order);
+    TEST_CASE_RUN(timer_releases_go_to_the_sinks_that_fed_them);
+    TEST_CASE_RUN(passed_records_keep_their_strings);
+TEST_MODULE_END
\ No newline at end of file
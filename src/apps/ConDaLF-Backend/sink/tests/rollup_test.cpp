@@ -0,0 +1,136 @@
+/**
+ * @file rollup_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the rollup windows
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/sink/rollup.hpp>
+
+#define ROLLUP_TEST_SINKS 0x2       // Sinks of the resource that fed the points
+#define ROLLUP_TEST_OTHER_SINKS 0x4 // Sinks of another resource
+
+using namespace condalf::sink;
+
+/**
+ * @brief Creates a pack with one numeric point
+ * 
+ * @param name The record name
+ * @param value The value
+ * @param seconds Time in seconds since the epoch
+ * @return common::senml::Pack The pack
+ */
+static common::senml::Pack point(std::string_view name, double value, int64_t seconds)
+{
+    common::senml::Pack pack;
+    common::senml::Record& record = pack.records.emplace_back();
+    record.name = name;
+    record.unit = "Cel";
+    record.type = common::senml::ValueType::NUMBER;
+    record.value = value;
+    record.timestamp = seconds * 1000000000;
+    record.time = static_cast<double>(seconds);
+    return pack;
+}
+
+TEST_CASE(windows_are_closed_by_later_points)
+{
+    Rollup rollup;
+    Rollup::options config;
+    config.window = 10;
+    config.grace = 0;
+    rollup.Configure(config);
+
+    common::senml::Pack out;
+    rollup.Process(point("rollup:a", 1, 100), ROLLUP_TEST_SINKS, out);
+    rollup.Process(point("rollup:a", 3, 105), ROLLUP_TEST_SINKS, out);
+    ASSERT_TRUE(out.records.empty());
+
+    rollup.Process(point("rollup:a", 7, 112), ROLLUP_TEST_SINKS, out);
+    ASSERT_EQUAL(out.records.size(), 4u);
+    ASSERT_TRUE(out.records[0].name == "rollup:a_min");
+    ASSERT_TRUE(out.records[3].name == "rollup:a_count");
+    ASSERT_EQUAL(out.records[0].value, 1.0);
+    ASSERT_EQUAL(out.records[1].value, 3.0);
+    ASSERT_EQUAL(out.records[2].value, 2.0);
+    ASSERT_EQUAL(out.records[3].value, 2.0);
+    ASSERT_TRUE(out.records[2].unit == "Cel");
+    ASSERT_TRUE(out.records[3].unit.empty());
+    ASSERT_EQUAL(out.records[0].timestamp, 100ll * 1000000000);
+}
+
+TEST_CASE(forgotten_series_keep_their_watermark)
+{
+    Rollup rollup;
+    Rollup::options config;
+    config.window = 10;
+    config.grace = 0;
+    rollup.Configure(config);
+
+    common::senml::Pack out;
+    std::vector<sink_batch> closed;
+    rollup.Process(point("rollup:b", 1, 100), ROLLUP_TEST_SINKS, out);
+
+    // The window closes at 110, the idle series is forgotten two windows later
+    rollup.Flush(110, closed);
+    ASSERT_EQUAL(closed.size(), 1u);
+    ASSERT_EQUAL(closed[0].pack.records.size(), 4u);
+    rollup.Flush(130, closed);
+    ASSERT_TRUE(rollup.GetStatistics().find("series=0/") == 0);
+
+    // A late point of the written window must not open it again
+    closed.clear();
+    rollup.Process(point("rollup:b", 2, 105), ROLLUP_TEST_SINKS, out);
+    rollup.Flush(1000, closed);
+    ASSERT_TRUE(out.records.empty());
+    ASSERT_TRUE(closed.empty());
+    ASSERT_TRUE(rollup.GetStatistics().find("late=1") != std::string::npos);
+
+    // Later windows are still rolled up
+    rollup.Process(point("rollup:b", 3, 140), ROLLUP_TEST_SINKS, out);
+    rollup.Flush(1000, closed);
+    ASSERT_EQUAL(closed.size(), 1u);
+    ASSERT_EQUAL(closed[0].pack.records.size(), 4u);
+    ASSERT_EQUAL(closed[0].pack.records[0].timestamp, 140ll * 1000000000);
+}
+
+TEST_CASE(timer_windows_go_to_the_sinks_that_fed_them)
+{
+    Rollup rollup;
+    Rollup::options config;
+    config.window = 10;
+    config.grace = 0;
+    rollup.Configure(config);
+
+    common::senml::Pack out;
+    rollup.Process(point("rollup:c", 1, 100), ROLLUP_TEST_SINKS, out);
+    rollup.Process(point("rollup:d", 1, 100), ROLLUP_TEST_OTHER_SINKS, out);
+    rollup.Process(point("rollup:e", 1, 100), ROLLUP_TEST_SINKS, out);
+    rollup.Process(point("rollup:e", 2, 101), ROLLUP_TEST_OTHER_SINKS, out);
+
+    std::vector<sink_batch> closed;
+    rollup.FlushAll(closed);
+    ASSERT_EQUAL(closed.size(), 3u);
+    for (const auto& batch : closed)
+    {
+        ASSERT_EQUAL(batch.pack.records.size(), 4u);
+        std::string_view name = batch.pack.records[0].name;
+        unsigned int expected = ROLLUP_TEST_SINKS | ROLLUP_TEST_OTHER_SINKS;
+        if (name == "rollup:c_min")
+            expected = ROLLUP_TEST_SINKS;
+        else if (name == "rollup:d_min")
+            expected = ROLLUP_TEST_OTHER_SINKS;
+        ASSERT_EQUAL(batch.sinks, expected);
+    }
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(windows_are_closed_by_later_points);
+    TEST_CASE_RUN(forgotten_series_keep_their_watermark);
+    TEST_CASE_RUN(timer_windows_go_to_the_sinks_that_fed_them);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,95 @@
+/**
+ * @file series_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the series names and the series dictionary
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/sink/series.hpp>
+
+using namespace condalf::sink;
+
+TEST_CASE(names_are_split)
+{
+    series_name parts = split_series_name("site:sensor:temp");
+    ASSERT_TRUE(parts.db == "site");
+    ASSERT_TRUE(parts.sensor == "sensor");
+    ASSERT_TRUE(parts.measurement == "temp");
+
+    // Only the last three parts are used
+    parts = split_series_name("a:site:sensor:temp");
+    ASSERT_TRUE(parts.db == "site");
+
+    parts = split_series_name("sensor:temp");
+    ASSERT_TRUE(parts.db == CONDALF_DEFAULT_DB);
+    ASSERT_TRUE(parts.sensor == "sensor");
+
+    parts = split_series_name("temp");
+    ASSERT_TRUE(parts.sensor.empty());
+    ASSERT_TRUE(parts.measurement == "temp");
+}
+
+TEST_CASE(names_are_interned)
+{
+    SeriesDictionary &dictionary = SeriesDictionary::getInstance();
+    dictionary.Reset();
+    dictionary.SetLimit(16);
+
+    uint32_t temp = dictionary.Intern("site:a:temp");
+    uint32_t hum = dictionary.Intern("site:a:hum");
+    ASSERT_EQUAL(temp, 0u);
+    ASSERT_EQUAL(hum, 1u);
+    ASSERT_EQUAL(dictionary.Intern("site:a:temp"), temp);
+    ASSERT_EQUAL(dictionary.Intern("site:a:", "hum"), hum);
+    ASSERT_EQUAL(dictionary.Find("site:a:hum"), hum);
+    ASSERT_EQUAL(dictionary.Find("site:a:other"), CONDALF_SERIES_INVALID);
+    ASSERT_TRUE(dictionary.Get(temp).name == "site:a:temp");
+    ASSERT_TRUE(dictionary.Get(temp).parts.measurement == "temp");
+    ASSERT_EQUAL(dictionary.Size(), 2u);
+
+    // Records that have an id keep it, the others get theirs
+    common::senml::Pack pack;
+    pack.records.resize(2);
+    pack.records[0].name = "site:a:hum";
+    pack.records[1].name = "site:a:temp";
+    pack.records[1].series = 7;
+    dictionary.Assign(pack);
+    ASSERT_EQUAL(pack.records[0].series, hum);
+    ASSERT_EQUAL(pack.records[1].series, 7u);
+    ASSERT_EQUAL(dictionary.Of(pack.records[1]), 7u);
+}
+
+TEST_CASE(full_dictionaries_refuse_new_names)
+{
+    SeriesDictionary &dictionary = SeriesDictionary::getInstance();
+    dictionary.Reset();
+    dictionary.SetLimit(2);
+
+    ASSERT_EQUAL(dictionary.Intern("a"), 0u);
+    ASSERT_EQUAL(dictionary.Intern("b"), 1u);
+    ASSERT_EQUAL(dictionary.Intern("c"), CONDALF_SERIES_INVALID);
+    ASSERT_EQUAL(dictionary.Intern("d"), CONDALF_SERIES_INVALID);
+    ASSERT_EQUAL(dictionary.Intern("a"), 0u);
+    ASSERT_EQUAL(dictionary.Find("c"), CONDALF_SERIES_INVALID);
+    ASSERT_TRUE(dictionary.GetStatistics() == "series=2/2 refused=2");
+
+    // A reset frees the ids and hands out the old names
+    std::vector<std::string> names = dictionary.Reset();
+    ASSERT_TRUE(names == std::vector<std::string>({ "a", "b" }));
+    ASSERT_EQUAL(dictionary.Size(), 0u);
+    ASSERT_EQUAL(dictionary.Find("a"), CONDALF_SERIES_INVALID);
+    ASSERT_EQUAL(dictionary.Intern("c"), 0u);
+    ASSERT_EQUAL(dictionary.Intern("a"), 1u);
+    ASSERT_TRUE(dictionary.GetStatistics() == "series=2/2 refused=2");
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(names_are_split);
+    TEST_CASE_RUN(names_are_interned);
+    TEST_CASE_RUN(full_dictionaries_refuse_new_names);
+TEST_MODULE_END
\ No newline at end of file
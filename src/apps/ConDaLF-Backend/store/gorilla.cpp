@@ -0,0 +1,231 @@
+/**
+ * @file gorilla.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-14
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "gorilla.hpp"
+
+#include <cstring>
+
+using namespace condalf::store;
+
+/**
+ * @brief Raw bits of a double
+ */
+static uint64_t to_bits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Double of raw bits
+ */
+static double from_bits(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void GorillaChunk::write(uint64_t value, unsigned int length)
+{
+    if (length == 0)
+        return;
+    if (length < 64)
+        value &= (uint64_t(1) << length) - 1;
+
+    // Bits are filled from the most significant bit of a word on
+    std::size_t offset = bits % 64;
+    if (offset == 0)
+        words.push_back(0);
+    std::size_t space = 64 - offset;
+    if (length <= space)
+        words.back() |= value << (space - length);
+    else
+    {
+        words.back() |= value >> (length - space);
+        words.push_back(value << (64 - (length - space)));
+    }
+    bits += length;
+}
+
+GorillaChunk::GorillaChunk()
+{
+    Clear();
+}
+
+bool GorillaChunk::Append(int64_t time, double value)
+{
+    uint64_t current = to_bits(value);
+
+    // The first point is stored as it is
+    if (count == 0)
+    {
+        write(time, 64);
+        write(current, 64);
+        last_time = time;
+        last_value = current;
+        count++;
+        return true;
+    }
+    if (time < last_time)
+        return false;
+
+    // Delta of deltas in buckets of 7, 9, 12 or 64 bits
+    int64_t delta = time - last_time;
+    int64_t dod = delta - last_delta;
+    if (dod == 0)
+        write(0, 1);
+    else if (dod >= -64 && dod <= 63)
+    {
+        write(0b10, 2);
+        write(dod, 7);
+    }
+    else if (dod >= -256 && dod <= 255)
+    {
+        write(0b110, 3);
+        write(dod, 9);
+    }
+    else if (dod >= -2048 && dod <= 2047)
+    {
+        write(0b1110, 4);
+        write(dod, 12);
+    }
+    else
+    {
+        write(0b1111, 4);
+        write(dod, 64);
+    }
+
+    // XOR with the previous value, only the meaningful bits are stored
+    uint64_t xored = current ^ last_value;
+    if (xored == 0)
+        write(0, 1);
+    else
+    {
+        int leading = __builtin_clzll(xored);
+        int trailing = __builtin_ctzll(xored);
+        if (leading > 31)
+            leading = 31;
+
+        if (last_leading >= 0 && leading >= last_leading && trailing >= last_trailing)
+        {
+            // Fits into the window of the previous value
+            write(0b10, 2);
+            write(xored >> last_trailing, 64 - last_leading - last_trailing);
+        }
+        else
+        {
+            int length = 64 - leading - trailing;
+            write(0b11, 2);
+            write(leading, 5);
+            write(length - 1, 6);
+            write(xored >> trailing, length);
+            last_leading = leading;
+            last_trailing = trailing;
+        }
+    }
+
+    last_time = time;
+    last_delta = delta;
+    last_value = current;
+    count++;
+    return true;
+}
+
+void GorillaChunk::Clear()
+{
+    words.clear();
+    bits = 0;
+    count = 0;
+    last_time = 0;
+    last_delta = 0;
+    last_value = 0;
+    last_leading = -1;
+    last_trailing = 0;
+}
+
+uint64_t GorillaReader::read(unsigned int length)
+{
+    if (length == 0)
+        return 0;
+
+    std::size_t word = position / 64;
+    std::size_t offset = position % 64;
+    std::size_t space = 64 - offset;
+    uint64_t result;
+    if (length <= space)
+        result = chunk.words[word] >> (space - length);
+    else
+        result = (chunk.words[word] << (length - space)) | (chunk.words[word + 1] >> (64 - (length - space)));
+    position += length;
+    return length < 64 ? result & ((uint64_t(1) << length) - 1) : result;
+}
+
+/**
+ * @brief Sign extends the lowest length bits
+ */
+static int64_t sign_extend(uint64_t value, unsigned int length)
+{
+    uint64_t sign = uint64_t(1) << (length - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+GorillaReader::GorillaReader(const GorillaChunk &_chunk)
+    : chunk(_chunk), position(0), index(0), time(0), delta(0), value(0), leading(0), trailing(0)
+{
+}
+
+bool GorillaReader::Next(int64_t &_time, double &_value)
+{
+    if (index >= chunk.count)
+        return false;
+
+    if (index == 0)
+    {
+        time = (int64_t)read(64);
+        value = read(64);
+    }
+    else
+    {
+        // Delta of deltas
+        int64_t dod = 0;
+        if (read(1) != 0)
+        {
+            if (read(1) == 0)
+                dod = sign_extend(read(7), 7);
+            else if (read(1) == 0)
+                dod = sign_extend(read(9), 9);
+            else if (read(1) == 0)
+                dod = sign_extend(read(12), 12);
+            else
+                dod = (int64_t)read(64);
+        }
+        delta += dod;
+        time += delta;
+
+        // XOR
+        if (read(1) != 0)
+        {
+            if (read(1) != 0)
+            {
+                leading = (int)read(5);
+                trailing = 64 - leading - ((int)read(6) + 1);
+            }
+            value ^= read(64 - leading - trailing) << trailing;
+        }
+    }
+
+    index++;
+    _time = time;
+    _value = from_bits(value);
+    return true;
+}
\ No newline at end of file
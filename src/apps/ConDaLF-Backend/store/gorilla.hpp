@@ -0,0 +1,126 @@
+/**
+ * @file gorilla.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Gorilla compression of time series chunks
+ * @version 0.1
+ * @date 2021-07-14
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace condalf::store
+{
+    /**
+     * @brief Points of one series compressed like Facebook's Gorilla does.
+     * Timestamps (ms) are stored as delta of deltas, values as XOR with the previous value.
+     * Regular series with slowly changing values need about 2 bytes per point.
+     * Timestamps must not decrease.
+     */
+    class GorillaChunk
+    {
+        private:
+            std::vector<uint64_t> words;
+            std::size_t bits;               // Bits used in words
+            std::size_t count;
+            int64_t last_time;
+            int64_t last_delta;
+            uint64_t last_value;            // Bits of the double
+            int last_leading;               // Leading zeros of the last XOR window, -1 if none yet
+            int last_trailing;
+
+            /**
+             * @brief Appends the lowest length bits of value
+             * 
+             * @param value The bits
+             * @param length Number of bits (up to 64)
+             */
+            void write(uint64_t value, unsigned int length);
+
+            friend class GorillaReader;
+
+        public:
+            /**
+             * @brief Construct an empty chunk
+             */
+            GorillaChunk();
+
+            /**
+             * @brief Appends a point
+             * 
+             * @param time Time in ms, not before the last point
+             * @param value The value
+             * @return true On success
+             * @return false If time is before the last point
+             */
+            bool Append(int64_t time, double value);
+
+            /**
+             * @brief Removes all points
+             */
+            void Clear();
+
+            /**
+             * @brief Number of points
+             */
+            std::size_t Count() const { return count; }
+
+            /**
+             * @brief Time of the last point in ms
+             */
+            int64_t LastTime() const { return last_time; }
+
+            /**
+             * @brief Bytes used by the compressed points
+             */
+            std::size_t Bytes() const { return (bits + 7) / 8; }
+    };
+
+    /**
+     * @brief Decodes the points of a chunk in order. The chunk must not change while reading.
+     */
+    class GorillaReader
+    {
+        private:
+            const GorillaChunk &chunk;
+            std::size_t position;           // Next bit
+            std::size_t index;              // Next point
+            int64_t time;
+            int64_t delta;
+            uint64_t value;
+            int leading;
+            int trailing;
+
+            /**
+             * @brief Reads length bits
+             * 
+             * @param length Number of bits (up to 64)
+             * @return uint64_t The bits
+             */
+            uint64_t read(unsigned int length);
+
+        public:
+            /**
+             * @brief Construct a new GorillaReader object
+             * 
+             * @param _chunk The chunk
+             */
+            GorillaReader(const GorillaChunk &_chunk);
+
+            /**
+             * @brief Decodes the next point
+             * 
+             * @param _time Time in ms
+             * @param _value The value
+             * @return true If there was a point
+             * @return false At the end of the chunk
+             */
+            bool Next(int64_t &_time, double &_value);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,258 @@
+/**
+ * @file last_value_cache.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-22
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "last_value_cache.hpp"
+#include "query_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+using namespace condalf::store;
+
+void LastValueCache::write(slot& entry, common::senml::ValueType type, double value, int64_t timestamp)
+{
+    // Take the slot, writers of the same series are rare and short
+    uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    do
+    {
+        while (sequence & 1)
+            sequence = entry.sequence.load(std::memory_order_relaxed);
+    } while (!entry.sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto current = static_cast<common::senml::ValueType>(entry.type.load(std::memory_order_relaxed));
+    int64_t current_timestamp = entry.timestamp.load(std::memory_order_relaxed);
+    if (current != common::senml::ValueType::NONE && timestamp < current_timestamp)
+    {
+        // Nothing was written, readers may keep what they read
+        entry.sequence.store(sequence, std::memory_order_release);
+        late++;
+        return;
+    }
+
+    bool changed = current != type || entry.value.load(std::memory_order_relaxed) != value || current_timestamp != timestamp;
+    if (changed)
+    {
+        entry.type.store(static_cast<uint8_t>(type), std::memory_order_relaxed);
+        entry.value.store(value, std::memory_order_relaxed);
+        entry.timestamp.store(timestamp, std::memory_order_relaxed);
+    }
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+
+    if (!changed)
+        return;
+    if (current == common::senml::ValueType::NONE)
+        series++;
+    updates++;
+    generation.fetch_add(1, std::memory_order_release);
+}
+
+LastValueCache::LastValueCache()
+{
+    generation.store(0);
+    series.store(0);
+    updates.store(0);
+    late.store(0);
+    dropped.store(0);
+    notifications.store(0);
+}
+
+void LastValueCache::Configure(const options& _config)
+{
+    bool resize = slots == nullptr || _config.max_series != config.max_series;
+    config = _config;
+    if (config.coalesce == 0)
+        config.coalesce = 1;
+    if (!resize)
+        return;
+
+    // make_unique value-initializes the slots, every series starts without a value
+    slots = std::make_unique<slot[]>(config.max_series);
+    series.store(0);
+    generation++;
+}
+
+void LastValueCache::Update(const common::senml::Pack& pack)
+{
+    using common::senml::ValueType;
+
+    if (slots == nullptr)
+        return;
+
+    for (const auto& record : pack.records)
+    {
+        if (record.type != ValueType::NUMBER && record.type != ValueType::BOOLEAN)
+            continue;
+
+        double value = record.type == ValueType::NUMBER ? record.value : (record.boolean ? 1 : 0);
+        if (!std::isfinite(value))
+            continue;
+        if (record.series >= config.max_series)
+        {
+            dropped++;
+            continue;
+        }
+        write(slots[record.series], record.type, value, record.timestamp);
+    }
+}
+
+bool LastValueCache::Get(uint32_t id, Value& value) const
+{
+    if (slots == nullptr || id >= config.max_series)
+        return false;
+
+    const slot& entry = slots[id];
+    uint32_t before, after;
+    do
+    {
+        before = entry.sequence.load(std::memory_order_acquire);
+        value.type = static_cast<common::senml::ValueType>(entry.type.load(std::memory_order_relaxed));
+        value.value = entry.value.load(std::memory_order_relaxed);
+        value.timestamp = entry.timestamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = entry.sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return value.type != common::senml::ValueType::NONE;
+}
+
+bool LastValueCache::Render(const std::string& query, std::string& body) const
+{
+    condalf::sink::SeriesDictionary &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    std::vector<uint32_t> ids;
+    std::string prefix;
+    bool selected = false;
+
+    // Split key=value pairs
+    std::string_view rest = query;
+    while (!rest.empty())
+    {
+        std::size_t next = std::min(rest.find('&'), rest.size());
+        std::string_view pair = rest.substr(0, next);
+        rest.remove_prefix(std::min(next + 1, rest.size()));
+
+        std::size_t separator = pair.find('=');
+        std::string_view key = pair.substr(0, separator);
+        std::string value;
+        if (separator != std::string_view::npos && !decode_component(pair.substr(separator + 1), value))
+            return false;
+
+        if (key == "series")
+        {
+            uint32_t id = dictionary.Find(value);
+            if (id != CONDALF_SERIES_INVALID)
+                ids.push_back(id);
+            selected = true;
+        }
+        else if (key == "prefix")
+            prefix = value;
+        else if (!key.empty())
+            return false;
+    }
+
+    // Without series every series the dictionary knows is a candidate
+    if (!selected)
+    {
+        std::size_t known = std::min(dictionary.Size(), config.max_series);
+        for (uint32_t id = 0; id < known; id++)
+            ids.push_back(id);
+    }
+
+    body.clear();
+    body += '[';
+    bool first = true;
+    Value value;
+    for (uint32_t id : ids)
+    {
+        if (!Get(id, value))
+            continue;
+        const std::string &name = dictionary.Get(id).name;
+        if (name.compare(0, prefix.size(), prefix) != 0)
+            continue;
+
+        if (!first)
+            body += ',';
+        body += "{\"n\":";
+        append_string(body, name);
+        if (value.type == common::senml::ValueType::BOOLEAN)
+            body += value.value != 0 ? ",\"vb\":true" : ",\"vb\":false";
+        else
+        {
+            body += ",\"v\":";
+            append_float(body, value.value);
+        }
+        body += ",\"t\":";
+        append_float(body, static_cast<double>(value.timestamp / 1000000000) + static_cast<double>(value.timestamp % 1000000000) / 1e9);
+        body += '}';
+        first = false;
+    }
+    body += ']';
+    return true;
+}
+
+bool LastValueCache::TakeChanges()
+{
+    uint64_t current = generation.load(std::memory_order_acquire);
+    if (current == notified_generation)
+        return false;
+    notified_generation = current;
+    notifications++;
+    return true;
+}
+
+void LastValueCache::Rekey(const std::vector<std::string>& names)
+{
+    if (slots == nullptr)
+        return;
+
+    condalf::sink::SeriesDictionary &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    auto moved = std::make_unique<slot[]>(config.max_series);
+    std::size_t known = std::min(names.size(), config.max_series);
+    uint64_t kept = 0;
+    Value value;
+    for (uint32_t id = 0; id < known; id++)
+    {
+        if (!Get(id, value))
+            continue;
+        uint32_t moved_id = dictionary.Intern(names[id]);
+        if (moved_id >= config.max_series)
+            continue;
+
+        slot& entry = moved[moved_id];
+        entry.type.store(static_cast<uint8_t>(value.type), std::memory_order_relaxed);
+        entry.value.store(value.value, std::memory_order_relaxed);
+        entry.timestamp.store(value.timestamp, std::memory_order_relaxed);
+        kept++;
+    }
+    slots = std::move(moved);
+    series.store(kept);
+    generation++;
+}
+
+void LastValueCache::Clear()
+{
+    slots.reset();
+    series.store(0);
+    generation++;
+}
+
+std::string LastValueCache::GetStatistics() const
+{
+    std::stringstream stats;
+    stats << "series=" << series.load() << "/" << config.max_series
+          << " updates=" << updates.load()
+          << " late=" << late.load()
+          << " dropped=" << dropped.load()
+          << " notifications=" << notifications.load();
+    return stats.str();
+}
\ No newline at end of file
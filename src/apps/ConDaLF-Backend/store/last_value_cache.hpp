@@ -0,0 +1,188 @@
+/**
+ * @file last_value_cache.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Keeps the latest value of every series for observers
+ * @version 0.1
+ * @date 2021-07-22
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <common/senml/senml.hpp>
+#include <sink/series.hpp>
+
+#define CONDALF_LATEST_COALESCE 250     // ms between two notifications of the observers at least
+
+namespace condalf::store
+{
+    /**
+     * @brief Latest numeric or boolean value of every series, indexed by series id.
+     * Every slot is a sequence lock: the writer makes the sequence odd, writes and makes it even again,
+     * readers retry when the sequence changed while they read. Reading never blocks the ingest pipeline
+     * and the ingest pipeline never waits for readers.
+     * Points older than the cached one do not replace it.
+     */
+    class LastValueCache
+    {
+        public:
+            /**
+             * @brief Options of the cache
+             */
+            struct options
+            {
+                std::size_t max_series = CONDALF_SERIES_LIMIT;      // Series ids that have a slot
+                unsigned int coalesce = CONDALF_LATEST_COALESCE;    // ms
+            };
+
+            /**
+             * @brief A cached value
+             */
+            struct Value
+            {
+                common::senml::ValueType type = common::senml::ValueType::NONE;
+                double value = 0;       // 0/1 for booleans
+                int64_t timestamp = 0;  // ns since the epoch
+            };
+
+        private:
+            /**
+             * @brief The value of a series
+             */
+            struct slot
+            {
+                std::atomic_uint32_t sequence;  // Odd while the slot is written
+                std::atomic_uint8_t type;       // ValueType, NONE while the series has no value
+                std::atomic<double> value;
+                std::atomic_int64_t timestamp;
+            };
+
+            /**
+             * @brief Options of the cache
+             */
+            options config;
+
+            /**
+             * @brief One slot per series id below max_series
+             */
+            std::unique_ptr<slot[]> slots;
+
+            /**
+             * @brief Counts the changes of any value
+             */
+            std::atomic_uint64_t generation;
+
+            /**
+             * @brief Generation of the last notification, only used by the thread that notifies
+             */
+            uint64_t notified_generation = 0;
+
+            std::atomic_uint64_t series;        // Slots with a value
+            std::atomic_uint64_t updates;       // Values that changed
+            std::atomic_uint64_t late;          // Points older than the cached value
+            std::atomic_uint64_t dropped;       // Points of series without a slot
+            std::atomic_uint64_t notifications;
+
+            /**
+             * @brief Writes a value into its slot
+             * 
+             * @param entry The slot
+             * @param type Type of the record
+             * @param value The value
+             * @param timestamp Time of the record in ns
+             */
+            void write(slot& entry, common::senml::ValueType type, double value, int64_t timestamp);
+
+        public:
+            /**
+             * @brief Construct a new LastValueCache object
+             */
+            LastValueCache();
+
+            /**
+             * @brief Sets the options. The values are kept unless the number of slots changed.
+             * Must not run while records are fed.
+             * 
+             * @param _config Options of the cache
+             */
+            void Configure(const options& _config);
+
+            /**
+             * @brief Get the options
+             * 
+             * @return const options& The options
+             */
+            const options& GetOptions() const { return config; }
+
+            /**
+             * @brief Takes the numeric and boolean records of a pack
+             * 
+             * @param pack The decoded pack with series ids and times normalized by common::senml::normalize_times
+             */
+            void Update(const common::senml::Pack& pack);
+
+            /**
+             * @brief Get the value of a series
+             * 
+             * @param id Series id
+             * @param value The value
+             * @return true If the series has a value
+             * @return false Otherwise
+             */
+            bool Get(uint32_t id, Value& value) const;
+
+            /**
+             * @brief Renders the values as SenML JSON. The query string selects the series with
+             * "series=<name>" (may be repeated) or "prefix=<start of the name>", all series without one.
+             * Series without a value are left out.
+             * 
+             * @param query The query string
+             * @param body The SenML JSON pack
+             * @return true On success
+             * @return false Malformed query
+             */
+            bool Render(const std::string& query, std::string& body) const;
+
+            /**
+             * @brief Get the generation of the values, it changes whenever a value changed
+             * 
+             * @return uint64_t The generation
+             */
+            uint64_t Generation() const { return generation.load(std::memory_order_acquire); }
+
+            /**
+             * @brief Checks if a value changed since the last call. Must only be called by one thread.
+             * 
+             * @return true If the observers should be notified
+             * @return false Nothing changed
+             */
+            bool TakeChanges();
+
+            /**
+             * @brief Moves the values to the ids the dictionary hands out after SeriesDictionary::Reset.
+             * Must not run while records are fed.
+             * 
+             * @param names Names by the ids before the reset
+             */
+            void Rekey(const std::vector<std::string>& names);
+
+            /**
+             * @brief Removes all values
+             */
+            void Clear();
+
+            /**
+             * @brief Get the statistics of the cache
+             * 
+             * @return std::string Series with a value, updates, late and dropped points and notifications
+             */
+            std::string GetStatistics() const;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+/**
+ * @file query_util.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "query_util.hpp"
+
+#include <charconv>
+
+void condalf::store::append_float(std::string& out, double value)
+{
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void condalf::store::append_string(std::string& out, std::string_view value)
+{
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xf];
+            out += hex[c & 0xf];
+        }
+        else
+            out += c;
+    }
+    out += '"';
+}
+
+bool condalf::store::decode_component(std::string_view value, std::string& decoded)
+{
+    auto hex_digit = [](char c) {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    };
+
+    decoded.clear();
+    decoded.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); i++)
+    {
+        if (value[i] != '%')
+        {
+            decoded += value[i];
+            continue;
+        }
+
+        if (value.size() - i < 3)
+            return false;
+        int high = hex_digit(value[i + 1]);
+        int low = hex_digit(value[i + 2]);
+        if (high < 0 || low < 0)
+            return false;
+        decoded += static_cast<char>((high << 4) | low);
+        i += 2;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+/**
+ * @file query_util.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Query parsing and JSON rendering shared by the store endpoints
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace condalf::store
+{
+    /**
+     * @brief Appends a number in its shortest form
+     * 
+     * @param out Output
+     * @param value The number
+     */
+    void append_float(std::string& out, double value);
+
+    /**
+     * @brief Appends a JSON string
+     * 
+     * @param out Output
+     * @param value The string, quotes are added
+     */
+    void append_string(std::string& out, std::string_view value);
+
+    /**
+     * @brief Decodes %XX escapes of a query value
+     * 
+     * @param value The value
+     * @param decoded The decoded value
+     * @return true On success
+     * @return false A % is not followed by two hex digits
+     */
+    bool decode_component(std::string_view value, std::string& decoded);
+}
\ No newline at end of file
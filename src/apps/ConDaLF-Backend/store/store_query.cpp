@@ -0,0 +1,201 @@
+/**
+ * @file store_query.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-14
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "store_query.hpp"
+#include "query_util.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace condalf::store;
+
+/**
+ * @brief Parses a time or duration in seconds
+ * 
+ * @param value The value
+ * @param seconds The number
+ * @return true On success
+ * @return false Not a finite number
+ */
+static bool parse_seconds(const std::string& value, double& seconds)
+{
+    if (value.empty())
+        return false;
+
+    char* end = nullptr;
+    seconds = std::strtod(value.c_str(), &end);
+    return end == value.c_str() + value.size() && std::isfinite(seconds);
+}
+
+StoreQuery::Status StoreQuery::execute(const std::string& query, Result& result) const
+{
+    std::string series;
+    std::string agg;
+    bool has_series = false;
+    double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    double from = -static_cast<double>(store.GetOptions().retention);
+    double to = 0;
+    double step = 0;
+
+    // Split key=value pairs
+    std::size_t position = 0;
+    while (!query.empty() && position <= query.size())
+    {
+        std::size_t next = query.find('&', position);
+        if (next == std::string::npos)
+            next = query.size();
+        std::string pair = query.substr(position, next - position);
+        position = next + 1;
+
+        std::size_t separator = pair.find('=');
+        std::string key = pair.substr(0, separator);
+        std::string value;
+        if (separator != std::string::npos && !decode_component(std::string_view(pair).substr(separator + 1), value))
+            return Status::BAD_REQUEST;
+        if (key == "series")
+        {
+            series = value;
+            has_series = true;
+        }
+        else if (key == "from")
+        {
+            if (!parse_seconds(value, from))
+                return Status::BAD_REQUEST;
+        }
+        else if (key == "to")
+        {
+            if (!parse_seconds(value, to))
+                return Status::BAD_REQUEST;
+        }
+        else if (key == "step")
+        {
+            if (!parse_seconds(value, step) || step < 0)
+                return Status::BAD_REQUEST;
+        }
+        else if (key == "agg")
+            agg = value;
+    }
+
+    // Names of all series
+    std::string body;
+    if (!has_series)
+    {
+        body += '[';
+        bool first = true;
+        for (const auto& name : store.Series())
+        {
+            if (!first)
+                body += ',';
+            append_string(body, name);
+            first = false;
+        }
+        body += ']';
+        result.body = std::make_shared<const std::string>(std::move(body));
+        result.senml = false;
+        return Status::OK;
+    }
+
+    Aggregate aggregate = Aggregate::NONE;
+    if (!agg.empty() && !parse_aggregate(agg, aggregate))
+        return Status::BAD_REQUEST;
+    if (aggregate == Aggregate::NONE && step > 0)
+        return Status::BAD_REQUEST;
+
+    // Times <= 0 are relative to now
+    if (from <= 0)
+        from += now;
+    if (to <= 0)
+        to += now;
+    int64_t from_ms = std::llround(from * 1000);
+    int64_t to_ms = std::llround(to * 1000);
+
+    std::vector<Point> points;
+    bool found = aggregate == Aggregate::NONE ? store.Query(series, from_ms, to_ms, points)
+                                              : store.Query(series, from_ms, to_ms, aggregate, std::llround(step * 1000), points);
+    if (!found)
+        return Status::NOT_FOUND;
+
+    // SenML JSON, the first record carries the base name and base time
+    body += '[';
+    for (std::size_t i = 0; i < points.size(); i++)
+    {
+        if (i == 0)
+        {
+            body += "{\"bn\":";
+            append_string(body, series);
+            body += ",\"bt\":";
+            append_float(body, points[0].time / 1000.0);
+            body += ",\"v\":";
+        }
+        else
+        {
+            body += ",{\"t\":";
+            append_float(body, (points[i].time - points[0].time) / 1000.0);
+            body += ",\"v\":";
+        }
+        append_float(body, points[i].value);
+        body += '}';
+    }
+    body += ']';
+    result.body = std::make_shared<const std::string>(std::move(body));
+    result.senml = true;
+    return Status::OK;
+}
+
+StoreQuery::StoreQuery(const TimeSeriesStore& _store) : store(_store)
+{
+}
+
+StoreQuery::Status StoreQuery::Execute(const std::string& client, const std::string& query, bool fresh, Result& result)
+{
+    std::string key = client;
+    key += ' ';
+    key += query;
+    clock::time_point now = clock::now();
+
+    {
+        std::lock_guard guard(cache_mutex);
+
+        // Drop results of finished transfers
+        for (auto it = cache.begin(); it != cache.end();)
+        {
+            if (now - it->second.created > std::chrono::seconds(CONDALF_STORE_QUERY_CACHE_TIMEOUT))
+                it = cache.erase(it);
+            else
+                it++;
+        }
+
+        auto cached = cache.find(key);
+        if (!fresh && cached != cache.end())
+        {
+            result = cached->second.result;
+            return Status::OK;
+        }
+    }
+
+    // The store is queried without holding the cache
+    Status status = execute(query, result);
+    if (status != Status::OK)
+        return status;
+
+    std::lock_guard guard(cache_mutex);
+    if (cache.size() >= CONDALF_STORE_QUERY_CACHE_SIZE)
+        cache.clear();
+    cache[key] = cache_entry { result, now };
+    return Status::OK;
+}
+
+void StoreQuery::Clear()
+{
+    std::lock_guard guard(cache_mutex);
+    cache.clear();
+}
\ No newline at end of file
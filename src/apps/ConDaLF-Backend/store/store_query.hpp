@@ -0,0 +1,116 @@
+/**
+ * @file store_query.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Range and aggregate queries on the time series store
+ * @version 0.1
+ * @date 2021-07-14
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "time_series_store.hpp"
+
+#define CONDALF_STORE_QUERY_CACHE_TIMEOUT 10    // Seconds a rendered result is kept for the following blocks
+#define CONDALF_STORE_QUERY_CACHE_SIZE 256      // Rendered results kept at most
+
+namespace condalf::store
+{
+    /**
+     * @brief Answers queries of the condalf/query resource.
+     * The query string is "series=<name>&from=<s>&to=<s>&agg=<aggregate>&step=<s>". Times are seconds since the epoch,
+     * values <= 0 are relative to now. from defaults to the retention, to to now. Without series the names of
+     * all series are returned as JSON array, otherwise the points as SenML JSON with one record per point.
+     * Results are kept for a few seconds per client and query so that all blocks of a Block2 transfer
+     * come from the same result.
+     */
+    class StoreQuery
+    {
+        public:
+            using clock = std::chrono::steady_clock;
+
+            /**
+             * @brief Result of a query
+             */
+            enum class Status
+            {
+                OK,
+                BAD_REQUEST,
+                NOT_FOUND
+            };
+
+            /**
+             * @brief A rendered result
+             */
+            struct Result
+            {
+                std::shared_ptr<const std::string> body;
+                bool senml = false;     // SenML JSON, a JSON array of names otherwise
+            };
+
+        private:
+            /**
+             * @brief A cached result
+             */
+            struct cache_entry
+            {
+                Result result;
+                clock::time_point created;
+            };
+
+            /**
+             * @brief The store to query
+             */
+            const TimeSeriesStore& store;
+
+            /**
+             * @brief Protects cache
+             */
+            std::mutex cache_mutex;
+
+            /**
+             * @brief Rendered results by client + query
+             */
+            std::unordered_map<std::string, cache_entry> cache;
+
+            /**
+             * @brief Runs a query
+             * 
+             * @param query The query string
+             * @param result The rendered result
+             * @return Status OK on success
+             */
+            Status execute(const std::string& query, Result& result) const;
+
+        public:
+            /**
+             * @brief Construct a new StoreQuery object
+             * 
+             * @param _store The store to query. It has to outlive this object.
+             */
+            StoreQuery(const TimeSeriesStore& _store);
+
+            /**
+             * @brief Answers a query
+             * 
+             * @param client Identifies the client (session)
+             * @param query The query string
+             * @param fresh True for the first block of a transfer, the query is run again
+             * @param result The rendered result
+             * @return Status OK on success
+             */
+            Status Execute(const std::string& client, const std::string& query, bool fresh, Result& result);
+
+            /**
+             * @brief Drops all cached results
+             */
+            void Clear();
+    };
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+/**
+ * @file gorilla_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the Gorilla chunk encoding
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/store/gorilla.hpp>
+
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace condalf::store;
+
+/**
+ * @brief Appends points to a chunk and decodes them again
+ * 
+ * @param points The points, times must not decrease
+ * @return true All points were decoded bit for bit
+ * @return false A point differed or the count did not match
+ */
+static bool round_trip(const std::vector<std::pair<int64_t, double>>& points)
+{
+    GorillaChunk chunk;
+    for (const auto& point : points)
+    {
+        if (!chunk.Append(point.first, point.second))
+            return false;
+    }
+    if (chunk.Count() != points.size())
+        return false;
+
+    GorillaReader reader(chunk);
+    int64_t time;
+    double value;
+    for (const auto& point : points)
+    {
+        // Compare the bits, NaN and -0.0 have to survive as well
+        if (!reader.Next(time, value) || time != point.first || std::memcmp(&value, &point.second, sizeof(value)) != 0)
+            return false;
+    }
+    return !reader.Next(time, value);
+}
+
+TEST_CASE(repeated_values)
+{
+    std::vector<std::pair<int64_t, double>> points;
+    for (int64_t i = 0; i < 1000; i++)
+        points.push_back({ 1626000000000 + i * 1000, 21.5 });
+    ASSERT_TRUE(round_trip(points));
+
+    // The first point is stored as it is, the second sets the delta (12 bit bucket),
+    // all further ones need a bit for the time and one for the value
+    GorillaChunk chunk;
+    for (const auto& point : points)
+        chunk.Append(point.first, point.second);
+    ASSERT_EQUAL(chunk.Bytes(), (128u + 4 + 12 + 1 + 998 * 2 + 7) / 8);
+}
+
+TEST_CASE(large_xor_deltas)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double infinity = std::numeric_limits<double>::infinity();
+    ASSERT_TRUE(round_trip({ { 0, 1.0 }, { 1, -1.0 }, { 2, 1e308 }, { 3, -1e-308 }, { 4, 0.0 }, { 5, -0.0 },
+                             { 6, nan }, { 7, infinity }, { 8, -infinity }, { 9, 5e-324 }, { 10, 1.0 } }));
+
+    // Windows that grow and shrink
+    std::mt19937_64 random(42);
+    std::vector<std::pair<int64_t, double>> points;
+    for (int64_t i = 0; i < 2000; i++)
+    {
+        uint64_t bits = random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        points.push_back({ i, i % 3 == 0 ? value : static_cast<double>(i % 7) });
+    }
+    ASSERT_TRUE(round_trip(points));
+}
+
+TEST_CASE(negative_timestamp_deltas)
+{
+    // Deltas that shrink give negative delta of deltas in every bucket
+    ASSERT_TRUE(round_trip({ { 100000, 1 }, { 200000, 2 }, { 200010, 3 }, { 200010, 4 }, { 200100, 5 },
+                             { 200150, 6 }, { 200350, 7 }, { 200360, 8 }, { 202360, 9 }, { 202361, 10 },
+                             { 9000000000000, 11 }, { 9000000000001, 12 } }));
+
+    // Times before the epoch
+    ASSERT_TRUE(round_trip({ { -5000, 1 }, { -4000, 2 }, { -3990, 3 }, { 0, 4 } }));
+
+    // Random gaps
+    std::mt19937_64 random(7);
+    std::vector<std::pair<int64_t, double>> points;
+    int64_t time = 1626000000000;
+    for (int i = 0; i < 2000; i++)
+    {
+        time += static_cast<int64_t>(random() % (i % 2 == 0 ? 10 : 100000));
+        points.push_back({ time, i * 0.25 });
+    }
+    ASSERT_TRUE(round_trip(points));
+
+    // Going back in time is refused and leaves the chunk intact
+    GorillaChunk chunk;
+    ASSERT_TRUE(chunk.Append(1000, 1));
+    ASSERT_FALSE(chunk.Append(999, 2));
+    ASSERT_EQUAL(chunk.Count(), 1u);
+    ASSERT_EQUAL(chunk.LastTime(), 1000);
+}
+
+TEST_CASE(partial_chunks)
+{
+    // Every length ends in a different place of the last word
+    std::vector<std::pair<int64_t, double>> points;
+    for (int64_t i = 0; i < 130; i++)
+    {
+        ASSERT_TRUE(round_trip(points));
+        points.push_back({ i * 10 + (i % 4), i * 1.5 });
+    }
+
+    // A reader only sees the points that were appended before it started
+    GorillaChunk chunk;
+    chunk.Append(0, 1);
+    chunk.Append(10, 2);
+    GorillaReader reader(chunk);
+    int64_t time;
+    double value;
+    ASSERT_TRUE(reader.Next(time, value));
+    ASSERT_TRUE(reader.Next(time, value));
+    ASSERT_EQUAL(time, 10);
+    ASSERT_EQUAL(value, 2.0);
+    ASSERT_FALSE(reader.Next(time, value));
+
+    // A cleared chunk starts over
+    chunk.Clear();
+    ASSERT_EQUAL(chunk.Count(), 0u);
+    ASSERT_EQUAL(chunk.Bytes(), 0u);
+    GorillaReader empty(chunk);
+    ASSERT_FALSE(empty.Next(time, value));
+    ASSERT_TRUE(chunk.Append(-1, 3));
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(repeated_values);
+    TEST_CASE_RUN(large_xor_deltas);
+    TEST_CASE_RUN(negative_timestamp_deltas);
+    TEST_CASE_RUN(partial_chunks);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,191 @@
+/**
+ * @file last_value_cache_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the last value cache
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/store/last_value_cache.hpp>
+
+#include <atomic>
+#include <thread>
+
+#define LAST_VALUE_CACHE_TEST_UPDATES 100000
+
+using namespace condalf::store;
+
+/**
+ * @brief Creates a pack with the numeric series a:x, a:y and b:z and assigns their ids
+ * 
+ * @return common::senml::Pack The pack
+ */
+static common::senml::Pack series()
+{
+    common::senml::Pack pack;
+    for (const char *name : { "a:x", "a:y", "b:z" })
+    {
+        common::senml::Record& record = pack.records.emplace_back();
+        record.name = name;
+        record.type = common::senml::ValueType::NUMBER;
+    }
+    condalf::sink::SeriesDictionary::getInstance().Assign(pack);
+    return pack;
+}
+
+/**
+ * @brief Configures a cache with room for a few series
+ * 
+ * @param cache The cache
+ */
+static void configure(LastValueCache& cache)
+{
+    LastValueCache::options config;
+    config.max_series = 16;
+    cache.Configure(config);
+}
+
+/**
+ * @brief Sets every record of the pack to the value with a timestamp derived from it
+ * 
+ * @param pack The pack
+ * @param value The value
+ */
+static void set(common::senml::Pack& pack, int64_t value)
+{
+    for (common::senml::Record& record : pack.records)
+    {
+        record.value = static_cast<double>(value);
+        record.timestamp = value * 1000000000 + value;
+    }
+}
+
+TEST_CASE(readers_never_see_torn_values)
+{
+    LastValueCache cache;
+    configure(cache);
+    common::senml::Pack pack = series();
+    uint32_t id = pack.records[0].series;
+
+    std::atomic_bool stop(false);
+    std::thread writer([&] {
+        for (int64_t i = 1; i <= LAST_VALUE_CACHE_TEST_UPDATES; i++)
+        {
+            set(pack, i);
+            cache.Update(pack);
+        }
+        stop.store(true);
+    });
+
+    uint64_t reads = 0, torn = 0;
+    LastValueCache::Value value;
+    while (!stop.load())
+    {
+        if (!cache.Get(id, value))
+            continue;
+        reads++;
+        int64_t written = static_cast<int64_t>(value.value);
+        if (value.timestamp != written * 1000000000 + written)
+            torn++;
+    }
+    writer.join();
+
+    ASSERT_EQUAL(torn, 0);
+    ASSERT_TRUE(cache.Get(id, value));
+    ASSERT_EQUAL(value.value, LAST_VALUE_CACHE_TEST_UPDATES);
+    std::cout << reads << " consistent reads during " << LAST_VALUE_CACHE_TEST_UPDATES << " updates" << std::endl;
+}
+
+TEST_CASE(older_points_do_not_replace_newer_ones)
+{
+    LastValueCache cache;
+    configure(cache);
+    common::senml::Pack pack = series();
+    set(pack, 10);
+    cache.Update(pack);
+
+    pack.records[1].value = -1;
+    pack.records[1].timestamp = 5;
+    cache.Update(pack);
+
+    LastValueCache::Value value;
+    ASSERT_TRUE(cache.Get(pack.records[1].series, value));
+    ASSERT_EQUAL(value.value, 10);
+    ASSERT_TRUE(cache.GetStatistics().find("late=1") != std::string::npos);
+}
+
+TEST_CASE(queries_select_series)
+{
+    LastValueCache cache;
+    configure(cache);
+    common::senml::Pack pack = series();
+    set(pack, 7);
+    cache.Update(pack);
+
+    std::string body;
+    ASSERT_TRUE(cache.Render("prefix=a:", body));
+    ASSERT_TRUE(body == "[{\"n\":\"a:x\",\"v\":7,\"t\":7.000000007},{\"n\":\"a:y\",\"v\":7,\"t\":7.000000007}]");
+    ASSERT_TRUE(cache.Render("series=b%3Az", body));
+    ASSERT_TRUE(body == "[{\"n\":\"b:z\",\"v\":7,\"t\":7.000000007}]");
+    ASSERT_FALSE(cache.Render("foo=1", body));
+
+    // Broken escapes are rejected like by the store query
+    ASSERT_FALSE(cache.Render("series=b%3", body));
+    ASSERT_FALSE(cache.Render("series=b%zz", body));
+}
+
+TEST_CASE(changes_are_taken_once)
+{
+    LastValueCache cache;
+    configure(cache);
+    common::senml::Pack pack = series();
+    cache.TakeChanges();    // Configure cleared the cache
+    ASSERT_FALSE(cache.TakeChanges());
+
+    set(pack, 1);
+    cache.Update(pack);
+    ASSERT_TRUE(cache.TakeChanges());
+    ASSERT_FALSE(cache.TakeChanges());
+
+    set(pack, 2);
+    cache.Update(pack);
+    cache.Update(pack);
+    ASSERT_TRUE(cache.TakeChanges());
+    ASSERT_FALSE(cache.TakeChanges());
+}
+
+TEST_CASE(values_move_to_new_ids)
+{
+    LastValueCache cache;
+    configure(cache);
+    common::senml::Pack pack = series();
+    set(pack, 5);
+    cache.Update(pack);
+
+    // Another series takes id 0 after the reset
+    condalf::sink::SeriesDictionary &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    std::vector<std::string> names = dictionary.Reset();
+    ASSERT_EQUAL(dictionary.Intern("c:first"), 0u);
+    cache.Rekey(names);
+
+    LastValueCache::Value value;
+    ASSERT_FALSE(cache.Get(0, value));
+    ASSERT_TRUE(cache.Get(dictionary.Find("b:z"), value));
+    ASSERT_EQUAL(value.value, 5.0);
+    std::string body;
+    ASSERT_TRUE(cache.Render("", body));
+    ASSERT_TRUE(body == "[{\"n\":\"a:x\",\"v\":5,\"t\":5.000000005},{\"n\":\"a:y\",\"v\":5,\"t\":5.000000005},{\"n\":\"b:z\",\"v\":5,\"t\":5.000000005}]");
+    ASSERT_TRUE(cache.GetStatistics().find("series=3/16 ") == 0);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(readers_never_see_torn_values);
+    TEST_CASE_RUN(older_points_do_not_replace_newer_ones);
+    TEST_CASE_RUN(queries_select_series);
+    TEST_CASE_RUN(changes_are_taken_once);
+    TEST_CASE_RUN(values_move_to_new_ids);
+TEST_MODULE_END
\ No newline at end of file
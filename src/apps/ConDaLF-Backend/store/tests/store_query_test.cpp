@@ -0,0 +1,144 @@
+/**
+ * @file store_query_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the query resource of the store
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/store/store_query.hpp>
+
+using namespace condalf::store;
+
+/**
+ * @brief Creates a store with the series a:x at 1000, 1001, ... 1019 seconds with the values 0 to 19 and b:y at 1000
+ * 
+ * @param store The store
+ */
+static void fill(TimeSeriesStore& store)
+{
+    common::senml::Pack pack;
+    for (int second = 0; second < 20; second++)
+    {
+        common::senml::Record& record = pack.records.emplace_back();
+        record.name = "a:x";
+        record.type = common::senml::ValueType::NUMBER;
+        record.value = second;
+        record.timestamp = (1000 + second) * 1000000000ll;
+    }
+    common::senml::Record& record = pack.records.emplace_back();
+    record.name = "b:y";
+    record.type = common::senml::ValueType::BOOLEAN;
+    record.boolean = true;
+    record.timestamp = 1000 * 1000000000ll;
+    store.Insert(pack);
+}
+
+/**
+ * @brief Runs a fresh query
+ * 
+ * @param query The query
+ * @param query_string The query string
+ * @param body The rendered body
+ * @return StoreQuery::Status The status
+ */
+static StoreQuery::Status run(StoreQuery& query, const std::string& query_string, std::string& body)
+{
+    StoreQuery::Result result;
+    StoreQuery::Status status = query.Execute("client", query_string, true, result);
+    body = status == StoreQuery::Status::OK ? *result.body : "";
+    return status;
+}
+
+TEST_CASE(ranges)
+{
+    TimeSeriesStore store;
+    fill(store);
+    StoreQuery query(store);
+
+    std::string body;
+    ASSERT_TRUE(run(query, "", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body == "[\"a:x\",\"b:y\"]");
+
+    ASSERT_TRUE(run(query, "series=a%3Ax&from=1017&to=1019", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body == "[{\"bn\":\"a:x\",\"bt\":1017,\"v\":17},{\"t\":1,\"v\":18},{\"t\":2,\"v\":19}]");
+
+    // Booleans are stored as 0 and 1, a range without points is an empty pack
+    ASSERT_TRUE(run(query, "series=b:y&from=1000&to=1000.5", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body == "[{\"bn\":\"b:y\",\"bt\":1000,\"v\":1}]");
+    ASSERT_TRUE(run(query, "series=b:y&from=1001&to=1002", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body == "[]");
+
+    // Unknown keys are ignored, unknown series are not found
+    ASSERT_TRUE(run(query, "series=a:x&from=1019&to=1019&foo=bar", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(run(query, "series=a:z", body) == StoreQuery::Status::NOT_FOUND);
+}
+
+TEST_CASE(aggregates)
+{
+    TimeSeriesStore store;
+    fill(store);
+    StoreQuery query(store);
+
+    std::string body;
+    ASSERT_TRUE(run(query, "series=a:x&from=1000&to=1019&agg=mean&step=10", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body == "[{\"bn\":\"a:x\",\"bt\":1000,\"v\":4.5},{\"t\":10,\"v\":14.5}]");
+
+    ASSERT_TRUE(run(query, "series=a:x&from=1000&to=1019&agg=sum", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body == "[{\"bn\":\"a:x\",\"bt\":1000,\"v\":190}]");
+
+    ASSERT_TRUE(run(query, "series=a:x&from=1000&to=1019&agg=last&step=0.5", body) == StoreQuery::Status::OK);
+    ASSERT_TRUE(body.find("{\"t\":19,\"v\":19}") != std::string::npos);
+}
+
+TEST_CASE(malformed_queries)
+{
+    TimeSeriesStore store;
+    fill(store);
+    StoreQuery query(store);
+
+    std::string body;
+    for (const char* malformed : { "series=a:x&from=abc", "series=a:x&from=", "series=a:x&to=1e999", "series=a:x&to=12x",
+                                   "series=a:x&agg=mean&step=-1", "series=a:x&agg=median", "series=a:x&step=10",
+                                   "series=a:x&from", "series=a%3", "series=a%3Gx" })
+    {
+        ASSERT_TRUE(run(query, malformed, body) == StoreQuery::Status::BAD_REQUEST);
+    }
+}
+
+TEST_CASE(blocks_come_from_one_result)
+{
+    TimeSeriesStore store;
+    fill(store);
+    StoreQuery query(store);
+
+    StoreQuery::Result first;
+    ASSERT_TRUE(query.Execute("client", "", true, first) == StoreQuery::Status::OK);
+
+    common::senml::Pack pack;
+    common::senml::Record& record = pack.records.emplace_back();
+    record.name = "c:z";
+    record.type = common::senml::ValueType::NUMBER;
+    record.timestamp = 1000 * 1000000000ll;
+    store.Insert(pack);
+
+    // Following blocks get the cached result, a new transfer and other clients run the query again
+    StoreQuery::Result result;
+    ASSERT_TRUE(query.Execute("client", "", false, result) == StoreQuery::Status::OK);
+    ASSERT_TRUE(result.body == first.body);
+    ASSERT_TRUE(query.Execute("other", "", false, result) == StoreQuery::Status::OK);
+    ASSERT_TRUE(*result.body == "[\"a:x\",\"b:y\",\"c:z\"]");
+    ASSERT_TRUE(query.Execute("client", "", true, result) == StoreQuery::Status::OK);
+    ASSERT_TRUE(*result.body == "[\"a:x\",\"b:y\",\"c:z\"]");
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(ranges);
+    TEST_CASE_RUN(aggregates);
+    TEST_CASE_RUN(malformed_queries);
+    TEST_CASE_RUN(blocks_come_from_one_result);
+TEST_MODULE_END
\ No newline at end of file
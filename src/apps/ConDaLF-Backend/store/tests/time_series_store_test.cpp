@@ -0,0 +1,196 @@
+/**
+ * @file time_series_store_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the in-memory time series store
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <apps/ConDaLF-Backend/store/time_series_store.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace condalf::store;
+
+/**
+ * @brief Creates a pack with one numeric record
+ * 
+ * @param name The record name
+ * @param seconds Time in seconds since the epoch
+ * @param value The value
+ * @return common::senml::Pack The pack
+ */
+static common::senml::Pack point(const char* name, double seconds, double value)
+{
+    common::senml::Pack pack;
+    common::senml::Record& record = pack.records.emplace_back();
+    record.name = name;
+    record.type = common::senml::ValueType::NUMBER;
+    record.value = value;
+    record.timestamp = std::llround(seconds * 1e9);
+    return pack;
+}
+
+/**
+ * @brief Configures a store with short chunks
+ * 
+ * @param store The store
+ * @param retention Seconds of data kept
+ * @param max_series Series kept at most
+ */
+static void configure(TimeSeriesStore& store, unsigned int retention, std::size_t max_series)
+{
+    TimeSeriesStore::options config;
+    config.retention = retention;
+    config.chunk = 10;
+    config.max_series = max_series;
+    store.Configure(config);
+}
+
+/**
+ * @brief Get the times of all points of a series in seconds
+ * 
+ * @param store The store
+ * @param name The series
+ * @return std::vector<int64_t> The times, empty for an unknown series
+ */
+static std::vector<int64_t> times(const TimeSeriesStore& store, const std::string& name)
+{
+    std::vector<Point> points;
+    store.Query(name, 0, INT64_MAX, points);
+    std::vector<int64_t> seconds;
+    for (const auto& current : points)
+        seconds.push_back(current.time / 1000);
+    return seconds;
+}
+
+TEST_CASE(points_are_kept_for_the_retention)
+{
+    // 30 seconds in chunks of 10 seconds -> a ring of 4 chunks
+    TimeSeriesStore store;
+    configure(store, 30, 16);
+    for (int second = 0; second < 50; second += 5)
+        store.Insert(point("a:x", 1000 + second, second));
+
+    // The chunks of 1000 and 1010 were reused by 1040
+    ASSERT_TRUE(times(store, "a:x") == std::vector<int64_t>({ 1010, 1015, 1020, 1025, 1030, 1035, 1040, 1045 }));
+
+    // A gap longer than the ring frees every chunk before it
+    store.Insert(point("a:x", 1200, 1));
+    ASSERT_TRUE(times(store, "a:x") == std::vector<int64_t>({ 1200 }));
+    ASSERT_TRUE(store.GetStatistics().find("points=1 ") != std::string::npos);
+}
+
+TEST_CASE(out_of_order_points_are_dropped)
+{
+    TimeSeriesStore store;
+    configure(store, 30, 16);
+    store.Insert(point("a:x", 1000, 1));
+    store.Insert(point("a:x", 1005, 2));
+    store.Insert(point("a:x", 1004, 3));    // Before the last point
+    store.Insert(point("a:x", 990, 4));     // Before the newest chunk
+    store.Insert(point("a:x", 1005, 5));    // Same time is kept
+    store.Insert(point("a:x", 1010, std::numeric_limits<double>::quiet_NaN()));
+    store.Insert(point("a:x", -1, 6));
+
+    ASSERT_TRUE(times(store, "a:x") == std::vector<int64_t>({ 1000, 1005, 1005 }));
+    ASSERT_TRUE(store.GetStatistics().find("inserted=3 dropped=4") != std::string::npos);
+}
+
+TEST_CASE(series_beyond_the_limit_are_dropped)
+{
+    TimeSeriesStore store;
+    configure(store, 30, 2);
+    store.Insert(point("b:x", 1000, 1));
+    store.Insert(point("b:y", 1000, 2));
+    store.Insert(point("b:z", 1000, 3));
+    store.Insert(point("b:x", 1001, 4));
+
+    ASSERT_TRUE(store.Series() == std::vector<std::string>({ "b:x", "b:y" }));
+    ASSERT_TRUE(times(store, "b:z").empty());
+    std::vector<Point> points;
+    ASSERT_FALSE(store.Query("b:z", 0, INT64_MAX, points));
+    ASSERT_TRUE(store.GetStatistics().find("series=2/2 ") == 0);
+    ASSERT_TRUE(store.GetStatistics().find("dropped=1") != std::string::npos);
+
+    // Clear makes room again, reconfiguring with the same options keeps the points
+    configure(store, 30, 2);
+    ASSERT_EQUAL(times(store, "b:x").size(), 2u);
+    store.Clear();
+    store.Insert(point("b:z", 1000, 3));
+    ASSERT_TRUE(store.Series() == std::vector<std::string>({ "b:z" }));
+
+    // Other options drop everything
+    configure(store, 60, 2);
+    ASSERT_TRUE(store.Series().empty());
+}
+
+TEST_CASE(aggregates)
+{
+    TimeSeriesStore store;
+    configure(store, 600, 16);
+    for (int second = 0; second < 30; second++)
+        store.Insert(point("c:x", 1000 + second, second));
+
+    std::vector<Point> points;
+    ASSERT_TRUE(store.Query("c:x", 1000000, 1029000, Aggregate::MEAN, 10000, points));
+    ASSERT_EQUAL(points.size(), 3u);
+    ASSERT_EQUAL(points[0].time, 1000000);
+    ASSERT_EQUAL(points[0].value, 4.5);
+    ASSERT_EQUAL(points[2].time, 1020000);
+    ASSERT_EQUAL(points[2].value, 24.5);
+
+    // Step 0 aggregates the whole range
+    points.clear();
+    ASSERT_TRUE(store.Query("c:x", 1005000, 1014000, Aggregate::COUNT, 0, points));
+    ASSERT_EQUAL(points.size(), 1u);
+    ASSERT_EQUAL(points[0].value, 10.0);
+
+    points.clear();
+    ASSERT_TRUE(store.Query("c:x", 1005000, 1014000, Aggregate::MAX, 0, points));
+    ASSERT_EQUAL(points[0].value, 14.0);
+
+    // Windows without points are left out
+    points.clear();
+    ASSERT_TRUE(store.Query("c:x", 990000, 1009000, Aggregate::FIRST, 5000, points));
+    ASSERT_EQUAL(points.size(), 2u);
+    ASSERT_EQUAL(points[0].time, 1000000);
+    ASSERT_EQUAL(points[0].value, 0.0);
+}
+
+TEST_CASE(series_move_to_new_ids)
+{
+    TimeSeriesStore store;
+    configure(store, 60, 16);
+    double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    store.Insert(point("d:old", 1000, 1));
+    store.Insert(point("d:recent", now - 10, 2));
+
+    // The ids are handed out again after a reset, series without points in the retention are gone
+    condalf::sink::SeriesDictionary &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    std::vector<std::string> names = dictionary.Reset();
+    dictionary.Intern("d:first");
+    store.Rekey(names);
+    ASSERT_TRUE(store.Series() == std::vector<std::string>({ "d:recent" }));
+    ASSERT_NOT_EQUAL(dictionary.Find("d:recent"), 0u);
+    ASSERT_EQUAL(dictionary.Find("d:old"), CONDALF_SERIES_INVALID);
+
+    std::vector<Point> points;
+    ASSERT_TRUE(store.Query("d:recent", 0, INT64_MAX, points));
+    ASSERT_EQUAL(points.size(), 1u);
+    ASSERT_EQUAL(points[0].value, 2.0);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(points_are_kept_for_the_retention);
+    TEST_CASE_RUN(out_of_order_points_are_dropped);
+    TEST_CASE_RUN(series_beyond_the_limit_are_dropped);
+    TEST_CASE_RUN(aggregates);
+    TEST_CASE_RUN(series_move_to_new_ids);
+TEST_MODULE_END
\ No newline at end of file
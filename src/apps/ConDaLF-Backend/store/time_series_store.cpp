@@ -0,0 +1,325 @@
+/**
+ * @file time_series_store.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2021-07-14
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "time_series_store.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+using namespace condalf::store;
+
+bool TimeSeriesStore::append(series& target, int64_t time, double value)
+{
+    int64_t slots = static_cast<int64_t>(target.ring.size());
+    int64_t index = time / chunk_ms;
+
+    if (target.last_index >= 0)
+    {
+        // Points have to be in time order
+        slot& newest = target.ring[target.last_index % slots];
+        if (index < target.last_index || time < newest.points.LastTime())
+            return false;
+    }
+
+    // A new chunk replaces the oldest one of the ring. Chunks that fell out of the ring over a gap are freed.
+    slot& current = target.ring[index % slots];
+    if (current.index != index)
+    {
+        if (index > target.last_index + 1)
+        {
+            for (auto& stale : target.ring)
+            {
+                if (stale.index >= 0 && stale.index <= index - slots)
+                {
+                    stale.points.Clear();
+                    stale.index = -1;
+                }
+            }
+        }
+        current.points.Clear();
+        current.index = index;
+    }
+    target.last_index = index;
+    return current.points.Append(time, value);
+}
+
+template <typename F>
+void TimeSeriesStore::scan(const series& target, int64_t from, int64_t to, F visit) const
+{
+    if (target.last_index < 0 || from > to)
+        return;
+
+    int64_t slots = static_cast<int64_t>(target.ring.size());
+    int64_t first = std::max(std::max<int64_t>(from, 0) / chunk_ms, target.last_index - slots + 1);
+    int64_t last = std::min(std::max<int64_t>(to, 0) / chunk_ms, target.last_index);
+    for (int64_t index = first; index <= last; index++)
+    {
+        const slot& current = target.ring[index % slots];
+        if (current.index != index)
+            continue;
+
+        GorillaReader reader(current.points);
+        int64_t time;
+        double value;
+        while (reader.Next(time, value))
+        {
+            if (time > to)
+                break;
+            if (time >= from)
+                visit(time, value);
+        }
+    }
+}
+
+TimeSeriesStore::TimeSeriesStore() : chunk_ms(static_cast<int64_t>(CONDALF_STORE_CHUNK) * 1000)
+{
+    inserted.store(0);
+    dropped.store(0);
+}
+
+void TimeSeriesStore::Configure(const options& _config)
+{
+    options normalized = _config;
+    if (normalized.chunk == 0)
+        normalized.chunk = 1;
+    if (normalized.retention < normalized.chunk)
+        normalized.retention = normalized.chunk;
+
+    std::lock_guard guard(store_mutex);
+    if (normalized == config)
+        return;
+
+    config = normalized;
+    chunk_ms = static_cast<int64_t>(config.chunk) * 1000;
+    series_map.clear();
+}
+
+void TimeSeriesStore::Insert(const common::senml::Pack& pack)
+{
+    using common::senml::ValueType;
+
+    condalf::sink::SeriesDictionary &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    std::lock_guard guard(store_mutex);
+    std::size_t slots = (config.retention + config.chunk - 1) / config.chunk + 1;
+    for (const auto& record : pack.records)
+    {
+        if (record.type != ValueType::NUMBER && record.type != ValueType::BOOLEAN)
+            continue;
+
+        double value = record.type == ValueType::NUMBER ? record.value : (record.boolean ? 1 : 0);
+        if (!std::isfinite(value) || record.timestamp < 0)
+        {
+            dropped++;
+            continue;
+        }
+
+        // Find the series or create it while there is room
+        uint32_t id = dictionary.Of(record);
+        auto it = series_map.find(id);
+        if (it == series_map.end())
+        {
+            if (id == CONDALF_SERIES_INVALID || series_map.size() >= config.max_series)
+            {
+                dropped++;
+                continue;
+            }
+            auto created = std::make_unique<series>();
+            created->ring.resize(slots);
+            it = series_map.emplace(id, std::move(created)).first;
+        }
+
+        if (append(*it->second, record.timestamp / 1000000, value))
+            inserted++;
+        else
+            dropped++;
+    }
+}
+
+bool TimeSeriesStore::Query(const std::string& name, int64_t from, int64_t to, std::vector<Point>& points) const
+{
+    uint32_t id = condalf::sink::SeriesDictionary::getInstance().Find(name);
+    std::lock_guard guard(store_mutex);
+    auto it = series_map.find(id);
+    if (it == series_map.end())
+        return false;
+
+    scan(*it->second, from, to, [&points](int64_t time, double value) {
+        points.push_back({ time, value });
+    });
+    return true;
+}
+
+bool TimeSeriesStore::Query(const std::string& name, int64_t from, int64_t to, Aggregate aggregate, int64_t step, std::vector<Point>& points) const
+{
+    uint32_t id = condalf::sink::SeriesDictionary::getInstance().Find(name);
+    std::lock_guard guard(store_mutex);
+    auto it = series_map.find(id);
+    if (it == series_map.end())
+        return false;
+
+    // Accumulator of the current window
+    int64_t window = -1;
+    double min = 0, max = 0, sum = 0, first = 0, last = 0;
+    uint64_t count = 0;
+    auto emit = [&]() {
+        if (count == 0)
+            return;
+
+        Point point;
+        point.time = step > 0 ? from + window * step : from;
+        switch (aggregate)
+        {
+            case Aggregate::MIN: point.value = min; break;
+            case Aggregate::MAX: point.value = max; break;
+            case Aggregate::MEAN: point.value = sum / count; break;
+            case Aggregate::SUM: point.value = sum; break;
+            case Aggregate::COUNT: point.value = static_cast<double>(count); break;
+            case Aggregate::FIRST: point.value = first; break;
+            default: point.value = last; break;
+        }
+        points.push_back(point);
+        count = 0;
+    };
+
+    scan(*it->second, from, to, [&](int64_t time, double value) {
+        int64_t current = step > 0 ? (time - from) / step : 0;
+        if (current != window)
+        {
+            emit();
+            window = current;
+        }
+
+        if (count == 0)
+        {
+            min = max = sum = first = value;
+        }
+        else
+        {
+            min = std::min(min, value);
+            max = std::max(max, value);
+            sum += value;
+        }
+        last = value;
+        count++;
+    });
+    emit();
+    return true;
+}
+
+std::vector<std::string> TimeSeriesStore::Series() const
+{
+    std::vector<std::string> names;
+    {
+        std::lock_guard guard(store_mutex);
+        names.reserve(series_map.size());
+        for (const auto& entry : series_map)
+            names.push_back(condalf::sink::SeriesDictionary::getInstance().Get(entry.first).name);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void TimeSeriesStore::Rekey(const std::vector<std::string>& names)
+{
+    condalf::sink::SeriesDictionary &dictionary = condalf::sink::SeriesDictionary::getInstance();
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t oldest = now - static_cast<int64_t>(config.retention) * 1000;
+
+    std::lock_guard guard(store_mutex);
+    std::unordered_map<uint32_t, std::unique_ptr<series>> moved;
+    for (auto& entry : series_map)
+    {
+        const series& target = *entry.second;
+        if (target.last_index < 0 || entry.first >= names.size())
+            continue;
+        const slot& newest = target.ring[target.last_index % static_cast<int64_t>(target.ring.size())];
+        if (newest.points.LastTime() < oldest)
+            continue;
+
+        uint32_t id = dictionary.Intern(names[entry.first]);
+        if (id != CONDALF_SERIES_INVALID)
+            moved.emplace(id, std::move(entry.second));
+    }
+    series_map = std::move(moved);
+}
+
+void TimeSeriesStore::Clear()
+{
+    std::lock_guard guard(store_mutex);
+    series_map.clear();
+}
+
+std::string TimeSeriesStore::GetStatistics() const
+{
+    std::size_t count = 0, points = 0, bytes = 0;
+    {
+        std::lock_guard guard(store_mutex);
+        count = series_map.size();
+        for (const auto& entry : series_map)
+        {
+            for (const auto& current : entry.second->ring)
+            {
+                if (current.index < 0)
+                    continue;
+                points += current.points.Count();
+                bytes += current.points.Bytes();
+            }
+        }
+    }
+
+    std::stringstream stats;
+    stats << "series=" << count << "/" << config.max_series
+          << " points=" << points
+          << " bytes=" << bytes
+          << " inserted=" << inserted.load()
+          << " dropped=" << dropped.load();
+    return stats.str();
+}
+
+bool condalf::store::parse_aggregate(const std::string& name, Aggregate& aggregate)
+{
+    static const std::pair<const char*, Aggregate> names[] = {
+        { "min", Aggregate::MIN },
+        { "max", Aggregate::MAX },
+        { "mean", Aggregate::MEAN },
+        { "sum", Aggregate::SUM },
+        { "count", Aggregate::COUNT },
+        { "first", Aggregate::FIRST },
+        { "last", Aggregate::LAST }
+    };
+
+    for (const auto& entry : names)
+    {
+        if (name == entry.first)
+        {
+            aggregate = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* condalf::store::aggregate_name(Aggregate aggregate)
+{
+    switch (aggregate)
+    {
+        case Aggregate::MIN: return "min";
+        case Aggregate::MAX: return "max";
+        case Aggregate::MEAN: return "mean";
+        case Aggregate::SUM: return "sum";
+        case Aggregate::COUNT: return "count";
+        case Aggregate::FIRST: return "first";
+        case Aggregate::LAST: return "last";
+        default: return "";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+/**
+ * @file time_series_store.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Keeps recent numeric records in memory
+ * @version 0.1
+ * @date 2021-07-14
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <common/senml/senml.hpp>
+#include <sink/series.hpp>
+#include "gorilla.hpp"
+
+#define CONDALF_STORE_RETENTION 21600   // Seconds of data kept per series
+#define CONDALF_STORE_CHUNK 600         // Seconds covered by one compressed chunk
+#define CONDALF_STORE_MAX_SERIES 10000  // Series kept at most, records of further series are dropped
+
+namespace condalf::store
+{
+    /**
+     * @brief Aggregates of a query
+     */
+    enum class Aggregate
+    {
+        NONE,
+        MIN,
+        MAX,
+        MEAN,
+        SUM,
+        COUNT,
+        FIRST,
+        LAST
+    };
+
+    /**
+     * @brief A point of a series
+     */
+    struct Point
+    {
+        int64_t time;   // ms since the epoch
+        double value;
+    };
+
+    /**
+     * @brief In-memory store of the numeric and boolean records of the last retention seconds.
+     * Every series (record name) has a fixed ring of chunks, one per chunk seconds. A chunk holds its points
+     * Gorilla compressed. When a point starts a new chunk the oldest one in the ring is reused,
+     * so the memory of a series is bounded by its rate and the retention.
+     * Points have to arrive in time order per series, points older than the last one are dropped.
+     */
+    class TimeSeriesStore
+    {
+        public:
+            /**
+             * @brief Options of the store
+             */
+            struct options
+            {
+                unsigned int retention = CONDALF_STORE_RETENTION;   // Seconds
+                unsigned int chunk = CONDALF_STORE_CHUNK;           // Seconds
+                std::size_t max_series = CONDALF_STORE_MAX_SERIES;
+
+                bool operator==(const options& other) const
+                {
+                    return retention == other.retention && chunk == other.chunk && max_series == other.max_series;
+                }
+            };
+
+        private:
+            /**
+             * @brief A chunk of the ring
+             */
+            struct slot
+            {
+                int64_t index = -1;     // Chunk number (time / chunk length), -1 if unused
+                GorillaChunk points;
+            };
+
+            /**
+             * @brief The ring of a series
+             */
+            struct series
+            {
+                std::vector<slot> ring;
+                int64_t last_index = -1;    // Newest chunk number
+            };
+
+            /**
+             * @brief Options of the store
+             */
+            options config;
+
+            /**
+             * @brief Length of a chunk in ms
+             */
+            int64_t chunk_ms;
+
+            /**
+             * @brief Protects series_map
+             */
+            mutable std::mutex store_mutex;
+
+            /**
+             * @brief Series by series id
+             */
+            std::unordered_map<uint32_t, std::unique_ptr<series>> series_map;
+
+            std::atomic_uint64_t inserted;
+            std::atomic_uint64_t dropped;       // Out of order, too old or too many series
+
+            /**
+             * @brief Appends a point to a series
+             * 
+             * @param target The series
+             * @param time Time in ms
+             * @param value The value
+             * @return true On success
+             * @return false The point is out of order or older than the ring
+             */
+            bool append(series& target, int64_t time, double value);
+
+            /**
+             * @brief Calls visit for the points of a series in [from, to] in time order
+             * 
+             * @tparam F void(int64_t time, double value)
+             * @param target The series
+             * @param from First time in ms
+             * @param to Last time in ms
+             * @param visit Called per point
+             */
+            template <typename F>
+            void scan(const series& target, int64_t from, int64_t to, F visit) const;
+
+        public:
+            /**
+             * @brief Construct an empty TimeSeriesStore object with the default options
+             */
+            TimeSeriesStore();
+
+            /**
+             * @brief Sets the options. The stored points are kept if the options did not change.
+             * 
+             * @param _config Options of the store
+             */
+            void Configure(const options& _config);
+
+            /**
+             * @brief Get the options of the store
+             */
+            const options& GetOptions() const { return config; }
+
+            /**
+             * @brief Stores the numeric and boolean records of a pack. Booleans are stored as 0 or 1.
+             * 
+             * @param pack The decoded pack with times normalized by common::senml::normalize_times
+             */
+            void Insert(const common::senml::Pack& pack);
+
+            /**
+             * @brief Get the points of a series
+             * 
+             * @param name Series (record name)
+             * @param from First time in ms
+             * @param to Last time in ms
+             * @param points The points in time order
+             * @return true On success
+             * @return false Unknown series
+             */
+            bool Query(const std::string& name, int64_t from, int64_t to, std::vector<Point>& points) const;
+
+            /**
+             * @brief Aggregates the points of a series in windows of step ms starting at from.
+             * Windows without points are left out. The time of a result is the start of its window.
+             * 
+             * @param name Series (record name)
+             * @param from First time in ms
+             * @param to Last time in ms
+             * @param aggregate The aggregate, not NONE
+             * @param step Window length in ms. 0 aggregates the whole range into one point.
+             * @param points One point per window
+             * @return true On success
+             * @return false Unknown series
+             */
+            bool Query(const std::string& name, int64_t from, int64_t to, Aggregate aggregate, int64_t step, std::vector<Point>& points) const;
+
+            /**
+             * @brief Get the names of all series
+             * 
+             * @return std::vector<std::string> Sorted names
+             */
+            std::vector<std::string> Series() const;
+
+            /**
+             * @brief Moves the series to the ids the dictionary hands out after SeriesDictionary::Reset.
+             * Series without points in the retention are dropped.
+             * 
+             * @param names Names by the ids before the reset
+             */
+            void Rekey(const std::vector<std::string>& names);
+
+            /**
+             * @brief Removes all series
+             */
+            void Clear();
+
+            /**
+             * @brief Get the statistics of the store
+             * 
+             * @return std::string Series, points and bytes held, inserted and dropped points
+             */
+            std::string GetStatistics() const;
+    };
+
+    /**
+     * @brief Parses the name of an aggregate
+     * 
+     * @param name min, max, mean, sum, count, first or last
+     * @param aggregate The aggregate
+     * @return true On success
+     * @return false Unknown name
+     */
+    bool parse_aggregate(const std::string& name, Aggregate& aggregate);
+
+    /**
+     * @brief Get the name of an aggregate
+     * 
+     * @param aggregate The aggregate
+     * @return const char* The name, "" for NONE
+     */
+    const char* aggregate_name(Aggregate aggregate);
+}
\ No newline at end of file
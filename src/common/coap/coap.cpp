@@ -11,6 +11,7 @@
 
 #include "coap.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <common/logging/logging.h>
 #include <cstdint>
@@ -147,12 +148,48 @@ void CoAP::ReleaseContext(context_descriptor descriptor)
     return;
 }
 
-bool CoAP::CreateEndpoint(context_descriptor context, const std::string &host, const std::string &port)
+/**
+ * @brief Fills the PKI setup for libcoap from the security configuration.
+ * 
+ * @param security The security configuration
+ * @param sni Server name indication (nullptr on the server side)
+ * @return coap_dtls_pki_t The PKI setup
+ */
+coap_dtls_pki_t make_pki_setup(const CoAP::security_config &security, const char *sni)
+{
+    coap_dtls_pki_t pki = {};
+    pki.version = COAP_DTLS_PKI_SETUP_VERSION;
+    pki.verify_peer_cert = !security.ca_file.empty();
+    pki.check_common_ca = !security.ca_file.empty();
+    pki.cert_chain_validation = 1;
+    pki.cert_chain_verify_depth = 2;
+    pki.client_sni = const_cast<char *>(sni);
+    pki.pki_key.key_type = COAP_PKI_KEY_PEM;
+    pki.pki_key.key.pem.ca_file = security.ca_file.empty() ? nullptr : security.ca_file.c_str();
+    pki.pki_key.key.pem.public_cert = security.cert_file.empty() ? nullptr : security.cert_file.c_str();
+    pki.pki_key.key.pem.private_key = security.key_file.empty() ? nullptr : security.key_file.c_str();
+    return pki;
+}
+
+bool CoAP::CreateEndpoint(context_descriptor context, const std::string &host, const std::string &port, const security_config *security, coap_proto_t proto)
 {
     // Check for invalid context
     if (context_descriptor_invalid(context))
         return false;
 
+    // Check if libcoap was built with support for the transport
+    bool reliable = proto == COAP_PROTO_TCP || proto == COAP_PROTO_TLS;
+    if ((security != nullptr && !reliable && !coap_dtls_is_supported()) || (security != nullptr && reliable && !coap_tls_is_supported()))
+    {
+        logging::log_error(std::cerr, LINE_INFORMATION, "DTLS or TLS is not supported by libcoap.");
+        return false;
+    }
+    if (reliable && !coap_tcp_is_supported())
+    {
+        logging::log_error(std::cerr, LINE_INFORMATION, "TCP is not supported by libcoap.");
+        return false;
+    }
+
     // Resolve the address
     coap_address_t coap_addr;
     if (!resolve_address(host, port, &coap_addr))
@@ -164,8 +201,38 @@ bool CoAP::CreateEndpoint(context_descriptor context, const std::string &host, c
     // Thread-safety
     std::lock_guard guard(coap_lock);
 
+    // Set up the credentials of the context for DTLS or TLS
+    proto = reliable ? COAP_PROTO_TCP : COAP_PROTO_UDP;
+    if (security != nullptr)
+    {
+        proto = reliable ? COAP_PROTO_TLS : COAP_PROTO_DTLS;
+        if (!security->psk_key.empty())
+        {
+            coap_dtls_spsk_t psk = {};
+            psk.version = COAP_DTLS_SPSK_SETUP_VERSION;
+            psk.psk_info.hint.s = (const uint8_t *)security->psk_identity.c_str();
+            psk.psk_info.hint.length = security->psk_identity.size();
+            psk.psk_info.key.s = (const uint8_t *)security->psk_key.c_str();
+            psk.psk_info.key.length = security->psk_key.size();
+            if (!coap_context_set_psk2(context_list.at(context), &psk))
+            {
+                logging::log_error(std::cerr, LINE_INFORMATION, "Could not set the pre-shared key.");
+                return false;
+            }
+        }
+        else
+        {
+            coap_dtls_pki_t pki = make_pki_setup(*security, nullptr);
+            if (!coap_context_set_pki(context_list.at(context), &pki))
+            {
+                logging::log_error(std::cerr, LINE_INFORMATION, "Could not set the certificates.");
+                return false;
+            }
+        }
+    }
+
     // New endpoint and check if valid
-    if (coap_new_endpoint(context_list.at(context), &coap_addr, COAP_PROTO_UDP) == nullptr)
+    if (coap_new_endpoint(context_list.at(context), &coap_addr, proto) == nullptr)
     {
         logging::log_error(std::cerr, LINE_INFORMATION, "Could not create endpoint.");
         return false;
@@ -173,11 +240,32 @@ bool CoAP::CreateEndpoint(context_descriptor context, const std::string &host, c
     return true;
 }
 
-CoAP::session_ptr CoAP::CreateSession(context_descriptor context, const std::string &host, const std::string &port)
+CoAP::session_ptr CoAP::CreateSession(context_descriptor context,
+                                      const std::string &host,
+                                      const std::string &port,
+                                      coap_proto_t proto,
+                                      const security_config *security)
 {
     // Check for invalid context
     if (context_descriptor_invalid(context))
         return nullptr;
+
+    // Check if libcoap was built with support for the transport
+    if ((proto == COAP_PROTO_TCP && !coap_tcp_is_supported()) ||
+        (proto == COAP_PROTO_TLS && !coap_tls_is_supported()) ||
+        (proto == COAP_PROTO_DTLS && !coap_dtls_is_supported()))
+    {
+        logging::log_error(std::cerr, LINE_INFORMATION, "Transport is not supported by libcoap.");
+        return nullptr;
+    }
+
+    // DTLS and TLS need credentials
+    bool secure = proto == COAP_PROTO_DTLS || proto == COAP_PROTO_TLS;
+    if (secure && security == nullptr)
+    {
+        logging::log_error(std::cerr, LINE_INFORMATION, "Secured session requested without a security configuration.");
+        return nullptr;
+    }
     
     // Resolve the address
     coap_address_t coap_addr;
@@ -191,7 +279,26 @@ CoAP::session_ptr CoAP::CreateSession(context_descriptor context, const std::str
     std::lock_guard guard(coap_lock);
 
     // Create Session
-    session_ptr session = coap_new_client_session(context_list.at(context), nullptr, &coap_addr, COAP_PROTO_UDP);
+    session_ptr session = COAP_INVALID_RVALUE;
+    if (secure && !security->psk_key.empty())
+    {
+        coap_dtls_cpsk_t psk = {};
+        psk.version = COAP_DTLS_CPSK_SETUP_VERSION;
+        psk.client_sni = const_cast<char *>(host.c_str());
+        psk.psk_info.identity.s = (const uint8_t *)security->psk_identity.c_str();
+        psk.psk_info.identity.length = security->psk_identity.size();
+        psk.psk_info.key.s = (const uint8_t *)security->psk_key.c_str();
+        psk.psk_info.key.length = security->psk_key.size();
+        session = coap_new_client_session_psk2(context_list.at(context), nullptr, &coap_addr, proto, &psk);
+    }
+    else if (secure)
+    {
+        coap_dtls_pki_t pki = make_pki_setup(*security, host.c_str());
+        session = coap_new_client_session_pki(context_list.at(context), nullptr, &coap_addr, proto, &pki);
+    }
+    else
+        session = coap_new_client_session(context_list.at(context), nullptr, &coap_addr, proto);
+
     if (session == COAP_INVALID_RVALUE)
         logging::log_error(std::cerr, LINE_INFORMATION, "Could not create session.");
     return session;
@@ -294,10 +401,19 @@ std::vector<uint8_t> CoAP::ResourceBlockHandler(resource_ptr resource,
     if (!coap_get_block(request, COAP_OPTION_BLOCK1, &block1))
         return data_vector; // Return whole data if there is no block
 
-    // Generate key for the Block Cache
-    coap_str_const_t *uri = coap_resource_get_uri_path(resource);
+    // Generate key for the Block Cache. The path of the request is used because one resource may serve several paths.
     std::string key = coap_session_str(session);
-    key.append((const char *)uri->s, uri->length);
+    coap_string_t *uri = coap_get_uri_path(request);
+    if (uri != nullptr)
+    {
+        key.append((const char *)uri->s, uri->length);
+        coap_delete_string(uri);
+    }
+    else
+    {
+        coap_str_const_t *resource_uri = coap_resource_get_uri_path(resource);
+        key.append((const char *)resource_uri->s, resource_uri->length);
+    }
 
     // Create entry structure
     block_cache_entry entry = {
@@ -415,6 +531,77 @@ std::vector<uint8_t> CoAP::ResourceBlockHandler(resource_ptr resource,
     return std::vector<uint8_t>();
 }
 
+bool CoAP::GetContentFormat(const coap_pdu_t *pdu, uint16_t &content_format)
+{
+    coap_opt_iterator_t opt_iter;
+    coap_opt_t *option = coap_check_option(pdu, COAP_OPTION_CONTENT_FORMAT, &opt_iter);
+    if (option == nullptr)
+        return false;
+
+    content_format = coap_decode_var_bytes(coap_opt_value(option), coap_opt_length(option));
+    return true;
+}
+
+bool CoAP::SetRetryResponse(coap_pdu_t *response, coap_pdu_code_t code, uint32_t max_age)
+{
+    uint8_t buf[4];
+    coap_pdu_set_code(response, code);
+    if (coap_add_option(response, COAP_OPTION_MAXAGE, coap_encode_var_safe(buf, sizeof(buf), max_age), buf) == 0)
+    {
+        logging::log_error(std::cerr, LINE_INFORMATION, "Could not add Max-Age option.");
+        return false;
+    }
+    return true;
+}
+
+bool CoAP::AddBlockedResponse(const coap_pdu_t *request, coap_pdu_t *response, uint16_t content_format, const uint8_t *data, size_t size)
+{
+    uint8_t buf[4];
+    coap_block_t block2 = {};
+    bool requested = coap_get_block(request, COAP_OPTION_BLOCK2, &block2) != 0;
+    if (!requested)
+        block2.szx = COAP_BLOCK2_DEFAULT_SZX;
+
+    // A szx of 7 is reserved
+    if (block2.szx > COAP_BLOCK2_DEFAULT_SZX)
+        block2.szx = COAP_BLOCK2_DEFAULT_SZX;
+    size_t block_size = size_t(1) << (block2.szx + 4);
+    size_t offset = size_t(block2.num) * block_size;
+
+    // Small bodies are sent without block options
+    if (!requested && size <= block_size)
+    {
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+        if (coap_add_option(response, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(buf, sizeof(buf), content_format), buf) == 0)
+        {
+            logging::log_error(std::cerr, LINE_INFORMATION, "Could not add Content-Format option.");
+            return false;
+        }
+        return size == 0 || coap_add_data(response, size, data) != 0;
+    }
+
+    if (offset >= size && !(offset == 0 && size == 0))
+    {
+        logging::log_warning(std::cout, LINE_INFORMATION, "A client requested a block past the end of the response.");
+        coap_pdu_set_code(response, COAP_RESPONSE_CODE_BAD_REQUEST);
+        return false;
+    }
+
+    size_t length = std::min(block_size, size - offset);
+    unsigned int more = offset + length < size ? 1 : 0;
+
+    // Options have to be added in ascending order
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+    if (coap_add_option(response, COAP_OPTION_CONTENT_FORMAT, coap_encode_var_safe(buf, sizeof(buf), content_format), buf) == 0 ||
+        coap_add_option(response, COAP_OPTION_BLOCK2, coap_encode_var_safe(buf, sizeof(buf), (block2.num << 4) | (more << 3) | block2.szx), buf) == 0 ||
+        coap_add_option(response, COAP_OPTION_SIZE2, coap_encode_var_safe(buf, sizeof(buf), size), buf) == 0)
+    {
+        logging::log_error(std::cerr, LINE_INFORMATION, "Could not add Block2 options.");
+        return false;
+    }
+    return length == 0 || coap_add_data(response, length, data + offset) != 0;
+}
+
 CoAP::resource_ptr CoAP::CreateResource(const std::string &URI, int flags)
 {
     CoAP::resource_ptr res = coap_resource_init(coap_make_str_const(URI.c_str()), flags);
@@ -423,6 +610,14 @@ CoAP::resource_ptr CoAP::CreateResource(const std::string &URI, int flags)
     return res;
 }
 
+CoAP::resource_ptr CoAP::CreateUnknownResource(coap_method_handler_t put_handler)
+{
+    CoAP::resource_ptr res = coap_resource_unknown_init(put_handler);
+    if (res == NULL)
+        logging::log_error(std::cerr, LINE_INFORMATION, "CoAP Resource for unknown paths could not be initialized.");
+    return res;
+}
+
 bool CoAP::RegisterResourceHandler(resource_ptr res, coap_request_t type, coap_method_handler_t handler)
 {
     if (res == nullptr || handler == nullptr)
@@ -444,6 +639,22 @@ bool CoAP::AddResource(context_descriptor context, resource_ptr res)
     return true;
 }
 
+bool CoAP::SetObservable(resource_ptr res)
+{
+    if (res == nullptr)
+        return false;
+
+    coap_resource_set_get_observable(res, 1);
+    return true;
+}
+
+bool CoAP::NotifyObservers(resource_ptr res)
+{
+    if (res == nullptr)
+        return false;
+    return coap_resource_notify_observers(res, nullptr) != 0;
+}
+
 void CoAP::IO_Loop(context_descriptor context)
 {
     if (context_descriptor_invalid(context))
@@ -20,6 +20,7 @@
 
 #define COAP_INVALID_RVALUE nullptr
 #define COAP_RESOURCE_BLOCK_TIMEOUT 60000 //60 seconds
+#define COAP_BLOCK2_DEFAULT_SZX 6 // 1024 byte blocks for responses when the client does not choose a size
 
 #define COAP_RESOURCE_HANDLER(fnc_name)             \
     void fnc_name(struct coap_resource_t *resource, \
@@ -54,6 +55,19 @@ namespace common
         using resource_ptr = struct coap_resource_t *;
         using session_ptr = struct coap_session_t *;
 
+        /**
+         * @brief Credentials for secured sessions. The strings have to stay valid for as long
+         * as the session exists because libcoap reads the files during the handshake.
+         */
+        struct security_config
+        {
+            std::string psk_identity; // PSK identity (client) or identity hint (server)
+            std::string psk_key;      // Pre-shared key. PSK mode is used when this is set.
+            std::string ca_file;      // CA to verify the peer with (no verification when empty)
+            std::string cert_file;    // Own certificate (PEM)
+            std::string key_file;     // Private key of the own certificate (PEM)
+        };
+
         /**
          * @brief Get the Singleton Instance
          * 
@@ -148,10 +162,12 @@ namespace common
          * @param context Context to assign the endpoint to
          * @param host host address
          * @param port port
+         * @param security Credentials for a DTLS or TLS endpoint (nullptr for plain UDP or TCP). Has to stay valid as long as the context exists.
+         * @param proto Transport of the endpoint, COAP_PROTO_UDP or COAP_PROTO_TCP (secured with the credentials)
          * @return true Successfully added endpoint
          * @return false Failure
          */
-        bool CreateEndpoint(context_descriptor context, const std::string &host, const std::string &port);
+        bool CreateEndpoint(context_descriptor context, const std::string &host, const std::string &port, const security_config *security = nullptr, coap_proto_t proto = COAP_PROTO_UDP);
 
         /**
          * @brief Creates a client session
@@ -159,9 +175,15 @@ namespace common
          * @param context Context to assign the session to
          * @param host host address
          * @param port port
+         * @param proto Transport of the session (UDP, DTLS, TCP or TLS)
+         * @param security Credentials for DTLS and TLS (required for COAP_PROTO_DTLS and COAP_PROTO_TLS)
          * @return session_ptr nullptr on failure
          */
-        session_ptr CreateSession(context_descriptor context, const std::string &host, const std::string &port);
+        session_ptr CreateSession(context_descriptor context,
+                                  const std::string &host,
+                                  const std::string &port,
+                                  coap_proto_t proto = COAP_PROTO_UDP,
+                                  const security_config *security = nullptr);
 
         /**
          * @brief Releases the session
@@ -221,12 +243,77 @@ namespace common
          */
         std::vector<uint8_t> ResourceBlockHandler(resource_ptr resource, coap_session_t *session, const coap_pdu_t *request, coap_pdu_t *response);
 
+        /**
+         * @brief Get the Content-Format option of a PDU
+         * 
+         * @param pdu The PDU
+         * @param content_format The content format
+         * @return true The PDU has a Content-Format option
+         * @return false The PDU has no Content-Format option
+         */
+        bool GetContentFormat(const coap_pdu_t *pdu, uint16_t &content_format);
+
+        /**
+         * @brief Sets the code of a response and adds a Max-Age option telling the client when to retry
+         * 
+         * @param response CoAP response
+         * @param code Response code (e.g. 5.03)
+         * @param max_age Seconds until the client may retry
+         * @return true On success
+         * @return false On failure
+         */
+        bool SetRetryResponse(coap_pdu_t *response, coap_pdu_code_t code, uint32_t max_age);
+
+        /**
+         * @brief Adds a response body that may not fit into a single PDU. The block the client asked for
+         * with Block2 is sent (1024 bytes if it did not ask), together with Block2 and Size2 options.
+         * Bodies that fit are sent as they are when the client did not ask for a block.
+         * The body has to be the same for all blocks of a transfer.
+         * 
+         * @param request The CoAP request
+         * @param response CoAP response, the code is set here
+         * @param content_format Content-Format of the body
+         * @param data The whole body
+         * @param size Size of the body
+         * @return true On success
+         * @return false The requested block is past the end of the body (4.00 is set) or options could not be added
+         */
+        bool AddBlockedResponse(const coap_pdu_t *request, coap_pdu_t *response, uint16_t content_format, const uint8_t *data, size_t size);
+
         //maybe put these following together later
         resource_ptr CreateResource(const std::string &URI, int flags = 0);
+
+        /**
+         * @brief Creates the resource that receives the requests for paths without a resource of their own.
+         * Further methods can be registered with RegisterResourceHandler.
+         * 
+         * @param put_handler Handler for PUT requests
+         * @return resource_ptr The resource, COAP_INVALID_RVALUE on failure
+         */
+        resource_ptr CreateUnknownResource(coap_method_handler_t put_handler);
         bool RegisterResourceHandler(resource_ptr res, coap_request_t type, coap_method_handler_t handler);
         bool AddResource(context_descriptor context, resource_ptr res);
         // ------
 
+        /**
+         * @brief Lets clients observe a resource with GET (RFC 7641)
+         * 
+         * @param res The resource
+         * @return true On success
+         * @return false Invalid resource
+         */
+        bool SetObservable(resource_ptr res);
+
+        /**
+         * @brief Sends a notification to all observers of a resource. The GET handler is run again for every observer.
+         * Has to be called on the thread that runs IO.
+         * 
+         * @param res The resource
+         * @return true If the resource has observers
+         * @return false Otherwise
+         */
+        bool NotifyObservers(resource_ptr res);
+
         /**
          * @brief Runs basic CoAP IO Loop
          * TODO: Maybe do this a bit better
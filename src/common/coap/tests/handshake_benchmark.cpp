@@ -0,0 +1,145 @@
+/**
+ * @file handshake_benchmark.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief DTLS-PSK handshakes per second against a local peer compared to requests on an established session
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <common/coap/coap.hpp>
+
+#include <atomic>
+#include <thread>
+
+#define HANDSHAKE_BENCHMARK_SESSIONS 50
+#define HANDSHAKE_BENCHMARK_REQUESTS 500
+#define HANDSHAKE_BENCHMARK_TIMEOUT 5000    // ms a request may take
+#define HANDSHAKE_BENCHMARK_PORT "15785"
+
+using bench_clock = std::chrono::steady_clock;
+
+std::atomic_uint64_t g_responses;   // Responses the client received
+
+/**
+ * @brief Answers every GET
+ */
+COAP_RESOURCE_HANDLER(handle_ping)
+{
+    coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+}
+
+/**
+ * @brief Counts the responses
+ */
+COAP_RESPONSE_HANDLER(handle_response)
+{
+    g_responses++;
+    return COAP_RESPONSE_OK;
+}
+
+/**
+ * @brief Sends a GET and waits for its response
+ * 
+ * @param context Context of the session
+ * @param session The client session
+ */
+static void request(common::CoAP::context_descriptor context, common::CoAP::session_ptr session)
+{
+    common::CoAP *coap = &common::CoAP::getInstance();
+    coap_pdu_t *pdu = coap_new_pdu(COAP_MESSAGE_CON, COAP_REQUEST_CODE_GET, session);
+    if (pdu == nullptr)
+        throw std::runtime_error(LINE_INFORMATION + std::string("\tCould not create pdu"));
+    coap_add_option(pdu, COAP_OPTION_URI_PATH, 4, reinterpret_cast<const uint8_t *>("ping"));
+
+    uint64_t expected = g_responses.load() + 1;
+    if (coap->SendPDU(session, pdu) == COAP_INVALID_MID)
+        throw std::runtime_error(LINE_INFORMATION + std::string("\tCould not send request"));
+
+    // The first request also waits for the handshake
+    auto deadline = bench_clock::now() + std::chrono::milliseconds(HANDSHAKE_BENCHMARK_TIMEOUT);
+    while (g_responses.load() < expected && bench_clock::now() < deadline)
+        coap->IO(context, 10);
+    ASSERT_TRUE(g_responses.load() >= expected);
+}
+
+TEST_CASE(psk_handshakes)
+{
+    common::CoAP *coap = &common::CoAP::getInstance();
+    if (!coap_dtls_is_supported())
+    {
+        std::cout << "libcoap was built without DTLS, skipping the handshake benchmark." << std::endl;
+        return;
+    }
+
+    common::CoAP::security_config server_security;
+    server_security.psk_identity = "condalf";
+    server_security.psk_key = "handshake-benchmark";
+    common::CoAP::security_config client_security = server_security;
+
+    common::CoAP::context_descriptor peer = coap->CreateContext();
+    ASSERT_TRUE(peer >= 0);
+    ASSERT_TRUE(coap->CreateEndpoint(peer, "127.0.0.1", HANDSHAKE_BENCHMARK_PORT, &server_security));
+    common::CoAP::resource_ptr resource = coap->CreateResource("ping");
+    ASSERT_TRUE(coap->RegisterResourceHandler(resource, COAP_REQUEST_GET, handle_ping));
+    ASSERT_TRUE(coap->AddResource(peer, resource));
+
+    std::atomic_bool stop(false);
+    std::thread io([&] {
+        while (!stop.load())
+            coap->IO(peer, 100);
+    });
+
+    common::CoAP::context_descriptor client = coap->CreateContext();
+    double handshakes = 0, handshake_latency = 0, request_latency = 0;
+    try
+    {
+        ASSERT_TRUE(client >= 0);
+        ASSERT_TRUE(coap->RegisterResponseHandler(client, handle_response));
+
+        // Every session does a full handshake, libcoap 4.3.0-rc3 can not resume one
+        auto begin = bench_clock::now();
+        for (unsigned int i = 0; i < HANDSHAKE_BENCHMARK_SESSIONS; i++)
+        {
+            common::CoAP::session_ptr session = coap->CreateSession(client, "127.0.0.1", HANDSHAKE_BENCHMARK_PORT, COAP_PROTO_DTLS, &client_security);
+            ASSERT_TRUE(session != nullptr);
+            request(client, session);
+            coap->ReleaseSession(session);
+        }
+        double seconds = std::chrono::duration<double>(bench_clock::now() - begin).count();
+        handshakes = HANDSHAKE_BENCHMARK_SESSIONS / seconds;
+        handshake_latency = seconds * 1000 / HANDSHAKE_BENCHMARK_SESSIONS;
+
+        // Requests on one established session as the lower bound
+        common::CoAP::session_ptr session = coap->CreateSession(client, "127.0.0.1", HANDSHAKE_BENCHMARK_PORT, COAP_PROTO_DTLS, &client_security);
+        ASSERT_TRUE(session != nullptr);
+        request(client, session);
+        begin = bench_clock::now();
+        for (unsigned int i = 0; i < HANDSHAKE_BENCHMARK_REQUESTS; i++)
+            request(client, session);
+        request_latency = std::chrono::duration<double>(bench_clock::now() - begin).count() * 1000 / HANDSHAKE_BENCHMARK_REQUESTS;
+        coap->ReleaseSession(session);
+    }
+    catch (...)
+    {
+        stop.store(true);
+        io.join();
+        coap->ReleaseContext(client);
+        coap->ReleaseContext(peer);
+        throw;
+    }
+
+    stop.store(true);
+    io.join();
+    coap->ReleaseContext(client);
+    coap->ReleaseContext(peer);
+    std::cout << "DTLS-PSK: " << handshakes << " handshakes/s, " << handshake_latency << " ms for handshake and first request, "
+              << request_latency << " ms per request on an established session" << std::endl;
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(psk_handshakes);
+TEST_MODULE_END
\ No newline at end of file
@@ -34,4 +34,36 @@ void common::config::parse(std::string file, std::function<void(const std::strin
 
     in.close();
     return;
+}
+
+/**
+ * @brief Removes leading and trailing whitespace.
+ * 
+ * @param str The string
+ * @return std::string Trimmed string
+ */
+static std::string trim(const std::string& str)
+{
+    std::size_t start = str.find_first_not_of(" \t\r");
+    if (start == std::string::npos)
+        return "";
+    std::size_t end = str.find_last_not_of(" \t\r");
+    return str.substr(start, end - start + 1);
+}
+
+void common::config::parse_options(std::string file, std::function<void(const std::string&, const std::string&)> option_handler)
+{
+    parse(file, [&option_handler](const std::string& line) {
+        std::string option = trim(line);
+        if (option.empty() || option[0] == '#')
+            return;
+
+        std::size_t separator = option.find('=');
+        if (separator == std::string::npos)
+        {
+            common::logging::log_warning(std::cout, LINE_INFORMATION, std::string("Ignoring line without '=': ") + option);
+            return;
+        }
+        option_handler(trim(option.substr(0, separator)), trim(option.substr(separator + 1)));
+    });
 }
\ No newline at end of file
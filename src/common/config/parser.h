@@ -23,4 +23,13 @@ namespace common::config
      * @param line_handler Handler that handles every read line
      */
     void parse(std::string file, std::function<void(const std::string&)> line_handler);
+
+    /**
+     * @brief Reads "key=value" lines and passes them to the option_handler.
+     * Empty lines and lines starting with '#' are skipped. Whitespace around key and value is removed.
+     * 
+     * @param file Filepath
+     * @param option_handler Handler that handles every option
+     */
+    void parse_options(std::string file, std::function<void(const std::string&, const std::string&)> option_handler);
 }
@@ -0,0 +1,335 @@
+/**
+ * @file http.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "http.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <common/logging/logging.h>
+
+using namespace common::http;
+
+/**
+ * @brief Encodes data as base64
+ * 
+ * @param data The data
+ * @return std::string The encoded data
+ */
+static std::string base64_encode(const std::string& data)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve((data.size() + 2) / 3 * 4);
+
+    std::size_t i = 0;
+    for (; i + 2 < data.size(); i += 3)
+    {
+        uint32_t triple = (uint8_t)data[i] << 16 | (uint8_t)data[i + 1] << 8 | (uint8_t)data[i + 2];
+        encoded += alphabet[(triple >> 18) & 0x3F];
+        encoded += alphabet[(triple >> 12) & 0x3F];
+        encoded += alphabet[(triple >> 6) & 0x3F];
+        encoded += alphabet[triple & 0x3F];
+    }
+
+    if (i < data.size())
+    {
+        uint32_t triple = (uint8_t)data[i] << 16 | (i + 1 < data.size() ? (uint8_t)data[i + 1] << 8 : 0);
+        encoded += alphabet[(triple >> 18) & 0x3F];
+        encoded += alphabet[(triple >> 12) & 0x3F];
+        encoded += i + 1 < data.size() ? alphabet[(triple >> 6) & 0x3F] : '=';
+        encoded += '=';
+    }
+    return encoded;
+}
+
+/**
+ * @brief Compares two strings ignoring the case
+ * 
+ * @param a First string
+ * @param b Second string
+ * @return true Equal
+ * @return false Not equal
+ */
+static bool equals_ignore_case(const std::string& a, const std::string& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower((unsigned char)x) == std::tolower((unsigned char)y);
+    });
+}
+
+std::string common::http::url_encode(const std::string& value)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    std::string encoded;
+    for (unsigned char c : value)
+    {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+            encoded += c;
+        else
+        {
+            encoded += '%';
+            encoded += hex[c >> 4];
+            encoded += hex[c & 0x0F];
+        }
+    }
+    return encoded;
+}
+
+Connection::Connection(const std::string& _host, const std::string& _port, int _timeout)
+    : host(_host), port(_port), timeout(_timeout), fd(-1)
+{
+}
+
+Connection::~Connection()
+{
+    Close();
+}
+
+void Connection::SetBasicAuth(const std::string& user, const std::string& password)
+{
+    authorization = user.empty() ? "" : "Basic " + base64_encode(user + ":" + password);
+}
+
+void Connection::Close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    read_buffer.clear();
+}
+
+bool Connection::connect()
+{
+    struct addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *result = nullptr;
+    int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (error != 0)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not resolve ") + host + ": " + gai_strerror(error));
+        return false;
+    }
+
+    for (struct addrinfo *ainfo = result; ainfo != nullptr; ainfo = ainfo->ai_next)
+    {
+        fd = socket(ainfo->ai_family, ainfo->ai_socktype | SOCK_CLOEXEC, ainfo->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        // Connect non-blocking so that an unreachable host does not stall the caller
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int res = ::connect(fd, ainfo->ai_addr, ainfo->ai_addrlen);
+        if (res < 0 && errno == EINPROGRESS)
+        {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            if (poll(&pfd, 1, timeout) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len) == 0 && so_error == 0)
+                res = 0;
+        }
+
+        if (res == 0)
+        {
+            fcntl(fd, F_SETFL, flags);
+
+            // Requests are written at once, do not wait for more data
+            int nodelay = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+            struct timeval tv = { timeout / 1000, (timeout % 1000) * 1000 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            break;
+        }
+
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0)
+    {
+        common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("Could not connect to ") + host + ":" + port);
+        return false;
+    }
+    return true;
+}
+
+bool Connection::send_all(const std::string& data)
+{
+    std::size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t res = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        sent += res;
+    }
+    return true;
+}
+
+bool Connection::receive()
+{
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t res = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            return false;
+        read_buffer.append(buffer, res);
+        return true;
+    }
+}
+
+bool Connection::read_line(std::string& line)
+{
+    std::size_t end;
+    while ((end = read_buffer.find("\r\n")) == std::string::npos)
+    {
+        if (read_buffer.size() > HTTP_MAX_HEADER_SIZE || !receive())
+            return false;
+    }
+    line = read_buffer.substr(0, end);
+    read_buffer.erase(0, end + 2);
+    return true;
+}
+
+bool Connection::read_exactly(std::size_t length, std::string& data)
+{
+    while (read_buffer.size() < length)
+    {
+        if (!receive())
+            return false;
+    }
+    data.append(read_buffer, 0, length);
+    read_buffer.erase(0, length);
+    return true;
+}
+
+bool Connection::read_response(int& status, std::string& body, bool& keep_alive)
+{
+    // Status line: HTTP/1.1 204 No Content
+    std::string line;
+    if (!read_line(line) || line.compare(0, 5, "HTTP/") != 0)
+        return false;
+
+    std::size_t code_start = line.find(' ');
+    if (code_start == std::string::npos)
+        return false;
+    status = std::atoi(line.c_str() + code_start + 1);
+    keep_alive = line.compare(0, 8, "HTTP/1.0") != 0;
+
+    // Headers
+    bool chunked = false;
+    std::size_t content_length = 0;
+    while (true)
+    {
+        if (!read_line(line))
+            return false;
+        if (line.empty())
+            break;
+
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string name = line.substr(0, colon);
+        std::size_t value_start = line.find_first_not_of(' ', colon + 1);
+        std::string value = value_start == std::string::npos ? "" : line.substr(value_start);
+
+        if (equals_ignore_case(name, "Content-Length"))
+            content_length = std::strtoul(value.c_str(), nullptr, 10);
+        else if (equals_ignore_case(name, "Transfer-Encoding"))
+            chunked = equals_ignore_case(value, "chunked");
+        else if (equals_ignore_case(name, "Connection"))
+            keep_alive = !equals_ignore_case(value, "close");
+    }
+
+    // Body
+    body.clear();
+    if (status == 204 || status == 304 || (status >= 100 && status < 200))
+        return true;
+
+    if (!chunked)
+        return read_exactly(content_length, body);
+
+    while (true)
+    {
+        if (!read_line(line))
+            return false;
+        std::size_t chunk_size = std::strtoul(line.c_str(), nullptr, 16);
+        if (chunk_size == 0)
+            break;
+        if (!read_exactly(chunk_size, body) || !read_line(line))
+            return false;
+    }
+
+    // Skip trailers
+    do
+    {
+        if (!read_line(line))
+            return false;
+    } while (!line.empty());
+    return true;
+}
+
+bool Connection::Post(const std::string& target, const std::string& content_type, const std::string& body, int& status, std::string& response)
+{
+    std::string request = "POST " + target + " HTTP/1.1\r\n"
+                           "Host: " + host + ":" + port + "\r\n"
+                           "Content-Type: " + content_type + "\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    if (!authorization.empty())
+        request += "Authorization: " + authorization + "\r\n";
+    request += "\r\n";
+    request += body;
+
+    // A kept-alive connection might have been closed by the server in the meantime -> retry once on a new one
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        bool reused = fd >= 0;
+        if (!reused && !connect())
+            return false;
+
+        bool keep_alive = true;
+        if (send_all(request) && read_response(status, response, keep_alive))
+        {
+            if (!keep_alive)
+                Close();
+            return true;
+        }
+
+        Close();
+        if (!reused)
+            break;
+    }
+
+    common::logging::log_error(std::cerr, LINE_INFORMATION, std::string("No HTTP response from ") + host + ":" + port);
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+/**
+ * @file http.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Minimal HTTP/1.1 client with persistent connections
+ * @version 0.1
+ * @date 2021-07-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <string>
+
+#define HTTP_DEFAULT_TIMEOUT 5000 // ms a connect, send or receive may take
+#define HTTP_MAX_HEADER_SIZE 16384
+
+namespace common::http
+{
+    /**
+     * @brief A single HTTP/1.1 connection that is kept alive between requests.
+     * The connection is (re)established on demand. It is not thread safe.
+     */
+    class Connection
+    {
+        private:
+            /**
+             * @brief Host of the HTTP server
+             */
+            std::string host;
+
+            /**
+             * @brief Port of the HTTP server
+             */
+            std::string port;
+
+            /**
+             * @brief Value of the Authorization header. Empty if none is sent.
+             */
+            std::string authorization;
+
+            /**
+             * @brief Timeout for connect, send and receive in ms
+             */
+            int timeout;
+
+            /**
+             * @brief The socket or -1 if not connected
+             */
+            int fd;
+
+            /**
+             * @brief Received bytes that were not consumed yet
+             */
+            std::string read_buffer;
+
+            /**
+             * @brief Opens the socket
+             * 
+             * @return true On success
+             * @return false On failure
+             */
+            bool connect();
+
+            /**
+             * @brief Sends all bytes of data
+             * 
+             * @param data The data
+             * @return true On success
+             * @return false On failure
+             */
+            bool send_all(const std::string& data);
+
+            /**
+             * @brief Receives more data into the read buffer
+             * 
+             * @return true On success
+             * @return false On failure or if the peer closed the connection
+             */
+            bool receive();
+
+            /**
+             * @brief Reads a line terminated by CRLF from the read buffer
+             * 
+             * @param line The line without CRLF
+             * @return true On success
+             * @return false On failure
+             */
+            bool read_line(std::string& line);
+
+            /**
+             * @brief Reads exactly length bytes from the read buffer
+             * 
+             * @param length Number of bytes
+             * @param data The bytes
+             * @return true On success
+             * @return false On failure
+             */
+            bool read_exactly(std::size_t length, std::string& data);
+
+            /**
+             * @brief Reads a complete response
+             * 
+             * @param status The status code
+             * @param body The response body
+             * @param keep_alive False if the server closes the connection
+             * @return true On success
+             * @return false On failure
+             */
+            bool read_response(int& status, std::string& body, bool& keep_alive);
+
+        public:
+            /**
+             * @brief Construct a new Connection object. Does not connect yet.
+             * 
+             * @param _host Host of the HTTP server
+             * @param _port Port of the HTTP server
+             * @param _timeout Timeout for connect, send and receive in ms
+             */
+            Connection(const std::string& _host, const std::string& _port, int _timeout = HTTP_DEFAULT_TIMEOUT);
+
+            /**
+             * @brief Destroy the Connection object
+             */
+            ~Connection();
+
+            /**
+             * @brief Deleted copy constructor
+             */
+            Connection(const Connection&) = delete;
+
+            /**
+             * @brief Deleted copy operator
+             */
+            Connection& operator=(const Connection&) = delete;
+
+            /**
+             * @brief Sends HTTP Basic credentials with every request
+             * 
+             * @param user The user
+             * @param password The password
+             */
+            void SetBasicAuth(const std::string& user, const std::string& password);
+
+            /**
+             * @brief Sends a POST request and waits for the response. A reused connection that
+             * was closed by the server is reopened once.
+             * 
+             * @param target Request target (e.g. /write?db=main)
+             * @param content_type Content-Type of the body
+             * @param body The body
+             * @param status The status code of the response
+             * @param response The body of the response
+             * @return true On success (any status)
+             * @return false If no response was received
+             */
+            bool Post(const std::string& target, const std::string& content_type, const std::string& body, int& status, std::string& response);
+
+            /**
+             * @brief Closes the connection
+             */
+            void Close();
+
+            /**
+             * @brief Checks if the connection is open
+             * 
+             * @return true Connected
+             * @return false Not connected
+             */
+            bool IsConnected() const { return fd >= 0; }
+    };
+
+    /**
+     * @brief Percent-encodes a string for use in a query
+     * 
+     * @param value The string
+     * @return std::string The encoded string
+     */
+    std::string url_encode(const std::string& value);
+}
\ No newline at end of file
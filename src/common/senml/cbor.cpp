@@ -0,0 +1,261 @@
+/**
+ * @file cbor.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-05
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "cbor.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#define CBOR_MAX_NESTING 16
+
+using namespace common::senml;
+
+/**
+ * @brief Converts an IEEE 754 half precision float.
+ * 
+ * @param half The raw bits
+ * @return double The value
+ */
+double decode_half(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1f;
+    int mantissa = half & 0x3ff;
+    double value;
+    if (exponent == 0)
+        value = std::ldexp(mantissa, -24);
+    else if (exponent != 31)
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+    else
+        value = mantissa == 0 ? INFINITY : NAN;
+    return (half & 0x8000) ? -value : value;
+}
+
+CborReader::CborReader(const uint8_t* data, size_t size)
+{
+    pos = data;
+    end = data + size;
+}
+
+bool CborReader::read_head(uint8_t& major, uint8_t& info, uint64_t& argument)
+{
+    if (pos >= end)
+        return false;
+
+    major = *pos >> 5;
+    info = *pos & 0x1f;
+    pos++;
+
+    // Argument is directly in the initial byte
+    if (info < 24)
+    {
+        argument = info;
+        return true;
+    }
+
+    // Indefinite length (or break for simple values)
+    if (info == 31)
+    {
+        argument = INDEFINITE;
+        return major == ARRAY || major == MAP || major == BYTES || major == TEXT || major == SIMPLE;
+    }
+
+    // Argument follows in 1, 2, 4 or 8 bytes (big endian)
+    if (info > 27)
+        return false;
+    size_t length = 1u << (info - 24);
+    if ((size_t)(end - pos) < length)
+        return false;
+
+    argument = 0;
+    for (size_t i = 0; i < length; i++)
+        argument = (argument << 8) | pos[i];
+    pos += length;
+    return true;
+}
+
+bool CborReader::AtEnd()
+{
+    return pos >= end;
+}
+
+bool CborReader::PeekType(uint8_t& major)
+{
+    if (pos >= end)
+        return false;
+    major = *pos >> 5;
+    return true;
+}
+
+bool CborReader::ReadBreak()
+{
+    if (pos >= end || *pos != 0xff)
+        return false;
+    pos++;
+    return true;
+}
+
+bool CborReader::ReadArray(uint64_t& length)
+{
+    uint8_t major, info;
+    return read_head(major, info, length) && major == ARRAY;
+}
+
+bool CborReader::ReadMap(uint64_t& length)
+{
+    uint8_t major, info;
+    return read_head(major, info, length) && major == MAP;
+}
+
+bool CborReader::ReadInteger(int64_t& value)
+{
+    uint8_t major, info;
+    uint64_t argument;
+    if (!read_head(major, info, argument) || argument == INDEFINITE || argument > INT64_MAX)
+        return false;
+
+    if (major == UNSIGNED)
+        value = (int64_t)argument;
+    else if (major == NEGATIVE)
+        value = -1 - (int64_t)argument;
+    else
+        return false;
+    return true;
+}
+
+bool CborReader::ReadNumber(double& value)
+{
+    uint8_t major, info;
+    uint64_t argument;
+    if (!read_head(major, info, argument) || argument == INDEFINITE)
+        return false;
+
+    switch (major)
+    {
+    case UNSIGNED:
+        value = (double)argument;
+        return true;
+    case NEGATIVE:
+        value = -1.0 - (double)argument;
+        return true;
+    case SIMPLE:
+        if (info == 25)
+        {
+            value = decode_half((uint16_t)argument);
+            return true;
+        }
+        else if (info == 26)
+        {
+            uint32_t bits = (uint32_t)argument;
+            float single;
+            std::memcpy(&single, &bits, sizeof(single));
+            value = single;
+            return true;
+        }
+        else if (info == 27)
+        {
+            std::memcpy(&value, &argument, sizeof(value));
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool CborReader::ReadBoolean(bool& value)
+{
+    uint8_t major, info;
+    uint64_t argument;
+    if (!read_head(major, info, argument) || major != SIMPLE || (info != 20 && info != 21))
+        return false;
+    value = info == 21;
+    return true;
+}
+
+bool CborReader::ReadText(std::string_view& value)
+{
+    uint8_t major, info;
+    uint64_t length;
+    if (!read_head(major, info, length) || major != TEXT || length == INDEFINITE || length > (uint64_t)(end - pos))
+        return false;
+    value = std::string_view((const char*)pos, length);
+    pos += length;
+    return true;
+}
+
+bool CborReader::ReadBytes(std::string_view& value)
+{
+    uint8_t major, info;
+    uint64_t length;
+    if (!read_head(major, info, length) || major != BYTES || length == INDEFINITE || length > (uint64_t)(end - pos))
+        return false;
+    value = std::string_view((const char*)pos, length);
+    pos += length;
+    return true;
+}
+
+bool CborReader::Skip(unsigned int depth)
+{
+    if (depth > CBOR_MAX_NESTING)
+        return false;
+
+    uint8_t major, info;
+    uint64_t argument;
+    if (!read_head(major, info, argument))
+        return false;
+
+    switch (major)
+    {
+    case UNSIGNED:
+    case NEGATIVE:
+        return argument != INDEFINITE;
+    case BYTES:
+    case TEXT:
+        // Indefinite strings consist of definite chunks until a break
+        if (argument == INDEFINITE)
+        {
+            while (!ReadBreak())
+            {
+                uint8_t chunk_major;
+                if (!PeekType(chunk_major) || chunk_major != major || !Skip(depth + 1))
+                    return false;
+            }
+            return true;
+        }
+        if (argument > (uint64_t)(end - pos))
+            return false;
+        pos += argument;
+        return true;
+    case ARRAY:
+    case MAP:
+    {
+        uint64_t items = major == MAP && argument != INDEFINITE ? argument * 2 : argument;
+        if (argument == INDEFINITE)
+        {
+            while (!ReadBreak())
+                if (!Skip(depth + 1))
+                    return false;
+            return true;
+        }
+        for (uint64_t i = 0; i < items; i++)
+            if (!Skip(depth + 1))
+                return false;
+        return true;
+    }
+    case TAG:
+        return argument != INDEFINITE && Skip(depth + 1);
+    case SIMPLE:
+        // A break is only valid inside indefinite items
+        return argument != INDEFINITE;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,173 @@
+/**
+ * @file cbor.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Minimal streaming CBOR reader (RFC 7049)
+ * @version 0.1
+ * @date 2021-07-05
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace common::senml
+{
+    /**
+     * @brief Reads CBOR items directly from a buffer without building a tree.
+     * Strings are returned as views into the buffer. All methods return false
+     * on malformed input and leave the reader in an undefined position.
+     */
+    class CborReader
+    {
+        public:
+            enum major_type : uint8_t
+            {
+                UNSIGNED = 0,
+                NEGATIVE = 1,
+                BYTES = 2,
+                TEXT = 3,
+                ARRAY = 4,
+                MAP = 5,
+                TAG = 6,
+                SIMPLE = 7
+            };
+
+            /**
+             * @brief Argument value of indefinite length items
+             */
+            static constexpr uint64_t INDEFINITE = UINT64_MAX;
+
+        private:
+            /**
+             * @brief Current read position
+             */
+            const uint8_t* pos;
+
+            /**
+             * @brief End of the buffer
+             */
+            const uint8_t* end;
+
+            /**
+             * @brief Reads the initial byte and the argument of the next item.
+             * 
+             * @param major Major type of the item
+             * @param info Additional information (low 5 bits)
+             * @param argument The argument (INDEFINITE for indefinite lengths)
+             * @return true On success
+             * @return false On malformed input
+             */
+            bool read_head(uint8_t& major, uint8_t& info, uint64_t& argument);
+
+        public:
+            /**
+             * @brief Construct a new reader on the buffer. The buffer has to outlive the reader.
+             * 
+             * @param data The buffer
+             * @param size Size of the buffer
+             */
+            CborReader(const uint8_t* data, size_t size);
+
+            /**
+             * @brief Checks if the whole buffer was read.
+             * 
+             * @return true Nothing left to read
+             * @return false There are bytes left
+             */
+            bool AtEnd();
+
+            /**
+             * @brief Get the major type of the next item without consuming it.
+             * 
+             * @param major The major type
+             * @return true On success
+             * @return false At the end of the buffer
+             */
+            bool PeekType(uint8_t& major);
+
+            /**
+             * @brief Checks for the break code of an indefinite container and consumes it.
+             * 
+             * @return true A break was read
+             * @return false The next item is not a break
+             */
+            bool ReadBreak();
+
+            /**
+             * @brief Reads the head of an array.
+             * 
+             * @param length Item count (INDEFINITE if terminated by a break)
+             * @return true On success
+             * @return false Not an array
+             */
+            bool ReadArray(uint64_t& length);
+
+            /**
+             * @brief Reads the head of a map.
+             * 
+             * @param length Pair count (INDEFINITE if terminated by a break)
+             * @return true On success
+             * @return false Not a map
+             */
+            bool ReadMap(uint64_t& length);
+
+            /**
+             * @brief Reads an integer that fits into int64.
+             * 
+             * @param value The integer
+             * @return true On success
+             * @return false Not an integer or out of range
+             */
+            bool ReadInteger(int64_t& value);
+
+            /**
+             * @brief Reads any number (integers, half, single and double floats).
+             * 
+             * @param value The number
+             * @return true On success
+             * @return false Not a number
+             */
+            bool ReadNumber(double& value);
+
+            /**
+             * @brief Reads a boolean.
+             * 
+             * @param value The boolean
+             * @return true On success
+             * @return false Not a boolean
+             */
+            bool ReadBoolean(bool& value);
+
+            /**
+             * @brief Reads a definite length text string.
+             * 
+             * @param value View into the buffer
+             * @return true On success
+             * @return false Not a definite length text string
+             */
+            bool ReadText(std::string_view& value);
+
+            /**
+             * @brief Reads a definite length byte string.
+             * 
+             * @param value View into the buffer
+             * @return true On success
+             * @return false Not a definite length byte string
+             */
+            bool ReadBytes(std::string_view& value);
+
+            /**
+             * @brief Skips the next item including all nested items.
+             * 
+             * @param depth Current nesting depth (used to stop malicious nesting)
+             * @return true On success
+             * @return false On malformed input
+             */
+            bool Skip(unsigned int depth = 0);
+    };
+}
@@ -0,0 +1,374 @@
+/**
+ * @file json.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-07
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "json.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define JSON_MAX_NESTING 16
+
+using namespace common::senml;
+
+/**
+ * @brief Finds the next quote, backslash or control character, i.e. the end of the plain part of a string.
+ * 
+ * @param pos Start of the search
+ * @param end End of the buffer
+ * @return const char* Position of the character or end
+ */
+const char* find_quote_escape_or_control(const char* pos, const char* end)
+{
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i escape = _mm_set1_epi8('\\');
+    const __m128i last_control = _mm_set1_epi8(0x1f);
+    while (end - pos >= 16)
+    {
+        // Unsigned min finds the bytes <= 0x1f, a signed compare would match UTF-8 as well
+        __m128i chunk = _mm_loadu_si128((const __m128i*)pos);
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(chunk, last_control), chunk);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape)), control));
+        if (mask != 0)
+            return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    while (pos < end && *pos != '"' && *pos != '\\' && (unsigned char)*pos >= 0x20)
+        pos++;
+    return pos;
+}
+
+/**
+ * @brief Finds the first character that is not JSON whitespace.
+ * 
+ * @param pos Start of the search
+ * @param end End of the buffer
+ * @return const char* Position of the character or end
+ */
+const char* find_non_whitespace(const char* pos, const char* end)
+{
+    // Most of the time there is no or only a single whitespace
+    if (pos < end && *pos != ' ' && *pos != '\n' && *pos != '\r' && *pos != '\t')
+        return pos;
+
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - pos >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)pos);
+        __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage_return), _mm_cmpeq_epi8(chunk, tab)));
+        int mask = ~_mm_movemask_epi8(whitespace) & 0xffff;
+        if (mask != 0)
+            return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+#endif
+    while (pos < end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+        pos++;
+    return pos;
+}
+
+/**
+ * @brief Parses 4 hex digits.
+ * 
+ * @param pos Start of the digits (4 bytes have to be available)
+ * @param value The value
+ * @return true On success
+ * @return false Invalid digit
+ */
+bool parse_hex4(const char* pos, uint32_t& value)
+{
+    value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        char c = pos[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9')
+            value |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            value |= c - 'A' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends a code point as UTF-8.
+ * 
+ * @param out The string
+ * @param code_point The code point
+ */
+void append_utf8(std::string& out, uint32_t code_point)
+{
+    if (code_point < 0x80)
+        out.push_back((char)code_point);
+    else if (code_point < 0x800)
+    {
+        out.push_back((char)(0xc0 | (code_point >> 6)));
+        out.push_back((char)(0x80 | (code_point & 0x3f)));
+    }
+    else if (code_point < 0x10000)
+    {
+        out.push_back((char)(0xe0 | (code_point >> 12)));
+        out.push_back((char)(0x80 | ((code_point >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (code_point & 0x3f)));
+    }
+    else
+    {
+        out.push_back((char)(0xf0 | (code_point >> 18)));
+        out.push_back((char)(0x80 | ((code_point >> 12) & 0x3f)));
+        out.push_back((char)(0x80 | ((code_point >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (code_point & 0x3f)));
+    }
+}
+
+JsonReader::JsonReader(const uint8_t* data, size_t size)
+{
+    pos = (const char*)data;
+    end = pos + size;
+}
+
+void JsonReader::skip_whitespace()
+{
+    pos = find_non_whitespace(pos, end);
+}
+
+bool JsonReader::AtEnd()
+{
+    skip_whitespace();
+    return pos >= end;
+}
+
+char JsonReader::Peek()
+{
+    skip_whitespace();
+    return pos < end ? *pos : '\0';
+}
+
+bool JsonReader::Consume(char c)
+{
+    if (Peek() != c)
+        return false;
+    pos++;
+    return true;
+}
+
+bool JsonReader::ReadString(std::string_view& value, std::string& storage)
+{
+    if (!Consume('"'))
+        return false;
+
+    // Fast path: no escapes
+    const char* start = pos;
+    const char* stop = find_quote_escape_or_control(pos, end);
+    if (stop >= end || (unsigned char)*stop < 0x20)
+        return false;
+    if (*stop == '"')
+    {
+        value = std::string_view(start, stop - start);
+        pos = stop + 1;
+        return true;
+    }
+
+    // Slow path: unescape into the storage
+    storage.assign(start, stop - start);
+    pos = stop;
+    while (pos < end)
+    {
+        if (*pos == '"')
+        {
+            pos++;
+            value = storage;
+            return true;
+        }
+
+        // Control characters have to be escaped (RFC 8259 section 7)
+        if ((unsigned char)*pos < 0x20)
+            return false;
+
+        // Plain part
+        if (*pos != '\\')
+        {
+            stop = find_quote_escape_or_control(pos, end);
+            storage.append(pos, stop - pos);
+            pos = stop;
+            continue;
+        }
+
+        // Escape sequence
+        if (end - pos < 2)
+            return false;
+        char escaped = pos[1];
+        pos += 2;
+        switch (escaped)
+        {
+        case '"': storage.push_back('"'); break;
+        case '\\': storage.push_back('\\'); break;
+        case '/': storage.push_back('/'); break;
+        case 'b': storage.push_back('\b'); break;
+        case 'f': storage.push_back('\f'); break;
+        case 'n': storage.push_back('\n'); break;
+        case 'r': storage.push_back('\r'); break;
+        case 't': storage.push_back('\t'); break;
+        case 'u':
+        {
+            uint32_t code_point;
+            if (end - pos < 4 || !parse_hex4(pos, code_point))
+                return false;
+            pos += 4;
+
+            // Surrogate pair, a low surrogate can not stand alone
+            if (code_point >= 0xdc00 && code_point < 0xe000)
+                return false;
+            if (code_point >= 0xd800 && code_point < 0xdc00)
+            {
+                uint32_t low;
+                if (end - pos < 6 || pos[0] != '\\' || pos[1] != 'u' || !parse_hex4(pos + 2, low) || low < 0xdc00 || low >= 0xe000)
+                    return false;
+                pos += 6;
+                code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+            }
+            append_utf8(storage, code_point);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Skips the digits 0-9.
+ * 
+ * @param pos Start of the digits
+ * @param end End of the buffer
+ * @return const char* Position after the last digit
+ */
+const char* skip_digits(const char* pos, const char* end)
+{
+    while (pos < end && *pos >= '0' && *pos <= '9')
+        pos++;
+    return pos;
+}
+
+bool JsonReader::ReadNumber(double& value)
+{
+    skip_whitespace();
+
+    // from_chars accepts more than JSON (inf, nan, hex floats, leading zeros), so the grammar
+    // of RFC 8259 section 6 is checked first: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    const char* number = pos;
+    if (number < end && *number == '-')
+        number++;
+    if (number >= end || *number < '0' || *number > '9')
+        return false;
+    number = *number == '0' ? number + 1 : skip_digits(number, end);
+    if (number < end && *number == '.')
+    {
+        const char* fraction = number + 1;
+        number = skip_digits(fraction, end);
+        if (number == fraction)
+            return false;
+    }
+    if (number < end && (*number == 'e' || *number == 'E'))
+    {
+        const char* exponent = number + 1;
+        if (exponent < end && (*exponent == '+' || *exponent == '-'))
+            exponent++;
+        number = skip_digits(exponent, end);
+        if (number == exponent)
+            return false;
+    }
+
+    auto result = std::from_chars(pos, number, value);
+    if (result.ec != std::errc() || result.ptr != number)
+        return false;
+    pos = number;
+    return true;
+}
+
+bool JsonReader::ReadBoolean(bool& value)
+{
+    skip_whitespace();
+    if (end - pos >= 4 && std::memcmp(pos, "true", 4) == 0)
+    {
+        value = true;
+        pos += 4;
+        return true;
+    }
+    if (end - pos >= 5 && std::memcmp(pos, "false", 5) == 0)
+    {
+        value = false;
+        pos += 5;
+        return true;
+    }
+    return false;
+}
+
+bool JsonReader::Skip(unsigned int depth)
+{
+    if (depth > JSON_MAX_NESTING)
+        return false;
+
+    std::string storage;
+    std::string_view text;
+    double number;
+    bool boolean;
+
+    switch (Peek())
+    {
+    case '"':
+        return ReadString(text, storage);
+    case 't':
+    case 'f':
+        return ReadBoolean(boolean);
+    case 'n':
+        if (end - pos < 4 || std::memcmp(pos, "null", 4) != 0)
+            return false;
+        pos += 4;
+        return true;
+    case '[':
+        pos++;
+        if (Consume(']'))
+            return true;
+        do
+        {
+            if (!Skip(depth + 1))
+                return false;
+        } while (Consume(','));
+        return Consume(']');
+    case '{':
+        pos++;
+        if (Consume('}'))
+            return true;
+        do
+        {
+            if (!ReadString(text, storage) || !Consume(':') || !Skip(depth + 1))
+                return false;
+        } while (Consume(','));
+        return Consume('}');
+    default:
+        return ReadNumber(number);
+    }
+}
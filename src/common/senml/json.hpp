@@ -0,0 +1,115 @@
+/**
+ * @file json.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Minimal streaming JSON reader with a vectorized scanner
+ * @version 0.1
+ * @date 2021-07-07
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace common::senml
+{
+    /**
+     * @brief Reads JSON values directly from a buffer without building a tree.
+     * Whitespace and string contents are scanned 16 bytes at a time when SSE2 is available.
+     * All methods return false on malformed input.
+     */
+    class JsonReader
+    {
+        private:
+            /**
+             * @brief Current read position
+             */
+            const char* pos;
+
+            /**
+             * @brief End of the buffer
+             */
+            const char* end;
+
+            /**
+             * @brief Skips whitespace.
+             */
+            void skip_whitespace();
+
+        public:
+            /**
+             * @brief Construct a new reader on the buffer. The buffer has to outlive the reader.
+             * 
+             * @param data The buffer
+             * @param size Size of the buffer
+             */
+            JsonReader(const uint8_t* data, size_t size);
+
+            /**
+             * @brief Checks if only whitespace is left.
+             * 
+             * @return true Nothing left to read
+             * @return false There are bytes left
+             */
+            bool AtEnd();
+
+            /**
+             * @brief Get the next character that is not whitespace without consuming it.
+             * 
+             * @return char The character or '\0' at the end of the buffer
+             */
+            char Peek();
+
+            /**
+             * @brief Consumes the character if it is the next one.
+             * 
+             * @param c The expected character
+             * @return true The character was consumed
+             * @return false The next character is a different one
+             */
+            bool Consume(char c);
+
+            /**
+             * @brief Reads a string. Strings without escapes are returned as views into the buffer,
+             * others get unescaped into the storage.
+             * 
+             * @param value The string
+             * @param storage Storage for unescaped strings (only modified when required)
+             * @return true On success
+             * @return false Not a string
+             */
+            bool ReadString(std::string_view& value, std::string& storage);
+
+            /**
+             * @brief Reads a number.
+             * 
+             * @param value The number
+             * @return true On success
+             * @return false Not a number
+             */
+            bool ReadNumber(double& value);
+
+            /**
+             * @brief Reads true or false.
+             * 
+             * @param value The boolean
+             * @return true On success
+             * @return false Not a boolean
+             */
+            bool ReadBoolean(bool& value);
+
+            /**
+             * @brief Skips the next value including all nested values.
+             * 
+             * @param depth Current nesting depth (used to stop malicious nesting)
+             * @return true On success
+             * @return false On malformed input
+             */
+            bool Skip(unsigned int depth = 0);
+    };
+}
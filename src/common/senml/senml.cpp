@@ -0,0 +1,424 @@
+/**
+ * @file senml.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief 
+ * @version 0.1
+ * @date 2021-07-05
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include "senml.hpp"
+#include "cbor.hpp"
+#include "json.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace common::senml;
+
+bool Resolver::Resolve(const raw_record& raw, Pack& pack)
+{
+    // Update the bases for this and all following records
+    if (raw.fields & raw_record::BASE_NAME)
+    {
+        base_name = raw.base_name;
+        base_name_owned = raw.owned & raw_record::BASE_NAME;
+    }
+    if (raw.fields & raw_record::BASE_UNIT)
+    {
+        base_unit = raw.base_unit;
+        base_unit_owned = raw.owned & raw_record::BASE_UNIT;
+    }
+    if (raw.fields & raw_record::BASE_TIME)
+        base_time = raw.base_time;
+    if (raw.fields & raw_record::BASE_VALUE)
+        base_value = raw.base_value;
+    if (raw.fields & raw_record::BASE_SUM)
+        base_sum = raw.base_sum;
+
+    // Records without a value or sum only carry bases
+    const uint16_t values = raw_record::VALUE | raw_record::STRING_VALUE | raw_record::BOOLEAN_VALUE | raw_record::DATA_VALUE | raw_record::SUM;
+    if ((raw.fields & values) == 0)
+        return true;
+
+    // Only names that have both parts need storage, otherwise the name points into the payload
+    Record record;
+    if (base_name.empty() || raw.name.empty())
+    {
+        record.name = base_name.empty() ? raw.name : base_name;
+        if (base_name.empty() ? (raw.owned & raw_record::NAME) : base_name_owned)
+            record.owned |= Record::OWNS_NAME;
+    }
+    else
+    {
+        std::string& name = pack.strings.emplace_back();
+        name.reserve(base_name.size() + raw.name.size());
+        name.append(base_name).append(raw.name);
+        record.name = name;
+        record.owned |= Record::OWNS_NAME;
+    }
+    if (record.name.empty())
+        return false;
+
+    record.unit = (raw.fields & raw_record::UNIT) ? raw.unit : base_unit;
+    if ((raw.fields & raw_record::UNIT) ? (raw.owned & raw_record::UNIT) : base_unit_owned)
+        record.owned |= Record::OWNS_UNIT;
+    record.time = base_time + raw.time;
+    record.update_time = raw.update_time;
+
+    if (raw.fields & raw_record::VALUE)
+    {
+        record.type = ValueType::NUMBER;
+        record.value = base_value + raw.value;
+    }
+    else if (raw.fields & raw_record::STRING_VALUE)
+    {
+        record.type = ValueType::STRING;
+        record.text = raw.string_value;
+        if (raw.owned & raw_record::STRING_VALUE)
+            record.owned |= Record::OWNS_TEXT;
+    }
+    else if (raw.fields & raw_record::BOOLEAN_VALUE)
+    {
+        record.type = ValueType::BOOLEAN;
+        record.boolean = raw.boolean_value;
+    }
+    else if (raw.fields & raw_record::DATA_VALUE)
+    {
+        record.type = ValueType::DATA;
+        record.text = raw.data_value;
+        if (raw.owned & raw_record::DATA_VALUE)
+            record.owned |= Record::OWNS_TEXT;
+    }
+
+    if (raw.fields & raw_record::SUM)
+    {
+        record.has_sum = true;
+        record.sum = base_sum + raw.sum;
+    }
+
+    pack.records.push_back(std::move(record));
+    return true;
+}
+
+void common::senml::append_record(const Record& record, Pack& pack)
+{
+    Record& copy = pack.records.emplace_back(record);
+    if (record.owned & Record::OWNS_NAME)
+        copy.name = pack.strings.emplace_back(record.name);
+    if (record.owned & Record::OWNS_UNIT)
+        copy.unit = pack.strings.emplace_back(record.unit);
+    if (record.owned & Record::OWNS_TEXT)
+        copy.text = pack.strings.emplace_back(record.text);
+}
+
+bool common::senml::absolute_time(double time, int64_t now, int64_t& timestamp)
+{
+    if (!std::isfinite(time))
+        return false;
+
+    // Relative times are small, they are exact as ns and only added to now
+    if (std::fabs(time) < SENML_RELATIVE_TIME)
+    {
+        timestamp = now + std::llround(time * 1e9);
+        return true;
+    }
+    if (time < 0 || time >= SENML_MAX_TIME)
+        return false;
+
+    // Seconds and fraction separately, a double can not hold ns since 1970 exactly
+    double seconds = std::floor(time);
+    timestamp = static_cast<int64_t>(seconds) * 1000000000 + std::llround((time - seconds) * 1e9);
+    return true;
+}
+
+bool common::senml::normalize_times(Pack& pack, int64_t now)
+{
+    for (auto& record : pack.records)
+    {
+        if (!absolute_time(record.time, now, record.timestamp))
+            return false;
+        record.time = static_cast<double>(record.timestamp / 1000000000) + static_cast<double>(record.timestamp % 1000000000) / 1e9;
+    }
+    return true;
+}
+
+/**
+ * @brief Maps the text labels to the integer labels of SenML CBOR (RFC 8428 section 6).
+ * 
+ * @param label Text label
+ * @param key The integer label
+ * @return true Known label
+ * @return false Unknown label
+ */
+bool text_label_to_key(std::string_view label, int64_t& key)
+{
+    static const std::string_view labels[] = { "bs", "bv", "bu", "bt", "bn", "bver", "n", "u", "v", "vs", "vb", "s", "t", "ut", "vd" };
+    for (int64_t i = 0; i < (int64_t)(sizeof(labels) / sizeof(labels[0])); i++)
+    {
+        if (labels[i] == label)
+        {
+            key = i - 6;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the fields of one record map.
+ * 
+ * @param reader Reader positioned at the map
+ * @param raw The read fields
+ * @return true On success
+ * @return false Malformed record
+ */
+bool read_cbor_record(CborReader& reader, raw_record& raw)
+{
+    uint64_t length;
+    if (!reader.ReadMap(length))
+        return false;
+
+    for (uint64_t i = 0; length == CborReader::INDEFINITE ? !reader.ReadBreak() : i < length; i++)
+    {
+        // Labels are integers but we accept the text labels as well
+        int64_t key = 0;
+        uint8_t major;
+        bool known = true;
+        if (!reader.PeekType(major))
+            return false;
+        if (major == CborReader::TEXT)
+        {
+            std::string_view label;
+            if (!reader.ReadText(label))
+                return false;
+            known = text_label_to_key(label, key);
+        }
+        else if (!reader.ReadInteger(key))
+            return false;
+
+        bool valid = true;
+        switch (known ? key : INT64_MAX)
+        {
+        case -6: valid = reader.ReadNumber(raw.base_sum); raw.fields |= raw_record::BASE_SUM; break;
+        case -5: valid = reader.ReadNumber(raw.base_value); raw.fields |= raw_record::BASE_VALUE; break;
+        case -4: valid = reader.ReadText(raw.base_unit); raw.fields |= raw_record::BASE_UNIT; break;
+        case -3: valid = reader.ReadNumber(raw.base_time); raw.fields |= raw_record::BASE_TIME; break;
+        case -2: valid = reader.ReadText(raw.base_name); raw.fields |= raw_record::BASE_NAME; break;
+        case 0: valid = reader.ReadText(raw.name); raw.fields |= raw_record::NAME; break;
+        case 1: valid = reader.ReadText(raw.unit); raw.fields |= raw_record::UNIT; break;
+        case 2: valid = reader.ReadNumber(raw.value); raw.fields |= raw_record::VALUE; break;
+        case 3: valid = reader.ReadText(raw.string_value); raw.fields |= raw_record::STRING_VALUE; break;
+        case 4: valid = reader.ReadBoolean(raw.boolean_value); raw.fields |= raw_record::BOOLEAN_VALUE; break;
+        case 5: valid = reader.ReadNumber(raw.sum); raw.fields |= raw_record::SUM; break;
+        case 6: valid = reader.ReadNumber(raw.time); raw.fields |= raw_record::TIME; break;
+        case 7: valid = reader.ReadNumber(raw.update_time); raw.fields |= raw_record::UPDATE_TIME; break;
+        case 8: valid = reader.ReadBytes(raw.data_value); raw.fields |= raw_record::DATA_VALUE; break;
+        default: valid = reader.Skip(); break; // Version and unknown labels
+        }
+
+        if (!valid)
+            return false;
+    }
+    return true;
+}
+
+bool common::senml::decode_cbor(const uint8_t* data, size_t size, Pack& pack)
+{
+    CborReader reader(data, size);
+    Resolver resolver;
+
+    // A pack is an array of records
+    uint64_t length;
+    if (!reader.ReadArray(length))
+        return false;
+
+    // Don't trust the length for the allocation. Every record takes at least one byte.
+    if (length != CborReader::INDEFINITE)
+        pack.records.reserve(pack.records.size() + std::min<uint64_t>(length, size));
+
+    for (uint64_t i = 0; length == CborReader::INDEFINITE ? !reader.ReadBreak() : i < length; i++)
+    {
+        raw_record raw;
+        if (!read_cbor_record(reader, raw) || !resolver.Resolve(raw, pack))
+            return false;
+    }
+    return reader.AtEnd();
+}
+
+
+/**
+ * @brief Reads a JSON string field and keeps unescaped strings alive in the pack.
+ * 
+ * @param reader The reader
+ * @param raw The read fields, field is marked as present and as owned by the pack if it had escapes
+ * @param field The field
+ * @param value The string
+ * @param pack Pack that owns unescaped strings
+ * @return true On success
+ * @return false Not a string
+ */
+bool read_json_field(JsonReader& reader, raw_record& raw, raw_record::field field, std::string_view& value, Pack& pack)
+{
+    raw.fields |= field;
+    std::string storage;
+    if (!reader.ReadString(value, storage))
+        return false;
+
+    // The string had escapes -> move it into the pack
+    if (value.data() == storage.data())
+    {
+        value = pack.strings.emplace_back(std::move(storage));
+        raw.owned |= field;
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes a base64 data value. SenML JSON uses the URL safe alphabet without padding
+ * (RFC 8428 section 5), the standard alphabet and padding are accepted as well.
+ * 
+ * @param text The encoded value
+ * @param data The decoded bytes
+ * @return true On success
+ * @return false Invalid character or length
+ */
+bool decode_base64(std::string_view text, std::string& data)
+{
+    while (!text.empty() && text.back() == '=')
+        text.remove_suffix(1);
+    if (text.size() % 4 == 1)
+        return false;
+
+    data.clear();
+    data.reserve(text.size() * 3 / 4);
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text)
+    {
+        uint32_t value;
+        if (c >= 'A' && c <= 'Z')
+            value = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            value = c - '0' + 52;
+        else if (c == '-' || c == '+')
+            value = 62;
+        else if (c == '_' || c == '/')
+            value = 63;
+        else
+            return false;
+
+        bits = (bits << 6) | value;
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            data.push_back((char)((bits >> count) & 0xff));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a JSON data value and decodes it into the pack, so that it holds the bytes as in CBOR.
+ * 
+ * @param reader The reader
+ * @param raw The read fields, the data value is marked as present and owned by the pack
+ * @param pack Pack that owns the decoded bytes
+ * @return true On success
+ * @return false Not a string or not base64
+ */
+bool read_json_data(JsonReader& reader, raw_record& raw, Pack& pack)
+{
+    std::string_view text;
+    std::string storage;
+    if (!reader.ReadString(text, storage))
+        return false;
+
+    std::string& data = pack.strings.emplace_back();
+    if (!decode_base64(text, data))
+        return false;
+    raw.data_value = data;
+    raw.fields |= raw_record::DATA_VALUE;
+    raw.owned |= raw_record::DATA_VALUE;
+    return true;
+}
+
+/**
+ * @brief Reads the fields of one record object.
+ * 
+ * @param reader Reader positioned at the object
+ * @param raw The read fields
+ * @param pack Pack that owns unescaped strings
+ * @return true On success
+ * @return false Malformed record
+ */
+bool read_json_record(JsonReader& reader, raw_record& raw, Pack& pack)
+{
+    if (!reader.Consume('{'))
+        return false;
+    if (reader.Consume('}'))
+        return true;
+
+    do
+    {
+        std::string_view label;
+        std::string label_storage;
+        int64_t key = 0;
+        if (!reader.ReadString(label, label_storage) || !reader.Consume(':'))
+            return false;
+
+        bool valid = true;
+        switch (text_label_to_key(label, key) ? key : INT64_MAX)
+        {
+        case -6: valid = reader.ReadNumber(raw.base_sum); raw.fields |= raw_record::BASE_SUM; break;
+        case -5: valid = reader.ReadNumber(raw.base_value); raw.fields |= raw_record::BASE_VALUE; break;
+        case -4: valid = read_json_field(reader, raw, raw_record::BASE_UNIT, raw.base_unit, pack); break;
+        case -3: valid = reader.ReadNumber(raw.base_time); raw.fields |= raw_record::BASE_TIME; break;
+        case -2: valid = read_json_field(reader, raw, raw_record::BASE_NAME, raw.base_name, pack); break;
+        case 0: valid = read_json_field(reader, raw, raw_record::NAME, raw.name, pack); break;
+        case 1: valid = read_json_field(reader, raw, raw_record::UNIT, raw.unit, pack); break;
+        case 2: valid = reader.ReadNumber(raw.value); raw.fields |= raw_record::VALUE; break;
+        case 3: valid = read_json_field(reader, raw, raw_record::STRING_VALUE, raw.string_value, pack); break;
+        case 4: valid = reader.ReadBoolean(raw.boolean_value); raw.fields |= raw_record::BOOLEAN_VALUE; break;
+        case 5: valid = reader.ReadNumber(raw.sum); raw.fields |= raw_record::SUM; break;
+        case 6: valid = reader.ReadNumber(raw.time); raw.fields |= raw_record::TIME; break;
+        case 7: valid = reader.ReadNumber(raw.update_time); raw.fields |= raw_record::UPDATE_TIME; break;
+        case 8: valid = read_json_data(reader, raw, pack); break;
+        default: valid = reader.Skip(); break; // Version and unknown labels
+        }
+
+        if (!valid)
+            return false;
+    } while (reader.Consume(','));
+
+    return reader.Consume('}');
+}
+
+bool common::senml::decode_json(const uint8_t* data, size_t size, Pack& pack)
+{
+    JsonReader reader(data, size);
+    Resolver resolver;
+
+    // A pack is an array of records
+    if (!reader.Consume('['))
+        return false;
+
+    if (!reader.Consume(']'))
+    {
+        do
+        {
+            raw_record raw;
+            if (!read_json_record(reader, raw, pack) || !resolver.Resolve(raw, pack))
+                return false;
+        } while (reader.Consume(','));
+
+        if (!reader.Consume(']'))
+            return false;
+    }
+    return reader.AtEnd();
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+/**
+ * @file senml.hpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Native SenML (RFC 8428) decoding
+ * @version 0.1
+ * @date 2021-07-05
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define SENML_RELATIVE_TIME 268435456.0 // 2^28, smaller times are relative to now (RFC 8428 section 4.5.3)
+#define SENML_MAX_TIME 9223372036.0     // Seconds since the epoch that still fit into int64 ns
+
+namespace common::senml
+{
+    enum class ValueType : uint8_t
+    {
+        NONE,
+        NUMBER,
+        STRING,
+        BOOLEAN,
+        DATA
+    };
+
+    /**
+     * @brief A resolved SenML record. Base name, time, value, unit and sum are already applied.
+     * The string views point into the decoded payload or into the strings of its pack, both have to outlive the record.
+     */
+    struct Record
+    {
+        std::string_view name;              // Base name + name
+        std::string_view unit;              // Unit or base unit
+        ValueType type = ValueType::NONE;   // Which of the values is set
+        double value = 0;                   // Base value + value
+        bool boolean = false;               // Boolean value
+        std::string_view text;              // String value or data value
+        bool has_sum = false;
+        double sum = 0;                     // Base sum + sum
+        double time = 0;                    // Base time + time in seconds, absolute after normalize_times
+        int64_t timestamp = 0;              // Absolute time in ns since the epoch, set by normalize_times
+        double update_time = 0;
+        uint32_t series = UINT32_MAX;       // Series id if a dictionary assigned one
+
+        /**
+         * @brief Views that point into the strings of the pack instead of the payload
+         */
+        enum owned_field : uint8_t
+        {
+            OWNS_NAME = 1 << 0,
+            OWNS_UNIT = 1 << 1,
+            OWNS_TEXT = 1 << 2
+        };
+        uint8_t owned = 0;                  // owned_field bits
+    };
+
+    /**
+     * @brief A decoded pack. Records point into the payload or into the strings of the pack
+     * (for strings that had to be unescaped and names that had to be joined with their base name),
+     * Record::owned tells which.
+     */
+    struct Pack
+    {
+        std::vector<Record> records;
+        std::deque<std::string> strings;    // Stable storage for unescaped strings and joined names
+    };
+
+    /**
+     * @brief Fields of a single record as they appear in the encoded pack.
+     */
+    struct raw_record
+    {
+        enum field : uint16_t
+        {
+            BASE_NAME = 1 << 0,
+            BASE_TIME = 1 << 1,
+            BASE_UNIT = 1 << 2,
+            BASE_VALUE = 1 << 3,
+            BASE_SUM = 1 << 4,
+            NAME = 1 << 5,
+            UNIT = 1 << 6,
+            VALUE = 1 << 7,
+            STRING_VALUE = 1 << 8,
+            BOOLEAN_VALUE = 1 << 9,
+            DATA_VALUE = 1 << 10,
+            SUM = 1 << 11,
+            TIME = 1 << 12,
+            UPDATE_TIME = 1 << 13
+        };
+
+        uint16_t fields = 0;    // Which fields are present
+        uint16_t owned = 0;     // Which strings were unescaped into the strings of the pack
+        std::string_view base_name, base_unit, name, unit, string_value, data_value;
+        double base_time = 0, base_value = 0, base_sum = 0;
+        double value = 0, sum = 0, time = 0, update_time = 0;
+        bool boolean_value = false;
+    };
+
+    /**
+     * @brief Applies the base fields of a pack to its records (RFC 8428 section 4.6).
+     * The base fields stay valid for all following records until they are replaced.
+     */
+    class Resolver
+    {
+        private:
+            std::string_view base_name;
+            std::string_view base_unit;
+            bool base_name_owned = false;   // The base name points into the strings of the pack
+            bool base_unit_owned = false;   // The base unit points into the strings of the pack
+            double base_time = 0;
+            double base_value = 0;
+            double base_sum = 0;
+
+        public:
+            /**
+             * @brief Resolves a record and appends it to the pack. Records that only contain
+             * base fields update the bases but are not appended.
+             * 
+             * @param raw The record as it was read
+             * @param pack Pack to append the resolved record to
+             * @return true On success
+             * @return false The record has a value but no name
+             */
+            bool Resolve(const raw_record& raw, Pack& pack);
+    };
+
+    /**
+     * @brief Appends a record of another pack. Strings that the other pack owns are copied,
+     * views into the payload are kept, so the payload still has to outlive the copy.
+     * 
+     * @param record The record
+     * @param pack Pack to append the copy to
+     */
+    void append_record(const Record& record, Pack& pack);
+
+    /**
+     * @brief Converts the resolved time of a record to ns since the epoch.
+     * A time of 0 means now, times below 2^28 are relative to now.
+     * 
+     * @param time Resolved time of the record in seconds
+     * @param now Receive time in ns since the epoch
+     * @param timestamp The absolute time in ns
+     * @return true On success
+     * @return false The time is not finite or does not fit into int64 ns
+     */
+    bool absolute_time(double time, int64_t now, int64_t& timestamp);
+
+    /**
+     * @brief Resolves the times of all records of a pack against the receive time of the payload.
+     * Afterwards timestamp holds ns since the epoch and time the same in seconds.
+     * 
+     * @param pack The decoded pack
+     * @param now Receive time in ns since the epoch
+     * @return true On success
+     * @return false A record has a time that can not be represented
+     */
+    bool normalize_times(Pack& pack, int64_t now);
+
+    /**
+     * @brief Decodes a SenML CBOR pack (application/senml+cbor).
+     * 
+     * @param data The payload. It has to outlive the records because strings are not copied.
+     * @param size Size of the payload
+     * @param pack The resolved records are appended here
+     * @return true On success
+     * @return false Malformed pack
+     */
+    bool decode_cbor(const uint8_t* data, size_t size, Pack& pack);
+
+    /**
+     * @brief Decodes a SenML JSON pack (application/senml+json).
+     * Data values ("vd") are decoded from base64 into the strings of the pack, so records hold the bytes as with CBOR.
+     * 
+     * @param data The payload. It has to outlive the records because strings are not copied.
+     * @param size Size of the payload
+     * @param pack The resolved records are appended here
+     * @return true On success
+     * @return false Malformed pack
+     */
+    bool decode_json(const uint8_t* data, size_t size, Pack& pack);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file cbor_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the SenML CBOR decoder
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <common/senml/senml.hpp>
+
+#include <vector>
+
+using namespace common::senml;
+
+TEST_CASE(base_fields)
+{
+    // [{-2: "db:dev:", -3: 1000, 0: "temp", 2: 21.5 (half), 1: "Cel"}, {0: "hum", 2: 40, 6: 5}]
+    const std::vector<uint8_t> data = { 0x82,
+        0xa5, 0x21, 0x67, 'd', 'b', ':', 'd', 'e', 'v', ':', 0x22, 0x19, 0x03, 0xe8, 0x00, 0x64, 't', 'e', 'm', 'p',
+              0x02, 0xf9, 0x4d, 0x60, 0x01, 0x63, 'C', 'e', 'l',
+        0xa3, 0x00, 0x63, 'h', 'u', 'm', 0x02, 0x18, 0x28, 0x06, 0x05 };
+    Pack pack;
+    ASSERT_TRUE(decode_cbor(data.data(), data.size(), pack));
+    ASSERT_EQUAL(pack.records.size(), 2u);
+
+    const Record& temp = pack.records[0];
+    ASSERT_TRUE(temp.name == "db:dev:temp");
+    ASSERT_TRUE(temp.unit == "Cel");
+    ASSERT_TRUE(temp.type == ValueType::NUMBER);
+    ASSERT_EQUAL(temp.value, 21.5);
+    ASSERT_EQUAL(temp.time, 1000.0);
+
+    const Record& hum = pack.records[1];
+    ASSERT_TRUE(hum.name == "db:dev:hum");
+    ASSERT_TRUE(hum.unit.empty());
+    ASSERT_EQUAL(hum.value, 40.0);
+    ASSERT_EQUAL(hum.time, 1005.0);
+
+    // Joined names are owned by the pack, the unit points into the payload
+    ASSERT_EQUAL(pack.strings.size(), 2u);
+    ASSERT_TRUE(temp.unit.data() >= (const char*)data.data() && temp.unit.data() < (const char*)data.data() + data.size());
+}
+
+TEST_CASE(names_point_into_payload)
+{
+    // [{0: "a:b", 2: 1}, {-2: "c:d", 2: 2}]
+    const std::vector<uint8_t> data = { 0x82,
+        0xa2, 0x00, 0x63, 'a', ':', 'b', 0x02, 0x01,
+        0xa2, 0x21, 0x63, 'c', ':', 'd', 0x02, 0x02 };
+    Pack pack;
+    ASSERT_TRUE(decode_cbor(data.data(), data.size(), pack));
+    ASSERT_EQUAL(pack.records.size(), 2u);
+    ASSERT_TRUE(pack.records[0].name == "a:b");
+    ASSERT_TRUE(pack.records[1].name == "c:d");
+    ASSERT_TRUE(pack.strings.empty());
+    ASSERT_TRUE(pack.records[0].name.data() == (const char*)data.data() + 4);
+}
+
+TEST_CASE(indefinite_lengths_and_text_labels)
+{
+    // [_ {_ "bn": "x", "vb": true}]
+    const std::vector<uint8_t> data = { 0x9f, 0xbf, 0x62, 'b', 'n', 0x61, 'x', 0x62, 'v', 'b', 0xf5, 0xff, 0xff };
+    Pack pack;
+    ASSERT_TRUE(decode_cbor(data.data(), data.size(), pack));
+    ASSERT_EQUAL(pack.records.size(), 1u);
+    ASSERT_TRUE(pack.records[0].type == ValueType::BOOLEAN);
+    ASSERT_TRUE(pack.records[0].boolean);
+    ASSERT_TRUE(pack.records[0].name == "x");
+}
+
+TEST_CASE(malformed_packs)
+{
+    // Trailing data after the pack
+    std::vector<uint8_t> trailing = { 0x81, 0xa2, 0x00, 0x61, 'x', 0x02, 0x01, 0x00 };
+    Pack pack;
+    ASSERT_FALSE(decode_cbor(trailing.data(), trailing.size(), pack));
+
+    // A value without a name: [{2: 3.14159}]
+    const std::vector<uint8_t> unnamed = { 0x81, 0xa1, 0x02, 0xfb, 0x40, 0x09, 0x21, 0xf9, 0xf0, 0x1b, 0x86, 0x6e };
+    pack = Pack();
+    ASSERT_FALSE(decode_cbor(unnamed.data(), unnamed.size(), pack));
+
+    // A text string longer than the payload
+    const std::vector<uint8_t> truncated = { 0x81, 0xa2, 0x00, 0x6a, 'x', 0x02, 0x01 };
+    pack = Pack();
+    ASSERT_FALSE(decode_cbor(truncated.data(), truncated.size(), pack));
+}
+
+TEST_CASE(absolute_times)
+{
+    // [{0: "x", 2: 1, 6: -2}, {0: "y", 2: 1, 6: 1600000000}]
+    const std::vector<uint8_t> data = { 0x82,
+        0xa3, 0x00, 0x61, 'x', 0x02, 0x01, 0x06, 0x21,
+        0xa3, 0x00, 0x61, 'y', 0x02, 0x01, 0x06, 0x1a, 0x5f, 0x5e, 0x10, 0x00 };
+    Pack pack;
+    ASSERT_TRUE(decode_cbor(data.data(), data.size(), pack));
+
+    int64_t now = 1700000000ll * 1000000000;
+    ASSERT_TRUE(normalize_times(pack, now));
+    ASSERT_EQUAL(pack.records[0].timestamp, now - 2000000000);
+    ASSERT_EQUAL(pack.records[1].timestamp, 1600000000ll * 1000000000);
+
+    int64_t timestamp = 0;
+    ASSERT_FALSE(absolute_time(SENML_MAX_TIME, now, timestamp));
+    ASSERT_FALSE(absolute_time(-SENML_RELATIVE_TIME, now, timestamp));
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(base_fields);
+    TEST_CASE_RUN(names_point_into_payload);
+    TEST_CASE_RUN(indefinite_lengths_and_text_labels);
+    TEST_CASE_RUN(malformed_packs);
+    TEST_CASE_RUN(absolute_times);
+TEST_MODULE_END
\ No newline at end of file
@@ -0,0 +1,184 @@
+/**
+ * @file json_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the SenML JSON decoder
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <common/senml/senml.hpp>
+
+#include <cstring>
+
+using namespace common::senml;
+
+/**
+ * @brief Decodes a JSON pack
+ * 
+ * @param json The pack
+ * @param pack The records
+ * @return true On success
+ * @return false Malformed pack
+ */
+static bool decode(const char* json, Pack& pack)
+{
+    pack = Pack();
+    return decode_json(reinterpret_cast<const uint8_t*>(json), std::strlen(json), pack);
+}
+
+/**
+ * @brief Decodes a pack with a single value
+ * 
+ * @param value The value as it appears in the JSON
+ * @return true The pack was accepted
+ * @return false The pack was rejected
+ */
+static bool accepts_value(const std::string& value)
+{
+    Pack pack;
+    return decode(("[{\"n\":\"a\",\"v\":" + value + "}]").c_str(), pack);
+}
+
+/**
+ * @brief Decodes a pack with a single string value
+ * 
+ * @param value The string as it appears in the JSON, without the quotes
+ * @return true The pack was accepted
+ * @return false The pack was rejected
+ */
+static bool accepts_string(const std::string& value)
+{
+    Pack pack;
+    return decode(("[{\"n\":\"a\",\"vs\":\"" + value + "\"}]").c_str(), pack);
+}
+
+TEST_CASE(records)
+{
+    Pack pack;
+    ASSERT_TRUE(decode(R"([ {"bn":"urn:dev:ow:10e2073a01080063:","bt":1.276020076001e+09,
+        "bu":"A","bver":5, "x":{"a":[1,2,null]},
+        "n":"voltage","u":"V","v":120.1},
+        {"n":"current","t":-5,"v":1.2},
+        {"n":"very long name that crosses sixteen bytesé\"q","vs":"he said \"hi\"   padding text here"},
+        {"n":"b","vb":false}
+    ])", pack));
+    ASSERT_EQUAL(pack.records.size(), 4u);
+
+    ASSERT_TRUE(pack.records[0].name == "urn:dev:ow:10e2073a01080063:voltage");
+    ASSERT_TRUE(pack.records[0].unit == "V");
+    ASSERT_EQUAL(pack.records[0].value, 120.1);
+    ASSERT_TRUE(pack.records[1].unit == "A");
+    ASSERT_EQUAL(pack.records[1].time, 1.276020076001e+09 - 5);
+    ASSERT_TRUE(pack.records[2].name == "urn:dev:ow:10e2073a01080063:very long name that crosses sixteen bytes\xc3\xa9\"q");
+    ASSERT_TRUE(pack.records[2].type == ValueType::STRING);
+    ASSERT_TRUE(pack.records[2].text == "he said \"hi\"   padding text here");
+    ASSERT_TRUE(pack.records[3].type == ValueType::BOOLEAN);
+    ASSERT_FALSE(pack.records[3].boolean);
+
+    ASSERT_TRUE(decode(" [ ] ", pack));
+    ASSERT_TRUE(pack.records.empty());
+}
+
+TEST_CASE(malformed_packs)
+{
+    Pack pack;
+    ASSERT_FALSE(decode("[{\"n\":\"a\",\"v\":1},]", pack));
+    ASSERT_FALSE(decode("[{\"n\":\"a\",\"v\":1}] x", pack));
+    ASSERT_FALSE(decode("[{\"n\":\"a\",\"v\":1}", pack));
+    ASSERT_FALSE(decode("[{\"v\":1}]", pack));
+}
+
+TEST_CASE(number_grammar)
+{
+    ASSERT_TRUE(accepts_value("0"));
+    ASSERT_TRUE(accepts_value("-0.5"));
+    ASSERT_TRUE(accepts_value("12.25e-3"));
+    ASSERT_TRUE(accepts_value("1E+2"));
+
+    ASSERT_FALSE(accepts_value("+1"));
+    ASSERT_FALSE(accepts_value("-inf"));
+    ASSERT_FALSE(accepts_value("-nan"));
+    ASSERT_FALSE(accepts_value("-infinity"));
+    ASSERT_FALSE(accepts_value("inf"));
+    ASSERT_FALSE(accepts_value("01"));
+    ASSERT_FALSE(accepts_value("-"));
+    ASSERT_FALSE(accepts_value("1."));
+    ASSERT_FALSE(accepts_value(".5"));
+    ASSERT_FALSE(accepts_value("1e"));
+    ASSERT_FALSE(accepts_value("1e+"));
+    ASSERT_FALSE(accepts_value("0x10"));
+}
+
+TEST_CASE(string_grammar)
+{
+    ASSERT_TRUE(accepts_string("\\ud83d\\ude00"));
+    ASSERT_TRUE(accepts_string("tab\\tescaped"));
+
+    // Lone surrogates
+    ASSERT_FALSE(accepts_string("\\ude00"));
+    ASSERT_FALSE(accepts_string("\\ud83d"));
+    ASSERT_FALSE(accepts_string("\\ud83dx"));
+
+    // Unescaped control characters in the fast and in the slow path, before and after 16 bytes
+    ASSERT_FALSE(accepts_string("tab\tinside"));
+    ASSERT_FALSE(accepts_string("a string longer than sixteen bytes\n"));
+    ASSERT_FALSE(accepts_string("\\\"escaped\x01"));
+    ASSERT_FALSE(accepts_string("\\\"escaped and longer than sixteen bytes\x1f"));
+    ASSERT_TRUE(accepts_string("utf-8 \xc3\xa9 is no control character, even after sixteen bytes \xc3\xa9"));
+}
+
+TEST_CASE(data_values)
+{
+    // Decoded into the same bytes as a CBOR byte string, URL safe without padding as in RFC 8428
+    const std::string bytes("\xfb\xff\x00" "a", 4);
+    Pack pack;
+    ASSERT_TRUE(decode(R"([{"n":"a","vd":"-_8AYQ"},{"n":"b","vd":"+/8AYQ=="},{"n":"c","vd":""}])", pack));
+    ASSERT_EQUAL(pack.records.size(), 3u);
+    ASSERT_TRUE(pack.records[0].type == ValueType::DATA);
+    ASSERT_TRUE(pack.records[0].text == bytes);
+    ASSERT_EQUAL(pack.records[0].owned, Record::OWNS_TEXT);
+    ASSERT_TRUE(pack.records[1].text == bytes);
+    ASSERT_TRUE(pack.records[2].type == ValueType::DATA);
+    ASSERT_TRUE(pack.records[2].text.empty());
+
+    ASSERT_FALSE(decode(R"([{"n":"a","vd":"-_8AY"}])", pack));
+    ASSERT_FALSE(decode(R"([{"n":"a","vd":"-_8A.Q"}])", pack));
+    ASSERT_FALSE(decode(R"([{"n":"a","vd":1}])", pack));
+}
+
+TEST_CASE(copied_records_own_their_strings)
+{
+    const char* json = R"([{"bn":"dev:","n":"temp","u":"C\u0065l","v":1},{"n":"plain","vs":"\"quoted\""},{"bn":"","n":"raw","u":"V","v":2}])";
+    Pack copy;
+    {
+        Pack pack;
+        ASSERT_TRUE(decode(json, pack));
+        ASSERT_EQUAL(pack.records[0].owned, Record::OWNS_NAME | Record::OWNS_UNIT);
+        ASSERT_EQUAL(pack.records[1].owned, Record::OWNS_NAME | Record::OWNS_TEXT);
+        ASSERT_EQUAL(pack.records[2].owned, 0);
+        for (const auto& record : pack.records)
+            append_record(record, copy);
+    }
+
+    // The pack is gone, only the views into the payload are left
+    ASSERT_TRUE(copy.records[0].name == "dev:temp");
+    ASSERT_TRUE(copy.records[0].unit == "Cel");
+    ASSERT_TRUE(copy.records[1].name == "dev:plain");
+    ASSERT_TRUE(copy.records[1].text == "\"quoted\"");
+    ASSERT_TRUE(copy.records[2].name == "raw");
+    ASSERT_TRUE(copy.records[2].name.data() == std::strstr(json, "raw"));
+    ASSERT_EQUAL(copy.strings.size(), 4u);
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(records);
+    TEST_CASE_RUN(malformed_packs);
+    TEST_CASE_RUN(number_grammar);
+    TEST_CASE_RUN(string_grammar);
+    TEST_CASE_RUN(data_values);
+    TEST_CASE_RUN(copied_records_own_their_strings);
+TEST_MODULE_END
\ No newline at end of file
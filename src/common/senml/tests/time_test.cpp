@@ -0,0 +1,72 @@
+/**
+ * @file time_test.cpp
+ * @author René Pascal Becker (OneDenper@gmail.com)
+ * @brief Tests of the resolution of SenML times
+ * @version 0.1
+ * @date 2021-07-24
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <testing/base.h>
+#include <common/senml/senml.hpp>
+
+#include <cmath>
+
+using namespace common::senml;
+
+static const int64_t now = 1700000000123456789ll;
+
+TEST_CASE(relative_times)
+{
+    int64_t timestamp = 0;
+    ASSERT_TRUE(absolute_time(0, now, timestamp));
+    ASSERT_EQUAL(timestamp, now);
+    ASSERT_TRUE(absolute_time(-5, now, timestamp));
+    ASSERT_EQUAL(timestamp, now - 5000000000ll);
+    ASSERT_TRUE(absolute_time(1.5, now, timestamp));
+    ASSERT_EQUAL(timestamp, now + 1500000000ll);
+}
+
+TEST_CASE(absolute_times)
+{
+    int64_t timestamp = 0;
+    ASSERT_TRUE(absolute_time(1700000000.25, now, timestamp));
+    ASSERT_EQUAL(timestamp, 1700000000250000000ll);
+    ASSERT_TRUE(absolute_time(SENML_RELATIVE_TIME, now, timestamp));
+    ASSERT_EQUAL(timestamp, 268435456000000000ll);
+}
+
+TEST_CASE(unrepresentable_times)
+{
+    int64_t timestamp = 0;
+    ASSERT_FALSE(absolute_time(1e300, now, timestamp));
+    ASSERT_FALSE(absolute_time(SENML_MAX_TIME, now, timestamp));
+    ASSERT_FALSE(absolute_time(-1e9, now, timestamp));
+    ASSERT_FALSE(absolute_time(INFINITY, now, timestamp));
+    ASSERT_FALSE(absolute_time(NAN, now, timestamp));
+}
+
+TEST_CASE(normalized_packs)
+{
+    Pack pack;
+    pack.records.resize(2);
+    pack.records[0].time = -0.5;
+    pack.records[1].time = 1600000000;
+    ASSERT_TRUE(normalize_times(pack, now));
+    ASSERT_EQUAL(pack.records[0].timestamp, now - 500000000);
+    ASSERT_TRUE(std::fabs(pack.records[0].time - 1699999999.623456789) < 1e-6);
+    ASSERT_EQUAL(pack.records[1].timestamp, 1600000000ll * 1000000000);
+    ASSERT_EQUAL(pack.records[1].time, 1600000000.0);
+
+    pack.records[1].time = NAN;
+    ASSERT_FALSE(normalize_times(pack, now));
+}
+
+TEST_MODULE
+    TEST_CASE_RUN(relative_times);
+    TEST_CASE_RUN(absolute_times);
+    TEST_CASE_RUN(unrepresentable_times);
+    TEST_CASE_RUN(normalized_packs);
+TEST_MODULE_END
\ No newline at end of file
@@ -6,16 +6,15 @@ using namespace common;
 
 void Service::service_loop()
 {
-    // Service is now running
-    service_running.store(true);
-
-    // Notify to announce start of thread
+    // Service is now running. Set under the lock so that Start can not miss the notification.
     {
         std::unique_lock<std::mutex> lock(service_mutex);
-        lock.unlock();
-        service_notifier.notify_one();
+        service_running.store(true);
     }
 
+    // Notify to announce start of thread
+    service_notifier.notify_one();
+
     // Run while we are active
     while (service_running.load())
         run();
@@ -73,7 +72,7 @@ bool Service::Start()
     // Wait for the Service to respond
     {
         std::unique_lock<std::mutex> lock(service_mutex);
-        service_notifier.wait(lock);
+        service_notifier.wait(lock, [this] { return service_running.load(); });
     }
     return true;
 }